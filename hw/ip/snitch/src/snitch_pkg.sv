@@ -182,6 +182,11 @@ package snitch_pkg;
     SrcFpuSeq = 2
   } trace_src_e;
 
+  // Extras of any trace port zero-extended to the widest one (`fpu_trace_port_t`), as passed to the
+  // binary tracer (`snitch_trace_write` in `hw/ip/test/src/trace_lib.cc`).
+  localparam int unsigned TraceMaxExtras = 34;
+  typedef bit [64*TraceMaxExtras-1:0] trace_extras_t;
+
   typedef struct packed {
     longint source;
     longint stall;
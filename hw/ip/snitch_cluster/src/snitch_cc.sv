@@ -804,10 +804,37 @@ module snitch_cc #(
   // Tracer
   // --------------------------
   // pragma translate_off
+  // Binary tracer, see `hw/ip/test/src/trace.hh` for the record format.
+  import "DPI-C" function chandle snitch_trace_open(input int hart_id, input bit compress);
+  import "DPI-C" function void snitch_trace_write(
+    input chandle trace,
+    input longint time_val,
+    input longint cycle,
+    input byte source,
+    input byte priv,
+    input byte flags,
+    input int pc,
+    input longint insn,
+    input snitch_pkg::trace_extras_t extras
+  );
+  import "DPI-C" function void snitch_trace_close(input chandle trace);
+
+  localparam byte TraceFlagPcValid = 8'h1;
+  localparam byte TraceFlagInsnValid = 8'h2;
+  localparam byte TraceFlagInsnWide = 8'h4;
+
   int f;
   string fn;
   logic [63:0] cycle = 0;
+  // Write the textual `.dasm` trace (`+trace_text`) instead of binary records, which can be
+  // compressed with `+trace_compress`.
+  bit trace_text;
+  bit trace_compress;
+  chandle trace;
+  // Factor from `$time` to the units in which `%t` prints it in the text trace.
+  longint time_mult;
   initial begin
+    string time_str;
     // We need to schedule the assignment into a safe region, otherwise
     // `hart_id_i` won't have a value assigned at the beginning of the first
     // delta cycle.
@@ -815,8 +842,17 @@ module snitch_cc #(
     #0;
     /* verilator lint_on STMTDLY */
     $system("mkdir logs -p");
-    $sformat(fn, "logs/trace_hart_%05x.dasm", hart_id_i);
-    f = $fopen(fn, "w");
+    trace_text = $test$plusargs("trace_text");
+    trace_compress = $test$plusargs("trace_compress");
+    if (trace_text) begin
+      $sformat(fn, "logs/trace_hart_%05x.dasm", hart_id_i);
+      f = $fopen(fn, "w");
+    end else begin
+      $sformat(fn, "logs/trace_hart_%05x.bin%s", hart_id_i, trace_compress ? ".gz" : "");
+      trace = snitch_trace_open(hart_id_i, trace_compress);
+    end
+    $sformat(time_str, "%0t", 1);
+    void'($sscanf(time_str, "%d", time_mult));
     $display("[Tracer] Logging Hart %d to %s", hart_id_i, fn);
   end
 
@@ -885,10 +921,16 @@ module snitch_cc #(
       if (
           !i_snitch.stall || i_snitch.retire_load || i_snitch.retire_acc
       ) begin
-        $sformat(trace_entry, "%t %1d %8d 0x%h DASM(%h) #; %s\n",
-            $time, cycle, i_snitch.priv_lvl_q, i_snitch.pc_q, i_snitch.inst_data_i,
-            snitch_pkg::print_snitch_trace(extras_snitch));
-        $fwrite(f, trace_entry);
+        if (trace_text) begin
+          $sformat(trace_entry, "%t %1d %8d 0x%h DASM(%h) #; %s\n",
+              $time, cycle, i_snitch.priv_lvl_q, i_snitch.pc_q, i_snitch.inst_data_i,
+              snitch_pkg::print_snitch_trace(extras_snitch));
+          $fwrite(f, trace_entry);
+        end else begin
+          snitch_trace_write(trace, $time * time_mult, cycle, snitch_pkg::SrcSnitch,
+              i_snitch.priv_lvl_q, TraceFlagPcValid | TraceFlagInsnValid, i_snitch.pc_q,
+              i_snitch.inst_data_i, extras_snitch);
+        end
       end
       if (FPEn) begin
         // Trace FPU iff:
@@ -898,18 +940,29 @@ module snitch_cc #(
         // OR an FPU result, LSU result or bus value is ready to be written back to an FPR register
         if (extras_fpu.acc_q_hs || extras_fpu.fpu_out_hs
         || extras_fpu.lsu_q_hs || extras_fpu.fpr_we) begin
-          $sformat(trace_entry, "%t %1d %8d 0x%h DASM(%h) #; %s\n",
-              $time, cycle, i_snitch.priv_lvl_q, 32'hz, extras_fpu.op_in,
-              snitch_pkg::print_fpu_trace(extras_fpu));
-          $fwrite(f, trace_entry);
+          if (trace_text) begin
+            $sformat(trace_entry, "%t %1d %8d 0x%h DASM(%h) #; %s\n",
+                $time, cycle, i_snitch.priv_lvl_q, 32'hz, extras_fpu.op_in,
+                snitch_pkg::print_fpu_trace(extras_fpu));
+            $fwrite(f, trace_entry);
+          end else begin
+            snitch_trace_write(trace, $time * time_mult, cycle, snitch_pkg::SrcFpu,
+                i_snitch.priv_lvl_q, TraceFlagInsnValid | TraceFlagInsnWide, '0,
+                extras_fpu.op_in, extras_fpu);
+          end
         end
         // sequencer instructions
         if (Xfrep) begin
           if (extras_fpu_seq_out.cbuf_push) begin
-            $sformat(trace_entry, "%t %1d %8d 0x%h DASM(%h) #; %s\n",
-                $time, cycle, i_snitch.priv_lvl_q, 32'hz, 64'hz,
-                snitch_pkg::print_fpu_sequencer_trace(extras_fpu_seq_out));
-            $fwrite(f, trace_entry);
+            if (trace_text) begin
+              $sformat(trace_entry, "%t %1d %8d 0x%h DASM(%h) #; %s\n",
+                  $time, cycle, i_snitch.priv_lvl_q, 32'hz, 64'hz,
+                  snitch_pkg::print_fpu_sequencer_trace(extras_fpu_seq_out));
+              $fwrite(f, trace_entry);
+            end else begin
+              snitch_trace_write(trace, $time * time_mult, cycle, snitch_pkg::SrcFpuSeq,
+                  i_snitch.priv_lvl_q, '0, '0, '0, extras_fpu_seq_out);
+            end
           end
         end
       end
@@ -919,7 +972,8 @@ module snitch_cc #(
   end
 
   final begin
-    $fclose(f);
+    if (trace_text) $fclose(f);
+    else snitch_trace_close(trace);
   end
   // verilog_lint: waive-stop always-ff-non-blocking
   // pragma translate_on
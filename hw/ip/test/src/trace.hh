@@ -0,0 +1,213 @@
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Solderpad Hardware License, Version 0.51, see LICENSE for details.
+// SPDX-License-Identifier: SHL-0.51
+
+// Binary instruction trace format written by the Snitch core complex tracer
+// (`snitch_cc.sv`) through the DPI functions in `trace_lib.cc`.
+//
+// A trace file `logs/trace_hart_<hartid>.bin` (`.bin.gz` if compressed)
+// starts with a `FileHeader`, followed by a sequence of records. Every record
+// is a fixed-width `RecordHeader` followed by `num_extras` 64-bit words which
+// hold the fields of the trace port of the record's source, in the order of
+// the `*_EXTRAS` tables below (which is the declaration order of the
+// `snitch_pkg::*_trace_port_t` structs). All values are little endian.
+//
+// `util/trace/bintrace.py` reads this format and converts it to the textual
+// `.dasm` traces, such that the existing trace pipeline keeps working. The
+// native annotator `util/trace/gen_trace` reads it directly.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace sim {
+namespace trace {
+
+// Bump on any change of the layout or of the extras tables.
+constexpr uint32_t VERSION = 1;
+constexpr char MAGIC[8] = {'S', 'N', 'T', 'R', 'A', 'C', 'E', '\0'};
+
+// Matches `snitch_pkg::trace_src_e`.
+enum Source : uint8_t {
+    SrcSnitch = 0,
+    SrcFpu = 1,
+    SrcFpuSeq = 2,
+};
+
+// Record flags.
+enum Flags : uint8_t {
+    // The record has a PC (records of the FPU and sequencer have none).
+    FlagPcValid = 1 << 0,
+    // The record has an instruction word (sequencer records have none).
+    FlagInsnValid = 1 << 1,
+    // The instruction word is printed with 64 bit (FPU records).
+    FlagInsnWide = 1 << 2,
+};
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t hart_id;
+};
+static_assert(sizeof(FileHeader) == 16, "unexpected trace file header size");
+
+struct RecordHeader {
+    // Simulation time in units of the default `$timeformat`.
+    uint64_t time;
+    // Cycle since the end of reset.
+    uint64_t cycle;
+    uint64_t insn;
+    uint32_t pc;
+    uint8_t source;
+    uint8_t priv;
+    uint8_t flags;
+    uint8_t num_extras;
+};
+static_assert(sizeof(RecordHeader) == 32, "unexpected trace record size");
+
+constexpr const char *SNITCH_EXTRAS[] = {
+    "source",       "stall",        "exception",    "rs1",
+    "rs2",          "rd",           "is_load",      "is_store",
+    "is_branch",    "pc_d",         "opa",          "opb",
+    "opa_select",   "opb_select",   "write_rd",     "csr_addr",
+    "writeback",    "gpr_rdata_1",  "ls_size",      "ld_result_32",
+    "lsu_rd",       "retire_load",  "alu_result",   "ls_amo",
+    "retire_acc",   "acc_pid",      "acc_pdata_32", "fpu_offload",
+    "is_seq_insn"};
+
+constexpr const char *FPU_EXTRAS[] = {
+    "source",       "acc_q_hs",     "fpu_out_hs",   "lsu_q_hs",
+    "op_in",        "rs1",          "rs2",          "rs3",
+    "rd",           "op_sel_0",     "op_sel_1",     "op_sel_2",
+    "src_fmt",      "dst_fmt",      "int_fmt",      "acc_qdata_0",
+    "acc_qdata_1",  "acc_qdata_2",  "op_0",         "op_1",
+    "op_2",         "use_fpu",      "fpu_in_rd",    "fpu_in_acc",
+    "ls_size",      "is_load",      "is_store",     "lsu_qaddr",
+    "lsu_rd",       "acc_wb_ready", "fpu_out_acc",  "fpr_waddr",
+    "fpr_wdata",    "fpr_we"};
+
+constexpr const char *FPU_SEQ_EXTRAS[] = {
+    "source",    "cbuf_push", "is_outer",  "max_inst",
+    "max_rpt",   "stg_max",   "stg_mask"};
+
+// Indices of the extras of a record.
+enum SnitchExtra : uint8_t {
+    SnitchSource,
+    SnitchStall,
+    SnitchException,
+    SnitchRs1,
+    SnitchRs2,
+    SnitchRd,
+    SnitchIsLoad,
+    SnitchIsStore,
+    SnitchIsBranch,
+    SnitchPcD,
+    SnitchOpa,
+    SnitchOpb,
+    SnitchOpaSelect,
+    SnitchOpbSelect,
+    SnitchWriteRd,
+    SnitchCsrAddr,
+    SnitchWriteback,
+    SnitchGprRdata1,
+    SnitchLsSize,
+    SnitchLdResult32,
+    SnitchLsuRd,
+    SnitchRetireLoad,
+    SnitchAluResult,
+    SnitchLsAmo,
+    SnitchRetireAcc,
+    SnitchAccPid,
+    SnitchAccPdata32,
+    SnitchFpuOffload,
+    SnitchIsSeqInsn,
+};
+
+enum FpuExtra : uint8_t {
+    FpuSource,
+    FpuAccQHs,
+    FpuFpuOutHs,
+    FpuLsuQHs,
+    FpuOpIn,
+    FpuRs1,
+    FpuRs2,
+    FpuRs3,
+    FpuRd,
+    FpuOpSel0,
+    FpuOpSel1,
+    FpuOpSel2,
+    FpuSrcFmt,
+    FpuDstFmt,
+    FpuIntFmt,
+    FpuAccQdata0,
+    FpuAccQdata1,
+    FpuAccQdata2,
+    FpuOp0,
+    FpuOp1,
+    FpuOp2,
+    FpuUseFpu,
+    FpuFpuInRd,
+    FpuFpuInAcc,
+    FpuLsSize,
+    FpuIsLoad,
+    FpuIsStore,
+    FpuLsuQaddr,
+    FpuLsuRd,
+    FpuAccWbReady,
+    FpuFpuOutAcc,
+    FpuFprWaddr,
+    FpuFprWdata,
+    FpuFprWe,
+};
+
+enum FpuSeqExtra : uint8_t {
+    FpuSeqSource,
+    FpuSeqCbufPush,
+    FpuSeqIsOuter,
+    FpuSeqMaxInst,
+    FpuSeqMaxRpt,
+    FpuSeqStgMax,
+    FpuSeqStgMask,
+};
+
+constexpr size_t NUM_SNITCH_EXTRAS =
+    sizeof(SNITCH_EXTRAS) / sizeof(SNITCH_EXTRAS[0]);
+constexpr size_t NUM_FPU_EXTRAS = sizeof(FPU_EXTRAS) / sizeof(FPU_EXTRAS[0]);
+constexpr size_t NUM_FPU_SEQ_EXTRAS =
+    sizeof(FPU_SEQ_EXTRAS) / sizeof(FPU_SEQ_EXTRAS[0]);
+// Width of the extras argument of `snitch_trace_write` in 64-bit words.
+constexpr size_t MAX_EXTRAS = NUM_FPU_EXTRAS;
+static_assert(SnitchIsSeqInsn + 1 == NUM_SNITCH_EXTRAS &&
+                  FpuFprWe + 1 == NUM_FPU_EXTRAS &&
+                  FpuSeqStgMask + 1 == NUM_FPU_SEQ_EXTRAS,
+              "extras indices out of sync with the tables");
+
+inline size_t num_extras(uint8_t source) {
+    switch (source) {
+        case SrcSnitch:
+            return NUM_SNITCH_EXTRAS;
+        case SrcFpu:
+            return NUM_FPU_EXTRAS;
+        case SrcFpuSeq:
+            return NUM_FPU_SEQ_EXTRAS;
+        default:
+            return 0;
+    }
+}
+
+inline const char *const *extras_names(uint8_t source) {
+    switch (source) {
+        case SrcSnitch:
+            return SNITCH_EXTRAS;
+        case SrcFpu:
+            return FPU_EXTRAS;
+        case SrcFpuSeq:
+            return FPU_SEQ_EXTRAS;
+        default:
+            return nullptr;
+    }
+}
+
+}  // namespace trace
+}  // namespace sim
@@ -0,0 +1,128 @@
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Solderpad Hardware License, Version 0.51, see LICENSE for details.
+// SPDX-License-Identifier: SHL-0.51
+
+// DPI functions of the binary instruction tracer, see `trace.hh` for the
+// format. Records are collected in a per-hart buffer and written in large
+// chunks. Compressed traces are piped through `gzip`, which runs in its own
+// process alongside the simulation.
+
+#include <stdio.h>
+#include <string.h>
+#include <svdpi.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "trace.hh"
+
+/// DPI Functions.
+extern "C" {
+void *snitch_trace_open(int hart_id, svBit compress);
+void snitch_trace_write(void *trace, long long time, long long cycle,
+                        char source, char priv, char flags, int pc,
+                        long long insn, const svBitVecVal *extras);
+void snitch_trace_close(void *trace);
+}
+
+namespace sim {
+namespace trace {
+
+class TraceWriter {
+   public:
+    static constexpr size_t BUF_SIZE = 1 << 20;
+
+    TraceWriter(uint32_t hart_id, bool compress) : compress(compress) {
+        char fn[64];
+        snprintf(fn, sizeof(fn), "logs/trace_hart_%05x.bin%s", hart_id,
+                 compress ? ".gz" : "");
+        if (compress) {
+            std::string cmd = std::string("gzip -1 -c > ") + fn;
+            file = popen(cmd.c_str(), "w");
+        } else {
+            file = fopen(fn, "wb");
+        }
+        if (!file) {
+            fprintf(stderr, "[Tracer] Failed to open %s\n", fn);
+            return;
+        }
+        buf.reserve(BUF_SIZE);
+        FileHeader header;
+        memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.hart_id = hart_id;
+        append(&header, sizeof(header));
+    }
+
+    ~TraceWriter() { close(); }
+
+    void append(const void *data, size_t len) {
+        if (buf.size() + len > BUF_SIZE) flush();
+        auto bytes = reinterpret_cast<const uint8_t *>(data);
+        buf.insert(buf.end(), bytes, bytes + len);
+    }
+
+    void flush() {
+        if (file && !buf.empty()) fwrite(buf.data(), 1, buf.size(), file);
+        buf.clear();
+    }
+
+    void close() {
+        if (!file) return;
+        flush();
+        if (compress) {
+            pclose(file);
+        } else {
+            fclose(file);
+        }
+        file = nullptr;
+    }
+
+   private:
+    FILE *file = nullptr;
+    bool compress;
+    std::vector<uint8_t> buf;
+};
+
+// Owns the writers, such that traces are flushed at exit even if the
+// simulator does not run `final` blocks.
+static std::vector<std::unique_ptr<TraceWriter>> writers;
+
+}  // namespace trace
+}  // namespace sim
+
+void *snitch_trace_open(int hart_id, svBit compress) {
+    sim::trace::writers.push_back(
+        std::make_unique<sim::trace::TraceWriter>(hart_id, compress));
+    return sim::trace::writers.back().get();
+}
+
+void snitch_trace_write(void *trace, long long time, long long cycle,
+                        char source, char priv, char flags, int pc,
+                        long long insn, const svBitVecVal *extras) {
+    using namespace sim::trace;
+    auto writer = static_cast<TraceWriter *>(trace);
+    RecordHeader header;
+    header.time = time;
+    header.cycle = cycle;
+    header.insn = insn;
+    header.pc = pc;
+    header.source = source;
+    header.priv = priv;
+    header.flags = flags;
+    header.num_extras = num_extras(source);
+    writer->append(&header, sizeof(header));
+    // The extras are a packed struct zero-extended to MAX_EXTRAS words, so
+    // the first field is the most significant word of the struct.
+    uint64_t words[MAX_EXTRAS];
+    for (size_t i = 0; i < header.num_extras; i++) {
+        size_t w = 2 * (header.num_extras - 1 - i);
+        words[i] = (uint64_t)extras[w + 1] << 32 | extras[w];
+    }
+    writer->append(words, header.num_extras * sizeof(uint64_t));
+}
+
+void snitch_trace_close(void *trace) {
+    static_cast<sim::trace::TraceWriter *>(trace)->close();
+}
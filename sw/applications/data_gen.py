@@ -11,6 +11,10 @@ import torch.nn as nn
 import argparse
 import pathlib
 import hjson
+import re
+import struct
+
+import graph_planner
 
 np.random.seed(42)
 torch.manual_seed(42)
@@ -30,6 +34,123 @@ def array_to_cstr(a):
     return out
 
 
+# C types of the precisions, FP8 values are emitted as the bits of E5M2 numbers
+ctypes = {
+    64: 'double',
+    32: 'float',
+    16: '__fp16',
+    8: 'char'
+}
+
+
+def to_fp8(a):
+    """Round to the nearest even E5M2 number, the upper byte of an FP16 number.
+    Returns the bits as uint8."""
+    bits = np.asarray(a, dtype=np.float16).view(np.uint16).astype(np.uint32)
+    bits = (bits + 0x7f + ((bits >> 8) & 1)) >> 8
+    return bits.astype(np.uint8)
+
+
+def quantize(a, prec):
+    """Round a float64 tensor to the values representable in `prec` bits."""
+    if prec == 64:
+        return a
+    if prec == 8:
+        bits = to_fp8(a.numpy()).astype(np.uint16) << 8
+        return torch.from_numpy(bits.view(np.float16).astype(np.float64))
+    return a.to(torch.float32 if prec == 32 else torch.float16).to(torch.float64)
+
+
+def fmap_to_cstr(a, prec):
+    if prec == 8:
+        return array_to_cstr(to_fp8(a.numpy()))
+    return array_to_cstr(a)
+
+
+# numpy types of the C types, FP8 values are stored as the bits of E5M2 numbers
+np_types = {
+    'double': np.float64,
+    'float': np.float32,
+    '__fp16': np.float16,
+    'char': np.uint8
+}
+
+# Binary tensor container, see `src/utils/tensor_file.h`. Tensors are aligned
+# to TENSOR_ALIGN bytes and described by a table of entries after the header.
+TENSOR_MAGIC = 0x42544e53  # "SNTB"
+TENSOR_VERSION = 1
+TENSOR_ALIGN = 64
+TENSOR_NAME_LEN = 48
+TENSOR_MAX_DIMS = 4
+TENSOR_HEADER = struct.Struct('<4I')
+TENSOR_ENTRY = struct.Struct(f'<{TENSOR_NAME_LEN}s2I{TENSOR_MAX_DIMS}I2Q')
+
+
+class TensorFile:
+    """Tensors of a header file, which are written into a binary container and
+    linked into the data section with `.incbin` instead of being emitted as C
+    arrays."""
+
+    def __init__(self):
+        self.tensors = []
+
+    def add(self, name, ctype, shape, data):
+        if len(name) >= TENSOR_NAME_LEN or len(shape) > TENSOR_MAX_DIMS:
+            raise ValueError(f'Tensor {name} can not be stored in the container')
+        self.tensors.append((name, ctype, shape, data.tobytes()))
+
+    def layout(self):
+        """Yields the tensors with the offsets of their data."""
+        offset = TENSOR_HEADER.size + len(self.tensors) * TENSOR_ENTRY.size
+        for name, ctype, shape, data in self.tensors:
+            offset = -(-offset // TENSOR_ALIGN) * TENSOR_ALIGN
+            yield name, ctype, shape, data, offset
+            offset += len(data)
+
+    def write(self, path):
+        layout = list(self.layout())
+        size = layout[-1][4] + len(layout[-1][3]) if layout else TENSOR_HEADER.size
+        with path.open('wb') as f:
+            f.write(TENSOR_HEADER.pack(TENSOR_MAGIC, TENSOR_VERSION, len(layout), size))
+            for name, ctype, shape, data, offset in layout:
+                dims = list(shape) + [1] * (TENSOR_MAX_DIMS - len(shape))
+                f.write(TENSOR_ENTRY.pack(name.encode(), np.dtype(np_types[ctype]).itemsize, len(shape), *dims,
+                                          offset, len(data)))
+            for name, ctype, shape, data, offset in layout:
+                f.write(bytes(offset - f.tell()))
+                f.write(data)
+
+    def emit_incbin(self, symbol, path):
+        """Links the container into the data section and defines the symbols of
+        the tensors within it. The container is referenced by its name only and
+        found through the data directory on the assembler search path, so that
+        the header does not depend on where the tree is checked out."""
+        layer_str = '#include "tensor_file.h"\n\n'
+        layer_str += f'TENSOR_FILE_INCBIN({symbol}, "{path.name}");\n'
+        for name, _, _, _, offset in self.layout():
+            layer_str += f'TENSOR_FILE_SYMBOL({symbol}, {name}, {offset});\n'
+        return layer_str + '\n'
+
+
+# Container of the current header file in binary mode, None otherwise
+tensor_file = None
+
+
+def emit_tensor(decl, a):
+    """Definition of the array `decl`, e.g. 'double x[2][3]', initialized with
+    the tensor a. In binary mode, the tensor is added to the container and only
+    declared."""
+    ctype, name, dims = re.fullmatch(r'(.+?)\s+(\w+)\s*((?:\[\d+\])*)', decl).groups()
+    if tensor_file is None:
+        init = fmap_to_cstr(a, 8) if ctype == 'char' else array_to_cstr(a)
+        return f'static {decl} = ' + init + ';\n\n\n'
+    if isinstance(a, torch.Tensor):
+        a = a.detach().numpy()
+    a = to_fp8(a) if ctype == 'char' else np.asarray(a, dtype=np_types[ctype])
+    tensor_file.add(name, ctype, [int(d) for d in re.findall(r'\d+', dims)], np.ascontiguousarray(a))
+    return f'extern {ctype} {name}{dims};\n\n\n'
+
+
 def emit_header_file(layer_type: str, **kwargs):
 
     file_path = pathlib.Path(__file__).parent / 'data'
@@ -49,9 +170,25 @@ def emit_header_file(layer_type: str, **kwargs):
     elif layer_type == 'MaxPool':
         file = file_path / 'data_maxpool.h'
         emit_str += emit_maxpool_layer(**kwargs)
+    elif layer_type == 'Transformer':
+        file = file_path / 'data_transformer.h'
+        emit_str += emit_transformer_layer(**kwargs)
     elif layer_type == 'FusedConv':
         file = file_path / 'data_fusedconv.h'
         emit_str += emit_fusedconv(**kwargs)
+    elif layer_type == 'ConvBlock':
+        file = file_path / 'data_convblock.h'
+        emit_str += emit_convblock(**kwargs)
+    elif layer_type == 'DwConv':
+        file = file_path / 'data_dwconv.h'
+        emit_str += emit_dwconv(**kwargs)
+    elif layer_type == 'Network':
+        file = file_path / 'data_network.h'
+        emit_str += emit_network(**kwargs)
+    if tensor_file is not None:
+        bin_file = file.with_suffix('.bin')
+        tensor_file.write(bin_file)
+        emit_str += tensor_file.emit_incbin(f'{file.stem}_tensors', bin_file)
     with file.open('w') as f:
         f.write(emit_str)
 
@@ -60,6 +197,8 @@ def emit_conv2d_layer(name='conv2d', **kwargs):
     ifmap = kwargs['ifmap']
     ofmap = kwargs['ofmap']
     weights = kwargs['weights']
+    prec = kwargs['prec']
+    dtype = ctypes[prec]
 
     n, ih, iw, ci = ifmap.shape
     _, oh, ow, co = ofmap.shape
@@ -75,14 +214,22 @@ def emit_conv2d_layer(name='conv2d', **kwargs):
     layer_str += f'\t.OH = {oh},\n'
     layer_str += f'\t.OW = {ow},\n'
     layer_str += f'\t.FH = {fh},\n'
-    layer_str += f'\t.FW = {fw}\n'
+    layer_str += f'\t.FW = {fw},\n'
+    layer_str += f'\t.dtype = FP{prec}\n'
     layer_str += '};\n\n\n'
 
-    layer_str += f'static double {name}_result[{oh}][{ow}][{co}] __attribute__((section(".data")));\n\n'
-    layer_str += f'static double {name}_checksum[{oh}][{ow}] = ' + array_to_cstr(torch.sum(ofmap, dim=-1)) + ';\n\n\n'
-    layer_str += f'static double {name}_ifmap_dram[{ih}][{iw}][{ci}] = ' + array_to_cstr(ifmap) + ';\n\n\n'
-    layer_str += f'static double {name}_weights_dram[{co}][{ci}][{fh}][{fw}] = ' + array_to_cstr(weights) + ';\n\n\n'
-    layer_str += f'static double {name}_ofmap_dram[{oh}][{ow}][{co}] = ' + array_to_cstr(ofmap) + ';\n\n\n'
+    layer_str += f'static {dtype} {name}_result[{oh}][{ow}][{co}] __attribute__((section(".data")));\n\n'
+    layer_str += emit_tensor(f'double {name}_checksum[{oh}][{ow}]', torch.sum(ofmap, dim=-1))
+    layer_str += emit_tensor(f'{dtype} {name}_ifmap_dram[{ih}][{iw}][{ci}]', ifmap)
+    layer_str += emit_tensor(f'{dtype} {name}_weights_dram[{co}][{ci}][{fh}][{fw}]', weights)
+    layer_str += emit_tensor(f'{dtype} {name}_ofmap_dram[{oh}][{ow}][{co}]', ofmap)
+
+    # Transformed filters of the Winograd convolution F(m x m, 3 x 3)
+    winograd = kwargs.get('winograd', {})
+    if winograd:
+        layer_str += f'#define {name.upper()}_WINOGRAD\n\n'
+    for m, u in winograd.items():
+        layer_str += emit_tensor(f'{dtype} {name}_winograd{m}_weights_dram[{u.shape[0]}][{co}][{ci}]', u)
 
     return layer_str
 
@@ -112,23 +259,26 @@ def emit_GEMM_layer(name='gemm', **kwargs):
     layer_str += f'\t.TA = {int(kwargs["ta"])},\n'
     layer_str += f'\t.TB = {int(kwargs["tb"])},\n'
     layer_str += f'\t.ALPHA = {kwargs["alpha"]},\n'
-    layer_str += f'\t.dtype = FP{kwargs["prec"]}\n'
+    if kwargs['tile'] is not None:
+        layer_str += f'\t.TILE_M = {kwargs["tile"]["m"]},\n'
+        layer_str += f'\t.TILE_N = {kwargs["tile"]["n"]},\n'
+        layer_str += f'\t.TILE_K = {kwargs["tile"]["k"]},\n'
+        layer_str += f'\t.TILE_PAD = {kwargs["tile"].get("pad", 0)},\n'
+        layer_str += f'\t.TILE_UNROLL = {kwargs["tile"].get("unroll", 8)},\n'
+    layer_str += f'\t.dtype = FP{kwargs["prec"]},\n'
+    layer_str += f'\t.expand = {int(kwargs["expand"])}\n'
     layer_str += '};\n\n\n'
 
-    ctypes = {
-        '64': 'double',
-        '32': 'float',
-        '16': '__fp16',
-        '8': 'char'
-    }
+    prec = kwargs['prec']
+    c_prec = 2 * prec if kwargs['expand'] else prec
+    dtype = ctypes[prec]
+    c_dtype = ctypes[c_prec]
 
-    dtype = ctypes[str(kwargs['prec'])]
-
-    layer_str += f'static {dtype} {name}_A_dram [{m}][{k}] = ' + array_to_cstr(mat_A) + ';\n\n\n'
-    layer_str += f'static {dtype} {name}_B_dram [{k}][{n}] = ' + array_to_cstr(mat_B) + ';\n\n\n'
-    layer_str += f'static {dtype} {name}_C_dram [{m}][{n}] = ' + array_to_cstr(mat_C) + ';\n\n\n'
-    layer_str += f'static {dtype} {name}_result[{m}][{n}] __attribute__((section(".data")));\n\n'
-    layer_str += f'static {dtype} {name}_checksum[{m}] = ' + array_to_cstr(torch.sum(result, dim=-1)) + ';\n\n\n'
+    layer_str += emit_tensor(f'{dtype} {name}_A_dram [{m}][{k}]', mat_A)
+    layer_str += emit_tensor(f'{dtype} {name}_B_dram [{k}][{n}]', mat_B)
+    layer_str += emit_tensor(f'{c_dtype} {name}_C_dram [{m}][{n}]', mat_C)
+    layer_str += f'static {c_dtype} {name}_result[{m}][{n}] __attribute__((section(".data")));\n\n'
+    layer_str += emit_tensor(f'double {name}_checksum[{m}]', torch.sum(result, dim=-1))
 
     return layer_str
 
@@ -139,6 +289,8 @@ def emit_batchnorm_layer(name='batchnorm', **kwargs):
     ofmap = kwargs['ofmap']
     beta = kwargs['beta']
     gamma = kwargs['gamma']
+    prec = kwargs['prec']
+    dtype = ctypes[prec]
 
     n, ih, iw, ci = ifmap.shape
     _, oh, ow, co = ofmap.shape
@@ -152,14 +304,15 @@ def emit_batchnorm_layer(name='batchnorm', **kwargs):
     layer_str += f'\t.IW = {iw},\n'
     layer_str += f'\t.OH = {oh},\n'
     layer_str += f'\t.OW = {ow},\n'
+    layer_str += f'\t.dtype = FP{prec}\n'
     layer_str += '};\n\n\n'
 
-    layer_str += f'static double {name}_result[{oh}][{ow}][{co}] __attribute__((section(".data")));\n\n'
-    layer_str += f'static double {name}_checksum[{oh}][{ow}] = ' + array_to_cstr(torch.sum(ofmap, dim=-1)) + ';\n\n\n'
-    layer_str += f'static double {name}_ifmap_dram[{ih}][{iw}][{ci}] = ' + array_to_cstr(ifmap) + ';\n\n\n'
-    layer_str += f'static double {name}_beta_dram[{ci}] = ' + array_to_cstr(beta) + ';\n\n\n'
-    layer_str += f'static double {name}_gamma_dram[{ci}] = ' + array_to_cstr(gamma) + ';\n\n\n'
-    layer_str += f'static double {name}_ofmap_dram[{oh}][{ow}][{co}] = ' + array_to_cstr(ofmap) + ';\n\n\n'
+    layer_str += f'static {dtype} {name}_result[{oh}][{ow}][{co}] __attribute__((section(".data")));\n\n'
+    layer_str += emit_tensor(f'double {name}_checksum[{oh}][{ow}]', torch.sum(ofmap, dim=-1))
+    layer_str += emit_tensor(f'{dtype} {name}_ifmap_dram[{ih}][{iw}][{ci}]', ifmap)
+    layer_str += emit_tensor(f'{dtype} {name}_beta_dram[{ci}]', beta)
+    layer_str += emit_tensor(f'{dtype} {name}_gamma_dram[{ci}]', gamma)
+    layer_str += emit_tensor(f'{dtype} {name}_ofmap_dram[{oh}][{ow}][{co}]', ofmap)
 
     return layer_str
 
@@ -168,7 +321,12 @@ def emit_maxpool_layer(name='maxpool', **kwargs):
 
     ifmap = kwargs['ifmap']
     ofmap = kwargs['ofmap']
+    avg = kwargs['avg']
+    glob = kwargs['global']
     k = kwargs['kernel_size']
+    stride = kwargs['stride']
+    prec = kwargs['prec']
+    dtype = ctypes[prec]
 
     n, ih, iw, ci = ifmap.shape
     _, oh, ow, co = ofmap.shape
@@ -184,12 +342,58 @@ def emit_maxpool_layer(name='maxpool', **kwargs):
     layer_str += f'\t.OW = {ow},\n'
     layer_str += f'\t.FH = {k},\n'
     layer_str += f'\t.FW = {k},\n'
+    layer_str += f'\t.stride = {stride},\n'
+    layer_str += f'\t.dtype = FP{prec}\n'
+    layer_str += '};\n\n\n'
+
+    layer_str += f'static {dtype} {name}_result[{oh}][{ow}][{co}] __attribute__((section(".data")));\n\n'
+    layer_str += emit_tensor(f'double {name}_checksum[{oh}][{ow}]', torch.sum(ofmap, dim=-1))
+    layer_str += emit_tensor(f'{dtype} {name}_ifmap_dram[{ih}][{iw}][{ci}]', ifmap)
+    layer_str += emit_tensor(f'{dtype} {name}_ofmap_dram[{oh}][{ow}][{co}]', ofmap)
+
+    # Average and global average pooling of the same ifmap
+    layer_str += f'static {dtype} {name}_avg_ofmap_dram[{oh}][{ow}][{co}] __attribute__((section(".data")));\n\n'
+    layer_str += emit_tensor(f'double {name}_avg_checksum[{oh}][{ow}]', torch.sum(avg, dim=-1))
+    layer_str += f'static {dtype} {name}_global_ofmap_dram[1][1][{co}] __attribute__((section(".data")));\n\n'
+    layer_str += emit_tensor(f'double {name}_global_checksum[1][1]', torch.sum(glob, dim=-1))
+
+    return layer_str
+
+
+def emit_transformer_layer(name='transformer', **kwargs):
+
+    ifmap = kwargs['ifmap']
+    prec = kwargs['prec']
+    dtype = ctypes[prec]
+
+    s, e = ifmap.shape
+    l, _ = kwargs['K'].shape
+    tile_s, tile_l = kwargs['tile']
+
+    layer_str = ''
+    layer_str += '#include "layer.h"\n\n'
+    layer_str += f'transformer_layer {name}_l = {{\n'
+    layer_str += f'\t.S = {s},\n'
+    layer_str += f'\t.E = {e},\n'
+    layer_str += f'\t.L = {l},\n'
+    layer_str += f'\t.eps = {kwargs["eps"]},\n'
+    layer_str += f'\t.scale = {kwargs["scale"]},\n'
+    layer_str += f'\t.TILE_S = {tile_s},\n'
+    layer_str += f'\t.TILE_L = {tile_l},\n'
+    layer_str += f'\t.dtype = FP{prec}\n'
     layer_str += '};\n\n\n'
 
-    layer_str += f'static double {name}_result[{oh}][{ow}][{co}] __attribute__((section(".data")));\n\n'
-    layer_str += f'static double {name}_checksum[{oh}][{ow}] = ' + array_to_cstr(torch.sum(ofmap, dim=-1)) + ';\n\n\n'
-    layer_str += f'static double {name}_ifmap_dram[{ih}][{iw}][{ci}] = ' + array_to_cstr(ifmap) + ';\n\n\n'
-    layer_str += f'static double {name}_ofmap_dram[{oh}][{ow}][{co}] = ' + array_to_cstr(ofmap) + ';\n\n\n'
+    layer_str += f'static {dtype} {name}_result[{s}][{e}] __attribute__((section(".data")));\n\n'
+    layer_str += emit_tensor(f'{dtype} {name}_ifmap_dram[{s}][{e}]', ifmap)
+    layer_str += emit_tensor(f'{dtype} {name}_gamma_dram[{e}]', kwargs['gamma'])
+    layer_str += emit_tensor(f'{dtype} {name}_beta_dram[{e}]', kwargs['beta'])
+    layer_str += emit_tensor(f'{dtype} {name}_q_dram[{s}][{e}]', kwargs['Q'])
+    layer_str += emit_tensor(f'{dtype} {name}_k_dram[{l}][{e}]', kwargs['K'])
+    layer_str += emit_tensor(f'{dtype} {name}_v_dram[{l}][{e}]', kwargs['V'])
+
+    # References of the layers, all of the same shape as the input
+    for ref in ('softmax', 'layernorm', 'gelu', 'attention'):
+        layer_str += emit_tensor(f'{dtype} {name}_{ref}_dram[{s}][{e}]', kwargs[ref])
 
     return layer_str
 
@@ -223,14 +427,7 @@ def emit_fusedconv(name='fusedconv', **kwargs):
         _, fh, fw, _ = kernel.shape
         ih_pad, iw_pad, _ = ifmap_padded.shape
 
-    ctypes = {
-        '64': 'double',
-        '32': 'float',
-        '16': '__fp16',
-        '8': 'char'
-    }
-
-    dtype = ctypes[str(kwargs['prec'])]
+    dtype = ctypes[kwargs['prec']]
 
     layer_str = '#include <stdint.h>\n'
     layer_str += '#include "conv2d.h"\n\n'
@@ -257,13 +454,280 @@ def emit_fusedconv(name='fusedconv', **kwargs):
     layer_str += f'uint32_t dw = {kwargs["depthwise"]};\n'
     layer_str += f'uint32_t chw_layer = {kwargs["chw_layer"]};\n'
 
-    layer_str += f'static {dtype} {name}_pInBuffer_dram[{ih_pad}][{iw_pad}][{ci}] = ' + \
-        array_to_cstr(ifmap_padded) + ';\n\n'
-    layer_str += f'static {dtype} {name}_pWeight_dram[{co}][{fh}][{fw}][{ci}] = {array_to_cstr(kernel)};\n\n'
-    layer_str += f'static {dtype} {name}_lambda_dram[{ci}] = {array_to_cstr(bn_l)};\n\n'
-    layer_str += f'static {dtype} {name}_kappa_dram[{ci}] = {array_to_cstr(bn_k)};\n\n'
-    layer_str += f'static {dtype} {name}_pOutBuffer_dram[{oh}][{ow}][{co}] = {array_to_cstr(ofmap_before)};\n\n'
-    layer_str += f'static {dtype} {name}_pCheckOutBuffer_dram[{oh}][{ow}][{co}] = {array_to_cstr(ofmap)};\n\n'
+    layer_str += emit_tensor(f'{dtype} {name}_pInBuffer_dram[{ih_pad}][{iw_pad}][{ci}]', ifmap_padded)
+    layer_str += emit_tensor(f'{dtype} {name}_pWeight_dram[{co}][{fh}][{fw}][{ci}]', kernel)
+    layer_str += emit_tensor(f'{dtype} {name}_lambda_dram[{ci}]', bn_l)
+    layer_str += emit_tensor(f'{dtype} {name}_kappa_dram[{ci}]', bn_k)
+    layer_str += emit_tensor(f'{dtype} {name}_pOutBuffer_dram[{oh}][{ow}][{co}]', ofmap_before)
+    layer_str += emit_tensor(f'{dtype} {name}_pCheckOutBuffer_dram[{oh}][{ow}][{co}]', ofmap)
+
+    return layer_str
+
+
+def emit_convblock(name='convblock', **kwargs):
+
+    ifmap = kwargs['ifmap']
+    weights = kwargs['weights']
+    gamma = kwargs['gamma']
+    beta = kwargs['beta']
+    pooled = kwargs['pooled']
+    ofmap = kwargs['ofmap']
+    pool = kwargs['pool']
+
+    padding = kwargs['padding']
+    stride = kwargs['stride']
+
+    n, ih, iw, ci = ifmap.shape
+    co, fh, fw, _ = weights.shape
+    oh = (ih + 2 * padding - fh) // stride + 1
+    ow = (iw + 2 * padding - fw) // stride + 1
+    _, poh, pow, _ = ofmap.shape
+
+    layer_str = ''
+    layer_str += '#include "layer.h"\n\n'
+    layer_str += f'conv_layer {name}_l = {{\n'
+    layer_str += f'\t.CO = {co},\n'
+    layer_str += f'\t.CI = {ci},\n'
+    layer_str += f'\t.IH = {ih},\n'
+    layer_str += f'\t.IW = {iw},\n'
+    layer_str += f'\t.OH = {oh},\n'
+    layer_str += f'\t.OW = {ow},\n'
+    layer_str += f'\t.FH = {fh},\n'
+    layer_str += f'\t.FW = {fw},\n'
+    layer_str += f'\t.pad = {padding},\n'
+    layer_str += f'\t.pool = {pool},\n'
+    layer_str += '\t.dtype = FP64\n'
+    layer_str += '};\n\n\n'
+
+    # Intermediate and output feature maps of the separate layers and the fused block
+    layer_str += f'static double {name}_conv_dram[{oh}][{ow}][{co}] __attribute__((section(".data")));\n\n'
+    layer_str += f'static double {name}_bn_dram[{oh}][{ow}][{co}] __attribute__((section(".data")));\n\n'
+    layer_str += f'static double {name}_pool_dram[{poh}][{pow}][{co}] __attribute__((section(".data")));\n\n'
+    layer_str += f'static double {name}_ofmap_dram[{poh}][{pow}][{co}] __attribute__((section(".data")));\n\n'
+    # The separate layers do not include a ReLU
+    layer_str += emit_tensor(f'double {name}_pool_checksum[{poh}][{pow}]', torch.sum(pooled, dim=-1))
+    layer_str += emit_tensor(f'double {name}_checksum[{poh}][{pow}]', torch.sum(ofmap, dim=-1))
+    layer_str += emit_tensor(f'double {name}_ifmap_dram[{ih}][{iw}][{ci}]', ifmap)
+    layer_str += emit_tensor(f'double {name}_weights_dram[{co}][{fh}][{fw}][{ci}]', weights)
+    layer_str += emit_tensor(f'double {name}_gamma_dram[{co}]', gamma)
+    layer_str += emit_tensor(f'double {name}_beta_dram[{co}]', beta)
+
+    return layer_str
+
+
+def emit_dwconv(name='dwconv', **kwargs):
+
+    ifmap = kwargs['ifmap']
+    dw_weights = kwargs['dw_weights']
+    pw_weights = kwargs['pw_weights']
+    dw = kwargs['dw']
+    ofmap = kwargs['ofmap']
+    prec = kwargs['prec']
+    dtype = ctypes[prec]
+
+    n, ih, iw, ci = ifmap.shape
+    fh, fw, _ = dw_weights.shape
+    co, _ = pw_weights.shape
+    _, oh, ow, _ = ofmap.shape
+
+    layer_str = ''
+    layer_str += '#include "layer.h"\n\n'
+    layer_str += f'conv_layer {name}_l = {{\n'
+    layer_str += f'\t.CO = {co},\n'
+    layer_str += f'\t.CI = {ci},\n'
+    layer_str += f'\t.IH = {ih},\n'
+    layer_str += f'\t.IW = {iw},\n'
+    layer_str += f'\t.OH = {oh},\n'
+    layer_str += f'\t.OW = {ow},\n'
+    layer_str += f'\t.FH = {fh},\n'
+    layer_str += f'\t.FW = {fw},\n'
+    layer_str += f'\t.pad = {kwargs["padding"]},\n'
+    layer_str += f'\t.conv_stride = {kwargs["stride"]},\n'
+    layer_str += f'\t.TILE_CI = {kwargs["tile_ci"]},\n'
+    layer_str += f'\t.dtype = FP{prec}\n'
+    layer_str += '};\n\n\n'
+
+    # Depthwise output of the separate layers, and pointwise outputs of the separate and fused layers
+    layer_str += f'static {dtype} {name}_dw_dram[{oh}][{ow}][{ci}] __attribute__((section(".data")));\n\n'
+    layer_str += f'static {dtype} {name}_pw_dram[{oh}][{ow}][{co}] __attribute__((section(".data")));\n\n'
+    layer_str += f'static {dtype} {name}_ofmap_dram[{oh}][{ow}][{co}] __attribute__((section(".data")));\n\n'
+    layer_str += emit_tensor(f'double {name}_dw_checksum[{oh}][{ow}]', torch.sum(dw, dim=-1))
+    layer_str += emit_tensor(f'double {name}_checksum[{oh}][{ow}]', torch.sum(ofmap, dim=-1))
+    layer_str += emit_tensor(f'{dtype} {name}_ifmap_dram[{ih}][{iw}][{ci}]', ifmap)
+    layer_str += emit_tensor(f'{dtype} {name}_dw_weights_dram[{fh}][{fw}][{ci}]', dw_weights)
+    layer_str += emit_tensor(f'{dtype} {name}_pw_weights_dram[{co}][{ci}]', pw_weights)
+
+    return layer_str
+
+
+def network_model(param):
+    """Build the torch model of the `layers` of a Network config."""
+    c = param['input_dim']['channels']
+    layers = []
+    for layer in param['layers']:
+        t = layer['type']
+        if t == 'Conv2d':
+            layers.append(nn.Conv2d(c, layer['out'], layer['kernel_size'], padding=layer.get('padding', 0),
+                                    bias=False, dtype=torch.float64))
+            c = layer['out']
+        elif t == 'BatchNorm':
+            bn = nn.BatchNorm2d(c, dtype=torch.float64)
+            bn.weight.data = torch.randn(c, dtype=torch.float64)
+            bn.bias.data = torch.randn(c, dtype=torch.float64)
+            bn.running_mean = torch.randn(c, dtype=torch.float64)
+            bn.running_var = torch.rand(c, dtype=torch.float64)
+            layers.append(bn)
+        elif t == 'MaxPool':
+            layers.append(nn.MaxPool2d(layer['kernel_size'], layer.get('stride')))
+        elif t == 'AvgPool':
+            layers.append(nn.AvgPool2d(layer['kernel_size'], layer.get('stride')))
+        elif t == 'GlobalAvgPool':
+            layers.append(nn.AdaptiveAvgPool2d(1))
+        elif t == 'Linear':
+            layers.append(nn.Flatten())
+            layers.append(nn.Linear(c, layer['out'], bias=False, dtype=torch.float64))
+            c = layer['out']
+        else:
+            raise ValueError(f'Unsupported layer {t}')
+    return nn.Sequential(*layers).eval()
+
+
+def network_graph(model, ifmap):
+    """Translate a sequential torch model into the nodes and tensors of the
+    graph runtime. Feature maps are stored in HWC format. Returns the nodes,
+    the tensors and the output of the model."""
+    tensors = [graph_planner.Tensor('input', ifmap.shape[1:], data=ifmap[0].permute(1, 2, 0))]
+    nodes = []
+    x = ifmap
+    chw = tuple(ifmap.shape[1:])
+    fmap = 0
+    count = {}
+
+    for m in model:
+        y = m(x)
+        if isinstance(m, nn.Flatten):
+            x = y
+            continue
+
+        kind = type(m).__name__.lower()
+        name = f'{kind}{count.get(kind, 0)}'
+        count[kind] = count.get(kind, 0) + 1
+
+        def param(suffix, data):
+            tensors.append(graph_planner.Tensor(f'{name}.{suffix}', data.shape, data=data, param=True))
+            return len(tensors) - 1
+
+        out_shape = y.shape[1:] if y.dim() == 2 else (y.shape[2], y.shape[3], y.shape[1])
+        tensors.append(graph_planner.Tensor(name, out_shape))
+        ops = {'ifmap': fmap, 'ofmap': len(tensors) - 1}
+
+        if isinstance(m, nn.Linear):
+            w = m.weight.detach()
+            k = w.shape[1]
+            # The columns follow the HWC order of the flattened feature map
+            c, h, w_ = chw
+            if h * w_ > 1:
+                w = w.reshape(-1, c, h, w_).permute(0, 2, 3, 1).reshape(-1, k)
+            ops['weights'] = param('weight', w)
+            params = {'M': 1, 'N': w.shape[0], 'K': k}
+            op = 'LINEAR'
+        else:
+            n, ci, ih, iw = x.shape
+            _, co, oh, ow = y.shape
+            params = {'CI': ci, 'CO': co, 'IH': ih, 'IW': iw, 'OH': oh, 'OW': ow}
+            if isinstance(m, nn.Conv2d):
+                if co % 8:
+                    raise ValueError(f'{name}: the number of output channels must be a multiple of 8')
+                fh, fw = m.kernel_size
+                params.update({'FH': fh, 'FW': fw, 'pad': m.padding[0]})
+                ops['weights'] = param('weight', m.weight.detach().permute(0, 2, 3, 1))
+                op = 'CONV2D'
+            elif isinstance(m, nn.BatchNorm2d):
+                gamma = m.weight.detach() / torch.sqrt(m.running_var + m.eps)
+                beta = m.bias.detach() - m.running_mean * gamma
+                ops['gamma'] = param('gamma', gamma)
+                ops['beta'] = param('beta', beta)
+                op = 'BATCHNORM'
+            elif isinstance(m, nn.AdaptiveAvgPool2d):
+                op = 'GLOBAL_AVGPOOL'
+            else:
+                params.update({'FH': m.kernel_size, 'FW': m.kernel_size, 'stride': m.stride})
+                op = 'MAXPOOL' if isinstance(m, nn.MaxPool2d) else 'AVGPOOL'
+            chw = (co, oh, ow)
+
+        nodes.append(graph_planner.Node(name, op, params, ops))
+        fmap = ops['ofmap']
+        x = y
+
+    return nodes, tensors, x
+
+
+def emit_network(name='network', **kwargs):
+    nodes = kwargs['nodes']
+    tensors = kwargs['tensors']
+    ofmap = kwargs['ofmap']
+
+    def cname(t):
+        return f'{name}_' + t.name.replace('.', '_') + '_dram'
+
+    def index(t):
+        return 'GRAPH_NO_TENSOR' if t is None else str(t)
+
+    layer_str = ''
+    layer_str += '#include "graph.h"\n'
+    layer_str += '#include "layer.h"\n\n'
+
+    for t in tensors:
+        if t.data is not None:
+            dims = ''.join(f'[{d}]' for d in t.shape)
+            layer_str += emit_tensor(f'double {cname(t)}{dims}', t.data)
+    layer_str += f'static double {name}_l3_arena[{kwargs["l3_size"] // 8}] __attribute__((section(".data")));\n\n'
+
+    layer_str += f'static const graph_tensor {name}_tensors[] = {{\n'
+    for t in tensors:
+        data = cname(t) if t.data is not None else 'NULL'
+        layer_str += f'\t{{.name = "{t.name}", .size = {t.bytes}, .mem = GRAPH_{t.mem}, .offset = {t.offset}, ' + \
+            f'.first = {t.first}, .data = {data}}},\n'
+    layer_str += '};\n\n'
+
+    layer_str += f'static const graph_node {name}_nodes[] = {{\n'
+    for n in nodes:
+        fields = ', '.join(f'.{k} = {v}' for k, v in n.params.items())
+        if n.op == 'LINEAR':
+            layer_str += f'\t{{.name = "{n.name}", .op = GRAPH_LINEAR, .gemm = {{{fields}, .TB = 1, .dtype = FP64}},\n'
+        else:
+            layer_str += f'\t{{.name = "{n.name}", .op = GRAPH_{n.op}, .conv = {{{fields}, .dtype = FP64}},\n'
+        layer_str += f'\t .ifmap = {n.tensors["ifmap"]}, .ofmap = {n.tensors["ofmap"]}, ' + \
+            f'.weights = {index(n.tensors.get("weights"))}, .gamma = {index(n.tensors.get("gamma"))}, ' + \
+            f'.beta = {index(n.tensors.get("beta"))}, .tcdm = {n.tcdm}}},\n'
+    layer_str += '};\n\n'
+
+    layer_str += f'graph {name}_graph = {{\n'
+    layer_str += f'\t.tensors = {name}_tensors,\n'
+    layer_str += f'\t.num_tensors = {len(tensors)},\n'
+    layer_str += f'\t.nodes = {name}_nodes,\n'
+    layer_str += f'\t.num_nodes = {len(nodes)},\n'
+    layer_str += f'\t.l3_arena = (char *){name}_l3_arena,\n'
+    layer_str += f'\t.l3_size = {kwargs["l3_size"]},\n'
+    layer_str += f'\t.l1_size = {kwargs["l1_size"]},\n'
+    layer_str += f'\t.l1_peak = {kwargs["l1_peak"]},\n'
+    layer_str += f'\t.output = {nodes[-1].tensors["ofmap"]}\n'
+    layer_str += '};\n\n\n'
+
+    # The output is checked like the ofmap of a layer, the one of a linear
+    # layer is a single pixel
+    if ofmap.dim() == 2:
+        ofmap = ofmap.reshape(1, 1, 1, -1)
+    else:
+        ofmap = ofmap.permute(0, 2, 3, 1)
+    _, oh, ow, co = ofmap.shape
+    layer_str += f'conv_layer {name}_out_l = {{\n'
+    layer_str += f'\t.CO = {co},\n'
+    layer_str += f'\t.OH = {oh},\n'
+    layer_str += f'\t.OW = {ow},\n'
+    layer_str += '\t.dtype = FP64\n'
+    layer_str += '};\n\n\n'
+    layer_str += emit_tensor(f'double {name}_checksum[{oh}][{ow}]', torch.sum(ofmap, dim=-1))
 
     return layer_str
 
@@ -272,7 +736,7 @@ def conv2d(ifmap, weights, padding=1, stride=1):
     n, ci, ih, iw = ifmap.shape
     co, _, fh, fw = weights.shape
 
-    conv2d = nn.Conv2d(ci, co, (fh, fw), padding=((fh-1)//2, (fw-1)//2))
+    conv2d = nn.Conv2d(ci, co, (fh, fw), padding=padding, stride=stride)
     conv2d.weight = nn.Parameter(weights, requires_grad=False)
     conv2d.bias = nn.Parameter(torch.zeros_like(conv2d.bias, dtype=weights.dtype), requires_grad=False)
     ofmap = conv2d(ifmap)
@@ -280,9 +744,24 @@ def conv2d(ifmap, weights, padding=1, stride=1):
     return ofmap
 
 
-def max_pooling(ifmap, kernel):
+# Filter transform matrices G of the Winograd convolution F(m x m, 3 x 3)
+winograd_G = {
+    2: [[1, 0, 0], [1/2, 1/2, 1/2], [1/2, -1/2, 1/2], [0, 0, 1]],
+    4: [[1/4, 0, 0], [-1/6, -1/6, -1/6], [-1/6, 1/6, -1/6], [1/24, 1/12, 1/6], [1/24, -1/12, 1/6], [0, 0, 1]],
+}
+
+
+def winograd_filter(weights, m):
+    """Transform CO x CI x 3 x 3 filters into G g G^T, returned in the
+    a*a x CO x CI format of the Winograd layer, a = m + 2."""
+    G = torch.tensor(winograd_G[m], dtype=torch.float64)
+    u = torch.einsum('xp,oipq,yq->xyoi', G, weights, G)
+    return u.reshape(-1, *weights.shape[:2])
+
+
+def max_pooling(ifmap, kernel, stride=None):
     n, ci, ih, iw = ifmap.shape
-    max_pool = nn.MaxPool2d(kernel_size=kernel)
+    max_pool = nn.MaxPool2d(kernel_size=kernel, stride=stride)
     ofmap = max_pool(ifmap)
 
     return ofmap
@@ -378,12 +857,22 @@ def main():
         action='store_true',
         help='Set verbose'
     )
+    parser.add_argument(
+        "-b",
+        "--binary",
+        action='store_true',
+        help='Store the tensors in a binary container linked with .incbin'
+    )
 
     args = parser.parse_args()
 
     global verbose
     verbose = args.verbose
 
+    global tensor_file
+    if args.binary:
+        tensor_file = TensorFile()
+
     with args.cfg.open() as f:
         param = hjson.loads(f.read())
 
@@ -394,33 +883,56 @@ def main():
     else:
         dtype = torch.float32
 
+    # The inputs of the Conv2d, BatchNorm, MaxPool and GEMM layers are rounded to the
+    # precision of the layer, while the reference is computed in FP64
+    prec = param['prec']
+
     if param['kernel'] == 'Conv2d':
         ifmap = torch.randn(1, param['channels']['in'],
                             param['input_dim']['height'],
-                            param['input_dim']['width'], requires_grad=False, dtype=dtype)
+                            param['input_dim']['width'], requires_grad=False, dtype=torch.float64)
         weights = torch.randn(param['channels']['out'],
                               param['channels']['in'],
                               param['filter']['height'],
-                              param['filter']['width'], requires_grad=False, dtype=dtype)
+                              param['filter']['width'], requires_grad=False, dtype=torch.float64)
+        ifmap = quantize(ifmap, prec)
+        weights = quantize(weights, prec)
 
         ofmap = conv2d(ifmap, weights,
                        padding=param['filter']['padding'],
                        stride=param['filter']['stride'])
 
+        # The Winograd layer supports 3x3 filters with stride 1 in FP64 and
+        # FP32, the transformed filters are rounded to the precision
+        winograd = {}
+        if weights.shape[2:] == (3, 3) and param['filter']['stride'] == 1 and prec in (64, 32):
+            winograd = {m: quantize(winograd_filter(weights, m), prec) for m in (2, 4)}
+
         # convert from CHW to HWC format
         ifmap = ifmap.permute(0, 2, 3, 1)
         ofmap = ofmap.permute(0, 2, 3, 1)
         weights = weights.permute(0, 2, 3, 1)
-        kwargs = {'ifmap': ifmap, 'weights': weights, 'ofmap': ofmap}
+        kwargs = {'ifmap': ifmap, 'weights': weights, 'ofmap': ofmap, 'prec': prec, 'winograd': winograd}
         emit_header_file('Conv2d', **kwargs)
 
     elif param['kernel'] == 'GEMM':
-        mat_A = torch.randn(param['M'], param['K'], requires_grad=False, dtype=dtype)
-        mat_B = torch.randn(param['K'], param['N'], requires_grad=False, dtype=dtype)
-        mat_C = torch.randn(param['M'], param['N'], requires_grad=False, dtype=dtype)
+        # Expanding kernels accumulate and store C in twice the precision
+        expand = param.get('expand', False)
+        c_prec = 2 * prec if expand else prec
+
+        mat_A = torch.randn(param['M'], param['K'], requires_grad=False, dtype=torch.float64)
+        mat_B = torch.randn(param['K'], param['N'], requires_grad=False, dtype=torch.float64)
+        mat_C = torch.randn(param['M'], param['N'], requires_grad=False, dtype=torch.float64)
+        mat_A = quantize(mat_A, prec)
+        mat_B = quantize(mat_B, prec)
+        mat_C = quantize(mat_C, c_prec)
 
         result = param['alpha'] * mat_C + torch.matmul(mat_A, mat_B)
 
+        if verbose:
+            error = torch.max(torch.abs(quantize(result, c_prec) - result))
+            print(f'Max error of the result rounded to FP{c_prec}: {error}')
+
         if param['transpose_A']:
             mat_A = mat_A.T
         if param['transpose_B']:
@@ -437,7 +949,9 @@ def main():
             'ta': param['transpose_A'],
             'tb': param['transpose_B'],
             'alpha': param['alpha'],
-            'prec': param['prec']
+            'prec': prec,
+            'expand': expand,
+            'tile': param.get('tile')
         }
 
         emit_header_file('GEMM', **kwargs)
@@ -445,31 +959,186 @@ def main():
     elif param['kernel'] == 'BatchNorm':
         ifmap = torch.randn(1, param['channels']['in'],
                             param['input_dim']['height'],
-                            param['input_dim']['width'], requires_grad=False, dtype=dtype)
+                            param['input_dim']['width'], requires_grad=False, dtype=torch.float64)
+        ifmap = quantize(ifmap, prec)
 
-        ofmap, gamma, beta = batchnorm(ifmap)
+        _, gamma, beta = batchnorm(ifmap)
+        gamma = quantize(gamma, prec)
+        beta = quantize(beta, prec)
+        ofmap = ifmap * gamma.unsqueeze(-1).unsqueeze(-1) + beta.unsqueeze(-1).unsqueeze(-1)
 
         # convert from CHW to HWC format
         ifmap = ifmap.permute(0, 2, 3, 1)
         ofmap = ofmap.permute(0, 2, 3, 1)
 
-        kwargs = {'ifmap': ifmap, 'beta': beta, 'gamma': gamma, 'ofmap': ofmap}
+        kwargs = {'ifmap': ifmap, 'beta': beta, 'gamma': gamma, 'ofmap': ofmap, 'prec': prec}
         emit_header_file('BatchNorm', **kwargs)
 
     elif param['kernel'] == 'MaxPool':
         ifmap = torch.randn(1, param['channels']['in'],
                             param['input_dim']['height'],
-                            param['input_dim']['width'], requires_grad=False, dtype=dtype)
+                            param['input_dim']['width'], requires_grad=False, dtype=torch.float64)
+        ifmap = quantize(ifmap, prec)
 
-        ofmap = max_pooling(ifmap, param['kernel_size'])
+        k = param['kernel_size']
+        stride = param.get('stride', k)
+        ofmap = max_pooling(ifmap, k, stride)
+        avg = torch.nn.functional.avg_pool2d(ifmap, k, stride)
+        glob = torch.mean(ifmap, dim=(2, 3), keepdim=True)
 
         # convert from CHW to HWC format
         ifmap = ifmap.permute(0, 2, 3, 1)
         ofmap = ofmap.permute(0, 2, 3, 1)
+        avg = avg.permute(0, 2, 3, 1)
+        glob = glob.permute(0, 2, 3, 1)
 
-        kwargs = {'ifmap': ifmap, 'ofmap': ofmap, 'kernel_size': param['kernel_size']}
+        kwargs = {'ifmap': ifmap, 'ofmap': ofmap, 'avg': avg, 'global': glob, 'kernel_size': k, 'stride': stride,
+                  'prec': prec}
         emit_header_file('MaxPool', **kwargs)
 
+    elif param['kernel'] == 'Transformer':
+        if prec != 64:
+            print('Transformer layers only support FP64')
+            return
+
+        s = param['seq_len']
+        e = param['embed_dim']
+        l_kv = param['kv_len']
+        eps = param.get('eps', 1e-5)
+        scale = e ** -0.5
+
+        # The references are computed by the torch modules
+        ifmap = torch.randn(s, e, requires_grad=False, dtype=torch.float64)
+        q = torch.randn(s, e, requires_grad=False, dtype=torch.float64)
+        k = torch.randn(l_kv, e, requires_grad=False, dtype=torch.float64)
+        v = torch.randn(l_kv, e, requires_grad=False, dtype=torch.float64)
+
+        layernorm = nn.LayerNorm(e, eps=eps, dtype=torch.float64)
+        with torch.no_grad():
+            layernorm.weight.copy_(torch.randn(e, dtype=torch.float64))
+            layernorm.bias.copy_(torch.randn(e, dtype=torch.float64))
+
+            kwargs = {
+                'ifmap': ifmap,
+                'gamma': layernorm.weight.detach(),
+                'beta': layernorm.bias.detach(),
+                'Q': q,
+                'K': k,
+                'V': v,
+                'softmax': nn.Softmax(dim=-1)(ifmap),
+                'layernorm': layernorm(ifmap),
+                'gelu': nn.GELU(approximate='tanh')(ifmap),
+                'attention': torch.matmul(nn.Softmax(dim=-1)(torch.matmul(q, k.T) * scale), v),
+                'eps': eps,
+                'scale': scale,
+                'tile': (param['tile']['seq'], param['tile']['kv']),
+                'prec': prec
+            }
+        emit_header_file('Transformer', **kwargs)
+
+    elif param['kernel'] == 'ConvBlock':
+        padding = param['filter']['padding']
+        stride = param['filter']['stride']
+        if stride != 1:
+            print('The conv block layer only supports a stride of 1')
+            return
+
+        ifmap = torch.randn(1, param['channels']['in'],
+                            param['input_dim']['height'],
+                            param['input_dim']['width'], requires_grad=False, dtype=dtype)
+        weights = torch.randn(param['channels']['out'],
+                              param['channels']['in'],
+                              param['filter']['height'],
+                              param['filter']['width'], requires_grad=False, dtype=dtype)
+
+        conv = conv2d(ifmap, weights, padding=padding, stride=stride)
+        bn, gamma, beta = batchnorm(conv)
+        pooled = max_pooling(bn, param['pool'])
+        ofmap = torch.nn.functional.relu(pooled)
+
+        # convert from CHW to HWC format
+        ifmap = ifmap.permute(0, 2, 3, 1)
+        weights = weights.permute(0, 2, 3, 1)
+        pooled = pooled.permute(0, 2, 3, 1)
+        ofmap = ofmap.permute(0, 2, 3, 1)
+
+        kwargs = {
+            'ifmap': ifmap,
+            'weights': weights,
+            'gamma': gamma,
+            'beta': beta,
+            'pooled': pooled,
+            'ofmap': ofmap,
+            'padding': padding,
+            'stride': stride,
+            'pool': param['pool']
+        }
+        emit_header_file('ConvBlock', **kwargs)
+
+    elif param['kernel'] == 'DwConv':
+        if prec not in (64, 32, 16):
+            print('Depthwise and pointwise layers only support FP64, FP32 and FP16')
+            return
+
+        ci = param['channels']['in']
+        co = param['channels']['out']
+        padding = param['filter']['padding']
+        stride = param['filter']['stride']
+        ifmap = torch.randn(1, ci, param['input_dim']['height'], param['input_dim']['width'],
+                            requires_grad=False, dtype=torch.float64)
+        dw_weights = torch.randn(ci, 1, param['filter']['height'], param['filter']['width'],
+                                 requires_grad=False, dtype=torch.float64)
+        pw_weights = torch.randn(co, ci, 1, 1, requires_grad=False, dtype=torch.float64)
+        ifmap = quantize(ifmap, prec)
+        dw_weights = quantize(dw_weights, prec)
+        pw_weights = quantize(pw_weights, prec)
+
+        dw = torch.nn.functional.conv2d(ifmap, dw_weights, padding=padding, stride=stride, groups=ci)
+        ofmap = torch.nn.functional.conv2d(dw, pw_weights)
+
+        # convert from CHW to HWC format, the depthwise filters to FH x FW x CI
+        kwargs = {
+            'ifmap': ifmap.permute(0, 2, 3, 1),
+            'dw_weights': dw_weights[:, 0].permute(1, 2, 0),
+            'pw_weights': pw_weights[:, :, 0, 0],
+            'dw': dw.permute(0, 2, 3, 1),
+            'ofmap': ofmap.permute(0, 2, 3, 1),
+            'padding': padding,
+            'stride': stride,
+            'tile_ci': param.get('tile_ci', ci),
+            'prec': prec
+        }
+        emit_header_file('DwConv', **kwargs)
+
+    elif param['kernel'] == 'Network':
+        if prec != 64:
+            raise ValueError('The graph runtime only supports FP64 networks')
+        model = network_model(param)
+        ifmap = torch.randn(1, param['input_dim']['channels'],
+                            param['input_dim']['height'],
+                            param['input_dim']['width'], requires_grad=False, dtype=torch.float64)
+        with torch.no_grad():
+            nodes, tensors, ofmap = network_graph(model, ifmap)
+
+        l1_size = param.get('l1_size', 0x1c000)
+        l3_size, l1_peak = graph_planner.plan(nodes, tensors, cores=param.get('cores', 8), l1_size=l1_size)
+        if verbose:
+            for n in nodes:
+                print(f'{n.name}: {n.params}, {n.footprint} bytes of TCDM')
+            for t in tensors:
+                print(f'{t.name}: {t.bytes} bytes in {t.mem} at {t.offset}, nodes {t.first} to {t.last}')
+            print(f'L3 arena: {l3_size} bytes, TCDM peak: {l1_peak} bytes')
+
+        kwargs = {
+            'nodes': nodes,
+            'tensors': tensors,
+            'ofmap': ofmap,
+            'l3_size': l3_size,
+            'l1_size': l1_size,
+            'l1_peak': l1_peak
+        }
+        emit_header_file('Network', **kwargs)
+
     elif param['kernel'] == 'FusedConv':
         ifmap = torch.randn(param['dim_in_y'], param['dim_in_x'], param['ch_in'], requires_grad=False, dtype=dtype)
         if not param['depthwise']:
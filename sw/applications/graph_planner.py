@@ -0,0 +1,188 @@
+# Copyright 2022 ETH Zurich and University of Bologna.
+# Licensed under the Apache License, Version 2.0, see LICENSE for details.
+# SPDX-License-Identifier: Apache-2.0
+
+# Offline memory planner of the graph runtime (`src/graph`). Given the nodes
+# of a network, it chooses the tiling of every layer and assigns every tensor
+# to main memory (L3) or the TCDM (L1):
+#
+# - Feature maps are placed in an L3 arena. Tensors whose lifetimes do not
+#   overlap share the same addresses.
+# - Parameters stay in place in L3 unless they fit into the TCDM left over by
+#   the layers, in which case the executor prefetches them into L1 while the
+#   node before their first use computes. The layers allocate their buffers
+#   from the start of the TCDM, the L1 tensors are therefore placed from its
+#   end downwards.
+#
+# The footprints mirror the buffer allocation of the layers in `src/layers`.
+
+ALIGN = 64
+
+
+def align_up(x, a=ALIGN):
+    return (x + a - 1) // a * a
+
+
+class Tensor:
+    def __init__(self, name, shape, size=8, data=None, param=False):
+        self.name = name
+        self.shape = tuple(shape)
+        self.bytes = size
+        for d in shape:
+            self.bytes *= d
+        # Constant data in L3 of the input of the network or a parameter,
+        # feature maps have none
+        self.data = data
+        self.param = param
+        self.first = None
+        self.last = None
+        self.mem = 'L3'
+        self.offset = 0
+
+
+class Node:
+    """A layer of the network. `params` are the fields of its layer struct,
+    `tensors` maps the operands (ifmap, ofmap, weights, gamma, beta) to the
+    tensors of the graph."""
+    def __init__(self, name, op, params, tensors):
+        self.name = name
+        self.op = op
+        self.params = params
+        self.tensors = tensors
+        self.footprint = 0
+        self.tcdm = 0
+
+
+def conv2d_footprint(p, size, cores):
+    row_pad = 8 // size
+    k = p['FH'] * p['FW'] * p['TILE_CI']
+    im2col = 2 * cores * (k + row_pad) * size
+    ifmap = 2 * p['FH'] * align_up(p['TILE_CI'] * (cores + p['FW'] - 1) * size)
+    weights = cores * (k + row_pad) * size
+    ofmap = 2 * align_up(cores * 8 * size)
+    return im2col + ifmap + weights + ofmap + 8
+
+
+def batchnorm_footprint(p, size, cores):
+    return (4 * p['IW'] * p['TILE_CI'] + 2 * p['CI']) * size
+
+
+def pool_footprint(p, size, cores):
+    return (2 * p['FH'] * p['FW'] * p['TILE_CI'] + 2 * p['TILE_CI']) * size
+
+
+def global_pool_footprint(p, size, cores):
+    return (2 * p['IH'] * p['IW'] * p['TILE_CI'] + 2 * p['TILE_CI']) * size
+
+
+def linear_footprint(p, size, cores, l1_size):
+    """The GEMM layer picks its tiles at run time from the TCDM it is given.
+    Ask for the double-buffered tiles of the whole problem, but at most half
+    of the TCDM."""
+    m = align_up(p['M'], cores)
+    n = align_up(p['N'], 8)
+    full = 2 * (align_up(m * p['K'] * size) + align_up(n * p['K'] * size) + align_up(m * n * size))
+    return min(full, l1_size // 2)
+
+
+FOOTPRINTS = {
+    'CONV2D': conv2d_footprint,
+    'BATCHNORM': batchnorm_footprint,
+    'MAXPOOL': pool_footprint,
+    'AVGPOOL': pool_footprint,
+    'GLOBAL_AVGPOOL': global_pool_footprint,
+}
+
+
+def choose_tiling(node, size, cores, l1_size, max_tile_bytes):
+    """Largest tile of input channels of at most `max_tile_bytes` which
+    divides CI and keeps the footprint within the TCDM. The tiles of the
+    BatchNorm and pooling layers hold a multiple of `cores` 64-bit words, the
+    ones of the convolution whole 64-bit words."""
+    if node.op == 'LINEAR':
+        node.footprint = linear_footprint(node.params, size, cores, l1_size)
+        return
+    p = node.params
+    grain = 8 // size if node.op == 'CONV2D' else cores * 8 // size
+    if p['CI'] % grain:
+        raise ValueError(f'{node.name}: CI must be a multiple of {grain}')
+    tile = p['CI']
+    while True:
+        p['TILE_CI'] = tile
+        node.footprint = FOOTPRINTS[node.op](p, size, cores)
+        if tile * size <= max_tile_bytes and node.footprint <= l1_size:
+            return
+        tile -= grain
+        while tile >= grain and p['CI'] % tile:
+            tile -= grain
+        if tile < grain:
+            raise ValueError(f'{node.name}: does not fit into {l1_size} bytes of TCDM')
+
+
+def lifetimes(nodes, tensors):
+    for i, node in enumerate(nodes):
+        for t in node.tensors.values():
+            t = tensors[t]
+            t.first = i if t.first is None else t.first
+            t.last = i
+
+
+def place_l1(nodes, tensors, l1_size):
+    """Place parameters into the TCDM above the footprints of the nodes during
+    which they are live (including the node prefetching them), from the end of
+    the TCDM downwards. Returns the peak TCDM usage."""
+    placed = []
+    for t in tensors:
+        if not t.param:
+            continue
+        start = max(t.first - 1, 0)
+        live = range(start, t.last + 1)
+        floor = max(nodes[i].footprint for i in live)
+        # Candidate tops: the end of the TCDM and the bottoms of the placed
+        # tensors overlapping in time
+        others = [o for o in placed if o[1] <= t.last and start <= o[2]]
+        tops = [l1_size] + [o[0].offset for o in others]
+        for top in sorted(tops, reverse=True):
+            offset = (top - t.bytes) // ALIGN * ALIGN
+            if offset < floor:
+                continue
+            if all(offset + t.bytes <= o[0].offset or o[0].offset + o[0].bytes <= offset for o in others):
+                t.mem = 'L1'
+                t.offset = offset
+                placed.append((t, start, t.last))
+                break
+
+    peak = 0
+    for i, node in enumerate(nodes):
+        live = [o[0].offset for o in placed if o[1] <= i <= o[2]]
+        node.tcdm = min(live + [l1_size])
+        peak = max(peak, node.footprint + sum(o[0].bytes for o in placed if o[1] <= i <= o[2]))
+    return peak
+
+
+def place_l3(tensors):
+    """First-fit placement of the feature maps into the L3 arena, largest
+    first. Returns the size of the arena."""
+    placed = []
+    fmaps = [t for t in tensors if t.data is None]
+    for t in sorted(fmaps, key=lambda t: -t.bytes):
+        others = sorted((o for o in placed if o.first <= t.last and t.first <= o.last), key=lambda o: o.offset)
+        offset = 0
+        for o in others:
+            if offset + t.bytes <= o.offset:
+                break
+            offset = max(offset, align_up(o.offset + o.bytes))
+        t.offset = offset
+        placed.append(t)
+    return max([align_up(t.offset + t.bytes) for t in placed] + [0])
+
+
+def plan(nodes, tensors, size=8, cores=8, l1_size=0x1c000, max_tile_bytes=256):
+    """Choose the tilings and place the tensors. Returns the size of the L3
+    arena and the peak TCDM usage in bytes."""
+    for node in nodes:
+        choose_tiling(node, size, cores, l1_size, max_tile_bytes)
+    lifetimes(nodes, tensors)
+    l1_peak = place_l1(nodes, tensors, l1_size)
+    l3_size = place_l3(tensors)
+    return l3_size, l1_peak
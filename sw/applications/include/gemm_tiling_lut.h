@@ -0,0 +1,12 @@
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+// Tuned GEMM tilings, generated by `tune_gemm.py` from the output of the GEMM
+// testbench in tuning mode. Problems without an entry use the cost model.
+// Format: {M, N, K, dtype, TA, TB, clusters, cores, {TILE_M, TILE_N, TILE_K,
+// PAD, UNROLL}},
+
+#pragma once
+
+#define GEMM_TILING_LUT_ENTRIES
@@ -29,6 +29,11 @@ typedef enum { FP64 = 8, FP32 = 4, FP16 = 2, FP8 = 1 } precision_t;
  * Tile factor across N dimension
  * @var gemm_layer_struct::TILE_K
  * Tile factor across K dimension
+ * @var gemm_layer_struct::TILE_PAD
+ * Row padding of the tiles in TCDM, only used if the tile factors are set
+ * @var gemm_layer_struct::TILE_UNROLL
+ * Columns of C per FREP block of the kernel, only used if the tile factors are
+ * set (8 if zero)
  * @var gemm_layer_struct::A
  * Pointer to matrix A
  * @var gemm_layer_struct::B
@@ -39,6 +44,9 @@ typedef enum { FP64 = 8, FP32 = 4, FP16 = 2, FP8 = 1 } precision_t;
  * constant factor: A * B + ALPHA * C
  * @var gemm_layer_struct::dtype
  * Precision of GEMM
+ * @var gemm_layer_struct::expand
+ * Accumulate and store C in twice the precision of A and B, only supported
+ * for FP16 (FP32 C) and FP8 (FP16 C)
  */
 typedef struct gemm_layer_struct {
     uint32_t M;
@@ -52,6 +60,8 @@ typedef struct gemm_layer_struct {
     uint32_t TILE_M;
     uint32_t TILE_N;
     uint32_t TILE_K;
+    uint32_t TILE_PAD;
+    uint32_t TILE_UNROLL;
 
     double *A;
     double *B;
@@ -60,6 +70,7 @@ typedef struct gemm_layer_struct {
     uint32_t ALPHA;
 
     precision_t dtype;
+    uint32_t expand;
 } gemm_layer;
 
 /**
@@ -84,22 +95,37 @@ typedef struct gemm_layer_struct {
  * Width of filter
  * @var conv_layer_struct::pad
  * Padding on all sides
+ * @var conv_layer_struct::conv_stride
+ * Stride of the convolution, which is 1 if 0. Only the depthwise convolution
+ * supports strides other than 1.
  * @var conv_layer_struct::ifmap
  * Pointer to input feature map
  * @var conv_layer_struct::weights
  * Pointer to weights
  * @var conv_layer_struct::ofmap
  * Pointer to output feature map
+ * @var conv_layer_struct::pw_weights
+ * Pointer to the CO x CI weights of a pointwise convolution fused into the
+ * depthwise convolution, which is not fused if NULL
  * @var conv_layer_struct::TILE_CI
  * Tiling factor of input channel
  * @var conv_layer_struct::cluster2cluster
  * Flag for enabling cluster 2 cluster communication
  * @var conv_layer_struct::im2col
  * Flag for enabling im2col + GEMM
+ * @var conv_layer_struct::winograd
+ * Output tile size m of the Winograd convolution F(m x m, 3 x 3), 2 or 4. The
+ * weights are the transformed filters in a*a x CO x CI format, a = m + 2.
  * @var conv_layer_struct::gamma
  * Pointer to gamma for BatchNorm
  * @var conv_layer_struct::beta
  * Pointer to beta for BatchNorm
+ * @var conv_layer_struct::pool
+ * Size and stride of the MaxPool window, only used by the fused conv block
+ * @var conv_layer_struct::stride
+ * Stride of the pooling windows of the pooling layers, which is the window
+ * size (FH and FW) if 0. Windows overlap for strides smaller than the window.
+ * Convolutions use conv_stride instead.
  * @var gemm_layer_struct::dtype
  * Precision of Convolution layer
  */
@@ -114,18 +140,79 @@ typedef struct conv_layer_struct {
     uint32_t FH;
     uint32_t FW;
     uint32_t pad;
+    uint32_t conv_stride;
 
     double *ifmap;
     double *weights;
     double *ofmap;
+    double *pw_weights;
 
     uint32_t TILE_CI;
     uint32_t cluster2cluster;
     uint32_t im2col;
+    uint32_t winograd;
 
     // BATCHNORM
     double *gamma;
     double *beta;
 
+    // MAXPOOL
+    uint32_t pool;
+    uint32_t stride;
+
     precision_t dtype;
 } conv_layer;
+
+/**
+ * @struct transformer_layer_struct
+ * @brief This structure contains all parameters necessary for the row-wise
+ * layers (softmax, layernorm, GELU) and the attention layer of transformers
+ * @var transformer_layer_struct::S
+ * Number of rows (tokens) of the input and of queries
+ * @var transformer_layer_struct::E
+ * Number of elements per row (embedding dimension)
+ * @var transformer_layer_struct::L
+ * Number of keys and values, only used by attention
+ * @var transformer_layer_struct::ifmap
+ * Pointer to the S x E input, the queries for attention
+ * @var transformer_layer_struct::K
+ * Pointer to the L x E keys
+ * @var transformer_layer_struct::V
+ * Pointer to the L x E values
+ * @var transformer_layer_struct::ofmap
+ * Pointer to the S x E output
+ * @var transformer_layer_struct::gamma
+ * Pointer to the E factors of LayerNorm
+ * @var transformer_layer_struct::beta
+ * Pointer to the E offsets of LayerNorm
+ * @var transformer_layer_struct::eps
+ * Added to the variance by LayerNorm
+ * @var transformer_layer_struct::scale
+ * Factor of the attention scores, usually 1 / sqrt(E)
+ * @var transformer_layer_struct::TILE_S
+ * Number of rows (queries) per tile in the TCDM
+ * @var transformer_layer_struct::TILE_L
+ * Number of keys and values per tile in the TCDM
+ * @var transformer_layer_struct::dtype
+ * Precision of the layer
+ */
+typedef struct transformer_layer_struct {
+    uint32_t S;
+    uint32_t E;
+    uint32_t L;
+
+    double *ifmap;
+    double *K;
+    double *V;
+    double *ofmap;
+
+    double *gamma;
+    double *beta;
+    double eps;
+    double scale;
+
+    uint32_t TILE_S;
+    uint32_t TILE_L;
+
+    precision_t dtype;
+} transformer_layer;
@@ -0,0 +1,114 @@
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "graph.h"
+
+#include "batchnorm_layer.h"
+#include "conv2d_layer.h"
+#include "gemm_layer.h"
+#include "gemm_tiling.h"
+#include "layer.h"
+#include "maxpool_layer.h"
+#include "printf.h"
+#include "snrt.h"
+#include "utils.h"
+
+void *graph_tensor_ptr(const graph *g, int32_t t) {
+    if (t == GRAPH_NO_TENSOR) return NULL;
+
+    const graph_tensor *x = &g->tensors[t];
+    if (x->mem == GRAPH_L1)
+        return (char *)snrt_cluster_memory().start + x->offset;
+    if (x->data) return (void *)x->data;
+    return g->l3_arena + x->offset;
+}
+
+// Start copying the tensors in L1 which are first used by node `n` into the
+// TCDM of the cluster
+static void prefetch(const graph *g, uint32_t n) {
+    for (uint32_t t = 0; t < g->num_tensors; t++) {
+        const graph_tensor *x = &g->tensors[t];
+        if (x->mem == GRAPH_L1 && x->first == n) {
+            snrt_dma_start_1d(graph_tensor_ptr(g, t), x->data, x->size);
+        }
+    }
+}
+
+static uint32_t run_node(const graph *g, const graph_node *node) {
+    if (node->op == GRAPH_LINEAR) {
+        gemm_layer l = node->gemm;
+        l.A = graph_tensor_ptr(g, node->ifmap);
+        l.B = graph_tensor_ptr(g, node->weights);
+        l.C = graph_tensor_ptr(g, node->ofmap);
+
+        // Tiles fitting into the TCDM below the tensors in L1
+        gemm_tiling t;
+        if (gemm_tiling_select(&l, node->tcdm, snrt_cluster_num(),
+                               snrt_cluster_compute_core_num(), &t))
+            return 1;
+        l.TILE_M = t.TILE_M;
+        l.TILE_N = t.TILE_N;
+        l.TILE_K = t.TILE_K;
+        l.TILE_PAD = t.PAD;
+        return tiled_gemm_layer(&l);
+    }
+
+    conv_layer l = node->conv;
+    l.ifmap = graph_tensor_ptr(g, node->ifmap);
+    l.ofmap = graph_tensor_ptr(g, node->ofmap);
+    l.weights = graph_tensor_ptr(g, node->weights);
+    l.gamma = graph_tensor_ptr(g, node->gamma);
+    l.beta = graph_tensor_ptr(g, node->beta);
+
+    switch (node->op) {
+        case GRAPH_CONV2D:
+            conv2d_layer(&l);
+            break;
+        case GRAPH_BATCHNORM:
+            batchnorm_layer(&l);
+            break;
+        case GRAPH_MAXPOOL:
+            return maxpool_layer(&l);
+        case GRAPH_AVGPOOL:
+            return avgpool_layer(&l);
+        case GRAPH_GLOBAL_AVGPOOL:
+            return global_avgpool_layer(&l);
+        default:
+            return 1;
+    }
+    return 0;
+}
+
+uint32_t graph_run(const graph *g, uint32_t *cycles) {
+    if (snrt_slice_len(snrt_cluster_memory()) < g->l1_size) {
+        if (snrt_global_core_idx() == 0)
+            printf("Graph planned for %d bytes of TCDM\n", g->l1_size);
+        return g->num_nodes;
+    }
+
+    uint32_t errors = 0;
+
+    if (snrt_is_dm_core()) {
+        prefetch(g, 0);
+        snrt_dma_wait_all();
+    }
+    snrt_global_barrier();
+
+    for (uint32_t n = 0; n < g->num_nodes; n++) {
+        uint32_t t0 = benchmark_get_cycle();
+
+        // The DMA transfers of the layer queue up behind the prefetch. The
+        // tensors in L1 are placed above the TCDM used by both nodes.
+        if (snrt_is_dm_core() && n + 1 < g->num_nodes) prefetch(g, n + 1);
+
+        errors += run_node(g, &g->nodes[n]);
+
+        if (snrt_is_dm_core()) snrt_dma_wait_all();
+        snrt_global_barrier();
+
+        if (cycles) cycles[n] = benchmark_get_cycle() - t0;
+    }
+
+    return errors;
+}
@@ -0,0 +1,143 @@
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <stdint.h>
+
+#include "layer.h"
+
+// Operands of a node without a tensor
+#define GRAPH_NO_TENSOR -1
+
+typedef enum { GRAPH_L3, GRAPH_L1 } graph_mem_t;
+
+typedef enum {
+    GRAPH_CONV2D,
+    GRAPH_BATCHNORM,
+    GRAPH_MAXPOOL,
+    GRAPH_AVGPOOL,
+    GRAPH_GLOBAL_AVGPOOL,
+    GRAPH_LINEAR
+} graph_op_t;
+
+/**
+ * @struct graph_tensor_struct
+ * @brief A tensor of a network and its place in memory as decided by the
+ * offline planner (`graph_planner.py`)
+ * @var graph_tensor_struct::name
+ * Name of the tensor
+ * @var graph_tensor_struct::size
+ * Size in bytes
+ * @var graph_tensor_struct::mem
+ * Memory the tensor is placed in. Tensors in L1 are copied from `data` into
+ * the TCDM of every cluster by the executor before their first use.
+ * @var graph_tensor_struct::offset
+ * Offset in the L3 arena of the graph for feature maps, from the start of the
+ * TCDM for tensors in L1
+ * @var graph_tensor_struct::first
+ * Index of the first node using the tensor
+ * @var graph_tensor_struct::data
+ * Constant data in main memory (input and parameters), NULL for feature maps
+ */
+typedef struct graph_tensor_struct {
+    const char *name;
+    uint32_t size;
+    graph_mem_t mem;
+    uint32_t offset;
+    uint32_t first;
+    const void *data;
+} graph_tensor;
+
+/**
+ * @struct graph_node_struct
+ * @brief A layer of a network
+ * @var graph_node_struct::name
+ * Name of the node
+ * @var graph_node_struct::op
+ * Layer to run
+ * @var graph_node_struct::conv
+ * Parameters and tiling of convolutional, BatchNorm and pooling layers, the
+ * pointers are set by the executor
+ * @var graph_node_struct::gemm
+ * Parameters of linear layers, the pointers and tiles are set by the executor
+ * @var graph_node_struct::ifmap
+ * Index of the input tensor
+ * @var graph_node_struct::ofmap
+ * Index of the output tensor
+ * @var graph_node_struct::weights
+ * Index of the weights tensor or GRAPH_NO_TENSOR
+ * @var graph_node_struct::gamma
+ * Index of the BatchNorm factors or GRAPH_NO_TENSOR
+ * @var graph_node_struct::beta
+ * Index of the BatchNorm offsets or GRAPH_NO_TENSOR
+ * @var graph_node_struct::tcdm
+ * Bytes of TCDM available to the layer, the tensors in L1 live above
+ */
+typedef struct graph_node_struct {
+    const char *name;
+    graph_op_t op;
+    conv_layer conv;
+    gemm_layer gemm;
+    int32_t ifmap;
+    int32_t ofmap;
+    int32_t weights;
+    int32_t gamma;
+    int32_t beta;
+    uint32_t tcdm;
+} graph_node;
+
+/**
+ * @struct graph_struct
+ * @brief A network of layers executed one after the other
+ * @var graph_struct::tensors
+ * Tensors of the network
+ * @var graph_struct::num_tensors
+ * Number of tensors
+ * @var graph_struct::nodes
+ * Nodes in execution order
+ * @var graph_struct::num_nodes
+ * Number of nodes
+ * @var graph_struct::l3_arena
+ * Buffer in main memory holding the feature maps
+ * @var graph_struct::l3_size
+ * Size of the L3 arena in bytes
+ * @var graph_struct::l1_size
+ * Bytes of TCDM the plan was made for
+ * @var graph_struct::l1_peak
+ * Peak TCDM usage of the layers and the tensors in L1 in bytes
+ * @var graph_struct::output
+ * Index of the output tensor
+ */
+typedef struct graph_struct {
+    const graph_tensor *tensors;
+    uint32_t num_tensors;
+    const graph_node *nodes;
+    uint32_t num_nodes;
+    char *l3_arena;
+    uint32_t l3_size;
+    uint32_t l1_size;
+    uint32_t l1_peak;
+    int32_t output;
+} graph;
+
+/**
+ * @brief Address of a tensor for the calling cluster
+ *
+ * @param g graph holding the tensor
+ * @param t index of the tensor
+ * @return pointer to the tensor, NULL for GRAPH_NO_TENSOR
+ */
+void *graph_tensor_ptr(const graph *g, int32_t t);
+
+/**
+ * @brief Runs all nodes of a graph on all clusters. While a node computes,
+ * the DM cores prefetch the tensors in L1 which are first used by the next
+ * node. Has to be called by all cores.
+ *
+ * @param g graph to run
+ * @param cycles cycles per node as measured by the calling core, or NULL
+ * @return number of nodes which failed
+ */
+uint32_t graph_run(const graph *g, uint32_t *cycles);
@@ -4,6 +4,10 @@
 
 #include "snrt.h"
 
+typedef float v2f32 __attribute__((vector_size(8)));
+typedef __fp16 v4f16 __attribute__((vector_size(8)));
+typedef char v8f8 __attribute__((vector_size(8)));
+
 void batchnorm_fp64(double *ifmap, double *gamma, double *beta, double *ofmap,
                     uint32_t OW, uint32_t CI, uint32_t compute_num,
                     uint32_t setup_SSR) {
@@ -36,3 +40,120 @@ void batchnorm_fp64(double *ifmap, double *gamma, double *beta, double *ofmap,
     __builtin_ssr_barrier(SNRT_SSR_DM1);
     snrt_ssr_disable();
 }
+
+void batchnorm_fp32simd(float *ifmap, float *gamma, float *beta, float *ofmap,
+                        uint32_t OW, uint32_t CI, uint32_t compute_num,
+                        uint32_t setup_SSR) {
+    // Every 64-bit word holds 2 channels
+    const uint32_t words = CI / 2;
+
+    // initial SSR setup
+    if (setup_SSR) {
+        uint32_t ssr_b[2] = {OW, words / compute_num};
+        uint32_t ssr_i[2] = {CI * sizeof(float), compute_num * sizeof(v2f32)};
+
+        snrt_ssr_loop_2d(SNRT_SSR_DM0, ssr_b[0], ssr_b[1], ssr_i[0], ssr_i[1]);
+        snrt_ssr_loop_2d(SNRT_SSR_DM1, ssr_b[0], ssr_b[1], ssr_i[0], ssr_i[1]);
+    }
+
+    // SSR address setup
+    snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_2D, ifmap);
+    snrt_ssr_write(SNRT_SSR_DM1, SNRT_SSR_2D, ofmap);
+    snrt_ssr_enable();
+
+    for (uint32_t w = 0; w < words; w += compute_num) {
+        register v2f32 g = ((v2f32 *)gamma)[w];
+        register v2f32 b = ((v2f32 *)beta)[w];
+        register v2f32 t;
+
+        // frep over OW dimension
+        asm volatile(
+            "frep.o %[n_frep], 2, 0, 0 \n"
+            "vfmul.s %[t], ft0, %[g] \n"
+            "vfadd.s ft1, %[t], %[b] \n"
+            : [ t ] "=&f"(t)
+            : [ g ] "f"(g), [ b ] "f"(b), [ n_frep ] "r"(OW - 1)
+            : "ft0", "ft1", "ft2");
+    }
+    snrt_fpu_fence();
+    __builtin_ssr_barrier(SNRT_SSR_DM1);
+    snrt_ssr_disable();
+}
+
+void batchnorm_fp16simd(__fp16 *ifmap, __fp16 *gamma, __fp16 *beta,
+                        __fp16 *ofmap, uint32_t OW, uint32_t CI,
+                        uint32_t compute_num, uint32_t setup_SSR) {
+    // Every 64-bit word holds 4 channels
+    const uint32_t words = CI / 4;
+
+    // initial SSR setup
+    if (setup_SSR) {
+        uint32_t ssr_b[2] = {OW, words / compute_num};
+        uint32_t ssr_i[2] = {CI * sizeof(__fp16), compute_num * sizeof(v4f16)};
+
+        snrt_ssr_loop_2d(SNRT_SSR_DM0, ssr_b[0], ssr_b[1], ssr_i[0], ssr_i[1]);
+        snrt_ssr_loop_2d(SNRT_SSR_DM1, ssr_b[0], ssr_b[1], ssr_i[0], ssr_i[1]);
+    }
+
+    // SSR address setup
+    snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_2D, ifmap);
+    snrt_ssr_write(SNRT_SSR_DM1, SNRT_SSR_2D, ofmap);
+    snrt_ssr_enable();
+
+    for (uint32_t w = 0; w < words; w += compute_num) {
+        register v4f16 g = ((v4f16 *)gamma)[w];
+        register v4f16 b = ((v4f16 *)beta)[w];
+        register v4f16 t;
+
+        // frep over OW dimension
+        asm volatile(
+            "frep.o %[n_frep], 2, 0, 0 \n"
+            "vfmul.h %[t], ft0, %[g] \n"
+            "vfadd.h ft1, %[t], %[b] \n"
+            : [ t ] "=&f"(t)
+            : [ g ] "f"(g), [ b ] "f"(b), [ n_frep ] "r"(OW - 1)
+            : "ft0", "ft1", "ft2");
+    }
+    snrt_fpu_fence();
+    __builtin_ssr_barrier(SNRT_SSR_DM1);
+    snrt_ssr_disable();
+}
+
+void batchnorm_fp8simd(char *ifmap, char *gamma, char *beta, char *ofmap,
+                       uint32_t OW, uint32_t CI, uint32_t compute_num,
+                       uint32_t setup_SSR) {
+    // Every 64-bit word holds 8 channels
+    const uint32_t words = CI / 8;
+
+    // initial SSR setup
+    if (setup_SSR) {
+        uint32_t ssr_b[2] = {OW, words / compute_num};
+        uint32_t ssr_i[2] = {CI * sizeof(char), compute_num * sizeof(v8f8)};
+
+        snrt_ssr_loop_2d(SNRT_SSR_DM0, ssr_b[0], ssr_b[1], ssr_i[0], ssr_i[1]);
+        snrt_ssr_loop_2d(SNRT_SSR_DM1, ssr_b[0], ssr_b[1], ssr_i[0], ssr_i[1]);
+    }
+
+    // SSR address setup
+    snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_2D, ifmap);
+    snrt_ssr_write(SNRT_SSR_DM1, SNRT_SSR_2D, ofmap);
+    snrt_ssr_enable();
+
+    for (uint32_t w = 0; w < words; w += compute_num) {
+        register v8f8 g = ((v8f8 *)gamma)[w];
+        register v8f8 b = ((v8f8 *)beta)[w];
+        register v8f8 t;
+
+        // frep over OW dimension
+        asm volatile(
+            "frep.o %[n_frep], 2, 0, 0 \n"
+            "vfmul.b %[t], ft0, %[g] \n"
+            "vfadd.b ft1, %[t], %[b] \n"
+            : [ t ] "=&f"(t)
+            : [ g ] "f"(g), [ b ] "f"(b), [ n_frep ] "r"(OW - 1)
+            : "ft0", "ft1", "ft2");
+    }
+    snrt_fpu_fence();
+    __builtin_ssr_barrier(SNRT_SSR_DM1);
+    snrt_ssr_disable();
+}
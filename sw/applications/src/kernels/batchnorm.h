@@ -20,3 +20,54 @@
 void batchnorm_fp64(double *ifmap, double *gamma, double *beta, double *ofmap,
                     uint32_t OW, uint32_t CI, uint32_t compute_num,
                     uint32_t setup_SSR);
+
+/**
+ * @brief implementation of a FP32 SIMD batchnorm as a linear combination
+ * y = gamma * x + beta, computing 2 channels per instruction
+ *
+ * @param ifmap pointer to input feature map
+ * @param gamma pointer to gamma
+ * @param beta pointer to beta
+ * @param ofmap pointer to output feature map
+ * @param OW width of output feature map
+ * @param CI number of input channels, a multiple of 2 * compute_num
+ * @param compute_num number of compute units
+ * @param setup_SSR setup SSR strides and bounds
+ */
+void batchnorm_fp32simd(float *ifmap, float *gamma, float *beta, float *ofmap,
+                        uint32_t OW, uint32_t CI, uint32_t compute_num,
+                        uint32_t setup_SSR);
+
+/**
+ * @brief implementation of a FP16 SIMD batchnorm as a linear combination
+ * y = gamma * x + beta, computing 4 channels per instruction
+ *
+ * @param ifmap pointer to input feature map
+ * @param gamma pointer to gamma
+ * @param beta pointer to beta
+ * @param ofmap pointer to output feature map
+ * @param OW width of output feature map
+ * @param CI number of input channels, a multiple of 4 * compute_num
+ * @param compute_num number of compute units
+ * @param setup_SSR setup SSR strides and bounds
+ */
+void batchnorm_fp16simd(__fp16 *ifmap, __fp16 *gamma, __fp16 *beta,
+                        __fp16 *ofmap, uint32_t OW, uint32_t CI,
+                        uint32_t compute_num, uint32_t setup_SSR);
+
+/**
+ * @brief implementation of a FP8 SIMD batchnorm as a linear combination
+ * y = gamma * x + beta, computing 8 channels per instruction
+ *
+ * @param ifmap pointer to input feature map
+ * @param gamma pointer to gamma
+ * @param beta pointer to beta
+ * @param ofmap pointer to output feature map
+ * @param OW width of output feature map
+ * @param CI number of input channels, a multiple of 8 * compute_num
+ * @param compute_num number of compute units
+ * @param setup_SSR setup SSR strides and bounds
+ */
+void batchnorm_fp8simd(char *ifmap, char *gamma, char *beta, char *ofmap,
+                       uint32_t OW, uint32_t CI, uint32_t compute_num,
+                       uint32_t setup_SSR);
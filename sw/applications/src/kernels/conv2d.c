@@ -5,6 +5,7 @@
 #include "conv2d.h"
 
 #include "printf.h"
+#include "ssr.h"
 
 typedef float v2f32 __attribute__((vector_size(8)));
 
@@ -60,15 +61,17 @@ void occamy_conv_opt_fp64(kernel_fp64* k) {
     //     }
     // }
 
-    // Setup SSRs bounds and strides for input feature map
+    // Setup SSRs bounds and strides for input feature map. The descriptors
+    // are computed once and only written to the SSRs when the loops change.
     const uint32_t ssr0_b[4] = {max_unroll, k->ch_in, k->dim_kernel_x,
                                 k->dim_kernel_y};
     const uint32_t ssr0_i[4] = {
         input_h_stride * k->stride_y * sizeof(double), 1 * sizeof(double),
         input_w_stride * sizeof(double), input_h_stride * sizeof(double)};
 
-    snrt_ssr_loop_4d(SNRT_SSR_DM0, ssr0_b[0], ssr0_b[1], ssr0_b[2], ssr0_b[3],
-                     ssr0_i[0], ssr0_i[1], ssr0_i[2], ssr0_i[3]);
+    const snrt_ssr_desc_t ssr0 =
+        snrt_ssr_desc_4d(ssr0_b[0], ssr0_b[1], ssr0_b[2], ssr0_b[3], ssr0_i[0],
+                         ssr0_i[1], ssr0_i[2], ssr0_i[3]);
 
     // Setup SSRs bounds and strides for kernel
     // We use only 3D SSRs here as the inner most dimension is repeated
@@ -77,10 +80,12 @@ void occamy_conv_opt_fp64(kernel_fp64* k) {
                                 kernel_w_stride * sizeof(double),
                                 kernel_h_stride * sizeof(double)};
 
-    snrt_ssr_loop_3d(SNRT_SSR_DM1, ssr1_b[0], ssr1_b[1], ssr1_b[2], ssr1_i[0],
-                     ssr1_i[1], ssr1_i[2]);
+    snrt_ssr_desc_t ssr1 = snrt_ssr_desc_3d(ssr1_b[0], ssr1_b[1], ssr1_b[2],
+                                            ssr1_i[0], ssr1_i[1], ssr1_i[2]);
+    snrt_ssr_desc_repeat(&ssr1, max_unroll);
 
-    snrt_ssr_repeat(SNRT_SSR_DM1, max_unroll);
+    snrt_ssr_desc_apply(SNRT_SSR_DM0, &ssr0);
+    snrt_ssr_desc_apply(SNRT_SSR_DM1, &ssr1);
 
     // Output channel dimension `k->ch_out` is parallelized over cores
     for (uint32_t co = compute_id; co < k->ch_out; co += compute_num) {
@@ -90,14 +95,8 @@ void occamy_conv_opt_fp64(kernel_fp64* k) {
         // at the end which modifies the SSR loops, thus initialize it again
         // correctly
         if (cleanup_unroll) {
-            snrt_ssr_loop_4d(SNRT_SSR_DM0, ssr0_b[0], ssr0_b[1], ssr0_b[2],
-                             ssr0_b[3], ssr0_i[0], ssr0_i[1], ssr0_i[2],
-                             ssr0_i[3]);
-
-            snrt_ssr_loop_3d(SNRT_SSR_DM1, ssr1_b[0], ssr1_b[1], ssr1_b[2],
-                             ssr1_i[0], ssr1_i[1], ssr1_i[2]);
-
-            snrt_ssr_repeat(SNRT_SSR_DM1, max_unroll);
+            snrt_ssr_desc_apply(SNRT_SSR_DM0, &ssr0);
+            snrt_ssr_desc_apply(SNRT_SSR_DM1, &ssr1);
         }
 
         // Output height dimension `k->dim_out_y` first split
@@ -119,13 +118,13 @@ void occamy_conv_opt_fp64(kernel_fp64* k) {
                 }
 
                 // SSR address setup and enable
-                snrt_ssr_read(
-                    SNRT_SSR_DM0, SNRT_SSR_4D,
+                snrt_ssr_desc_read(
+                    SNRT_SSR_DM0, &ssr0,
                     (void*)(k->pInBuffer +
                             h0 * max_unroll * k->stride_y * input_h_stride +
                             w * k->stride_x * input_w_stride));
-                snrt_ssr_read(SNRT_SSR_DM1, SNRT_SSR_3D,
-                              (void*)(k->pWeight + co * kernel_co_stride));
+                snrt_ssr_desc_read(SNRT_SSR_DM1, &ssr1,
+                                   (void*)(k->pWeight + co * kernel_co_stride));
                 snrt_ssr_enable();
 
                 asm volatile(
@@ -159,14 +158,14 @@ void occamy_conv_opt_fp64(kernel_fp64* k) {
         // Clean up rows
         if (cleanup_unroll) {
             // Modify most inner loop unrolling
-            snrt_ssr_loop_4d(SNRT_SSR_DM0, cleanup_unroll, ssr0_b[1], ssr0_b[2],
-                             ssr0_b[3], ssr0_i[0], ssr0_i[1], ssr0_i[2],
-                             ssr0_i[3]);
-
-            snrt_ssr_loop_3d(SNRT_SSR_DM1, ssr1_b[0], ssr1_b[1], ssr1_b[2],
-                             ssr1_i[0], ssr1_i[1], ssr1_i[2]);
+            const snrt_ssr_desc_t ssr0_cleanup = snrt_ssr_desc_4d(
+                cleanup_unroll, ssr0_b[1], ssr0_b[2], ssr0_b[3], ssr0_i[0],
+                ssr0_i[1], ssr0_i[2], ssr0_i[3]);
+            snrt_ssr_desc_t ssr1_cleanup = ssr1;
+            snrt_ssr_desc_repeat(&ssr1_cleanup, cleanup_unroll);
 
-            snrt_ssr_repeat(SNRT_SSR_DM1, cleanup_unroll);
+            snrt_ssr_desc_apply(SNRT_SSR_DM0, &ssr0_cleanup);
+            snrt_ssr_desc_apply(SNRT_SSR_DM1, &ssr1_cleanup);
 
             // Output width dimension `k->dim_out_x`
             for (uint32_t w = 0; w < k->dim_out_x; w++) {
@@ -184,13 +183,13 @@ void occamy_conv_opt_fp64(kernel_fp64* k) {
                 }
 
                 // SSR address setup and enable
-                snrt_ssr_read(
-                    SNRT_SSR_DM0, SNRT_SSR_4D,
+                snrt_ssr_desc_read(
+                    SNRT_SSR_DM0, &ssr0,
                     (void*)(k->pInBuffer +
                             h0 * max_unroll * k->stride_y * input_h_stride +
                             w * k->stride_x * input_w_stride));
-                snrt_ssr_read(SNRT_SSR_DM1, SNRT_SSR_3D,
-                              (void*)(k->pWeight + co * kernel_co_stride));
+                snrt_ssr_desc_read(SNRT_SSR_DM1, &ssr1,
+                                   (void*)(k->pWeight + co * kernel_co_stride));
                 snrt_ssr_enable();
 
                 switch (cleanup_unroll) {
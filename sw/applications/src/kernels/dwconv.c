@@ -0,0 +1,91 @@
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "dwconv.h"
+
+#include "layer.h"
+#include "snrt.h"
+
+// Multiply-accumulate of a word of channels of the input (ft0) and of the
+// filter (ft1) into the accumulator `acc`
+#define FMADD_D(acc) "fmadd.d %[" acc "], ft0, ft1, %[" acc "] \n"
+#define VFMAC_S(acc) "vfmac.s %[" acc "], ft0, ft1 \n"
+#define VFMAC_H(acc) "vfmac.h %[" acc "], ft0, ft1 \n"
+
+// One output pixel: the 8 accumulators are cleared, which also clears all
+// lanes of a SIMD vector, accumulate the FH * FW filter elements in an FREP
+// loop and are stored to `out`
+#define DWCONV_PIXEL(fmac)                                                    \
+    asm volatile(                                                             \
+        "fcvt.d.w %[a0], zero \n"                                             \
+        "fcvt.d.w %[a1], zero \n"                                             \
+        "fcvt.d.w %[a2], zero \n"                                             \
+        "fcvt.d.w %[a3], zero \n"                                             \
+        "fcvt.d.w %[a4], zero \n"                                             \
+        "fcvt.d.w %[a5], zero \n"                                             \
+        "fcvt.d.w %[a6], zero \n"                                             \
+        "fcvt.d.w %[a7], zero \n"                                             \
+        "frep.o %[n_frep], 8, 0, 0 \n" fmac("a0") fmac("a1") fmac("a2")       \
+            fmac("a3") fmac("a4") fmac("a5") fmac("a6") fmac("a7")            \
+        "fsd %[a0], 0(%[out]) \n"                                             \
+        "fsd %[a1], 8(%[out]) \n"                                             \
+        "fsd %[a2], 16(%[out]) \n"                                            \
+        "fsd %[a3], 24(%[out]) \n"                                            \
+        "fsd %[a4], 32(%[out]) \n"                                            \
+        "fsd %[a5], 40(%[out]) \n"                                            \
+        "fsd %[a6], 48(%[out]) \n"                                            \
+        "fsd %[a7], 56(%[out]) \n"                                            \
+        : [ a0 ] "=&f"(acc[0]), [ a1 ] "=&f"(acc[1]), [ a2 ] "=&f"(acc[2]),   \
+          [ a3 ] "=&f"(acc[3]), [ a4 ] "=&f"(acc[4]), [ a5 ] "=&f"(acc[5]),   \
+          [ a6 ] "=&f"(acc[6]), [ a7 ] "=&f"(acc[7])                          \
+        : [ n_frep ] "r"(n_frep), [ out ] "r"(out)                            \
+        : "ft0", "ft1", "ft2", "memory")
+
+void dwconv_ssr_frep(precision_t dtype, uint32_t OW, uint32_t FH, uint32_t FW,
+                     uint32_t stride, const double *ifmap, uint32_t ldw,
+                     uint32_t ldh, const double *weights, uint32_t ldf,
+                     double *ofmap, uint32_t ldo, uint32_t setup_SSR) {
+    // Words of channels processed at once
+    const uint32_t unroll = 8;
+
+    if (setup_SSR) {
+        // Input: words of channels, filter columns, filter rows and output
+        // pixels
+        snrt_ssr_loop_4d(SNRT_SSR_DM0, unroll, FW, FH, OW, sizeof(double),
+                         sizeof(double) * ldw, sizeof(double) * ldh,
+                         sizeof(double) * stride * ldw);
+        snrt_ssr_repeat(SNRT_SSR_DM0, 1);
+
+        // Filter: words of channels and filter elements, the same for every
+        // output pixel
+        snrt_ssr_loop_3d(SNRT_SSR_DM1, unroll, FH * FW, OW, sizeof(double),
+                         sizeof(double) * ldf, 0);
+        snrt_ssr_repeat(SNRT_SSR_DM1, 1);
+    }
+
+    snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_4D, (void *)ifmap);
+    snrt_ssr_read(SNRT_SSR_DM1, SNRT_SSR_3D, (void *)weights);
+    snrt_ssr_enable();
+
+    const uint32_t n_frep = FH * FW - 1;
+    double acc[8];
+    for (uint32_t ow = 0; ow < OW; ow++) {
+        double *out = ofmap + ow * ldo;
+        switch (dtype) {
+            case FP64:
+                DWCONV_PIXEL(FMADD_D);
+                break;
+            case FP32:
+                DWCONV_PIXEL(VFMAC_S);
+                break;
+            default:
+                DWCONV_PIXEL(VFMAC_H);
+                break;
+        }
+    }
+
+    // The stores are issued by the FPU sequencer
+    snrt_fpu_fence();
+    snrt_ssr_disable();
+}
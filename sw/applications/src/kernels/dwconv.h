@@ -0,0 +1,41 @@
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <stdint.h>
+
+#include "layer.h"
+
+// Depthwise convolution of channels-last feature maps. Every channel is
+// convolved with its own FH x FW filter, such that neighbouring channels of a
+// pixel are independent and can be processed as packed SIMD vectors. The
+// kernel works on 64-bit words of 1 (FP64), 2 (FP32) or 4 (FP16) channels and
+// computes 8 consecutive words of channels of a row of output pixels at once.
+
+/**
+ * @brief depthwise convolution of one row of output pixels for 8 words of
+ * channels with SSR and FREP. Strides are in 64-bit words.
+ *
+ * @param dtype precision of the feature maps and filters, FP64, FP32 or FP16
+ * @param OW number of output pixels of the row
+ * @param FH height of the filters
+ * @param FW width of the filters
+ * @param stride stride of the convolution
+ * @param ifmap pointer to the first word of channels in the top left pixel of
+ * the receptive field of the first output pixel
+ * @param ldw stride between input pixels
+ * @param ldh stride between input rows
+ * @param weights pointer to the first word of channels of the first filter
+ * element, filter elements are stored row by row with stride ldf
+ * @param ldf stride between filter elements
+ * @param ofmap pointer to the first word of channels of the first output pixel
+ * @param ldo stride between output pixels
+ * @param setup_SSR setup SSR bounds and strides, which only depend on OW, FH,
+ * FW, stride and the strides of the buffers
+ */
+void dwconv_ssr_frep(precision_t dtype, uint32_t OW, uint32_t FH, uint32_t FW,
+                     uint32_t stride, const double *ifmap, uint32_t ldw,
+                     uint32_t ldh, const double *weights, uint32_t ldf,
+                     double *ofmap, uint32_t ldo, uint32_t setup_SSR);
@@ -6,6 +6,7 @@
 
 #include "printf.h"
 #include "snrt.h"
+#include "ssr.h"
 
 typedef float v2f32 __attribute__((vector_size(8)));
 typedef __fp16 v4f16 __attribute__((vector_size(8)));
@@ -61,34 +62,44 @@ void gemm_fp64_ssr_frep(uint32_t M, uint32_t N, uint32_t K, double* A,
                         uint32_t ldA, uint32_t ta, double* B, uint32_t ldB,
                         uint32_t tb, double* C, uint32_t ldC,
                         const uint32_t* ALPHA, uint32_t setup_SSR) {
+    gemm_fp64_ssr_frep_unroll(M, N, K, A, ldA, ta, B, ldB, tb, C, ldC, ALPHA,
+                              8, setup_SSR);
+}
+
+void gemm_fp64_ssr_frep_unroll(uint32_t M, uint32_t N, uint32_t K, double* A,
+                               uint32_t ldA, uint32_t ta, double* B,
+                               uint32_t ldB, uint32_t tb, double* C,
+                               uint32_t ldC, const uint32_t* ALPHA,
+                               uint32_t unroll, uint32_t setup_SSR) {
     register volatile double ft0 asm("ft0");
     register volatile double ft1 asm("ft1");
     register volatile double ft2 asm("ft2");
     asm volatile("" : "=f"(ft0), "=f"(ft1), "=f"(ft2));
 
-    // Unrolling factor of most inner loop.
-    // Should be at least as high as the FMA delay
-    // for maximum utilization
-    const uint32_t unroll = 8;
-
     // SSR strides and bounds only have to be configured
     // once in the beginning
     if (setup_SSR) {
-        // First matrix is stored in transposed format
+        // First matrix is stored in transposed format, with its rows
+        // interleaved across the compute cores
         if (ta) {
             const uint32_t ssr0_b[4] = {unroll, K, N / unroll, M};
-            const uint32_t ssr0_i[4] = {0, 8 * ldA, 0, 8 * 8};
-
-            snrt_ssr_loop_3d(SNRT_SSR_DM0, ssr0_b[1], ssr0_b[2], ssr0_b[3],
-                             ssr0_i[1], ssr0_i[2], ssr0_i[3]);
-            snrt_ssr_repeat(SNRT_SSR_DM0, unroll);
+            const uint32_t ssr0_i[4] = {0, 8 * ldA, 0,
+                                        8 * snrt_cluster_compute_core_num()};
+
+            snrt_ssr_desc_t ssr0 =
+                snrt_ssr_desc_3d(ssr0_b[1], ssr0_b[2], ssr0_b[3], ssr0_i[1],
+                                 ssr0_i[2], ssr0_i[3]);
+            snrt_ssr_desc_repeat(&ssr0, unroll);
+            snrt_ssr_desc_apply(SNRT_SSR_DM0, &ssr0);
         } else {
             const uint32_t ssr0_b[4] = {unroll, K, N / unroll, M};
             const uint32_t ssr0_i[4] = {0, 8, 0, 8 * ldA};
 
-            snrt_ssr_loop_3d(SNRT_SSR_DM0, ssr0_b[1], ssr0_b[2], ssr0_b[3],
-                             ssr0_i[1], ssr0_i[2], ssr0_i[3]);
-            snrt_ssr_repeat(SNRT_SSR_DM0, unroll);
+            snrt_ssr_desc_t ssr0 =
+                snrt_ssr_desc_3d(ssr0_b[1], ssr0_b[2], ssr0_b[3], ssr0_i[1],
+                                 ssr0_i[2], ssr0_i[3]);
+            snrt_ssr_desc_repeat(&ssr0, unroll);
+            snrt_ssr_desc_apply(SNRT_SSR_DM0, &ssr0);
         }
 
         // Second matrix is stored in transposed format
@@ -96,28 +107,30 @@ void gemm_fp64_ssr_frep(uint32_t M, uint32_t N, uint32_t K, double* A,
             const uint32_t ssr1_b[4] = {unroll, K, N / unroll, M};
             const uint32_t ssr1_i[4] = {8 * ldB, 8, 8 * ldB * unroll, 0};
 
-            snrt_ssr_loop_4d(SNRT_SSR_DM1, ssr1_b[0], ssr1_b[1], ssr1_b[2],
-                             ssr1_b[3], ssr1_i[0], ssr1_i[1], ssr1_i[2],
-                             ssr1_i[3]);
+            const snrt_ssr_desc_t ssr1 =
+                snrt_ssr_desc_4d(ssr1_b[0], ssr1_b[1], ssr1_b[2], ssr1_b[3],
+                                 ssr1_i[0], ssr1_i[1], ssr1_i[2], ssr1_i[3]);
+            snrt_ssr_desc_apply(SNRT_SSR_DM1, &ssr1);
         } else {
             const uint32_t ssr1_b[4] = {unroll, K, N / unroll, M};
             const uint32_t ssr1_i[4] = {8, 8 * ldB, 8 * unroll, 0};
 
-            snrt_ssr_loop_4d(SNRT_SSR_DM1, ssr1_b[0], ssr1_b[1], ssr1_b[2],
-                             ssr1_b[3], ssr1_i[0], ssr1_i[1], ssr1_i[2],
-                             ssr1_i[3]);
+            const snrt_ssr_desc_t ssr1 =
+                snrt_ssr_desc_4d(ssr1_b[0], ssr1_b[1], ssr1_b[2], ssr1_b[3],
+                                 ssr1_i[0], ssr1_i[1], ssr1_i[2], ssr1_i[3]);
+            snrt_ssr_desc_apply(SNRT_SSR_DM1, &ssr1);
         }
     }
 
     // SSR start address need to be configured each time
-    snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_4D, A);
-    snrt_ssr_read(SNRT_SSR_DM1, SNRT_SSR_4D, B);
+    snrt_ssr_rebase_read(SNRT_SSR_DM0, SNRT_SSR_4D, A);
+    snrt_ssr_rebase_read(SNRT_SSR_DM1, SNRT_SSR_4D, B);
     snrt_ssr_enable();
 
     for (uint32_t m = 0; m < M; m++) {
         uint32_t n = 0;
         for (uint32_t n0 = 0; n0 < N / unroll; n0++) {
-            register double c[unroll];
+            register double c[8];
 
             // Load intermediate result
             if (*ALPHA) {
@@ -125,46 +138,64 @@ void gemm_fp64_ssr_frep(uint32_t M, uint32_t N, uint32_t K, double* A,
                 c[1] = C[m * ldC + n + 1];
                 c[2] = C[m * ldC + n + 2];
                 c[3] = C[m * ldC + n + 3];
-                c[4] = C[m * ldC + n + 4];
-                c[5] = C[m * ldC + n + 5];
-                c[6] = C[m * ldC + n + 6];
-                c[7] = C[m * ldC + n + 7];
             } else {
                 c[0] = 0.0;
                 c[1] = 0.0;
                 c[2] = 0.0;
                 c[3] = 0.0;
-                c[4] = 0.0;
-                c[5] = 0.0;
-                c[6] = 0.0;
-                c[7] = 0.0;
             }
 
-            asm volatile(
-                "frep.o %[n_frep], 8, 0, 0 \n"
-                "fmadd.d %[c0], ft0, ft1, %[c0] \n"
-                "fmadd.d %[c1], ft0, ft1, %[c1] \n"
-                "fmadd.d %[c2], ft0, ft1, %[c2] \n"
-                "fmadd.d %[c3], ft0, ft1, %[c3] \n"
-                "fmadd.d %[c4], ft0, ft1, %[c4] \n"
-                "fmadd.d %[c5], ft0, ft1, %[c5] \n"
-                "fmadd.d %[c6], ft0, ft1, %[c6] \n"
-                "fmadd.d %[c7], ft0, ft1, %[c7] \n"
-                : [ c0 ] "+f"(c[0]), [ c1 ] "+f"(c[1]), [ c2 ] "+f"(c[2]),
-                  [ c3 ] "+f"(c[3]), [ c4 ] "+f"(c[4]), [ c5 ] "+f"(c[5]),
-                  [ c6 ] "+f"(c[6]), [ c7 ] "+f"(c[7])
-                : [ n_frep ] "r"(K - 1)
-                : "ft0", "ft1");
+            if (unroll == 4) {
+                asm volatile(
+                    "frep.o %[n_frep], 4, 0, 0 \n"
+                    "fmadd.d %[c0], ft0, ft1, %[c0] \n"
+                    "fmadd.d %[c1], ft0, ft1, %[c1] \n"
+                    "fmadd.d %[c2], ft0, ft1, %[c2] \n"
+                    "fmadd.d %[c3], ft0, ft1, %[c3] \n"
+                    : [ c0 ] "+f"(c[0]), [ c1 ] "+f"(c[1]), [ c2 ] "+f"(c[2]),
+                      [ c3 ] "+f"(c[3])
+                    : [ n_frep ] "r"(K - 1)
+                    : "ft0", "ft1");
+            } else {
+                if (*ALPHA) {
+                    c[4] = C[m * ldC + n + 4];
+                    c[5] = C[m * ldC + n + 5];
+                    c[6] = C[m * ldC + n + 6];
+                    c[7] = C[m * ldC + n + 7];
+                } else {
+                    c[4] = 0.0;
+                    c[5] = 0.0;
+                    c[6] = 0.0;
+                    c[7] = 0.0;
+                }
+
+                asm volatile(
+                    "frep.o %[n_frep], 8, 0, 0 \n"
+                    "fmadd.d %[c0], ft0, ft1, %[c0] \n"
+                    "fmadd.d %[c1], ft0, ft1, %[c1] \n"
+                    "fmadd.d %[c2], ft0, ft1, %[c2] \n"
+                    "fmadd.d %[c3], ft0, ft1, %[c3] \n"
+                    "fmadd.d %[c4], ft0, ft1, %[c4] \n"
+                    "fmadd.d %[c5], ft0, ft1, %[c5] \n"
+                    "fmadd.d %[c6], ft0, ft1, %[c6] \n"
+                    "fmadd.d %[c7], ft0, ft1, %[c7] \n"
+                    : [ c0 ] "+f"(c[0]), [ c1 ] "+f"(c[1]), [ c2 ] "+f"(c[2]),
+                      [ c3 ] "+f"(c[3]), [ c4 ] "+f"(c[4]), [ c5 ] "+f"(c[5]),
+                      [ c6 ] "+f"(c[6]), [ c7 ] "+f"(c[7])
+                    : [ n_frep ] "r"(K - 1)
+                    : "ft0", "ft1");
+
+                C[m * ldC + n + 4] = c[4];
+                C[m * ldC + n + 5] = c[5];
+                C[m * ldC + n + 6] = c[6];
+                C[m * ldC + n + 7] = c[7];
+            }
 
             // Store results back
             C[m * ldC + n + 0] = c[0];
             C[m * ldC + n + 1] = c[1];
             C[m * ldC + n + 2] = c[2];
             C[m * ldC + n + 3] = c[3];
-            C[m * ldC + n + 4] = c[4];
-            C[m * ldC + n + 5] = c[5];
-            C[m * ldC + n + 6] = c[6];
-            C[m * ldC + n + 7] = c[7];
             n += unroll;
         }
 
@@ -217,17 +248,20 @@ void gemm_fp32simd_tb_ssr_frep(const uint32_t M, const uint32_t N,
         uint32_t ssr1_i[4] = {sizeof(float) * ldB, sizeof(float) * 2,
                               sizeof(float) * unroll * ldB, 0};
 
-        snrt_ssr_loop_3d(SNRT_SSR_DM0, ssr0_b[1], ssr0_b[2], ssr0_b[3],
-                         ssr0_i[1], ssr0_i[2], ssr0_i[3]);
-        snrt_ssr_repeat(SNRT_SSR_DM0, unroll);
+        snrt_ssr_desc_t ssr0 = snrt_ssr_desc_3d(
+            ssr0_b[1], ssr0_b[2], ssr0_b[3], ssr0_i[1], ssr0_i[2], ssr0_i[3]);
+        snrt_ssr_desc_repeat(&ssr0, unroll);
+        snrt_ssr_desc_apply(SNRT_SSR_DM0, &ssr0);
 
-        snrt_ssr_loop_4d(SNRT_SSR_DM1, ssr1_b[0], ssr1_b[1], ssr1_b[2],
-                         ssr1_b[3], ssr1_i[0], ssr1_i[1], ssr1_i[2], ssr1_i[3]);
+        const snrt_ssr_desc_t ssr1 =
+            snrt_ssr_desc_4d(ssr1_b[0], ssr1_b[1], ssr1_b[2], ssr1_b[3],
+                             ssr1_i[0], ssr1_i[1], ssr1_i[2], ssr1_i[3]);
+        snrt_ssr_desc_apply(SNRT_SSR_DM1, &ssr1);
     }
 
     // SSR start address need to be configured each time
-    snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_4D, A);
-    snrt_ssr_read(SNRT_SSR_DM1, SNRT_SSR_4D, B);
+    snrt_ssr_rebase_read(SNRT_SSR_DM0, SNRT_SSR_4D, A);
+    snrt_ssr_rebase_read(SNRT_SSR_DM1, SNRT_SSR_4D, B);
     snrt_ssr_enable();
 
     // Kernel progresses by 2 values each step
@@ -378,17 +412,20 @@ void gemm_fp16simd_tb_ssr_frep(uint32_t M, uint32_t N, uint32_t K, __fp16* A,
         uint32_t ssr1_i[4] = {sizeof(__fp16) * ldB, sizeof(__fp16) * 4,
                               sizeof(__fp16) * unroll * ldB, 0};
 
-        snrt_ssr_loop_3d(SNRT_SSR_DM0, ssr0_b[1], ssr0_b[2], ssr0_b[3],
-                         ssr0_i[1], ssr0_i[2], ssr0_i[3]);
-        snrt_ssr_repeat(SNRT_SSR_DM0, unroll);
+        snrt_ssr_desc_t ssr0 = snrt_ssr_desc_3d(
+            ssr0_b[1], ssr0_b[2], ssr0_b[3], ssr0_i[1], ssr0_i[2], ssr0_i[3]);
+        snrt_ssr_desc_repeat(&ssr0, unroll);
+        snrt_ssr_desc_apply(SNRT_SSR_DM0, &ssr0);
 
-        snrt_ssr_loop_4d(SNRT_SSR_DM1, ssr1_b[0], ssr1_b[1], ssr1_b[2],
-                         ssr1_b[3], ssr1_i[0], ssr1_i[1], ssr1_i[2], ssr1_i[3]);
+        const snrt_ssr_desc_t ssr1 =
+            snrt_ssr_desc_4d(ssr1_b[0], ssr1_b[1], ssr1_b[2], ssr1_b[3],
+                             ssr1_i[0], ssr1_i[1], ssr1_i[2], ssr1_i[3]);
+        snrt_ssr_desc_apply(SNRT_SSR_DM1, &ssr1);
     }
 
     // SSR start address need to be configured each time
-    snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_4D, A);
-    snrt_ssr_read(SNRT_SSR_DM1, SNRT_SSR_4D, B);
+    snrt_ssr_rebase_read(SNRT_SSR_DM0, SNRT_SSR_4D, A);
+    snrt_ssr_rebase_read(SNRT_SSR_DM1, SNRT_SSR_4D, B);
     snrt_ssr_enable();
 
     // Kernel progresses by 4 values each step
@@ -407,14 +444,23 @@ void gemm_fp16simd_tb_ssr_frep(uint32_t M, uint32_t N, uint32_t K, __fp16* A,
                 "lw      %[alpha], 0(%[ALPHA]) \n"
                 "beqz    %[alpha], 1f \n"
                 // Load intermediate results
-                "flw %[c0], 0(%[C]) \n"
-                "flw %[c1], 4(%[C]) \n"
-                "flw %[c2], 8(%[C]) \n"
-                "flw %[c3], 12(%[C]) \n"
-                "flw %[c4], 16(%[C]) \n"
-                "flw %[c5], 20(%[C]) \n"
-                "flw %[c6], 24(%[C]) \n"
-                "flw %[c7], 28(%[C]) \n"
+                "flh %[c0], 0(%[C]) \n"
+                "flh %[c1], 2(%[C]) \n"
+                "flh %[c2], 4(%[C]) \n"
+                "flh %[c3], 6(%[C]) \n"
+                "flh %[c4], 8(%[C]) \n"
+                "flh %[c5], 10(%[C]) \n"
+                "flh %[c6], 12(%[C]) \n"
+                "flh %[c7], 14(%[C]) \n"
+                // Convert them to the FP32 accumulators
+                "fcvt.s.h %[c0], %[c0] \n"
+                "fcvt.s.h %[c1], %[c1] \n"
+                "fcvt.s.h %[c2], %[c2] \n"
+                "fcvt.s.h %[c3], %[c3] \n"
+                "fcvt.s.h %[c4], %[c4] \n"
+                "fcvt.s.h %[c5], %[c5] \n"
+                "fcvt.s.h %[c6], %[c6] \n"
+                "fcvt.s.h %[c7], %[c7] \n"
                 // Pack intermediate results into SIMD vector
                 "vfcpka.s.s %[c0], %[c0], %[zero]\n"
                 "vfcpka.s.s %[c1], %[c1], %[zero]\n"
@@ -508,3 +554,409 @@ void gemm_fp16simd_tb_ssr_frep(uint32_t M, uint32_t N, uint32_t K, __fp16* A,
 
     asm volatile("" ::"f"(ft0), "f"(ft1), "f"(ft2));
 }
+
+void gemm_fp16simd_ex_tb_ssr_frep(uint32_t M, uint32_t N, uint32_t K,
+                                  __fp16* A, uint32_t ldA, __fp16* B,
+                                  uint32_t ldB, float* C, uint32_t ldC,
+                                  const uint32_t* ALPHA, uint32_t setup_SSR) {
+    register volatile double ft0 asm("ft0");
+    register volatile double ft1 asm("ft1");
+    register volatile double ft2 asm("ft2");
+    asm volatile("" : "=f"(ft0), "=f"(ft1), "=f"(ft2));
+
+    // Unrolling factor of most inner loop.
+    // Should be at least as high as the FMA delay
+    // for maximum utilization
+    const uint32_t unroll = 8;
+
+    // SSR strides and bounds only have to be configured
+    // once in the beginning
+    if (setup_SSR) {
+        uint32_t ssr0_b[4] = {unroll, K / 4, N / unroll, M};
+        uint32_t ssr0_i[4] = {0, sizeof(__fp16) * 4, 0, sizeof(__fp16) * ldA};
+
+        uint32_t ssr1_b[4] = {unroll, K / 4, N / unroll, M};
+        uint32_t ssr1_i[4] = {sizeof(__fp16) * ldB, sizeof(__fp16) * 4,
+                              sizeof(__fp16) * unroll * ldB, 0};
+
+        snrt_ssr_desc_t ssr0 = snrt_ssr_desc_3d(
+            ssr0_b[1], ssr0_b[2], ssr0_b[3], ssr0_i[1], ssr0_i[2], ssr0_i[3]);
+        snrt_ssr_desc_repeat(&ssr0, unroll);
+        snrt_ssr_desc_apply(SNRT_SSR_DM0, &ssr0);
+
+        const snrt_ssr_desc_t ssr1 =
+            snrt_ssr_desc_4d(ssr1_b[0], ssr1_b[1], ssr1_b[2], ssr1_b[3],
+                             ssr1_i[0], ssr1_i[1], ssr1_i[2], ssr1_i[3]);
+        snrt_ssr_desc_apply(SNRT_SSR_DM1, &ssr1);
+    }
+
+    // SSR start address need to be configured each time
+    snrt_ssr_rebase_read(SNRT_SSR_DM0, SNRT_SSR_4D, A);
+    snrt_ssr_rebase_read(SNRT_SSR_DM1, SNRT_SSR_4D, B);
+    snrt_ssr_enable();
+
+    // Kernel progresses by 4 values each step
+    const uint32_t n_frep = K / 4 - 1;
+
+    for (uint32_t m = 0; m < M; m++) {
+        uint32_t n = 0;
+        for (uint32_t n0 = 0; n0 < N / unroll; n0++) {
+            float* _C = &C[m * ldC + n];
+            const register float zero = 0.0;
+            register v2f32 c[unroll], reduce_reg[unroll];
+            uint32_t alpha;
+
+            asm volatile(
+                "lw      %[alpha], 0(%[ALPHA]) \n"
+                "beqz    %[alpha], 1f \n"
+                // Load intermediate results
+                "flw %[c0], 0(%[C]) \n"
+                "flw %[c1], 4(%[C]) \n"
+                "flw %[c2], 8(%[C]) \n"
+                "flw %[c3], 12(%[C]) \n"
+                "flw %[c4], 16(%[C]) \n"
+                "flw %[c5], 20(%[C]) \n"
+                "flw %[c6], 24(%[C]) \n"
+                "flw %[c7], 28(%[C]) \n"
+                // Pack intermediate results into SIMD vector
+                "vfcpka.s.s %[c0], %[c0], %[zero] \n"
+                "vfcpka.s.s %[c1], %[c1], %[zero] \n"
+                "vfcpka.s.s %[c2], %[c2], %[zero] \n"
+                "vfcpka.s.s %[c3], %[c3], %[zero] \n"
+                "vfcpka.s.s %[c4], %[c4], %[zero] \n"
+                "vfcpka.s.s %[c5], %[c5], %[zero] \n"
+                "vfcpka.s.s %[c6], %[c6], %[zero] \n"
+                "vfcpka.s.s %[c7], %[c7], %[zero] \n"
+                "j 2f \n"
+                "1: \n"
+                // Initialize SIMD vector with zeros
+                "vfcpka.s.s %[c0], %[zero], %[zero] \n"
+                "vfcpka.s.s %[c1], %[zero], %[zero] \n"
+                "vfcpka.s.s %[c2], %[zero], %[zero] \n"
+                "vfcpka.s.s %[c3], %[zero], %[zero] \n"
+                "vfcpka.s.s %[c4], %[zero], %[zero] \n"
+                "vfcpka.s.s %[c5], %[zero], %[zero] \n"
+                "vfcpka.s.s %[c6], %[zero], %[zero] \n"
+                "vfcpka.s.s %[c7], %[zero], %[zero] \n"
+                "2: \n"
+                // Perform expanding sum-dotproducts
+                "frep.o  %[n_frep], 8, 0, 0 \n"
+                "vfdotpex.s.h %[c0], ft1, ft0 \n"
+                "vfdotpex.s.h %[c1], ft1, ft0 \n"
+                "vfdotpex.s.h %[c2], ft1, ft0 \n"
+                "vfdotpex.s.h %[c3], ft1, ft0 \n"
+                "vfdotpex.s.h %[c4], ft1, ft0 \n"
+                "vfdotpex.s.h %[c5], ft1, ft0 \n"
+                "vfdotpex.s.h %[c6], ft1, ft0 \n"
+                "vfdotpex.s.h %[c7], ft1, ft0 \n"
+                // Initialize reduce register to zero
+                "vfcpka.s.s %[reduce_reg0], %[zero], %[zero] \n"
+                "vfcpka.s.s %[reduce_reg1], %[zero], %[zero] \n"
+                "vfcpka.s.s %[reduce_reg2], %[zero], %[zero] \n"
+                "vfcpka.s.s %[reduce_reg3], %[zero], %[zero] \n"
+                "vfcpka.s.s %[reduce_reg4], %[zero], %[zero] \n"
+                "vfcpka.s.s %[reduce_reg5], %[zero], %[zero] \n"
+                "vfcpka.s.s %[reduce_reg6], %[zero], %[zero] \n"
+                "vfcpka.s.s %[reduce_reg7], %[zero], %[zero] \n"
+                // Sum-reduce vector
+                "vfsum.s %[reduce_reg0], %[c0] \n"
+                "vfsum.s %[reduce_reg1], %[c1] \n"
+                "vfsum.s %[reduce_reg2], %[c2] \n"
+                "vfsum.s %[reduce_reg3], %[c3] \n"
+                "vfsum.s %[reduce_reg4], %[c4] \n"
+                "vfsum.s %[reduce_reg5], %[c5] \n"
+                "vfsum.s %[reduce_reg6], %[c6] \n"
+                "vfsum.s %[reduce_reg7], %[c7] \n"
+                // Pack results together again into vectors
+                "vfcpka.s.s %[c0], %[reduce_reg0], %[reduce_reg1] \n"
+                "vfcpka.s.s %[c1], %[reduce_reg2], %[reduce_reg3] \n"
+                "vfcpka.s.s %[c2], %[reduce_reg4], %[reduce_reg5] \n"
+                "vfcpka.s.s %[c3], %[reduce_reg6], %[reduce_reg7] \n"
+                : [ c0 ] "+f"(c[0]), [ c1 ] "+f"(c[1]), [ c2 ] "+f"(c[2]),
+                  [ c3 ] "+f"(c[3]), [ c4 ] "+f"(c[4]), [ c5 ] "+f"(c[5]),
+                  [ c6 ] "+f"(c[6]), [ c7 ] "+f"(c[7]), [ alpha ] "=r"(alpha),
+                  [ reduce_reg0 ] "+f"(reduce_reg[0]),
+                  [ reduce_reg1 ] "+f"(reduce_reg[1]),
+                  [ reduce_reg2 ] "+f"(reduce_reg[2]),
+                  [ reduce_reg3 ] "+f"(reduce_reg[3]),
+                  [ reduce_reg4 ] "+f"(reduce_reg[4]),
+                  [ reduce_reg5 ] "+f"(reduce_reg[5]),
+                  [ reduce_reg6 ] "+f"(reduce_reg[6]),
+                  [ reduce_reg7 ] "+f"(reduce_reg[7])
+                : [ C ] "r"(_C), [ zero ] "f"(zero), [ n_frep ] "r"(n_frep),
+                  [ ALPHA ] "r"(ALPHA)
+                : "ft0", "ft1", "ft2");
+
+            // Store results back
+            ((v2f32*)_C)[0] = c[0];
+            ((v2f32*)_C)[1] = c[1];
+            ((v2f32*)_C)[2] = c[2];
+            ((v2f32*)_C)[3] = c[3];
+            n += unroll;
+        }
+    }
+
+    snrt_ssr_disable();
+
+    asm volatile("" ::"f"(ft0), "f"(ft1), "f"(ft2));
+}
+
+// Loads of 8 intermediate FP8 or FP16 results at `_C` into reduce_reg0-7,
+// converted to FP16
+#define GEMM_FP8SIMD_LOAD_FP8                                                 \
+    "flb %[reduce_reg0], 0(%[C]) \n"                                          \
+    "flb %[reduce_reg1], 1(%[C]) \n"                                          \
+    "flb %[reduce_reg2], 2(%[C]) \n"                                          \
+    "flb %[reduce_reg3], 3(%[C]) \n"                                          \
+    "flb %[reduce_reg4], 4(%[C]) \n"                                          \
+    "flb %[reduce_reg5], 5(%[C]) \n"                                          \
+    "flb %[reduce_reg6], 6(%[C]) \n"                                          \
+    "flb %[reduce_reg7], 7(%[C]) \n"                                          \
+    "fcvt.h.b %[reduce_reg0], %[reduce_reg0] \n"                              \
+    "fcvt.h.b %[reduce_reg1], %[reduce_reg1] \n"                              \
+    "fcvt.h.b %[reduce_reg2], %[reduce_reg2] \n"                              \
+    "fcvt.h.b %[reduce_reg3], %[reduce_reg3] \n"                              \
+    "fcvt.h.b %[reduce_reg4], %[reduce_reg4] \n"                              \
+    "fcvt.h.b %[reduce_reg5], %[reduce_reg5] \n"                              \
+    "fcvt.h.b %[reduce_reg6], %[reduce_reg6] \n"                              \
+    "fcvt.h.b %[reduce_reg7], %[reduce_reg7] \n"
+
+#define GEMM_FP8SIMD_LOAD_FP16                                                \
+    "flh %[reduce_reg0], 0(%[C]) \n"                                          \
+    "flh %[reduce_reg1], 2(%[C]) \n"                                          \
+    "flh %[reduce_reg2], 4(%[C]) \n"                                          \
+    "flh %[reduce_reg3], 6(%[C]) \n"                                          \
+    "flh %[reduce_reg4], 8(%[C]) \n"                                          \
+    "flh %[reduce_reg5], 10(%[C]) \n"                                         \
+    "flh %[reduce_reg6], 12(%[C]) \n"                                         \
+    "flh %[reduce_reg7], 14(%[C]) \n"
+
+// Packing of the 8 FP32 results in c0-7 into reduce_reg0 (FP8) or
+// reduce_reg0-1 (FP16)
+#define GEMM_FP8SIMD_PACK_FP8                                                 \
+    "vfcpka.b.s %[reduce_reg0], %[c0], %[c1] \n"                              \
+    "vfcpkb.b.s %[reduce_reg0], %[c2], %[c3] \n"                              \
+    "vfcpkc.b.s %[reduce_reg0], %[c4], %[c5] \n"                              \
+    "vfcpkd.b.s %[reduce_reg0], %[c6], %[c7] \n"
+
+#define GEMM_FP8SIMD_PACK_FP16                                                \
+    "vfcpka.h.s %[reduce_reg0], %[c0], %[c1] \n"                              \
+    "vfcpkb.h.s %[reduce_reg0], %[c2], %[c3] \n"                              \
+    "vfcpka.h.s %[reduce_reg1], %[c4], %[c5] \n"                              \
+    "vfcpkb.h.s %[reduce_reg1], %[c6], %[c7] \n"
+
+// One tile of 8 results of an FP8 GEMM: the intermediate results at `_C` are
+// loaded with `load_c` if `*ALPHA` is set, the expanding dot products of
+// ft0 (A) and ft1 (B) are accumulated in FP16 over `n_frep + 1` steps and
+// reduced to FP32, and the results are packed with `pack_c`
+#define GEMM_FP8SIMD_TILE(load_c, pack_c)                                     \
+    asm volatile(                                                             \
+        "lw      %[alpha], 0(%[ALPHA]) \n"                                    \
+        "beqz    %[alpha], 1f \n"                                             \
+        /* Load intermediate results and convert them to FP32 */              \
+        load_c                                                                \
+        "fcvt.s.h %[reduce_reg0], %[reduce_reg0] \n"                          \
+        "fcvt.s.h %[reduce_reg1], %[reduce_reg1] \n"                          \
+        "fcvt.s.h %[reduce_reg2], %[reduce_reg2] \n"                          \
+        "fcvt.s.h %[reduce_reg3], %[reduce_reg3] \n"                          \
+        "fcvt.s.h %[reduce_reg4], %[reduce_reg4] \n"                          \
+        "fcvt.s.h %[reduce_reg5], %[reduce_reg5] \n"                          \
+        "fcvt.s.h %[reduce_reg6], %[reduce_reg6] \n"                          \
+        "fcvt.s.h %[reduce_reg7], %[reduce_reg7] \n"                          \
+        /* Pack intermediate results into SIMD vector */                      \
+        "vfcpka.s.s %[reduce_reg0], %[reduce_reg0], %[zero] \n"               \
+        "vfcpka.s.s %[reduce_reg1], %[reduce_reg1], %[zero] \n"               \
+        "vfcpka.s.s %[reduce_reg2], %[reduce_reg2], %[zero] \n"               \
+        "vfcpka.s.s %[reduce_reg3], %[reduce_reg3], %[zero] \n"               \
+        "vfcpka.s.s %[reduce_reg4], %[reduce_reg4], %[zero] \n"               \
+        "vfcpka.s.s %[reduce_reg5], %[reduce_reg5], %[zero] \n"               \
+        "vfcpka.s.s %[reduce_reg6], %[reduce_reg6], %[zero] \n"               \
+        "vfcpka.s.s %[reduce_reg7], %[reduce_reg7], %[zero] \n"               \
+        "j 2f \n"                                                             \
+        "1: \n"                                                               \
+        /* Initialize SIMD vector with zeros */                               \
+        "vfcpka.s.s %[reduce_reg0], %[zero], %[zero] \n"                      \
+        "vfcpka.s.s %[reduce_reg1], %[zero], %[zero] \n"                      \
+        "vfcpka.s.s %[reduce_reg2], %[zero], %[zero] \n"                      \
+        "vfcpka.s.s %[reduce_reg3], %[zero], %[zero] \n"                      \
+        "vfcpka.s.s %[reduce_reg4], %[zero], %[zero] \n"                      \
+        "vfcpka.s.s %[reduce_reg5], %[zero], %[zero] \n"                      \
+        "vfcpka.s.s %[reduce_reg6], %[zero], %[zero] \n"                      \
+        "vfcpka.s.s %[reduce_reg7], %[zero], %[zero] \n"                      \
+        "2: \n"                                                               \
+        /* Initialize FP16 accumulators with zeros */                         \
+        "vfcpka.s.s %[c0], %[zero], %[zero] \n"                               \
+        "vfcpka.s.s %[c1], %[zero], %[zero] \n"                               \
+        "vfcpka.s.s %[c2], %[zero], %[zero] \n"                               \
+        "vfcpka.s.s %[c3], %[zero], %[zero] \n"                               \
+        "vfcpka.s.s %[c4], %[zero], %[zero] \n"                               \
+        "vfcpka.s.s %[c5], %[zero], %[zero] \n"                               \
+        "vfcpka.s.s %[c6], %[zero], %[zero] \n"                               \
+        "vfcpka.s.s %[c7], %[zero], %[zero] \n"                               \
+        /* Perform expanding sum-dotproducts */                               \
+        "frep.o  %[n_frep], 8, 0, 0 \n"                                       \
+        "vfdotpex.h.b %[c0], ft1, ft0 \n"                                     \
+        "vfdotpex.h.b %[c1], ft1, ft0 \n"                                     \
+        "vfdotpex.h.b %[c2], ft1, ft0 \n"                                     \
+        "vfdotpex.h.b %[c3], ft1, ft0 \n"                                     \
+        "vfdotpex.h.b %[c4], ft1, ft0 \n"                                     \
+        "vfdotpex.h.b %[c5], ft1, ft0 \n"                                     \
+        "vfdotpex.h.b %[c6], ft1, ft0 \n"                                     \
+        "vfdotpex.h.b %[c7], ft1, ft0 \n"                                     \
+        /* Sum-reduce the FP16 accumulators into FP32 vectors */              \
+        "vfsumex.s.h %[reduce_reg0], %[c0] \n"                                \
+        "vfsumex.s.h %[reduce_reg1], %[c1] \n"                                \
+        "vfsumex.s.h %[reduce_reg2], %[c2] \n"                                \
+        "vfsumex.s.h %[reduce_reg3], %[c3] \n"                                \
+        "vfsumex.s.h %[reduce_reg4], %[c4] \n"                                \
+        "vfsumex.s.h %[reduce_reg5], %[c5] \n"                                \
+        "vfsumex.s.h %[reduce_reg6], %[c6] \n"                                \
+        "vfsumex.s.h %[reduce_reg7], %[c7] \n"                                \
+        /* Sum-reduce vector */                                               \
+        "vfcpka.s.s %[c0], %[zero], %[zero] \n"                               \
+        "vfcpka.s.s %[c1], %[zero], %[zero] \n"                               \
+        "vfcpka.s.s %[c2], %[zero], %[zero] \n"                               \
+        "vfcpka.s.s %[c3], %[zero], %[zero] \n"                               \
+        "vfcpka.s.s %[c4], %[zero], %[zero] \n"                               \
+        "vfcpka.s.s %[c5], %[zero], %[zero] \n"                               \
+        "vfcpka.s.s %[c6], %[zero], %[zero] \n"                               \
+        "vfcpka.s.s %[c7], %[zero], %[zero] \n"                               \
+        "vfsum.s %[c0], %[reduce_reg0] \n"                                    \
+        "vfsum.s %[c1], %[reduce_reg1] \n"                                    \
+        "vfsum.s %[c2], %[reduce_reg2] \n"                                    \
+        "vfsum.s %[c3], %[reduce_reg3] \n"                                    \
+        "vfsum.s %[c4], %[reduce_reg4] \n"                                    \
+        "vfsum.s %[c5], %[reduce_reg5] \n"                                    \
+        "vfsum.s %[c6], %[reduce_reg6] \n"                                    \
+        "vfsum.s %[c7], %[reduce_reg7] \n"                                    \
+        /* Pack and convert the results */                                    \
+        pack_c                                                                \
+        : [ c0 ] "+f"(c[0]), [ c1 ] "+f"(c[1]), [ c2 ] "+f"(c[2]),            \
+          [ c3 ] "+f"(c[3]), [ c4 ] "+f"(c[4]), [ c5 ] "+f"(c[5]),            \
+          [ c6 ] "+f"(c[6]), [ c7 ] "+f"(c[7]), [ alpha ] "=r"(alpha),        \
+          [ reduce_reg0 ] "+f"(reduce_reg[0]),                                \
+          [ reduce_reg1 ] "+f"(reduce_reg[1]),                                \
+          [ reduce_reg2 ] "+f"(reduce_reg[2]),                                \
+          [ reduce_reg3 ] "+f"(reduce_reg[3]),                                \
+          [ reduce_reg4 ] "+f"(reduce_reg[4]),                                \
+          [ reduce_reg5 ] "+f"(reduce_reg[5]),                                \
+          [ reduce_reg6 ] "+f"(reduce_reg[6]),                                \
+          [ reduce_reg7 ] "+f"(reduce_reg[7])                                 \
+        : [ C ] "r"(_C), [ zero ] "f"(zero), [ n_frep ] "r"(n_frep),          \
+          [ ALPHA ] "r"(ALPHA)                                                \
+        : "ft0", "ft1", "ft2")
+
+/// Configure the SSRs of the FP8 GEMMs and start them at `A` and `B`.
+static void gemm_fp8simd_ssr(uint32_t M, uint32_t N, uint32_t K, char* A,
+                             uint32_t ldA, char* B, uint32_t ldB,
+                             uint32_t unroll, uint32_t setup_SSR) {
+    // SSR strides and bounds only have to be configured
+    // once in the beginning
+    if (setup_SSR) {
+        uint32_t ssr0_b[4] = {unroll, K / 8, N / unroll, M};
+        uint32_t ssr0_i[4] = {0, sizeof(char) * 8, 0, sizeof(char) * ldA};
+
+        uint32_t ssr1_b[4] = {unroll, K / 8, N / unroll, M};
+        uint32_t ssr1_i[4] = {sizeof(char) * ldB, sizeof(char) * 8,
+                              sizeof(char) * unroll * ldB, 0};
+
+        snrt_ssr_desc_t ssr0 = snrt_ssr_desc_3d(
+            ssr0_b[1], ssr0_b[2], ssr0_b[3], ssr0_i[1], ssr0_i[2], ssr0_i[3]);
+        snrt_ssr_desc_repeat(&ssr0, unroll);
+        snrt_ssr_desc_apply(SNRT_SSR_DM0, &ssr0);
+
+        const snrt_ssr_desc_t ssr1 =
+            snrt_ssr_desc_4d(ssr1_b[0], ssr1_b[1], ssr1_b[2], ssr1_b[3],
+                             ssr1_i[0], ssr1_i[1], ssr1_i[2], ssr1_i[3]);
+        snrt_ssr_desc_apply(SNRT_SSR_DM1, &ssr1);
+    }
+
+    // SSR start address need to be configured each time
+    snrt_ssr_rebase_read(SNRT_SSR_DM0, SNRT_SSR_4D, A);
+    snrt_ssr_rebase_read(SNRT_SSR_DM1, SNRT_SSR_4D, B);
+}
+
+void gemm_fp8simd_tb_ssr_frep(uint32_t M, uint32_t N, uint32_t K, char* A,
+                              uint32_t ldA, char* B, uint32_t ldB, char* C,
+                              uint32_t ldC, const uint32_t* ALPHA,
+                              uint32_t setup_SSR) {
+    register volatile double ft0 asm("ft0");
+    register volatile double ft1 asm("ft1");
+    register volatile double ft2 asm("ft2");
+    asm volatile("" : "=f"(ft0), "=f"(ft1), "=f"(ft2));
+
+    // Unrolling factor of most inner loop.
+    // Should be at least as high as the FMA delay
+    // for maximum utilization
+    const uint32_t unroll = 8;
+
+    gemm_fp8simd_ssr(M, N, K, A, ldA, B, ldB, unroll, setup_SSR);
+    snrt_ssr_enable();
+
+    // Kernel progresses by 8 values each step
+    const uint32_t n_frep = K / 8 - 1;
+
+    for (uint32_t m = 0; m < M; m++) {
+        uint32_t n = 0;
+        for (uint32_t n0 = 0; n0 < N / unroll; n0++) {
+            char* _C = &C[m * ldC + n];
+            const register float zero = 0.0;
+            register v4f16 c[unroll];
+            register v2f32 reduce_reg[unroll];
+            uint32_t alpha;
+
+            GEMM_FP8SIMD_TILE(GEMM_FP8SIMD_LOAD_FP8, GEMM_FP8SIMD_PACK_FP8);
+
+            // Store results back
+            ((v2f32*)_C)[0] = reduce_reg[0];
+            n += unroll;
+        }
+    }
+
+    snrt_ssr_disable();
+
+    asm volatile("" ::"f"(ft0), "f"(ft1), "f"(ft2));
+}
+
+void gemm_fp8simd_ex_tb_ssr_frep(uint32_t M, uint32_t N, uint32_t K, char* A,
+                                 uint32_t ldA, char* B, uint32_t ldB,
+                                 __fp16* C, uint32_t ldC,
+                                 const uint32_t* ALPHA, uint32_t setup_SSR) {
+    register volatile double ft0 asm("ft0");
+    register volatile double ft1 asm("ft1");
+    register volatile double ft2 asm("ft2");
+    asm volatile("" : "=f"(ft0), "=f"(ft1), "=f"(ft2));
+
+    // Unrolling factor of most inner loop.
+    // Should be at least as high as the FMA delay
+    // for maximum utilization
+    const uint32_t unroll = 8;
+
+    gemm_fp8simd_ssr(M, N, K, A, ldA, B, ldB, unroll, setup_SSR);
+    snrt_ssr_enable();
+
+    // Kernel progresses by 8 values each step
+    const uint32_t n_frep = K / 8 - 1;
+
+    for (uint32_t m = 0; m < M; m++) {
+        uint32_t n = 0;
+        for (uint32_t n0 = 0; n0 < N / unroll; n0++) {
+            __fp16* _C = &C[m * ldC + n];
+            const register float zero = 0.0;
+            register v4f16 c[unroll];
+            register v2f32 reduce_reg[unroll];
+            uint32_t alpha;
+
+            GEMM_FP8SIMD_TILE(GEMM_FP8SIMD_LOAD_FP16, GEMM_FP8SIMD_PACK_FP16);
+
+            // Store results back
+            ((v2f32*)_C)[0] = reduce_reg[0];
+            ((v2f32*)_C)[1] = reduce_reg[1];
+            n += unroll;
+        }
+    }
+
+    snrt_ssr_disable();
+
+    asm volatile("" ::"f"(ft0), "f"(ft1), "f"(ft2));
+}
@@ -35,7 +35,8 @@ void gemm_fp64(uint32_t M, uint32_t N, uint32_t K, double* A, uint32_t ldA,
  * @param K number of columns of matrix A
  * @param A pointer to matrix A
  * @param ldA row stride in matrix A
- * @param ta transposed memory layout for matrix A
+ * @param ta transposed memory layout for matrix A, whose rows are then
+ * interleaved across the compute cores of the cluster
  * @param B pointer to matrix B
  * @param ldB row stride in matrix B
  * @param tb transposed memory layout for matrix B
@@ -49,6 +50,20 @@ void gemm_fp64_ssr_frep(uint32_t M, uint32_t N, uint32_t K, double* A,
                         uint32_t tb, double* C, uint32_t ldC,
                         const uint32_t* ALPHA, uint32_t setup_SSR);
 
+/**
+ * @brief FP64 GEMM with configured SSRs and frep loop as
+ * `gemm_fp64_ssr_frep`, computing `unroll` columns of C per frep loop.
+ * `unroll` is 4 or 8 and should be at least the FMA latency, `N` should be a
+ * multiple of it.
+ *
+ * @param unroll number of columns of C computed per frep loop
+ */
+void gemm_fp64_ssr_frep_unroll(uint32_t M, uint32_t N, uint32_t K, double* A,
+                               uint32_t ldA, uint32_t ta, double* B,
+                               uint32_t ldB, uint32_t tb, double* C,
+                               uint32_t ldC, const uint32_t* ALPHA,
+                               uint32_t unroll, uint32_t setup_SSR);
+
 /**
  * @brief implementation of a FP32 SIMD GEMM with configured
  * SSRs and frep loop. Matrix B has to be stored in transposed/consecutive
@@ -95,3 +110,77 @@ void gemm_fp16simd_tb_ssr_frep(uint32_t M, uint32_t N, uint32_t K, __fp16* A,
                                uint32_t ldA, __fp16* B, uint32_t ldB, __fp16* C,
                                uint32_t ldC, const uint32_t* ALPHA,
                                uint32_t setup_SSR);
+
+/**
+ * @brief implementation of an expanding FP16 SIMD GEMM with configured
+ * SSRs and frep loop. The products of the FP16 matrices A and B are
+ * accumulated and stored in FP32. Matrix B has to be stored in
+ * transposed/consecutive memory layout in order to support SIMD instructions.
+ *
+ * @param M number of rows of matrix A
+ * @param N number of columns of matrix B
+ * @param K number of columns of matrix A
+ * @param A pointer to matrix A
+ * @param ldA row stride in matrix A
+ * @param B pointer to matrix B
+ * @param ldB row stride in matrix B
+ * @param C pointer to FP32 matrix C
+ * @param ldC row stride in matrix C
+ * @param ALPHA accmulate factor of C
+ * @param setup_SSR setup SSR bounds and strides
+ * @return * void
+ */
+void gemm_fp16simd_ex_tb_ssr_frep(uint32_t M, uint32_t N, uint32_t K,
+                                  __fp16* A, uint32_t ldA, __fp16* B,
+                                  uint32_t ldB, float* C, uint32_t ldC,
+                                  const uint32_t* ALPHA, uint32_t setup_SSR);
+
+/**
+ * @brief implementation of a FP8 SIMD GEMM with configured
+ * SSRs and frep loop. The products are accumulated in FP16 and the partial
+ * sums reduced in FP32 before rounding the result to FP8. Matrix B has to be
+ * stored in transposed/consecutive memory layout in order to support SIMD
+ * instructions.
+ *
+ * @param M number of rows of matrix A
+ * @param N number of columns of matrix B
+ * @param K number of columns of matrix A
+ * @param A pointer to matrix A
+ * @param ldA row stride in matrix A
+ * @param B pointer to matrix B
+ * @param ldB row stride in matrix B
+ * @param C pointer to matrix C
+ * @param ldC row stride in matrix C
+ * @param ALPHA accmulate factor of C
+ * @param setup_SSR setup SSR bounds and strides
+ * @return * void
+ */
+void gemm_fp8simd_tb_ssr_frep(uint32_t M, uint32_t N, uint32_t K, char* A,
+                              uint32_t ldA, char* B, uint32_t ldB, char* C,
+                              uint32_t ldC, const uint32_t* ALPHA,
+                              uint32_t setup_SSR);
+
+/**
+ * @brief implementation of an expanding FP8 SIMD GEMM with configured
+ * SSRs and frep loop. The products of the FP8 matrices A and B are
+ * accumulated in FP16 and the result is stored in FP16. Matrix B has to be
+ * stored in transposed/consecutive memory layout in order to support SIMD
+ * instructions.
+ *
+ * @param M number of rows of matrix A
+ * @param N number of columns of matrix B
+ * @param K number of columns of matrix A
+ * @param A pointer to matrix A
+ * @param ldA row stride in matrix A
+ * @param B pointer to matrix B
+ * @param ldB row stride in matrix B
+ * @param C pointer to FP16 matrix C
+ * @param ldC row stride in matrix C
+ * @param ALPHA accmulate factor of C
+ * @param setup_SSR setup SSR bounds and strides
+ * @return * void
+ */
+void gemm_fp8simd_ex_tb_ssr_frep(uint32_t M, uint32_t N, uint32_t K, char* A,
+                                 uint32_t ldA, char* B, uint32_t ldB,
+                                 __fp16* C, uint32_t ldC,
+                                 const uint32_t* ALPHA, uint32_t setup_SSR);
@@ -4,17 +4,402 @@
 
 #include "snrt.h"
 
+typedef float v2f32 __attribute__((vector_size(8)));
+typedef __fp16 v4f16 __attribute__((vector_size(8)));
+typedef char v8f8 __attribute__((vector_size(8)));
+
+// Streams the pooling windows of the `n` words of channels of a core, which
+// are `compute_num` words apart, `repeat` times each, and writes back one word
+// per window. The windows of `unroll` words are interleaved to hide the FPU
+// latency.
+static void pool_ssr_setup(void *ifmap, void *ofmap, uint32_t CI_bytes,
+                           uint32_t window, uint32_t n, uint32_t unroll,
+                           uint32_t repeat, uint32_t compute_num) {
+    snrt_ssr_repeat(SNRT_SSR_DM0, repeat);
+    snrt_ssr_loop_3d(SNRT_SSR_DM0, unroll, window, n / unroll,
+                     compute_num * sizeof(double), CI_bytes,
+                     unroll * compute_num * sizeof(double));
+    snrt_ssr_loop_1d(SNRT_SSR_DM1, n, compute_num * sizeof(double));
+    snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_3D, ifmap);
+    snrt_ssr_write(SNRT_SSR_DM1, SNRT_SSR_1D, ofmap);
+    snrt_ssr_enable();
+}
+
+static void pool_ssr_teardown() {
+    snrt_fpu_fence();
+    __builtin_ssr_barrier(SNRT_SSR_DM1);
+    snrt_ssr_disable();
+}
+
 void maxpool_fp64(double *ifmap, double *ofmap, uint32_t CI, uint32_t FH,
                   uint32_t FW, uint32_t compute_num) {
-    for (uint32_t ci = 0; ci < CI; ci += compute_num) {
-        register volatile double max = ifmap[ci];
+    const uint32_t n = CI / compute_num;
+    const uint32_t window = FH * FW;
+    const uint32_t unroll = n % 4 ? 1 : 4;
+    pool_ssr_setup(ifmap, ofmap, CI * sizeof(double), window, n, unroll, 1,
+                   compute_num);
+
+    register double m0, m1, m2, m3;
+    if (unroll == 4) {
+        for (uint32_t i = 0; i < n; i += 4) {
+            asm volatile(
+                "fmv.d %[m0], ft0 \n"
+                "fmv.d %[m1], ft0 \n"
+                "fmv.d %[m2], ft0 \n"
+                "fmv.d %[m3], ft0 \n"
+                "frep.o %[n_frep], 4, 0, 0 \n"
+                "fmax.d %[m0], %[m0], ft0 \n"
+                "fmax.d %[m1], %[m1], ft0 \n"
+                "fmax.d %[m2], %[m2], ft0 \n"
+                "fmax.d %[m3], %[m3], ft0 \n"
+                "fmv.d ft1, %[m0] \n"
+                "fmv.d ft1, %[m1] \n"
+                "fmv.d ft1, %[m2] \n"
+                "fmv.d ft1, %[m3] \n"
+                : [ m0 ] "=&f"(m0), [ m1 ] "=&f"(m1), [ m2 ] "=&f"(m2),
+                  [ m3 ] "=&f"(m3)
+                : [ n_frep ] "r"(window - 2)
+                : "ft0", "ft1", "ft2");
+        }
+    } else {
+        for (uint32_t i = 0; i < n; i++) {
+            asm volatile(
+                "fmv.d %[m0], ft0 \n"
+                "frep.o %[n_frep], 1, 0, 0 \n"
+                "fmax.d %[m0], %[m0], ft0 \n"
+                "fmv.d ft1, %[m0] \n"
+                : [ m0 ] "=&f"(m0)
+                : [ n_frep ] "r"(window - 2)
+                : "ft0", "ft1", "ft2");
+        }
+    }
+
+    pool_ssr_teardown();
+}
+
+void maxpool_fp32simd(float *ifmap, float *ofmap, uint32_t CI, uint32_t FH,
+                      uint32_t FW, uint32_t compute_num) {
+    // Every 64-bit word holds 2 channels
+    const uint32_t n = CI / 2 / compute_num;
+    const uint32_t window = FH * FW;
+    const uint32_t unroll = n % 4 ? 1 : 4;
+    pool_ssr_setup(ifmap, ofmap, CI * sizeof(float), window, n, unroll, 1,
+                   compute_num);
+
+    register v2f32 m0, m1, m2, m3;
+    if (unroll == 4) {
+        for (uint32_t i = 0; i < n; i += 4) {
+            asm volatile(
+                "fmv.d %[m0], ft0 \n"
+                "fmv.d %[m1], ft0 \n"
+                "fmv.d %[m2], ft0 \n"
+                "fmv.d %[m3], ft0 \n"
+                "frep.o %[n_frep], 4, 0, 0 \n"
+                "vfmax.s %[m0], %[m0], ft0 \n"
+                "vfmax.s %[m1], %[m1], ft0 \n"
+                "vfmax.s %[m2], %[m2], ft0 \n"
+                "vfmax.s %[m3], %[m3], ft0 \n"
+                "fmv.d ft1, %[m0] \n"
+                "fmv.d ft1, %[m1] \n"
+                "fmv.d ft1, %[m2] \n"
+                "fmv.d ft1, %[m3] \n"
+                : [ m0 ] "=&f"(m0), [ m1 ] "=&f"(m1), [ m2 ] "=&f"(m2),
+                  [ m3 ] "=&f"(m3)
+                : [ n_frep ] "r"(window - 2)
+                : "ft0", "ft1", "ft2");
+        }
+    } else {
+        for (uint32_t i = 0; i < n; i++) {
+            asm volatile(
+                "fmv.d %[m0], ft0 \n"
+                "frep.o %[n_frep], 1, 0, 0 \n"
+                "vfmax.s %[m0], %[m0], ft0 \n"
+                "fmv.d ft1, %[m0] \n"
+                : [ m0 ] "=&f"(m0)
+                : [ n_frep ] "r"(window - 2)
+                : "ft0", "ft1", "ft2");
+        }
+    }
+
+    pool_ssr_teardown();
+}
+
+void maxpool_fp16simd(__fp16 *ifmap, __fp16 *ofmap, uint32_t CI, uint32_t FH,
+                      uint32_t FW, uint32_t compute_num) {
+    // Every 64-bit word holds 4 channels
+    const uint32_t n = CI / 4 / compute_num;
+    const uint32_t window = FH * FW;
+    const uint32_t unroll = n % 4 ? 1 : 4;
+    pool_ssr_setup(ifmap, ofmap, CI * sizeof(__fp16), window, n, unroll, 1,
+                   compute_num);
+
+    register v4f16 m0, m1, m2, m3;
+    if (unroll == 4) {
+        for (uint32_t i = 0; i < n; i += 4) {
+            asm volatile(
+                "fmv.d %[m0], ft0 \n"
+                "fmv.d %[m1], ft0 \n"
+                "fmv.d %[m2], ft0 \n"
+                "fmv.d %[m3], ft0 \n"
+                "frep.o %[n_frep], 4, 0, 0 \n"
+                "vfmax.h %[m0], %[m0], ft0 \n"
+                "vfmax.h %[m1], %[m1], ft0 \n"
+                "vfmax.h %[m2], %[m2], ft0 \n"
+                "vfmax.h %[m3], %[m3], ft0 \n"
+                "fmv.d ft1, %[m0] \n"
+                "fmv.d ft1, %[m1] \n"
+                "fmv.d ft1, %[m2] \n"
+                "fmv.d ft1, %[m3] \n"
+                : [ m0 ] "=&f"(m0), [ m1 ] "=&f"(m1), [ m2 ] "=&f"(m2),
+                  [ m3 ] "=&f"(m3)
+                : [ n_frep ] "r"(window - 2)
+                : "ft0", "ft1", "ft2");
+        }
+    } else {
+        for (uint32_t i = 0; i < n; i++) {
+            asm volatile(
+                "fmv.d %[m0], ft0 \n"
+                "frep.o %[n_frep], 1, 0, 0 \n"
+                "vfmax.h %[m0], %[m0], ft0 \n"
+                "fmv.d ft1, %[m0] \n"
+                : [ m0 ] "=&f"(m0)
+                : [ n_frep ] "r"(window - 2)
+                : "ft0", "ft1", "ft2");
+        }
+    }
+
+    pool_ssr_teardown();
+}
+
+void maxpool_fp8simd(char *ifmap, char *ofmap, uint32_t CI, uint32_t FH,
+                     uint32_t FW, uint32_t compute_num) {
+    // Every 64-bit word holds 8 channels
+    const uint32_t words = CI / 8;
+    v8f8 *in = (v8f8 *)ifmap;
+    v8f8 *out = (v8f8 *)ofmap;
+
+    for (uint32_t w = 0; w < words; w += compute_num) {
+        register v8f8 max = in[w];
         for (uint32_t fh = 0; fh < FH; fh++) {
             for (uint32_t fw = 0; fw < FW; fw++) {
-                if (ifmap[(fh * FW + fw) * CI + ci] > max) {
-                    max = ifmap[(fh * FW + fw) * CI + ci];
-                }
+                register v8f8 x = in[(fh * FW + fw) * words + w];
+                asm volatile("vfmax.b %[max], %[max], %[x] \n"
+                             : [ max ] "+f"(max)
+                             : [ x ] "f"(x));
             }
         }
-        ofmap[ci] = max;
+        out[w] = max;
+    }
+}
+
+void avgpool_fp64(double *ifmap, double *ofmap, uint32_t CI, uint32_t FH,
+                  uint32_t FW, uint32_t compute_num) {
+    const uint32_t n = CI / compute_num;
+    const uint32_t window = FH * FW;
+    const uint32_t unroll = n % 4 ? 1 : 4;
+    register const double scale = 1.0 / window;
+    pool_ssr_setup(ifmap, ofmap, CI * sizeof(double), window, n, unroll, 1,
+                   compute_num);
+
+    register double s0, s1, s2, s3;
+    if (unroll == 4) {
+        for (uint32_t i = 0; i < n; i += 4) {
+            asm volatile(
+                "fmv.d %[s0], ft0 \n"
+                "fmv.d %[s1], ft0 \n"
+                "fmv.d %[s2], ft0 \n"
+                "fmv.d %[s3], ft0 \n"
+                "frep.o %[n_frep], 4, 0, 0 \n"
+                "fadd.d %[s0], %[s0], ft0 \n"
+                "fadd.d %[s1], %[s1], ft0 \n"
+                "fadd.d %[s2], %[s2], ft0 \n"
+                "fadd.d %[s3], %[s3], ft0 \n"
+                "fmul.d ft1, %[s0], %[scale] \n"
+                "fmul.d ft1, %[s1], %[scale] \n"
+                "fmul.d ft1, %[s2], %[scale] \n"
+                "fmul.d ft1, %[s3], %[scale] \n"
+                : [ s0 ] "=&f"(s0), [ s1 ] "=&f"(s1), [ s2 ] "=&f"(s2),
+                  [ s3 ] "=&f"(s3)
+                : [ n_frep ] "r"(window - 2), [ scale ] "f"(scale)
+                : "ft0", "ft1", "ft2");
+        }
+    } else {
+        for (uint32_t i = 0; i < n; i++) {
+            asm volatile(
+                "fmv.d %[s0], ft0 \n"
+                "frep.o %[n_frep], 1, 0, 0 \n"
+                "fadd.d %[s0], %[s0], ft0 \n"
+                "fmul.d ft1, %[s0], %[scale] \n"
+                : [ s0 ] "=&f"(s0)
+                : [ n_frep ] "r"(window - 2), [ scale ] "f"(scale)
+                : "ft0", "ft1", "ft2");
+        }
+    }
+
+    pool_ssr_teardown();
+}
+
+void avgpool_fp32simd(float *ifmap, float *ofmap, uint32_t CI, uint32_t FH,
+                      uint32_t FW, uint32_t compute_num) {
+    // Every 64-bit word holds 2 channels
+    const uint32_t n = CI / 2 / compute_num;
+    const uint32_t window = FH * FW;
+    const uint32_t unroll = n % 4 ? 1 : 4;
+    const float f = 1.0f / window;
+    register const v2f32 scale = {f, f};
+    pool_ssr_setup(ifmap, ofmap, CI * sizeof(float), window, n, unroll, 1,
+                   compute_num);
+
+    register v2f32 s0, s1, s2, s3;
+    if (unroll == 4) {
+        for (uint32_t i = 0; i < n; i += 4) {
+            asm volatile(
+                "fmv.d %[s0], ft0 \n"
+                "fmv.d %[s1], ft0 \n"
+                "fmv.d %[s2], ft0 \n"
+                "fmv.d %[s3], ft0 \n"
+                "frep.o %[n_frep], 4, 0, 0 \n"
+                "vfadd.s %[s0], %[s0], ft0 \n"
+                "vfadd.s %[s1], %[s1], ft0 \n"
+                "vfadd.s %[s2], %[s2], ft0 \n"
+                "vfadd.s %[s3], %[s3], ft0 \n"
+                "vfmul.s ft1, %[s0], %[scale] \n"
+                "vfmul.s ft1, %[s1], %[scale] \n"
+                "vfmul.s ft1, %[s2], %[scale] \n"
+                "vfmul.s ft1, %[s3], %[scale] \n"
+                : [ s0 ] "=&f"(s0), [ s1 ] "=&f"(s1), [ s2 ] "=&f"(s2),
+                  [ s3 ] "=&f"(s3)
+                : [ n_frep ] "r"(window - 2), [ scale ] "f"(scale)
+                : "ft0", "ft1", "ft2");
+        }
+    } else {
+        for (uint32_t i = 0; i < n; i++) {
+            asm volatile(
+                "fmv.d %[s0], ft0 \n"
+                "frep.o %[n_frep], 1, 0, 0 \n"
+                "vfadd.s %[s0], %[s0], ft0 \n"
+                "vfmul.s ft1, %[s0], %[scale] \n"
+                : [ s0 ] "=&f"(s0)
+                : [ n_frep ] "r"(window - 2), [ scale ] "f"(scale)
+                : "ft0", "ft1", "ft2");
+        }
+    }
+
+    pool_ssr_teardown();
+}
+
+// Accumulation of a streamed word of four fp16 channels (ft0, read twice) in
+// fp32: the even channels 0 and 2 into the two lanes of `e`, the odd channels
+// 1 and 3 into the two lanes of `o`
+#define AVG_H_ACC(e, o)                                                       \
+    "vfdotpex.s.h %[" e "], ft0, %[even] \n"                                  \
+    "vfdotpex.s.h %[" o "], ft0, %[odd] \n"
+
+// Scale the sums `e` and `o` and write them back as a word of four fp16
+// channels through ft1. Channels 2 and 3 are moved into the low lanes by
+// clearing the high ones and summing the lanes.
+#define AVG_H_STORE(e, o)                                                     \
+    "vfmul.s %[" e "], %[" e "], %[scale] \n"                                 \
+    "vfmul.s %[" o "], %[" o "], %[scale] \n"                                 \
+    "vfcpka.h.s %[p], %[" e "], %[" o "] \n"                                  \
+    "vfmul.s %[" e "], %[" e "], %[high] \n"                                  \
+    "vfmul.s %[" o "], %[" o "], %[high] \n"                                  \
+    "vfsum.s %[" e "], %[" e "] \n"                                           \
+    "vfsum.s %[" o "], %[" o "] \n"                                           \
+    "vfcpkb.h.s %[p], %[" e "], %[" o "] \n"                                  \
+    "fmv.d ft1, %[p] \n"
+
+void avgpool_fp16simd(__fp16 *ifmap, __fp16 *ofmap, uint32_t CI, uint32_t FH,
+                      uint32_t FW, uint32_t compute_num) {
+    // Every 64-bit word holds 4 channels, which are summed up in fp32 such
+    // that large windows neither overflow nor lose the small addends
+    const uint32_t n = CI / 4 / compute_num;
+    const uint32_t window = FH * FW;
+    const uint32_t unroll = n % 4 ? 1 : 4;
+    const float f = 1.0f / window;
+    register const v2f32 scale = {f, f};
+    register const v2f32 high = {0.0f, 1.0f};
+    register const v4f16 even = {1.0f, 0.0f, 1.0f, 0.0f};
+    register const v4f16 odd = {0.0f, 1.0f, 0.0f, 1.0f};
+    pool_ssr_setup(ifmap, ofmap, CI * sizeof(__fp16), window, n, unroll, 2,
+                   compute_num);
+
+    register v2f32 e0, e1, e2, e3, o0, o1, o2, o3;
+    register v4f16 p;
+    if (unroll == 4) {
+        for (uint32_t i = 0; i < n; i += 4) {
+            asm volatile(
+                "fcvt.d.w %[e0], zero \n"
+                "fcvt.d.w %[e1], zero \n"
+                "fcvt.d.w %[e2], zero \n"
+                "fcvt.d.w %[e3], zero \n"
+                "fcvt.d.w %[o0], zero \n"
+                "fcvt.d.w %[o1], zero \n"
+                "fcvt.d.w %[o2], zero \n"
+                "fcvt.d.w %[o3], zero \n"
+                "frep.o %[n_frep], 8, 0, 0 \n" AVG_H_ACC("e0", "o0")
+                    AVG_H_ACC("e1", "o1") AVG_H_ACC("e2", "o2")
+                    AVG_H_ACC("e3", "o3") AVG_H_STORE("e0", "o0")
+                    AVG_H_STORE("e1", "o1") AVG_H_STORE("e2", "o2")
+                    AVG_H_STORE("e3", "o3")
+                : [ e0 ] "=&f"(e0), [ e1 ] "=&f"(e1), [ e2 ] "=&f"(e2),
+                  [ e3 ] "=&f"(e3), [ o0 ] "=&f"(o0), [ o1 ] "=&f"(o1),
+                  [ o2 ] "=&f"(o2), [ o3 ] "=&f"(o3), [ p ] "=&f"(p)
+                : [ n_frep ] "r"(window - 1), [ scale ] "f"(scale),
+                  [ high ] "f"(high), [ even ] "f"(even), [ odd ] "f"(odd)
+                : "ft0", "ft1", "ft2");
+        }
+    } else {
+        for (uint32_t i = 0; i < n; i++) {
+            asm volatile(
+                "fcvt.d.w %[e0], zero \n"
+                "fcvt.d.w %[o0], zero \n"
+                "frep.o %[n_frep], 2, 0, 0 \n" AVG_H_ACC("e0", "o0")
+                    AVG_H_STORE("e0", "o0")
+                : [ e0 ] "=&f"(e0), [ o0 ] "=&f"(o0), [ p ] "=&f"(p)
+                : [ n_frep ] "r"(window - 1), [ scale ] "f"(scale),
+                  [ high ] "f"(high), [ even ] "f"(even), [ odd ] "f"(odd)
+                : "ft0", "ft1", "ft2");
+        }
     }
+
+    pool_ssr_teardown();
+    // Kernels which do not configure the repetition expect none
+    snrt_ssr_repeat(SNRT_SSR_DM0, 1);
+}
+
+void bn_relu_maxpool_fp64(double *ifmap, double gamma, double beta,
+                          double *ofmap, uint32_t OW, uint32_t IW, uint32_t CI,
+                          uint32_t FH, uint32_t FW) {
+    // Stream the pooling windows one after the other and write back the
+    // pooled pixels
+    snrt_ssr_repeat(SNRT_SSR_DM0, 1);
+    snrt_ssr_loop_3d(SNRT_SSR_DM0, FW, FH, OW, CI * sizeof(double),
+                     IW * CI * sizeof(double), FW * CI * sizeof(double));
+    snrt_ssr_loop_1d(SNRT_SSR_DM1, OW, CI * sizeof(double));
+    snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_3D, ifmap);
+    snrt_ssr_write(SNRT_SSR_DM1, SNRT_SSR_1D, ofmap);
+    snrt_ssr_enable();
+
+    // ReLU commutes with the maximum, such that it only has to be applied
+    // once per window
+    register double max;
+    register double bn;
+    register const double zero = 0.0;
+    for (uint32_t ow = 0; ow < OW; ow++) {
+        asm volatile(
+            "fmadd.d %[max], ft0, %[g], %[b] \n"
+            "frep.o %[n_frep], 2, 0, 0 \n"
+            "fmadd.d %[bn], ft0, %[g], %[b] \n"
+            "fmax.d %[max], %[max], %[bn] \n"
+            "fmax.d ft1, %[max], %[zero] \n"
+            : [ max ] "=&f"(max), [ bn ] "=&f"(bn)
+            : [ g ] "f"(gamma), [ b ] "f"(beta), [ zero ] "f"(zero),
+              [ n_frep ] "r"(FH * FW - 2)
+            : "ft0", "ft1", "ft2");
+    }
+
+    snrt_fpu_fence();
+    __builtin_ssr_barrier(SNRT_SSR_DM1);
+    snrt_ssr_disable();
 }
@@ -5,14 +5,123 @@
 #include "snrt.h"
 
 /**
- * @brief implementation of FP64 maxpooling
+ * @brief implementation of FP64 maxpooling with SSR streams and FREP. Every
+ * core pools every `compute_num`-th channel of a buffer of FH * FW pixels.
+ *
+ * @param ifmap pointer to the first channel of the core in the window
+ * @param ofmap pointer to the first channel of the core in the output pixel
+ * @param CI number of input channels (stride between pixels), a multiple of
+ * compute_num
+ * @param FH height of filter
+ * @param FW width of filter, FH * FW must be at least 2
+ * @param compute_num number of compute units
+ */
+void maxpool_fp64(double *ifmap, double *ofmap, uint32_t CI, uint32_t FH,
+                  uint32_t FW, uint32_t compute_num);
+
+/**
+ * @brief implementation of FP32 SIMD maxpooling with SSR streams and FREP,
+ * computing 2 channels per instruction
+ *
+ * @param ifmap pointer to the first channel of the core in the window
+ * @param ofmap pointer to the first channel of the core in the output pixel
+ * @param CI number of input channels, a multiple of 2 * compute_num
+ * @param FH height of filter
+ * @param FW width of filter, FH * FW must be at least 2
+ * @param compute_num number of compute units
+ */
+void maxpool_fp32simd(float *ifmap, float *ofmap, uint32_t CI, uint32_t FH,
+                      uint32_t FW, uint32_t compute_num);
+
+/**
+ * @brief implementation of FP16 SIMD maxpooling with SSR streams and FREP,
+ * computing 4 channels per instruction
+ *
+ * @param ifmap pointer to the first channel of the core in the window
+ * @param ofmap pointer to the first channel of the core in the output pixel
+ * @param CI number of input channels, a multiple of 4 * compute_num
+ * @param FH height of filter
+ * @param FW width of filter, FH * FW must be at least 2
+ * @param compute_num number of compute units
+ */
+void maxpool_fp16simd(__fp16 *ifmap, __fp16 *ofmap, uint32_t CI, uint32_t FH,
+                      uint32_t FW, uint32_t compute_num);
+
+/**
+ * @brief implementation of FP8 SIMD maxpooling, computing 8 channels per
+ * instruction
  *
  * @param ifmap pointer to input feature map
  * @param ofmap pointer to output feature map
- * @param CI number of input channels
+ * @param CI number of input channels, a multiple of 8
  * @param FH height of filter
  * @param FW width of filter
  * @param compute_num number of compute units
  */
-void maxpool_fp64(double *ifmap, double *ofmap, uint32_t CI, uint32_t FH,
+void maxpool_fp8simd(char *ifmap, char *ofmap, uint32_t CI, uint32_t FH,
+                     uint32_t FW, uint32_t compute_num);
+
+/**
+ * @brief implementation of FP64 average pooling with SSR streams and FREP.
+ * The window is summed up and scaled by 1 / (FH * FW).
+ *
+ * @param ifmap pointer to the first channel of the core in the window
+ * @param ofmap pointer to the first channel of the core in the output pixel
+ * @param CI number of input channels (stride between pixels), a multiple of
+ * compute_num
+ * @param FH height of filter
+ * @param FW width of filter, FH * FW must be at least 2
+ * @param compute_num number of compute units
+ */
+void avgpool_fp64(double *ifmap, double *ofmap, uint32_t CI, uint32_t FH,
                   uint32_t FW, uint32_t compute_num);
+
+/**
+ * @brief implementation of FP32 SIMD average pooling with SSR streams and
+ * FREP, computing 2 channels per instruction. The window is summed up in
+ * FP32.
+ *
+ * @param ifmap pointer to the first channel of the core in the window
+ * @param ofmap pointer to the first channel of the core in the output pixel
+ * @param CI number of input channels, a multiple of 2 * compute_num
+ * @param FH height of filter
+ * @param FW width of filter, FH * FW must be at least 2
+ * @param compute_num number of compute units
+ */
+void avgpool_fp32simd(float *ifmap, float *ofmap, uint32_t CI, uint32_t FH,
+                      uint32_t FW, uint32_t compute_num);
+
+/**
+ * @brief implementation of FP16 SIMD average pooling with SSR streams and
+ * FREP, computing 2 channels per instruction. The window is summed up in
+ * FP32 and rounded to FP16 once.
+ *
+ * @param ifmap pointer to the first channel of the core in the window
+ * @param ofmap pointer to the first channel of the core in the output pixel
+ * @param CI number of input channels, a multiple of 4 * compute_num
+ * @param FH height of filter
+ * @param FW width of filter, FH * FW must be at least 2
+ * @param compute_num number of compute units
+ */
+void avgpool_fp16simd(__fp16 *ifmap, __fp16 *ofmap, uint32_t CI, uint32_t FH,
+                      uint32_t FW, uint32_t compute_num);
+
+/**
+ * @brief implementation of a FP64 BatchNorm + ReLU + MaxPooling of a single
+ * channel with SSR streams. The windows do not overlap, i.e. the stride of the
+ * pooling equals the window size.
+ *
+ * @param ifmap pointer to the channel in the input feature map, which is FH
+ * rows high
+ * @param gamma BatchNorm factor of the channel
+ * @param beta BatchNorm offset of the channel
+ * @param ofmap pointer to the channel in the output row
+ * @param OW width of output feature map
+ * @param IW width of input feature map
+ * @param CI number of channels (stride between pixels)
+ * @param FH height of filter
+ * @param FW width of filter, FH * FW must be at least 2
+ */
+void bn_relu_maxpool_fp64(double *ifmap, double gamma, double beta,
+                          double *ofmap, uint32_t OW, uint32_t IW, uint32_t CI,
+                          uint32_t FH, uint32_t FW);
@@ -0,0 +1,300 @@
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "transformer.h"
+
+#include "snrt.h"
+
+// exp(x) = p(x / 2^10)^(2^10), p being the Taylor polynomial of degree 8.
+// Within [-64, 64], the argument of p is at most 1/16 in magnitude and the
+// error of the polynomial is below 1e-16, amplified by 2^10 by the squarings.
+// Outside, the exponential is negligible or saturated for all kernels.
+#define EXP_CLAMP 64.0
+#define EXP_SQUARINGS 10
+#define EXP_SCALE (1.0 / 1024)
+#define EXP_DEGREE 8
+
+static const double exp_coeffs[EXP_DEGREE + 1] = {
+    1.0,         1.0,          1.0 / 2,      1.0 / 6,       1.0 / 24,
+    1.0 / 120.0, 1.0 / 720.0, 1.0 / 5040.0, 1.0 / 40320.0};
+
+// Streams a, every element `repeat` times, into ft0 and y out of ft2
+static void ssr_setup_unary(const double *a, uint32_t repeat, double *y,
+                            uint32_t n) {
+    snrt_ssr_loop_1d(SNRT_SSR_DM0, n, sizeof(double));
+    snrt_ssr_repeat(SNRT_SSR_DM0, repeat);
+    snrt_ssr_loop_1d(SNRT_SSR_DM2, n, sizeof(double));
+    snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_1D, (double *)a);
+    snrt_ssr_write(SNRT_SSR_DM2, SNRT_SSR_1D, y);
+    snrt_ssr_enable();
+}
+
+// Streams a, every element `repeat` times, into ft0 for reductions
+static void ssr_setup_reduce(const double *a, uint32_t repeat, uint32_t n) {
+    snrt_ssr_loop_1d(SNRT_SSR_DM0, n, sizeof(double));
+    snrt_ssr_repeat(SNRT_SSR_DM0, repeat);
+    snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_1D, (double *)a);
+    snrt_ssr_enable();
+}
+
+// Streams a into ft0, b into ft1 and y out of ft2
+static void ssr_setup_binary(const double *a, const double *b, double *y,
+                             uint32_t n) {
+    snrt_ssr_loop_1d(SNRT_SSR_DM0, n, sizeof(double));
+    snrt_ssr_repeat(SNRT_SSR_DM0, 1);
+    snrt_ssr_loop_1d(SNRT_SSR_DM1, n, sizeof(double));
+    snrt_ssr_repeat(SNRT_SSR_DM1, 1);
+    snrt_ssr_loop_1d(SNRT_SSR_DM2, n, sizeof(double));
+    snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_1D, (double *)a);
+    snrt_ssr_read(SNRT_SSR_DM1, SNRT_SSR_1D, (double *)b);
+    snrt_ssr_write(SNRT_SSR_DM2, SNRT_SSR_1D, y);
+    snrt_ssr_enable();
+}
+
+static void ssr_teardown() {
+    snrt_fpu_fence();
+    __builtin_ssr_barrier(SNRT_SSR_DM2);
+    snrt_ssr_disable();
+}
+
+// y = a * s + c
+static void vec_fmadd_s(const double *a, double *y, uint32_t n, double s,
+                        double c) {
+    ssr_setup_unary(a, 1, y, n);
+    asm volatile(
+        "frep.o %[n_frep], 1, 0, 0 \n"
+        "fmadd.d ft2, ft0, %[s], %[c] \n" ::[s] "f"(s),
+        [ c ] "f"(c), [ n_frep ] "r"(n - 1)
+        : "ft0", "ft1", "ft2");
+    ssr_teardown();
+}
+
+// y = max(a, c)
+static void vec_max_s(const double *a, double *y, uint32_t n, double c) {
+    ssr_setup_unary(a, 1, y, n);
+    asm volatile(
+        "frep.o %[n_frep], 1, 0, 0 \n"
+        "fmax.d ft2, ft0, %[c] \n" ::[c] "f"(c),
+        [ n_frep ] "r"(n - 1)
+        : "ft0", "ft1", "ft2");
+    ssr_teardown();
+}
+
+// y = min(a, c)
+static void vec_min_s(const double *a, double *y, uint32_t n, double c) {
+    ssr_setup_unary(a, 1, y, n);
+    asm volatile(
+        "frep.o %[n_frep], 1, 0, 0 \n"
+        "fmin.d ft2, ft0, %[c] \n" ::[c] "f"(c),
+        [ n_frep ] "r"(n - 1)
+        : "ft0", "ft1", "ft2");
+    ssr_teardown();
+}
+
+// y = a * a, every element is streamed twice
+static void vec_square(const double *a, double *y, uint32_t n) {
+    ssr_setup_unary(a, 2, y, n);
+    asm volatile(
+        "frep.o %[n_frep], 1, 0, 0 \n"
+        "fmul.d ft2, ft0, ft0 \n" ::[n_frep] "r"(n - 1)
+        : "ft0", "ft1", "ft2");
+    ssr_teardown();
+}
+
+// y = a * b + c
+static void vec_fmadd_v(const double *a, const double *b, double *y,
+                        uint32_t n, double c) {
+    ssr_setup_binary(a, b, y, n);
+    asm volatile(
+        "frep.o %[n_frep], 1, 0, 0 \n"
+        "fmadd.d ft2, ft0, ft1, %[c] \n" ::[c] "f"(c),
+        [ n_frep ] "r"(n - 1)
+        : "ft0", "ft1", "ft2");
+    ssr_teardown();
+}
+
+// y = a * b
+static void vec_mul_v(const double *a, const double *b, double *y,
+                      uint32_t n) {
+    ssr_setup_binary(a, b, y, n);
+    asm volatile(
+        "frep.o %[n_frep], 1, 0, 0 \n"
+        "fmul.d ft2, ft0, ft1 \n" ::[n_frep] "r"(n - 1)
+        : "ft0", "ft1", "ft2");
+    ssr_teardown();
+}
+
+// y = a + b
+static void vec_add_v(const double *a, const double *b, double *y,
+                      uint32_t n) {
+    ssr_setup_binary(a, b, y, n);
+    asm volatile(
+        "frep.o %[n_frep], 1, 0, 0 \n"
+        "fadd.d ft2, ft0, ft1 \n" ::[n_frep] "r"(n - 1)
+        : "ft0", "ft1", "ft2");
+    ssr_teardown();
+}
+
+// y = a / b
+static void vec_div_v(const double *a, const double *b, double *y,
+                      uint32_t n) {
+    ssr_setup_binary(a, b, y, n);
+    asm volatile(
+        "frep.o %[n_frep], 1, 0, 0 \n"
+        "fdiv.d ft2, ft0, ft1 \n" ::[n_frep] "r"(n - 1)
+        : "ft0", "ft1", "ft2");
+    ssr_teardown();
+}
+
+// Reductions interleave 4 partial results to hide the FPU latency, the
+// remaining elements are added without streams
+static double vec_max(const double *a, uint32_t n) {
+    const uint32_t n4 = n / 4 * 4;
+    register double r0 = a[0], r1 = a[0], r2 = a[0], r3 = a[0];
+    if (n4) {
+        ssr_setup_reduce(a, 1, n4);
+        asm volatile(
+            "frep.o %[n_frep], 4, 0, 0 \n"
+            "fmax.d %[r0], %[r0], ft0 \n"
+            "fmax.d %[r1], %[r1], ft0 \n"
+            "fmax.d %[r2], %[r2], ft0 \n"
+            "fmax.d %[r3], %[r3], ft0 \n"
+            : [ r0 ] "+f"(r0), [ r1 ] "+f"(r1), [ r2 ] "+f"(r2),
+              [ r3 ] "+f"(r3)
+            : [ n_frep ] "r"(n4 / 4 - 1)
+            : "ft0", "ft1", "ft2");
+        snrt_fpu_fence();
+        snrt_ssr_disable();
+    }
+    for (uint32_t i = n4; i < n; i++) r0 = a[i] > r0 ? a[i] : r0;
+    r0 = r1 > r0 ? r1 : r0;
+    r2 = r3 > r2 ? r3 : r2;
+    return r2 > r0 ? r2 : r0;
+}
+
+static double vec_sum(const double *a, uint32_t n) {
+    const uint32_t n4 = n / 4 * 4;
+    register double r0 = 0.0, r1 = 0.0, r2 = 0.0, r3 = 0.0;
+    if (n4) {
+        ssr_setup_reduce(a, 1, n4);
+        asm volatile(
+            "frep.o %[n_frep], 4, 0, 0 \n"
+            "fadd.d %[r0], %[r0], ft0 \n"
+            "fadd.d %[r1], %[r1], ft0 \n"
+            "fadd.d %[r2], %[r2], ft0 \n"
+            "fadd.d %[r3], %[r3], ft0 \n"
+            : [ r0 ] "+f"(r0), [ r1 ] "+f"(r1), [ r2 ] "+f"(r2),
+              [ r3 ] "+f"(r3)
+            : [ n_frep ] "r"(n4 / 4 - 1)
+            : "ft0", "ft1", "ft2");
+        snrt_fpu_fence();
+        snrt_ssr_disable();
+    }
+    for (uint32_t i = n4; i < n; i++) r0 += a[i];
+    return (r0 + r1) + (r2 + r3);
+}
+
+// Sum of squares, every element is streamed twice
+static double vec_sumsq(const double *a, uint32_t n) {
+    const uint32_t n4 = n / 4 * 4;
+    register double r0 = 0.0, r1 = 0.0, r2 = 0.0, r3 = 0.0;
+    if (n4) {
+        ssr_setup_reduce(a, 2, n4);
+        asm volatile(
+            "frep.o %[n_frep], 4, 0, 0 \n"
+            "fmadd.d %[r0], ft0, ft0, %[r0] \n"
+            "fmadd.d %[r1], ft0, ft0, %[r1] \n"
+            "fmadd.d %[r2], ft0, ft0, %[r2] \n"
+            "fmadd.d %[r3], ft0, ft0, %[r3] \n"
+            : [ r0 ] "+f"(r0), [ r1 ] "+f"(r1), [ r2 ] "+f"(r2),
+              [ r3 ] "+f"(r3)
+            : [ n_frep ] "r"(n4 / 4 - 1)
+            : "ft0", "ft1", "ft2");
+        snrt_fpu_fence();
+        snrt_ssr_disable();
+    }
+    for (uint32_t i = n4; i < n; i++) r0 += a[i] * a[i];
+    return (r0 + r1) + (r2 + r3);
+}
+
+// y = exp(t / EXP_SCALE) for t within [-EXP_CLAMP, EXP_CLAMP] * EXP_SCALE:
+// Horner's scheme followed by the squarings, t must not be equal to y
+static void vec_exp_scaled(const double *t, double *y, uint32_t n) {
+    vec_fmadd_s(t, y, n, exp_coeffs[EXP_DEGREE], exp_coeffs[EXP_DEGREE - 1]);
+    for (int32_t k = EXP_DEGREE - 2; k >= 0; k--) {
+        vec_fmadd_v(y, t, y, n, exp_coeffs[k]);
+    }
+    for (uint32_t k = 0; k < EXP_SQUARINGS; k++) {
+        vec_square(y, y, n);
+    }
+}
+
+// Scalar version of the same approximation
+static double exp_scalar(double x) {
+    x = x < -EXP_CLAMP ? -EXP_CLAMP : x > EXP_CLAMP ? EXP_CLAMP : x;
+    const double t = x * EXP_SCALE;
+    double p = exp_coeffs[EXP_DEGREE];
+    for (int32_t k = EXP_DEGREE - 1; k >= 0; k--) p = p * t + exp_coeffs[k];
+    for (uint32_t k = 0; k < EXP_SQUARINGS; k++) p = p * p;
+    return p;
+}
+
+// y = exp(scale * x - shift) for scale * x <= shift, clamped from below
+static void vec_exp_shifted(const double *x, double *y, double *tmp,
+                            uint32_t n, double scale, double shift) {
+    vec_max_s(x, tmp, n, (shift - EXP_CLAMP) / scale);
+    vec_fmadd_s(tmp, tmp, n, scale * EXP_SCALE, -shift * EXP_SCALE);
+    vec_exp_scaled(tmp, y, n);
+}
+
+void softmax_fp64(const double *x, double *y, double *tmp, uint32_t n) {
+    const double m = vec_max(x, n);
+    vec_exp_shifted(x, y, tmp, n, 1.0, m);
+    vec_fmadd_s(y, y, n, 1.0 / vec_sum(y, n), 0.0);
+}
+
+void layernorm_fp64(const double *x, double *y, const double *gamma,
+                    const double *beta, uint32_t n, double eps) {
+    const double mean = vec_sum(x, n) / n;
+    vec_fmadd_s(x, y, n, 1.0, -mean);
+    const double var = vec_sumsq(y, n) / n;
+    vec_fmadd_s(y, y, n, 1.0 / __builtin_sqrt(var + eps), 0.0);
+    vec_mul_v(y, gamma, y, n);
+    vec_add_v(y, beta, y, n);
+}
+
+void gelu_fp64(const double *x, double *y, double *tmp, uint32_t n) {
+    // -2 * sqrt(2 / pi)
+    const double c = -1.5957691216057308;
+
+    // tmp = x + 0.044715 * x^3, clamped such that c * tmp is within
+    // [-EXP_CLAMP, EXP_CLAMP]
+    vec_square(x, tmp, n);
+    vec_fmadd_s(tmp, tmp, n, 0.044715, 1.0);
+    vec_mul_v(tmp, x, tmp, n);
+    vec_max_s(tmp, tmp, n, EXP_CLAMP / c);
+    vec_min_s(tmp, tmp, n, -EXP_CLAMP / c);
+    vec_fmadd_s(tmp, tmp, n, c * EXP_SCALE, 0.0);
+
+    // y = x / (1 + exp(c * tmp))
+    vec_exp_scaled(tmp, y, n);
+    vec_fmadd_s(y, y, n, 1.0, 1.0);
+    vec_div_v(x, y, y, n);
+}
+
+double online_softmax_fp64(double *s, double *tmp, uint32_t n, double scale,
+                           double *m, double *l) {
+    const double m_row = scale * vec_max(s, n);
+    const double m_new = m_row > *m ? m_row : *m;
+    const double corr = exp_scalar(*m - m_new);
+
+    vec_exp_shifted(s, s, tmp, n, scale, m_new);
+    *l = *l * corr + vec_sum(s, n);
+    *m = m_new;
+    return corr;
+}
+
+void scale_fp64(const double *x, double *y, uint32_t n, double a) {
+    vec_fmadd_s(x, y, n, a, 0.0);
+}
@@ -0,0 +1,76 @@
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include "snrt.h"
+
+// Row-wise kernels of transformers. Every kernel processes one row of `n`
+// elements in the TCDM as a sequence of element-wise passes, each of which
+// streams the row with SSRs through a single FPU instruction repeated with
+// FREP. exp(x) is evaluated with a polynomial and repeated squaring, for x
+// clamped to [-64, 64], such that it only needs FMAs.
+
+/**
+ * @brief FP64 softmax of a row, y = exp(x - max(x)) / sum(exp(x - max(x)))
+ *
+ * @param x pointer to the input row
+ * @param y pointer to the output row, may be equal to x
+ * @param tmp pointer to a scratch buffer of n elements
+ * @param n number of elements
+ */
+void softmax_fp64(const double *x, double *y, double *tmp, uint32_t n);
+
+/**
+ * @brief FP64 layer normalization of a row,
+ * y = (x - mean(x)) / sqrt(var(x) + eps) * gamma + beta
+ *
+ * @param x pointer to the input row
+ * @param y pointer to the output row, may be equal to x
+ * @param gamma pointer to the n factors
+ * @param beta pointer to the n offsets
+ * @param n number of elements
+ * @param eps added to the variance
+ */
+void layernorm_fp64(const double *x, double *y, const double *gamma,
+                    const double *beta, uint32_t n, double eps);
+
+/**
+ * @brief FP64 GELU of a row with the tanh approximation,
+ * y = x / 2 * (1 + tanh(sqrt(2 / pi) * (x + 0.044715 * x^3))), evaluated as
+ * y = x / (1 + exp(-2 * sqrt(2 / pi) * (x + 0.044715 * x^3)))
+ *
+ * @param x pointer to the input row
+ * @param y pointer to the output row, must not be equal to x
+ * @param tmp pointer to a scratch buffer of n elements
+ * @param n number of elements
+ */
+void gelu_fp64(const double *x, double *y, double *tmp, uint32_t n);
+
+/**
+ * @brief FP64 online softmax step of a row of attention scores. The running
+ * maximum m of the scaled scores is updated with the row and the scores are
+ * replaced by s = exp(scale * s - m). The running sum l of the exponentials is
+ * rescaled to the new maximum and the row is added to it.
+ *
+ * @param s pointer to the row of unscaled scores
+ * @param tmp pointer to a scratch buffer of n elements
+ * @param n number of elements
+ * @param scale positive factor of the scores
+ * @param m running maximum, -INFINITY before the first row
+ * @param l running sum, 0 before the first row
+ * @return factor exp(m_old - m) to rescale previous results with
+ */
+double online_softmax_fp64(double *s, double *tmp, uint32_t n, double scale,
+                           double *m, double *l);
+
+/**
+ * @brief FP64 scaling of a row, y = a * x
+ *
+ * @param x pointer to the input row
+ * @param y pointer to the output row, may be equal to x
+ * @param n number of elements
+ * @param a factor
+ */
+void scale_fp64(const double *x, double *y, uint32_t n, double a);
@@ -0,0 +1,199 @@
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "winograd.h"
+
+#include "snrt.h"
+
+// One-dimensional transforms of a vector x with stride sx into a vector y
+// with stride sy. The 2D transforms apply them to the columns and then to the
+// rows of a tile. The coefficients are the ones of Lavin and Gray, "Fast
+// Algorithms for Convolutional Neural Networks", with interpolation points
+// 0, 1, -1 (F(2, 3)) and 0, 1, -1, 2, -2 (F(4, 3)).
+
+// B^T of F(2, 3), 4 -> 4 elements
+static inline void bt2_fp64(const double *x, uint32_t sx, double *y,
+                            uint32_t sy) {
+    const double x0 = x[0], x1 = x[sx], x2 = x[2 * sx], x3 = x[3 * sx];
+    y[0] = x0 - x2;
+    y[sy] = x1 + x2;
+    y[2 * sy] = x2 - x1;
+    y[3 * sy] = x1 - x3;
+}
+
+// B^T of F(4, 3), 6 -> 6 elements
+static inline void bt4_fp64(const double *x, uint32_t sx, double *y,
+                            uint32_t sy) {
+    const double x0 = x[0], x1 = x[sx], x2 = x[2 * sx], x3 = x[3 * sx];
+    const double x4 = x[4 * sx], x5 = x[5 * sx];
+    y[0] = 4.0 * x0 - 5.0 * x2 + x4;
+    y[sy] = x3 + x4 - 4.0 * (x1 + x2);
+    y[2 * sy] = x4 - x3 + 4.0 * (x1 - x2);
+    y[3 * sy] = x4 - x2 + 2.0 * (x3 - x1);
+    y[4 * sy] = x4 - x2 - 2.0 * (x3 - x1);
+    y[5 * sy] = 4.0 * x1 - 5.0 * x3 + x5;
+}
+
+// A^T of F(2, 3), 4 -> 2 elements
+static inline void at2_fp64(const double *x, uint32_t sx, double *y,
+                            uint32_t sy) {
+    const double x0 = x[0], x1 = x[sx], x2 = x[2 * sx], x3 = x[3 * sx];
+    y[0] = x0 + x1 + x2;
+    y[sy] = x1 - x2 - x3;
+}
+
+// A^T of F(4, 3), 6 -> 4 elements
+static inline void at4_fp64(const double *x, uint32_t sx, double *y,
+                            uint32_t sy) {
+    const double s1 = x[sx] + x[2 * sx], d1 = x[sx] - x[2 * sx];
+    const double s2 = x[3 * sx] + x[4 * sx], d2 = x[3 * sx] - x[4 * sx];
+    y[0] = x[0] + s1 + s2;
+    y[sy] = d1 + 2.0 * d2;
+    y[2 * sy] = s1 + 4.0 * s2;
+    y[3 * sy] = d1 + 8.0 * d2 + x[5 * sx];
+}
+
+static inline void bt2_fp32(const float *x, uint32_t sx, float *y,
+                            uint32_t sy) {
+    const float x0 = x[0], x1 = x[sx], x2 = x[2 * sx], x3 = x[3 * sx];
+    y[0] = x0 - x2;
+    y[sy] = x1 + x2;
+    y[2 * sy] = x2 - x1;
+    y[3 * sy] = x1 - x3;
+}
+
+static inline void bt4_fp32(const float *x, uint32_t sx, float *y,
+                            uint32_t sy) {
+    const float x0 = x[0], x1 = x[sx], x2 = x[2 * sx], x3 = x[3 * sx];
+    const float x4 = x[4 * sx], x5 = x[5 * sx];
+    y[0] = 4.0f * x0 - 5.0f * x2 + x4;
+    y[sy] = x3 + x4 - 4.0f * (x1 + x2);
+    y[2 * sy] = x4 - x3 + 4.0f * (x1 - x2);
+    y[3 * sy] = x4 - x2 + 2.0f * (x3 - x1);
+    y[4 * sy] = x4 - x2 - 2.0f * (x3 - x1);
+    y[5 * sy] = 4.0f * x1 - 5.0f * x3 + x5;
+}
+
+static inline void at2_fp32(const float *x, uint32_t sx, float *y,
+                            uint32_t sy) {
+    const float x0 = x[0], x1 = x[sx], x2 = x[2 * sx], x3 = x[3 * sx];
+    y[0] = x0 + x1 + x2;
+    y[sy] = x1 - x2 - x3;
+}
+
+static inline void at4_fp32(const float *x, uint32_t sx, float *y,
+                            uint32_t sy) {
+    const float s1 = x[sx] + x[2 * sx], d1 = x[sx] - x[2 * sx];
+    const float s2 = x[3 * sx] + x[4 * sx], d2 = x[3 * sx] - x[4 * sx];
+    y[0] = x[0] + s1 + s2;
+    y[sy] = d1 + 2.0f * d2;
+    y[2 * sy] = s1 + 4.0f * s2;
+    y[3 * sy] = d1 + 8.0f * d2 + x[5 * sx];
+}
+
+void winograd_input_fp64(uint32_t m, const double *d, uint32_t ldh,
+                         uint32_t ldw, double *V, uint32_t ldv, uint32_t n,
+                         uint32_t step) {
+    // Columns transformed first, t = B^T d
+    double t[6][6];
+
+    if (m == 2) {
+        for (uint32_t c = 0; c < n; c += step) {
+            for (uint32_t j = 0; j < 4; j++) {
+                bt2_fp64(d + j * ldw + c, ldh, &t[0][j], 6);
+            }
+            for (uint32_t i = 0; i < 4; i++) {
+                bt2_fp64(t[i], 1, V + 4 * i * ldv + c, ldv);
+            }
+        }
+    } else {
+        for (uint32_t c = 0; c < n; c += step) {
+            for (uint32_t j = 0; j < 6; j++) {
+                bt4_fp64(d + j * ldw + c, ldh, &t[0][j], 6);
+            }
+            for (uint32_t i = 0; i < 6; i++) {
+                bt4_fp64(t[i], 1, V + 6 * i * ldv + c, ldv);
+            }
+        }
+    }
+}
+
+void winograd_input_fp32(uint32_t m, const float *d, uint32_t ldh,
+                         uint32_t ldw, float *V, uint32_t ldv, uint32_t n,
+                         uint32_t step) {
+    float t[6][6];
+
+    if (m == 2) {
+        for (uint32_t c = 0; c < n; c += step) {
+            for (uint32_t j = 0; j < 4; j++) {
+                bt2_fp32(d + j * ldw + c, ldh, &t[0][j], 6);
+            }
+            for (uint32_t i = 0; i < 4; i++) {
+                bt2_fp32(t[i], 1, V + 4 * i * ldv + c, ldv);
+            }
+        }
+    } else {
+        for (uint32_t c = 0; c < n; c += step) {
+            for (uint32_t j = 0; j < 6; j++) {
+                bt4_fp32(d + j * ldw + c, ldh, &t[0][j], 6);
+            }
+            for (uint32_t i = 0; i < 6; i++) {
+                bt4_fp32(t[i], 1, V + 6 * i * ldv + c, ldv);
+            }
+        }
+    }
+}
+
+void winograd_output_fp64(uint32_t m, const double *M, uint32_t ldm,
+                          double *Y, uint32_t ldh, uint32_t ldw, uint32_t n,
+                          uint32_t step) {
+    // Columns transformed first, t = A^T M
+    double t[4][6];
+
+    if (m == 2) {
+        for (uint32_t c = 0; c < n; c += step) {
+            for (uint32_t j = 0; j < 4; j++) {
+                at2_fp64(M + j * ldm + c, 4 * ldm, &t[0][j], 6);
+            }
+            for (uint32_t i = 0; i < 2; i++) {
+                at2_fp64(t[i], 1, Y + i * ldh + c, ldw);
+            }
+        }
+    } else {
+        for (uint32_t c = 0; c < n; c += step) {
+            for (uint32_t j = 0; j < 6; j++) {
+                at4_fp64(M + j * ldm + c, 6 * ldm, &t[0][j], 6);
+            }
+            for (uint32_t i = 0; i < 4; i++) {
+                at4_fp64(t[i], 1, Y + i * ldh + c, ldw);
+            }
+        }
+    }
+}
+
+void winograd_output_fp32(uint32_t m, const float *M, uint32_t ldm, float *Y,
+                          uint32_t ldh, uint32_t ldw, uint32_t n,
+                          uint32_t step) {
+    float t[4][6];
+
+    if (m == 2) {
+        for (uint32_t c = 0; c < n; c += step) {
+            for (uint32_t j = 0; j < 4; j++) {
+                at2_fp32(M + j * ldm + c, 4 * ldm, &t[0][j], 6);
+            }
+            for (uint32_t i = 0; i < 2; i++) {
+                at2_fp32(t[i], 1, Y + i * ldh + c, ldw);
+            }
+        }
+    } else {
+        for (uint32_t c = 0; c < n; c += step) {
+            for (uint32_t j = 0; j < 6; j++) {
+                at4_fp32(M + j * ldm + c, 6 * ldm, &t[0][j], 6);
+            }
+            for (uint32_t i = 0; i < 4; i++) {
+                at4_fp32(t[i], 1, Y + i * ldh + c, ldw);
+            }
+        }
+    }
+}
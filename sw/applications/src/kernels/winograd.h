@@ -0,0 +1,92 @@
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include "snrt.h"
+
+// Transforms of the Winograd convolution F(m x m, 3 x 3). An output tile of
+// m x m pixels is computed from an input tile of a x a pixels, a = m + 2:
+//
+//     Y = A^T [(G g G^T) * (B^T d B)] A
+//
+// where `*` is the element-wise product, which turns into a * a independent
+// GEMMs over the channels. The filter transform G g G^T is precomputed
+// offline by `data_gen.py`. Every element of the input tile (B^T d B) and of
+// the output tile (A^T M A) is a linear combination of a few elements of the
+// other, with small integer coefficients. Both transforms are computed for a
+// set of channels, which are spread with a stride `step` to distribute them
+// across cores.
+
+/**
+ * @brief FP64 Winograd input transform V = B^T d B of one tile
+ *
+ * @param m output tile size, 2 or 4
+ * @param d pointer to the first channel in the top left pixel of the input
+ * tile
+ * @param ldh stride between rows of the input tile
+ * @param ldw stride between pixels of the input tile
+ * @param V pointer to the first channel of element 0 of the transformed tile,
+ * element xi of the a x a elements is stored at V + xi * ldv
+ * @param ldv stride between elements of the transformed tile
+ * @param n number of channels from the first one
+ * @param step stride between the transformed channels
+ */
+void winograd_input_fp64(uint32_t m, const double *d, uint32_t ldh,
+                         uint32_t ldw, double *V, uint32_t ldv, uint32_t n,
+                         uint32_t step);
+
+/**
+ * @brief FP32 Winograd input transform V = B^T d B of one tile
+ *
+ * @param m output tile size, 2 or 4
+ * @param d pointer to the first channel in the top left pixel of the input
+ * tile
+ * @param ldh stride between rows of the input tile
+ * @param ldw stride between pixels of the input tile
+ * @param V pointer to the first channel of element 0 of the transformed tile,
+ * element xi of the a x a elements is stored at V + xi * ldv
+ * @param ldv stride between elements of the transformed tile
+ * @param n number of channels from the first one
+ * @param step stride between the transformed channels
+ */
+void winograd_input_fp32(uint32_t m, const float *d, uint32_t ldh,
+                         uint32_t ldw, float *V, uint32_t ldv, uint32_t n,
+                         uint32_t step);
+
+/**
+ * @brief FP64 Winograd output transform Y = A^T M A of one tile
+ *
+ * @param m output tile size, 2 or 4
+ * @param M pointer to the first channel of element 0 of the tile in the
+ * Winograd domain, element xi of the a x a elements is stored at M + xi * ldm
+ * @param ldm stride between elements of the tile in the Winograd domain
+ * @param Y pointer to the first channel in the top left pixel of the output
+ * tile
+ * @param ldh stride between rows of the output tile
+ * @param ldw stride between pixels of the output tile
+ * @param n number of channels from the first one
+ * @param step stride between the transformed channels
+ */
+void winograd_output_fp64(uint32_t m, const double *M, uint32_t ldm,
+                          double *Y, uint32_t ldh, uint32_t ldw, uint32_t n,
+                          uint32_t step);
+
+/**
+ * @brief FP32 Winograd output transform Y = A^T M A of one tile
+ *
+ * @param m output tile size, 2 or 4
+ * @param M pointer to the first channel of element 0 of the tile in the
+ * Winograd domain, element xi of the a x a elements is stored at M + xi * ldm
+ * @param ldm stride between elements of the tile in the Winograd domain
+ * @param Y pointer to the first channel in the top left pixel of the output
+ * tile
+ * @param ldh stride between rows of the output tile
+ * @param ldw stride between pixels of the output tile
+ * @param n number of channels from the first one
+ * @param step stride between the transformed channels
+ */
+void winograd_output_fp32(uint32_t m, const float *M, uint32_t ldm, float *Y,
+                          uint32_t ldh, uint32_t ldw, uint32_t n,
+                          uint32_t step);
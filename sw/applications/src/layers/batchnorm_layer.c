@@ -8,26 +8,55 @@
 #include "layer.h"
 #include "snrt.h"
 
+static void batchnorm(precision_t dtype, void *ifmap, void *gamma, void *beta,
+                      void *ofmap, uint32_t OW, uint32_t CI,
+                      uint32_t compute_num, uint32_t setup_SSR) {
+    switch (dtype) {
+        case FP64:
+            batchnorm_fp64(ifmap, gamma, beta, ofmap, OW, CI, compute_num,
+                           setup_SSR);
+            break;
+        case FP32:
+            batchnorm_fp32simd(ifmap, gamma, beta, ofmap, OW, CI, compute_num,
+                               setup_SSR);
+            break;
+        case FP16:
+            batchnorm_fp16simd(ifmap, gamma, beta, ofmap, OW, CI, compute_num,
+                               setup_SSR);
+            break;
+        case FP8:
+            batchnorm_fp8simd(ifmap, gamma, beta, ofmap, OW, CI, compute_num,
+                              setup_SSR);
+            break;
+    }
+}
+
 void batchnorm_layer(const conv_layer *l) {
     const uint32_t cluster_num = snrt_cluster_num();
     const uint32_t cluster_id = snrt_cluster_idx();
     const uint32_t compute_num = snrt_cluster_compute_core_num();
     const uint32_t compute_id = snrt_cluster_compute_core_idx();
 
+    // Sizes are given in elements of the layer precision
+    const uint32_t size = l->dtype;
+
     // Each cluster loads one tile of a row
     uint32_t ifmap_size = 2 * l->IW * l->TILE_CI;
     uint32_t weights_size = l->CI;
     uint32_t ofmap_size = 2 * l->IW * l->TILE_CI;
 
-    double *ptr = (double *)snrt_cluster_memory().start;
-    double *ifmap = ptr;
-    ptr += ifmap_size;
-    double *gamma = ptr;
-    ptr += weights_size;
-    double *beta = ptr;
-    ptr += weights_size;
-    double *ofmap = ptr;
-    ptr += ofmap_size;
+    char *ptr = (char *)snrt_cluster_memory().start;
+    char *ifmap = ptr;
+    ptr += ifmap_size * size;
+    char *gamma = ptr;
+    ptr += weights_size * size;
+    char *beta = ptr;
+    ptr += weights_size * size;
+    char *ofmap = ptr;
+    ptr += ofmap_size * size;
+
+    const char *l_ifmap = (const char *)l->ifmap;
+    char *l_ofmap = (char *)l->ofmap;
 
     uint32_t read_buf = 0;
     uint32_t write_buf = 0;
@@ -41,26 +70,26 @@ void batchnorm_layer(const conv_layer *l) {
             if (snrt_is_dm_core()) {
                 // Load weights once in the beginning
                 if (oh == cluster_id && ci == 0) {
-                    snrt_dma_start_1d(gamma, l->gamma, sizeof(double) * l->CI);
-                    snrt_dma_start_1d(beta, l->beta, sizeof(double) * l->CI);
+                    snrt_dma_start_1d(gamma, l->gamma, size * l->CI);
+                    snrt_dma_start_1d(beta, l->beta, size * l->CI);
                     snrt_dma_wait_all();
                 }
 
                 // Load some stuff
                 if (l->TILE_CI == l->CI) {
                     // data layout is consecutively in memory
-                    snrt_dma_start_1d(&ifmap[write_buf * ifmap_size / 2],
-                                      &l->ifmap[oh * l->IW * l->CI],
-                                      sizeof(double) * l->IW * l->TILE_CI);
+                    snrt_dma_start_1d(ifmap + write_buf * ifmap_size / 2 * size,
+                                      l_ifmap + oh * l->IW * l->CI * size,
+                                      size * l->IW * l->TILE_CI);
                 } else {
                     // data is interleaved
                     snrt_dma_start_2d(
-                        &ifmap[write_buf * ifmap_size / 2], /* dst */
-                        &l->ifmap[oh * l->IW * l->CI + ci], /* src */
-                        sizeof(double) * l->TILE_CI,        /* size */
-                        sizeof(double) * l->TILE_CI,        /* dst_stride */
-                        sizeof(double) * l->CI,             /* src_stride */
-                        l->IW);                             /* repetitions */
+                        ifmap + write_buf * ifmap_size / 2 * size, /* dst */
+                        l_ifmap + (oh * l->IW * l->CI + ci) * size, /* src */
+                        size * l->TILE_CI,                         /* size */
+                        size * l->TILE_CI, /* dst_stride */
+                        size * l->CI,      /* src_stride */
+                        l->IW);            /* repetitions */
                 }
 
                 snrt_dma_wait_all();
@@ -70,19 +99,22 @@ void batchnorm_layer(const conv_layer *l) {
                 if (!(oh == cluster_id && ci == 0)) {
                     if (l->TILE_CI == l->CI) {
                         // data is stored consecutively
-                        snrt_dma_start_1d(&l->ofmap[prev_oh * l->OW * l->CI],
-                                          &ofmap[!read_buf * (ofmap_size / 2)],
-                                          sizeof(double) * l->IW * l->CI);
+                        snrt_dma_start_1d(
+                            l_ofmap + prev_oh * l->OW * l->CI * size,
+                            ofmap + !read_buf * (ofmap_size / 2) * size,
+                            size * l->IW * l->CI);
                     } else {
                         // data is stored in interleaved layout
                         snrt_dma_start_2d(
-                            &l->ofmap[prev_oh * l->OW * l->CI +
-                                      prev_ci],                   /* dst */
-                            &ofmap[!read_buf * (ofmap_size / 2)], /* src */
-                            sizeof(double) * l->TILE_CI,          /* size */
-                            sizeof(double) * l->CI,      /* dst_stride */
-                            sizeof(double) * l->TILE_CI, /* src_stride */
-                            l->IW);                      /* repetitions */
+                            /* dst */
+                            l_ofmap + (prev_oh * l->OW * l->CI + prev_ci) *
+                                          size,
+                            /* src */
+                            ofmap + !read_buf * (ofmap_size / 2) * size,
+                            size * l->TILE_CI, /* size */
+                            size * l->CI,      /* dst_stride */
+                            size * l->TILE_CI, /* src_stride */
+                            l->IW);            /* repetitions */
                     }
                 }
 
@@ -100,11 +132,16 @@ void batchnorm_layer(const conv_layer *l) {
                 // initially setup SSRs
                 uint32_t setup_SSR = (oh == cluster_id && ci == 0);
 
-                // Start kernel
-                batchnorm_fp64(&ifmap[read_buf * ofmap_size / 2 + compute_id],
-                               &gamma[ci + compute_id], &beta[ci + compute_id],
-                               &ofmap[write_buf * ofmap_size / 2 + compute_id],
-                               l->OW, l->TILE_CI, compute_num, setup_SSR);
+                // Start kernel, every core handles every `compute_num`-th
+                // 64-bit word of channels
+                batchnorm(l->dtype,
+                          ifmap + read_buf * ofmap_size / 2 * size +
+                              compute_id * 8,
+                          gamma + ci * size + compute_id * 8,
+                          beta + ci * size + compute_id * 8,
+                          ofmap + write_buf * ofmap_size / 2 * size +
+                              compute_id * 8,
+                          l->OW, l->TILE_CI, compute_num, setup_SSR);
 
                 write_buf = !write_buf;
                 read_buf = !read_buf;
@@ -118,18 +155,18 @@ void batchnorm_layer(const conv_layer *l) {
     if (snrt_is_dm_core()) {
         if (l->TILE_CI == l->CI) {
             // data is stored consecutively
-            snrt_dma_start_1d(&l->ofmap[prev_oh * l->OW * l->CI],
-                              &ofmap[!read_buf * (ofmap_size / 2)],
-                              sizeof(double) * l->IW * l->CI);
+            snrt_dma_start_1d(l_ofmap + prev_oh * l->OW * l->CI * size,
+                              ofmap + !read_buf * (ofmap_size / 2) * size,
+                              size * l->IW * l->CI);
         } else {
             // data is stored in interleaved layout
             snrt_dma_start_2d(
-                &l->ofmap[prev_oh * l->OW * l->CI + prev_ci], /* dst */
-                &ofmap[!read_buf * (ofmap_size / 2)],         /* src */
-                sizeof(double) * l->TILE_CI,                  /* size */
-                sizeof(double) * l->CI,                       /* dst_stride */
-                sizeof(double) * l->TILE_CI,                  /* src_stride */
-                l->IW);                                       /* repetitions */
+                l_ofmap + (prev_oh * l->OW * l->CI + prev_ci) * size, /* dst */
+                ofmap + !read_buf * (ofmap_size / 2) * size,          /* src */
+                size * l->TILE_CI,                                    /* size */
+                size * l->CI,      /* dst_stride */
+                size * l->TILE_CI, /* src_stride */
+                l->IW);            /* repetitions */
         }
 
         snrt_dma_wait_all();
@@ -12,6 +12,33 @@
 
 #define min(a, b) ((a) < (b) ? (a) : (b))
 #define max(a, b) ((a) > (b) ? (a) : (b))
+#define ceil_div(a, b) (((a) + (b)-1) / (b))
+#define align_up(a, b) (ceil_div(a, b) * (b))
+
+// Multiplies one row of the im2col matrix with the weights of 8 output
+// channels in the precision of the layer
+static void conv2d_gemm(precision_t dtype, uint32_t K, void *im2col,
+                        void *weights, uint32_t ldB, void *ofmap,
+                        const uint32_t *alpha, uint32_t setup_SSR) {
+    switch (dtype) {
+        case FP64:
+            gemm_fp64_ssr_frep(1, 8, K, im2col, 0, 0, weights, ldB, 1, ofmap,
+                               0, alpha, setup_SSR);
+            break;
+        case FP32:
+            gemm_fp32simd_tb_ssr_frep(1, 8, K, im2col, 0, weights, ldB, ofmap,
+                                      0, alpha, setup_SSR);
+            break;
+        case FP16:
+            gemm_fp16simd_tb_ssr_frep(1, 8, K, im2col, 0, weights, ldB, ofmap,
+                                      0, alpha, setup_SSR);
+            break;
+        case FP8:
+            gemm_fp8simd_tb_ssr_frep(1, 8, K, im2col, 0, weights, ldB, ofmap,
+                                     0, alpha, setup_SSR);
+            break;
+    }
+}
 
 void conv2d_layer(const conv_layer *l) {
     uint32_t cluster_num = snrt_cluster_num();
@@ -21,45 +48,61 @@ void conv2d_layer(const conv_layer *l) {
 
     const uint32_t cluster_per_quadrant = min(4, cluster_num);
 
+    // All buffers are addressed in bytes, strides and sizes are given in
+    // elements of the layer precision
+    const uint32_t size = l->dtype;
+
+    // Rows are padded by one 64-bit word to prevent banking conflicts, which
+    // keeps them aligned for the SIMD kernels
+    const uint32_t row_pad = 8 / size;
+
     // typedef struct cluster_mem_alloc_struct {
-    //     double im2col[2][compute_num][l->FW*l->FH*l->TILE_CI+1];
-    //     double ifmap[2][l->FH][compute_num + l->FW - 1][l->TILE_CI];
-    //     double weights[compute_num][l->FH*l->FW*l->TILE_CI+1];
-    //     double ofmap[2][compute_num][8];
+    //     T im2col[2][compute_num][l->FW*l->FH*l->TILE_CI+row_pad];
+    //     T ifmap[2][l->FH][compute_num + l->FW - 1][l->TILE_CI];
+    //     T weights[compute_num][l->FH*l->FW*l->TILE_CI+row_pad];
+    //     T ofmap[2][compute_num][8];
     //     volatile uint32_t synch_flag[2];
     // } cluster_mem_alloc;
 
-    // im2col[2][compute_num][l->FW*l->FH*l->TILE_CI+1];
-    uint32_t im2col_row_stride = l->FW * l->FH * l->TILE_CI + 1;
+    // im2col[2][compute_num][l->FW*l->FH*l->TILE_CI+row_pad];
+    uint32_t im2col_row_stride = l->FW * l->FH * l->TILE_CI + row_pad;
     uint32_t im2col_mat_stride = im2col_row_stride * compute_num;
     uint32_t im2col_size = 2 * im2col_mat_stride;
 
-    // ifmap[2][l->FH][compute_num + l->FW - 1][l->TILE_CI];
+    // ifmap[2][l->FH][compute_num + l->FW - 1][l->TILE_CI], rows are aligned
+    // such that they can be cleared with `dma_memset`
     uint32_t ifmap_col_stride = l->TILE_CI;
-    uint32_t ifmap_row_stride = ifmap_col_stride * (compute_num + l->FW - 1);
+    uint32_t ifmap_row_stride =
+        align_up(ifmap_col_stride * (compute_num + l->FW - 1) * size, 64) /
+        size;
     uint32_t ifmap_stride = ifmap_row_stride * l->FH;
     uint32_t ifmap_size = 2 * ifmap_stride;
 
-    // weights[compute_num][l->FH*l->FW*l->TILE_CI+1];
-    uint32_t weights_co_stride = l->FH * l->FW * l->TILE_CI + 1;
+    // weights[compute_num][l->FH*l->FW*l->TILE_CI+row_pad];
+    uint32_t weights_co_stride = l->FH * l->FW * l->TILE_CI + row_pad;
     uint32_t weights_size = compute_num * weights_co_stride;
 
     // ofmap[2][compute_num][8];
     uint32_t ofmap_co_stride = 8;
-    uint32_t ofmap_stride = compute_num * ofmap_co_stride;
+    uint32_t ofmap_stride = align_up(compute_num * ofmap_co_stride * size, 64) /
+                            size;
     uint32_t ofmap_size = 2 * ofmap_stride;
 
-    double *ptr = (double *)snrt_cluster_memory().start;
-    double *im2col = ptr;
-    ptr += im2col_size;
-    double *ifmap = ptr;
-    ptr += ifmap_size;
-    double *weights = ptr;
-    ptr += weights_size;
-    double *ofmap = ptr;
-    ptr += ofmap_size;
+    char *ptr = (char *)snrt_cluster_memory().start;
+    char *im2col = ptr;
+    ptr += im2col_size * size;
+    char *ifmap = ptr;
+    ptr += ifmap_size * size;
+    char *weights = ptr;
+    ptr += weights_size * size;
+    char *ofmap = ptr;
+    ptr += ofmap_size * size;
     volatile uint32_t *synch_flag = (void *)ptr;
 
+    const char *l_ifmap = (const char *)l->ifmap;
+    const char *l_weights = (const char *)l->weights;
+    char *l_ofmap = (char *)l->ofmap;
+
     uint32_t write_buf = 0;
     uint32_t read_buf = 0;
 
@@ -86,18 +129,19 @@ void conv2d_layer(const conv_layer *l) {
                 for (uint32_t _co = 0; _co < 8; _co++) {
                     if (l->TILE_CI == l->CI) {
                         snrt_dma_txid_t weight_txid = snrt_dma_start_1d(
-                            &weights[_co * weights_co_stride], /* dst */
-                            &l->weights[(co + _co) * l->FH * l->FW *
-                                        l->CI], /* src */
-                            sizeof(double) * l->CI * l->FH * l->FW /* size */);
+                            weights + _co * weights_co_stride * size, /* dst */
+                            l_weights + (co + _co) * l->FH * l->FW * l->CI *
+                                            size,          /* src */
+                            size * l->CI * l->FH * l->FW /* size */);
                     } else {
                         snrt_dma_txid_t weight_txid = snrt_dma_start_2d(
-                            &weights[_co * weights_co_stride], /* dst */
-                            &l->weights[(co + _co) * l->FH * l->FW * l->CI +
-                                        ci],             /* src */
-                            sizeof(double) * l->TILE_CI, /* size */
-                            sizeof(double) * l->TILE_CI, /* dst_stride */
-                            sizeof(double) * l->CI,      /* src_stride */
+                            weights + _co * weights_co_stride * size, /* dst */
+                            l_weights +
+                                ((co + _co) * l->FH * l->FW * l->CI + ci) *
+                                    size,      /* src */
+                            size * l->TILE_CI, /* size */
+                            size * l->TILE_CI, /* dst_stride */
+                            size * l->CI,      /* src_stride */
                             l->FH * l->FW /* repetitions */);
                     }
                 }
@@ -140,17 +184,20 @@ void conv2d_layer(const conv_layer *l) {
                         // Load the intermediate outputs from memory
                         if (ci != 0) {
                             snrt_dma_txid_t ofmap_txid = snrt_dma_start_2d(
-                                &ofmap[write_buf * ofmap_stride], /* dst */
-                                &l->ofmap[(oh * l->OW + ow) * l->CO +
-                                          co],          /* src */
-                                sizeof(double) * 8,     /* size */
-                                sizeof(double) * 8,     /* dst_stride */
-                                sizeof(double) * l->CO, /* src_stride */
-                                n_ofmap_pixel_read);    /* repetitions */
+                                /* dst */
+                                ofmap + write_buf * ofmap_stride * size,
+                                /* src */
+                                l_ofmap + ((oh * l->OW + ow) * l->CO + co) *
+                                              size,
+                                size * 8,           /* size */
+                                size * 8,           /* dst_stride */
+                                size * l->CO,       /* src_stride */
+                                n_ofmap_pixel_read); /* repetitions */
                             snrt_dma_wait_all();
                         } else {
-                            dma_memset(&ofmap[write_buf * ofmap_stride], 0,
-                                       sizeof(double) * 8 * n_ofmap_pixel_read);
+                            dma_memset(
+                                ofmap + write_buf * ofmap_stride * size, 0,
+                                align_up(size * 8 * n_ofmap_pixel_read, 64));
                         }
 
                         if (l->cluster2cluster) {
@@ -180,11 +227,14 @@ void conv2d_layer(const conv_layer *l) {
                                 // Fill horizontal lines with zeros for padding
                                 if (oh + fh < l->pad ||
                                     oh + fh >= l->IH + ((l->FH - 1) >> 1)) {
-                                    dma_memset(&ifmap[write_buf * ifmap_stride +
-                                                      fh * ifmap_row_stride],
-                                               0,
-                                               sizeof(double) * l->TILE_CI *
-                                                   n_ifmap_pixel_read);
+                                    dma_memset(
+                                        ifmap + (write_buf * ifmap_stride +
+                                                 fh * ifmap_row_stride) *
+                                                    size,
+                                        0,
+                                        align_up(size * l->TILE_CI *
+                                                     n_ifmap_pixel_read,
+                                                 64));
                                 } else {
                                     uint32_t padding_left =
                                         (ow < l->pad) ? (l->pad - ow) : 0;
@@ -199,34 +249,31 @@ void conv2d_layer(const conv_layer *l) {
                                     // buffer to zero
                                     if (padding_left || padding_right) {
                                         dma_memset(
-                                            &ifmap[write_buf * ifmap_stride +
-                                                   fh * ifmap_row_stride],
-                                            0,
-                                            sizeof(double) *
-                                                (compute_num + l->FW - 1) *
-                                                l->TILE_CI);
+                                            ifmap + (write_buf * ifmap_stride +
+                                                     fh * ifmap_row_stride) *
+                                                        size,
+                                            0, size * ifmap_row_stride);
                                     }
 
                                     // Then fill in the rest of the values
                                     snrt_dma_txid_t ifmap_txid =
                                         snrt_dma_start_2d(
-                                            &ifmap[write_buf * ifmap_stride +
-                                                   fh * ifmap_row_stride +
-                                                   padding_left *
-                                                       ifmap_col_stride], /* dst
-                                                                           */
-                                            (double *)&l->ifmap
-                                                [((oh + fh - l->pad) * l->IW +
+                                            ifmap +
+                                                (write_buf * ifmap_stride +
+                                                 fh * ifmap_row_stride +
+                                                 padding_left *
+                                                     ifmap_col_stride) *
+                                                    size, /* dst */
+                                            l_ifmap +
+                                                (((oh + fh - l->pad) * l->IW +
                                                   ow -
                                                   (l->pad - padding_left)) *
                                                      l->CI +
-                                                 ci], /* src */
-                                            sizeof(double) *
-                                                l->TILE_CI, /* size */
-                                            sizeof(double) *
-                                                l->TILE_CI, /* dst_stride */
-                                            sizeof(double) *
-                                                l->CI, /* src_stride */
+                                                 ci) *
+                                                    size,  /* src */
+                                            size * l->TILE_CI, /* size */
+                                            size * l->TILE_CI, /* dst_stride */
+                                            size * l->CI,      /* src_stride */
                                             n_ifmap_pixel_read - padding_left -
                                                 padding_right /* n_ifmap_pixel_read
                                                                */
@@ -243,7 +290,7 @@ void conv2d_layer(const conv_layer *l) {
                             uint32_t cluster_offset = 0x00040000;
                             volatile uint32_t *src_synch_flag =
                                 (void *)synch_flag - cluster_offset;
-                            double *src_ifmap = (void *)ifmap - cluster_offset;
+                            char *src_ifmap = ifmap - cluster_offset;
 
                             // Wait until previous cluster has released data
                             if (l->cluster2cluster &&
@@ -256,10 +303,9 @@ void conv2d_layer(const conv_layer *l) {
                             // such that im2col transformation can be performed
                             // for every core
                             snrt_dma_txid_t ifmap_txid = snrt_dma_start_1d(
-                                &ifmap[write_buf * ifmap_stride],
-                                &src_ifmap[!write_buf * ifmap_stride],
-                                sizeof(double) * n_ifmap_pixel_read *
-                                    l->TILE_CI * l->FH);
+                                ifmap + write_buf * ifmap_stride * size,
+                                src_ifmap + !write_buf * ifmap_stride * size,
+                                size * ifmap_stride);
                             snrt_dma_wait_all();
 
                             // clear synch flag of src cluster
@@ -288,16 +334,16 @@ void conv2d_layer(const conv_layer *l) {
                             // only construct im2col matrix for leftover pixels
                             if (ow + n < l->OW) {
                                 snrt_dma_txid_t im2col_txid = snrt_dma_start_2d(
-                                    &im2col[write_buf * im2col_mat_stride +
-                                            n * im2col_row_stride], /* dst */
-                                    &ifmap[read_buf * ifmap_stride +
-                                           n * ifmap_col_stride], /* src */
-                                    sizeof(double) * l->FW *
-                                        l->TILE_CI, /* size */
-                                    sizeof(double) * l->FW *
-                                        l->TILE_CI, /* dst_stride */
-                                    sizeof(double) * (compute_num + l->FW - 1) *
-                                        l->TILE_CI, /* src_stride */
+                                    im2col + (write_buf * im2col_mat_stride +
+                                              n * im2col_row_stride) *
+                                                 size, /* dst */
+                                    ifmap + (read_buf * ifmap_stride +
+                                             n * ifmap_col_stride) *
+                                                size,            /* src */
+                                    size * l->FW * l->TILE_CI,   /* size */
+                                    /* dst_stride */
+                                    size * l->FW * l->TILE_CI,
+                                    size * ifmap_row_stride, /* src_stride */
                                     l->FH /* repetitions */);
                             }
                         }
@@ -312,13 +358,16 @@ void conv2d_layer(const conv_layer *l) {
                         // Transfer back the output feature maps
                         if (oh_prev + ow_prev >= 0) {
                             snrt_dma_txid_t ofmap_txid = snrt_dma_start_2d(
-                                &l->ofmap[(oh_prev * l->OW + ow_prev) * l->CO +
-                                          co],                    /* dst */
-                                &ofmap[!read_buf * ofmap_stride], /* src */
-                                sizeof(double) * 8,               /* size */
-                                sizeof(double) * l->CO, /* dst_stride */
-                                sizeof(double) * 8,     /* src_stride */
-                                n_ofmap_pixel_write);   /* repetitions */
+                                /* dst */
+                                l_ofmap +
+                                    ((oh_prev * l->OW + ow_prev) * l->CO + co) *
+                                        size,
+                                /* src */
+                                ofmap + !read_buf * ofmap_stride * size,
+                                size * 8,             /* size */
+                                size * l->CO,        /* dst_stride */
+                                size * 8,            /* src_stride */
+                                n_ofmap_pixel_write); /* repetitions */
                             snrt_dma_wait_all();
                         }
                         oh_prev = oh;
@@ -343,30 +392,20 @@ void conv2d_layer(const conv_layer *l) {
                             uint32_t setup_SSR =
                                 (ci == 0 && ow == 0 && _oh == 0) ? 1 : 0;
 
-                            if (ci != 0 && l->TILE_CI != l->CI) {
-                                const uint32_t alpha = 0;
-                                gemm_fp64_ssr_frep(
-                                    1, 8, l->FH * l->FW * l->TILE_CI,
-                                    &im2col[read_buf * im2col_mat_stride +
-                                            compute_id * im2col_row_stride],
-                                    0, 0, weights,
-                                    l->FH * l->FW * l->TILE_CI + 1, 1,
-                                    &ofmap[write_buf * ofmap_stride +
-                                           compute_id * ofmap_co_stride],
-                                    0, &alpha, setup_SSR);
-
-                            } else {
-                                const uint32_t alpha = 1;
-                                gemm_fp64_ssr_frep(
-                                    1, 8, l->FH * l->FW * l->TILE_CI,
-                                    &im2col[read_buf * im2col_mat_stride +
-                                            compute_id * im2col_row_stride],
-                                    0, 0, weights,
-                                    l->FH * l->FW * l->TILE_CI + 1, 1,
-                                    &ofmap[write_buf * ofmap_stride +
-                                           compute_id * ofmap_co_stride],
-                                    0, &alpha, setup_SSR);
-                            }
+                            // The output buffer is either cleared or holds
+                            // the partial sums of the previous input channel
+                            // tiles, so it is always accumulated upon
+                            const uint32_t alpha = 1;
+                            conv2d_gemm(
+                                l->dtype, l->FH * l->FW * l->TILE_CI,
+                                im2col + (read_buf * im2col_mat_stride +
+                                          compute_id * im2col_row_stride) *
+                                             size,
+                                weights, weights_co_stride,
+                                ofmap + (write_buf * ofmap_stride +
+                                         compute_id * ofmap_co_stride) *
+                                            size,
+                                &alpha, setup_SSR);
                         }
                         // Toggle read and write buffer
                         read_buf = !read_buf;
@@ -380,12 +419,12 @@ void conv2d_layer(const conv_layer *l) {
             // Transfer back last output tile
             if (snrt_is_dm_core()) {
                 snrt_dma_txid_t ofmap_txid = snrt_dma_start_2d(
-                    &l->ofmap[(oh_prev * l->OW + ow_prev) * l->CO +
-                              co],                      /* dst */
-                    &ofmap[!read_buf * ofmap_stride],   /* src */
-                    sizeof(double) * 8,                 /* size */
-                    sizeof(double) * l->CO,             /* dst_stride */
-                    sizeof(double) * 8,                 /* src_stride */
+                    l_ofmap + ((oh_prev * l->OW + ow_prev) * l->CO + co) *
+                                  size,                      /* dst */
+                    ofmap + !read_buf * ofmap_stride * size, /* src */
+                    size * 8,                                /* size */
+                    size * l->CO,                            /* dst_stride */
+                    size * 8,                                /* src_stride */
                     min(compute_num, l->OW - ow_prev)); /* repetitions */
                 snrt_dma_wait_all();
             }
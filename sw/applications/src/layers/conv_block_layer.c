@@ -0,0 +1,244 @@
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "conv_block_layer.h"
+
+#include "gemm.h"
+#include "layer.h"
+#include "maxpool.h"
+#include "printf.h"
+#include "snrt.h"
+#include "utils.h"
+
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#define ceil_div(a, b) (((a) + (b)-1) / (b))
+#define align_up(a, b) (ceil_div(a, b) * (b))
+
+// Number of output channels computed at once, given by the unrolling of the
+// GEMM kernel
+#define CO_TILE 8
+
+/**
+ * @struct conv_block_step_struct
+ * @brief One step of the conv block: the contribution of a tile of input
+ * channels to one row of pooled output pixels of a group of output channels.
+ */
+typedef struct conv_block_step_struct {
+    uint32_t co, ph, ci;
+    uint32_t group, tile;
+    uint32_t first, last;
+} conv_block_step;
+
+static conv_block_step get_step(const conv_layer *l, uint32_t s) {
+    uint32_t ci_tiles = l->CI / l->TILE_CI;
+    uint32_t tiles_per_group = l->OH / l->pool;
+
+    // Groups of output channels are distributed across clusters in a
+    // round-robin fashion
+    conv_block_step st;
+    st.tile = s / ci_tiles;
+    st.group = st.tile / tiles_per_group;
+    st.co = (snrt_cluster_idx() + st.group * snrt_cluster_num()) * CO_TILE;
+    st.ph = st.tile % tiles_per_group;
+    st.ci = s % ci_tiles * l->TILE_CI;
+    st.first = st.ci == 0;
+    st.last = st.ci + l->TILE_CI == l->CI;
+    return st;
+}
+
+void conv_block_layer(const conv_layer *l) {
+    const uint32_t cluster_num = snrt_cluster_num();
+    const uint32_t cluster_id = snrt_cluster_idx();
+    const uint32_t compute_num = snrt_cluster_compute_core_num();
+    const uint32_t compute_id = snrt_cluster_compute_core_idx();
+
+    // Pooled output dimensions, the remaining conv outputs are not computed
+    const uint32_t P = l->pool;
+    const uint32_t POW = l->OW / P;
+    const uint32_t W = POW * P;
+
+    // band[2][P + FH - 1][W + FW - 1][TILE_CI]
+    uint32_t band_w = W + l->FW - 1;
+    uint32_t band_h = P + l->FH - 1;
+    uint32_t band_size = align_up(band_h * band_w * l->TILE_CI, 8);
+
+    // weights[2][CO_TILE][FH * FW * TILE_CI + 1], padded to prevent banking
+    // conflicts
+    uint32_t weights_co_stride = l->FH * l->FW * l->TILE_CI + 1;
+    uint32_t weights_size = CO_TILE * weights_co_stride;
+
+    // acc[2][P][W][CO_TILE], out[2][POW][CO_TILE]
+    uint32_t acc_size = P * W * CO_TILE;
+    uint32_t out_size = POW * CO_TILE;
+
+    double *ptr = (double *)snrt_cluster_memory().start;
+    double *band[2], *weights[2], *acc[2], *out[2];
+    for (uint32_t i = 0; i < 2; i++) {
+        band[i] = ptr;
+        ptr += band_size;
+    }
+    for (uint32_t i = 0; i < 2; i++) {
+        weights[i] = ptr;
+        ptr += weights_size;
+        acc[i] = ptr;
+        ptr += acc_size;
+        out[i] = ptr;
+        ptr += out_size;
+    }
+    double *gamma = ptr;
+    ptr += l->CO;
+    double *beta = ptr;
+    ptr += l->CO;
+
+    uint32_t groups = l->CO / CO_TILE;
+    uint32_t groups_cluster =
+        groups > cluster_id ? ceil_div(groups - cluster_id, cluster_num) : 0;
+    uint32_t steps = groups_cluster * (l->OH / P) * (l->CI / l->TILE_CI);
+
+    // The zero padding on the left and right is the same for every row, so
+    // it is only set once. The DMA never writes these columns.
+    if (snrt_is_dm_core()) {
+        snrt_dma_start_tracking();
+        dma_memset(band[0], 0, sizeof(double) * band_size);
+        dma_memset(band[1], 0, sizeof(double) * band_size);
+        snrt_dma_start_1d(gamma, l->gamma, sizeof(double) * l->CO);
+        snrt_dma_start_1d(beta, l->beta, sizeof(double) * l->CO);
+        snrt_dma_wait_all();
+        snrt_dma_stop_tracking();
+    }
+
+    benchmark_get_cycle();
+
+    // In step `s`, the DMA core writes back the pooled row completed in step
+    // `s - 3` and loads the input rows and weights of step `s`. The compute
+    // cores pool the row completed in step `s - 2`, and then accumulate the
+    // conv outputs of step `s - 1`. The input band alternates between the
+    // buffers with the step, the conv and pooled outputs with the row.
+    for (uint32_t s = 0; s < steps + 3; s++) {
+        if (snrt_is_dm_core()) {
+            if (s >= 3) {
+                conv_block_step st = get_step(l, s - 3);
+                if (st.last) {
+                    snrt_dma_start_2d(
+                        &l->ofmap[st.ph * POW * l->CO + st.co], /* dst */
+                        out[st.tile % 2],                       /* src */
+                        sizeof(double) * CO_TILE,               /* size */
+                        sizeof(double) * l->CO, /* dst_stride */
+                        sizeof(double) * CO_TILE, /* src_stride */
+                        POW);                     /* repetitions */
+                    snrt_dma_wait_all();
+                }
+            }
+            if (s < steps) {
+                conv_block_step st = get_step(l, s);
+                uint32_t buf = s % 2;
+                snrt_dma_start_tracking();
+
+                // Rows above and below the input are zero padding
+                uint32_t row0 = st.ph * P;
+                uint32_t row_start = row0 < l->pad ? l->pad - row0 : 0;
+                uint32_t row_end = min(band_h, l->IH + l->pad - row0);
+                if (row_start > 0 || row_end < band_h) {
+                    dma_memset(band[buf], 0, sizeof(double) * band_size);
+                }
+
+                uint32_t cols = min(band_w, l->IW + l->pad) - l->pad;
+                double *dst =
+                    &band[buf][(row_start * band_w + l->pad) * l->TILE_CI];
+                double *src =
+                    &l->ifmap[(row0 + row_start - l->pad) * l->IW * l->CI +
+                              st.ci];
+                if (l->TILE_CI == l->CI) {
+                    // Pixels of a row are stored consecutively
+                    snrt_dma_start_2d(
+                        dst,                             /* dst */
+                        src,                             /* src */
+                        sizeof(double) * cols * l->CI,   /* size */
+                        sizeof(double) * band_w * l->CI, /* dst_stride */
+                        sizeof(double) * l->IW * l->CI,  /* src_stride */
+                        row_end - row_start);            /* repetitions */
+                } else {
+                    for (uint32_t r = row_start; r < row_end; r++) {
+                        snrt_dma_start_2d(
+                            dst,                         /* dst */
+                            src,                         /* src */
+                            sizeof(double) * l->TILE_CI, /* size */
+                            sizeof(double) * l->TILE_CI, /* dst_stride */
+                            sizeof(double) * l->CI,      /* src_stride */
+                            cols);                       /* repetitions */
+                        dst += band_w * l->TILE_CI;
+                        src += l->IW * l->CI;
+                    }
+                }
+
+                // Without input channel tiling the weights of a group stay in
+                // the same buffer for all of its rows
+                if (l->TILE_CI != l->CI || (st.ph == 0 && st.first)) {
+                    double *w = weights[l->TILE_CI == l->CI ? st.group % 2
+                                                            : buf];
+                    for (uint32_t _co = 0; _co < CO_TILE; _co++) {
+                        snrt_dma_start_2d(
+                            &w[_co * weights_co_stride], /* dst */
+                            &l->weights[(st.co + _co) * l->FH * l->FW * l->CI +
+                                        st.ci],          /* src */
+                            sizeof(double) * l->TILE_CI, /* size */
+                            sizeof(double) * l->TILE_CI, /* dst_stride */
+                            sizeof(double) * l->CI,      /* src_stride */
+                            l->FH * l->FW);              /* repetitions */
+                    }
+                }
+                snrt_dma_wait_all();
+
+                snrt_dma_stop_tracking();
+            }
+        } else if (snrt_is_compute_core()) {
+            benchmark_get_cycle();
+
+            // BatchNorm, ReLU and MaxPool of a completed row, every core
+            // handles a subset of the channels
+            if (s >= 2 && s - 2 < steps) {
+                conv_block_step st = get_step(l, s - 2);
+                if (st.last) {
+                    for (uint32_t _co = compute_id; _co < CO_TILE;
+                         _co += compute_num) {
+                        bn_relu_maxpool_fp64(
+                            &acc[st.tile % 2][_co], gamma[st.co + _co],
+                            beta[st.co + _co], &out[st.tile % 2][_co], POW, W,
+                            CO_TILE, P, P);
+                    }
+                }
+            }
+
+            // Each core computes every `compute_num`-th pixel of the conv
+            // rows. The receptive field of a pixel is FH rows of FW
+            // consecutive pixels in the input band, such that every filter
+            // row is a GEMM of (pixels x FW*TILE_CI) * (FW*TILE_CI x CO_TILE)
+            // without an im2col transformation.
+            if (s >= 1 && s <= steps && W > compute_id) {
+                conv_block_step st = get_step(l, s - 1);
+                uint32_t buf = (s - 1) % 2;
+                double *w = weights[l->TILE_CI == l->CI ? st.group % 2 : buf];
+                uint32_t m = ceil_div(W - compute_id, compute_num);
+
+                for (uint32_t r = 0; r < P; r++) {
+                    for (uint32_t fh = 0; fh < l->FH; fh++) {
+                        const uint32_t alpha = !st.first || fh != 0;
+                        gemm_fp64_ssr_frep(
+                            m, CO_TILE, l->FW * l->TILE_CI,
+                            &band[buf][((r + fh) * band_w + compute_id) *
+                                       l->TILE_CI],
+                            compute_num * l->TILE_CI, 0,
+                            &w[fh * l->FW * l->TILE_CI], weights_co_stride, 1,
+                            &acc[st.tile % 2][(r * W + compute_id) * CO_TILE],
+                            compute_num * CO_TILE, &alpha, 1);
+                    }
+                }
+            }
+            benchmark_get_cycle();
+        }
+        snrt_cluster_hw_barrier();
+    }
+
+    benchmark_get_cycle();
+}
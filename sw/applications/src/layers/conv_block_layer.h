@@ -0,0 +1,21 @@
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "layer.h"
+
+/**
+ * @brief Conv2d + BatchNorm + ReLU + MaxPool block that keeps the conv output
+ * in the TCDM. For every row of pooled output pixels, the conv outputs of the
+ * `pool` rows below it are accumulated over the input channel tiles, then
+ * normalized, rectified and pooled in a single SSR stream. Only the pooled row
+ * is written back to main memory. Groups of 8 output channels are distributed
+ * across clusters, data transfers are double buffered.
+ *
+ * Requires a stride of 1, CO to be a multiple of 8, TILE_CI to divide CI and
+ * a pooling window of at least 2. The ofmap is of size
+ * (OH / pool) x (OW / pool) x CO.
+ *
+ * @param l conv_layer struct that holds addresses and parameters
+ */
+void conv_block_layer(const conv_layer *l);
@@ -0,0 +1,378 @@
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "dwconv_layer.h"
+
+#include "dwconv.h"
+#include "gemm.h"
+#include "layer.h"
+#include "printf.h"
+#include "snrt.h"
+#include "utils.h"
+
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#define max(a, b) ((a) > (b) ? (a) : (b))
+#define ceil_div(a, b) (((a) + (b)-1) / (b))
+#define align_up(a, b) (ceil_div(a, b) * (b))
+
+// Stages of the layer
+#define DW 1
+#define PW 2
+
+/**
+ * @struct dwconv_buffers_struct
+ * @brief Buffers of the layer in the TCDM for tiles of TH output rows,
+ * strides in elements
+ */
+typedef struct dwconv_buffers_struct {
+    // in[2][rows][ldh]: the input rows of the depthwise stage, rows aligned
+    // for `dma_memset`, or the input pixels of the pointwise layer
+    char *in;
+    uint32_t in_ldw;
+    uint32_t in_ldh;
+    uint32_t in_stride;
+    // dw_weights[2][FH * FW][TILE_CI]
+    char *dw_weights;
+    // dw_out[2][TH * OW][TILE_CI], or a single dw_out[TH * OW][ld] if fused
+    char *dw_out;
+    uint32_t dw_ld;
+    // pw_weights[2][CO][ld]
+    char *pw_weights;
+    // acc[2][TH * OW][CO]
+    char *acc;
+    // Rows of the GEMM operands are padded by one 64-bit word to prevent
+    // banking conflicts
+    uint32_t ld;
+    uint32_t bytes;
+} dwconv_buffers;
+
+/**
+ * @struct dwconv_step_struct
+ * @brief One step of the layer: a tile of input channels of a tile of output
+ * rows
+ */
+typedef struct dwconv_step_struct {
+    uint32_t tile, k;
+    uint32_t oh, rows, ci;
+} dwconv_step;
+
+static inline uint32_t get_stride(const conv_layer *l) {
+    return l->conv_stride ? l->conv_stride : 1;
+}
+
+static dwconv_buffers get_buffers(const conv_layer *l, uint32_t stages,
+                                  uint32_t TH) {
+    const uint32_t size = l->dtype;
+    const uint32_t T = l->TILE_CI;
+    const uint32_t P = TH * l->OW;
+
+    dwconv_buffers b;
+    b.ld = T + 8 / size;
+    if (stages & DW) {
+        b.in_ldw = T;
+        b.in_ldh = align_up((l->IW + 2 * l->pad) * T * size, 64) / size;
+        b.in_stride = ((TH - 1) * get_stride(l) + l->FH) * b.in_ldh;
+    } else {
+        b.in_ldw = b.ld;
+        b.in_ldh = l->OW * b.ld;
+        b.in_stride = P * b.ld;
+    }
+    b.dw_ld = stages == DW ? T : b.ld;
+
+    char *ptr = (char *)snrt_cluster_memory().start;
+    b.in = ptr;
+    ptr += 2 * b.in_stride * size;
+    b.dw_weights = ptr;
+    if (stages & DW) ptr += 2 * l->FH * l->FW * T * size;
+    b.dw_out = ptr;
+    if (stages == DW) ptr += 2 * P * T * size;
+    if (stages == (DW | PW)) ptr += P * b.ld * size;
+    b.pw_weights = ptr;
+    if (stages & PW) ptr += 2 * l->CO * b.ld * size;
+    b.acc = ptr;
+    if (stages & PW) ptr += 2 * P * l->CO * size;
+    b.bytes = ptr - (char *)snrt_cluster_memory().start;
+    return b;
+}
+
+static dwconv_step get_step(const conv_layer *l, uint32_t TH, uint32_t row0,
+                            uint32_t row1, uint32_t s) {
+    const uint32_t n_ci = l->CI / l->TILE_CI;
+
+    dwconv_step st;
+    st.tile = s / n_ci;
+    st.k = s % n_ci;
+    st.oh = row0 + st.tile * TH;
+    st.rows = min(TH, row1 - st.oh);
+    st.ci = st.k * l->TILE_CI;
+    return st;
+}
+
+// Loads the inputs of a step into buffer `buf` and, if `weights` is set, its
+// weights into buffer `wbuf`
+static void load_step(const conv_layer *l, const dwconv_buffers *b,
+                      uint32_t stages, const dwconv_step *st, uint32_t buf,
+                      uint32_t wbuf, uint32_t weights) {
+    const uint32_t size = l->dtype;
+    const uint32_t T = l->TILE_CI;
+    const char *ifmap = (const char *)l->ifmap;
+    char *in = b->in + buf * b->in_stride * size;
+
+    if (stages & DW) {
+        // Rows above and below the ifmap are zero padding, the columns left
+        // and right of it are never written
+        const int32_t ih0 = (int32_t)(st->oh * get_stride(l)) - (int32_t)l->pad;
+        const int32_t rows = (st->rows - 1) * get_stride(l) + l->FH;
+        const int32_t r0 = min(max(-ih0, 0), rows);
+        const int32_t r1 = max(min((int32_t)l->IH - ih0, rows), r0);
+        for (int32_t r = 0; r < rows; r++) {
+            if (r < r0 || r >= r1) {
+                dma_memset(in + r * b->in_ldh * size, 0, b->in_ldh * size);
+            }
+        }
+
+        char *dst = in + (r0 * b->in_ldh + l->pad * T) * size;
+        const char *src = ifmap + ((ih0 + r0) * l->IW * l->CI + st->ci) * size;
+        if (r1 > r0 && T == l->CI) {
+            // Pixels of a row are stored consecutively
+            snrt_dma_start_2d(dst,                  /* dst */
+                              src,                  /* src */
+                              size * l->IW * l->CI, /* size */
+                              size * b->in_ldh,     /* dst_stride */
+                              size * l->IW * l->CI, /* src_stride */
+                              r1 - r0 /* repetitions */);
+        } else {
+            for (int32_t r = r0; r < r1; r++) {
+                snrt_dma_start_2d(dst,          /* dst */
+                                  src,          /* src */
+                                  size * T,     /* size */
+                                  size * T,     /* dst_stride */
+                                  size * l->CI, /* src_stride */
+                                  l->IW /* repetitions */);
+                dst += b->in_ldh * size;
+                src += l->IW * l->CI * size;
+            }
+        }
+
+        if (weights) {
+            snrt_dma_start_2d(
+                b->dw_weights + wbuf * l->FH * l->FW * T * size, /* dst */
+                (const char *)l->weights + st->ci * size,        /* src */
+                size * T,                                        /* size */
+                size * T,     /* dst_stride */
+                size * l->CI, /* src_stride */
+                l->FH * l->FW /* repetitions */);
+        }
+    } else {
+        snrt_dma_start_2d(
+            in,                                                /* dst */
+            ifmap + (st->oh * l->OW * l->CI + st->ci) * size,  /* src */
+            size * T,                                          /* size */
+            size * b->ld,                                      /* dst_stride */
+            size * l->CI,                                      /* src_stride */
+            st->rows * l->OW /* repetitions */);
+    }
+
+    if ((stages & PW) && weights) {
+        const char *w =
+            (const char *)(stages & DW ? l->pw_weights : l->weights);
+        snrt_dma_start_2d(
+            b->pw_weights + wbuf * l->CO * b->ld * size, /* dst */
+            w + st->ci * size,                           /* src */
+            size * T,                                    /* size */
+            size * b->ld,                                /* dst_stride */
+            size * l->CI,                                /* src_stride */
+            l->CO /* repetitions */);
+    }
+}
+
+// Writes back the output of a step from buffer `buf`
+static void store_step(const conv_layer *l, const dwconv_buffers *b,
+                       uint32_t stages, const dwconv_step *st, uint32_t TH,
+                       uint32_t buf) {
+    const uint32_t size = l->dtype;
+    const uint32_t T = l->TILE_CI;
+    char *ofmap = (char *)l->ofmap;
+
+    if (stages & PW) {
+        // The tile consists of complete rows with all output channels
+        snrt_dma_start_1d(ofmap + st->oh * l->OW * l->CO * size,
+                          b->acc + buf * TH * l->OW * l->CO * size,
+                          size * st->rows * l->OW * l->CO);
+    } else {
+        snrt_dma_start_2d(
+            ofmap + (st->oh * l->OW * l->CI + st->ci) * size, /* dst */
+            b->dw_out + buf * TH * l->OW * T * size,          /* src */
+            size * T,                                         /* size */
+            size * l->CI,                                     /* dst_stride */
+            size * T,                                         /* src_stride */
+            st->rows * l->OW /* repetitions */);
+    }
+}
+
+// Multiplies pixels with the transposed pointwise weights in the precision of
+// the layer
+static void pw_gemm(precision_t dtype, uint32_t M, uint32_t N, uint32_t K,
+                    void *A, uint32_t ldA, void *B, uint32_t ldB, void *C,
+                    uint32_t ldC, const uint32_t *alpha) {
+    switch (dtype) {
+        case FP64:
+            gemm_fp64_ssr_frep(M, N, K, A, ldA, 0, B, ldB, 1, C, ldC, alpha,
+                               1);
+            break;
+        case FP32:
+            gemm_fp32simd_tb_ssr_frep(M, N, K, A, ldA, B, ldB, C, ldC, alpha,
+                                      1);
+            break;
+        case FP16:
+            gemm_fp16simd_tb_ssr_frep(M, N, K, A, ldA, B, ldB, C, ldC, alpha,
+                                      1);
+            break;
+        default:
+            break;
+    }
+}
+
+static uint32_t dwconv(const conv_layer *l, uint32_t stages) {
+    const uint32_t cluster_num = snrt_cluster_num();
+    const uint32_t cluster_id = snrt_cluster_idx();
+    const uint32_t compute_num = snrt_cluster_compute_core_num();
+    const uint32_t compute_id = snrt_cluster_compute_core_idx();
+    const uint32_t is_main =
+        cluster_id == 0 && snrt_is_compute_core() && compute_id == 0;
+
+    const uint32_t size = l->dtype;
+    const uint32_t T = l->TILE_CI;
+
+    if ((l->dtype != FP64 && l->dtype != FP32 && l->dtype != FP16) || !T ||
+        l->CI % T || T * size % 64 || ((stages & PW) && l->CO % 8) ||
+        (stages == DW && l->CO != l->CI)) {
+        if (is_main) printf("Unsupported depthwise/pointwise layer\n");
+        return 1;
+    }
+
+    // Output rows are distributed across clusters in contiguous ranges
+    const uint32_t per_cluster = ceil_div(l->OH, cluster_num);
+    const uint32_t row0 = min(cluster_id * per_cluster, l->OH);
+    const uint32_t row1 = min(row0 + per_cluster, l->OH);
+
+    // At least four tiles of rows per cluster to overlap the transfers with
+    // the computation, unless the depthwise stage of a tile would not occupy
+    // all cores. Tiles are shrunk until they fit into the TCDM.
+    const uint32_t groups = T * size / 64;
+    uint32_t TH = min(per_cluster, max(ceil_div(per_cluster, 4),
+                                       ceil_div(compute_num, groups)));
+    dwconv_buffers b = get_buffers(l, stages, TH);
+    while (b.bytes > snrt_slice_len(snrt_cluster_memory())) {
+        if (TH == 1) {
+            if (is_main) printf("Depthwise/pointwise layer does not fit\n");
+            return 1;
+        }
+        TH--;
+        b = get_buffers(l, stages, TH);
+    }
+
+    const uint32_t n_ci = l->CI / T;
+    const uint32_t steps = ceil_div(row1 - row0, TH) * n_ci;
+
+    // Without tiling of the input channels, all steps share their weights,
+    // which are only loaded once
+    const uint32_t reload = n_ci > 1;
+
+    if (snrt_is_dm_core() && steps) {
+        if ((stages & DW) && l->pad) {
+            dma_memset(b.in, 0, 2 * b.in_stride * size);
+        }
+        const dwconv_step st = get_step(l, TH, row0, row1, 0);
+        load_step(l, &b, stages, &st, 0, 0, 1);
+        snrt_dma_wait_all();
+    }
+
+    for (uint32_t s = 0; s < steps; s++) {
+        const dwconv_step st = get_step(l, TH, row0, row1, s);
+        const uint32_t buf = s % 2;
+        const uint32_t wbuf = reload ? buf : 0;
+
+        snrt_cluster_hw_barrier();
+
+        if (snrt_is_dm_core()) {
+            // Prefetch the next step, and write back the output completed in
+            // the previous one while the current one is computed
+            if (s + 1 < steps) {
+                const dwconv_step next = get_step(l, TH, row0, row1, s + 1);
+                load_step(l, &b, stages, &next, !buf, reload ? !buf : 0,
+                          reload);
+            }
+            if (s > 0) {
+                const dwconv_step prev = get_step(l, TH, row0, row1, s - 1);
+                if (stages == DW || prev.k == n_ci - 1) {
+                    store_step(l, &b, stages, &prev, TH,
+                               stages & PW ? prev.tile % 2 : !buf);
+                }
+            }
+            if (stages == (DW | PW)) snrt_cluster_hw_barrier();
+            snrt_dma_wait_all();
+            continue;
+        }
+
+        // Every core convolves every `compute_num`-th group of 8 words of
+        // channels of the output rows
+        if (stages & DW) {
+            const uint32_t wpe = size * T / 8;
+            const uint32_t ldo = b.dw_ld * size / 8;
+            char *in = b.in + buf * b.in_stride * size;
+            char *out = b.dw_out;
+            if (stages == DW) out += buf * TH * l->OW * T * size;
+            uint32_t setup_SSR = 1;
+            for (uint32_t i = compute_id; i < st.rows * groups;
+                 i += compute_num) {
+                const uint32_t r = i / groups;
+                const uint32_t g = i % groups;
+                dwconv_ssr_frep(
+                    l->dtype, l->OW, l->FH, l->FW, get_stride(l),
+                    (double *)(in +
+                               r * get_stride(l) * b.in_ldh * size) + g * 8,
+                    wpe, b.in_ldh * size / 8,
+                    (double *)(b.dw_weights +
+                               wbuf * l->FH * l->FW * T * size) + g * 8,
+                    wpe, (double *)(out + r * l->OW * b.dw_ld * size) + g * 8,
+                    ldo, setup_SSR);
+                setup_SSR = 0;
+            }
+            if (stages == (DW | PW)) snrt_cluster_hw_barrier();
+        }
+
+        // Every core multiplies every `compute_num`-th pixel of the tile with
+        // the pointwise weights, the first tile of input channels overwrites
+        // the accumulators
+        const uint32_t P = st.rows * l->OW;
+        if ((stages & PW) && P > compute_id) {
+            const uint32_t alpha = st.k != 0;
+            char *A = stages & DW ? b.dw_out : b.in + buf * b.in_stride * size;
+            pw_gemm(l->dtype, ceil_div(P - compute_id, compute_num), l->CO, T,
+                    A + compute_id * b.ld * size, compute_num * b.ld,
+                    b.pw_weights + wbuf * l->CO * b.ld * size, b.ld,
+                    b.acc + (st.tile % 2 * TH * l->OW + compute_id) * l->CO *
+                                size,
+                    compute_num * l->CO, &alpha);
+        }
+    }
+
+    snrt_cluster_hw_barrier();
+
+    if (snrt_is_dm_core() && steps) {
+        const dwconv_step last = get_step(l, TH, row0, row1, steps - 1);
+        store_step(l, &b, stages, &last, TH,
+                   stages & PW ? last.tile % 2 : (steps - 1) % 2);
+        snrt_dma_wait_all();
+    }
+
+    return 0;
+}
+
+uint32_t dwconv_layer(const conv_layer *l) {
+    return dwconv(l, l->pw_weights ? DW | PW : DW);
+}
+
+uint32_t pwconv_layer(const conv_layer *l) { return dwconv(l, PW); }
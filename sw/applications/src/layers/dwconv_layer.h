@@ -0,0 +1,45 @@
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "layer.h"
+
+/**
+ * @brief Depthwise convolution layer with an optionally fused pointwise
+ * convolution. The output rows are distributed across clusters in contiguous
+ * ranges, which are processed in tiles of rows. For every tile of input
+ * channels, the DMA core streams the input rows of a row tile into the TCDM
+ * with 2D transfers, and the compute cores convolve groups of 8 words of
+ * channels of an output row (SSR and FREP). Transfers are double buffered.
+ *
+ * If `l->pw_weights` is set, the depthwise output of a tile stays in the TCDM
+ * and is multiplied with the pointwise weights, accumulating the CO output
+ * channels over the tiles of input channels. Only the pointwise output is
+ * written back to main memory. Otherwise, the ofmap has CI channels.
+ *
+ * Supports FP64, FP32 and FP16. Requires TILE_CI to divide CI and to fill a
+ * multiple of 64 bytes, CO to be a multiple of 8 if fused, and CO = CI
+ * otherwise. The weights are in FH x FW x CI format, the stride is
+ * `l->conv_stride`. Tiles are shrunk until the buffers fit into the TCDM, the
+ * fused layer needs at least one output row with CO channels.
+ *
+ * @param l conv_layer struct that holds addresses and parameters
+ * @return uint32_t 0 on success, 1 if the layer is not supported or does not
+ * fit into the TCDM
+ */
+uint32_t dwconv_layer(const conv_layer *l);
+
+/**
+ * @brief Pointwise (1 x 1) convolution layer, the tiled GEMM of the pixels
+ * with the CO x CI weights. Tiles of output rows are distributed across
+ * clusters like in the depthwise layer and accumulated over the tiles of
+ * input channels in the TCDM.
+ *
+ * Supports FP64, FP32 and FP16 with the same requirements as the fused
+ * depthwise layer. The input and output feature maps have the same size.
+ *
+ * @param l conv_layer struct that holds addresses and parameters
+ * @return uint32_t 0 on success, 1 if the layer is not supported or does not
+ * fit into the TCDM
+ */
+uint32_t pwconv_layer(const conv_layer *l);
@@ -0,0 +1,212 @@
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "gemm_layer.h"
+
+#include "gemm.h"
+#include "gemm_tiling.h"
+#include "layer.h"
+#include "printf.h"
+#include "snrt.h"
+#include "utils.h"
+
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#define ceil_div(a, b) (((a) + (b)-1) / (b))
+#define align_up(a, b) (ceil_div(a, b) * (b))
+
+/**
+ * @struct gemm_step_struct
+ * @brief One step of the tiled GEMM: the product of a tile of A and a tile of
+ * B accumulated into a tile of C. The sizes are the valid part of the tiles.
+ */
+typedef struct gemm_step_struct {
+    uint32_t m0, n0, k0;
+    uint32_t m, n, k;
+    uint32_t first, last;
+    uint32_t c_buf;
+} gemm_step;
+
+static gemm_step get_step(const gemm_layer *l, const gemm_tiling *t,
+                          uint32_t s) {
+    uint32_t cluster_num = snrt_cluster_num();
+    uint32_t cluster_id = snrt_cluster_idx();
+    uint32_t tiles_n = ceil_div(l->N, t->TILE_N);
+    uint32_t tiles_k = ceil_div(l->K, t->TILE_K);
+
+    // Tiles of C are distributed across clusters in a round-robin fashion
+    uint32_t tile = cluster_id + (s / tiles_k) * cluster_num;
+    gemm_step st;
+    st.c_buf = (s / tiles_k) % 2;
+    st.m0 = tile / tiles_n * t->TILE_M;
+    st.n0 = tile % tiles_n * t->TILE_N;
+    st.k0 = s % tiles_k * t->TILE_K;
+    st.m = min(t->TILE_M, l->M - st.m0);
+    st.n = min(t->TILE_N, l->N - st.n0);
+    st.k = min(t->TILE_K, l->K - st.k0);
+    st.first = st.k0 == 0;
+    st.last = st.k0 + t->TILE_K >= l->K;
+    return st;
+}
+
+uint32_t tiled_gemm_layer(const gemm_layer *l) {
+    const uint32_t cluster_num = snrt_cluster_num();
+    const uint32_t cluster_id = snrt_cluster_idx();
+    const uint32_t compute_num = snrt_cluster_compute_core_num();
+    const uint32_t compute_id = snrt_cluster_compute_core_idx();
+    const uint32_t size = l->dtype;
+    const uint32_t c_elem = gemm_c_size(l);
+
+    gemm_tiling t;
+    snrt_slice_t mem = snrt_cluster_memory();
+    if (gemm_tiling_select(l, snrt_slice_len(mem), cluster_num, compute_num,
+                           &t)) {
+        if (cluster_id == 0 && compute_id == 0 && snrt_is_compute_core())
+            printf("No valid GEMM tiling\n");
+        return 1;
+    }
+
+    // A[2][TILE_M][TILE_K + PAD] (or A[2][TILE_K][TILE_M + PAD] if
+    // transposed), B[2][TILE_K][TILE_N + PAD] (or B[2][TILE_N][TILE_K + PAD]
+    // if transposed), C[2][TILE_M][TILE_N] in the precision of C
+    uint32_t lda = l->TA ? t.TILE_M + t.PAD : t.TILE_K + t.PAD;
+    uint32_t ldb = l->TB ? t.TILE_K + t.PAD : t.TILE_N + t.PAD;
+    uint32_t ldc = t.TILE_N;
+    uint32_t a_size =
+        align_up((l->TA ? t.TILE_K : t.TILE_M) * lda * size, 64);
+    uint32_t b_size =
+        align_up((l->TB ? t.TILE_N : t.TILE_K) * ldb * size, 64);
+    uint32_t c_size = align_up(t.TILE_M * ldc * c_elem, 64);
+
+    char *ptr = (char *)mem.start;
+    char *a[2], *b[2], *c[2];
+    for (uint32_t i = 0; i < 2; i++) {
+        a[i] = ptr;
+        ptr += a_size;
+        b[i] = ptr;
+        ptr += b_size;
+        c[i] = ptr;
+        ptr += c_size;
+    }
+
+    const char *A = (const char *)l->A;
+    const char *B = (const char *)l->B;
+    char *C = (char *)l->C;
+
+    uint32_t tiles_mn = ceil_div(l->M, t.TILE_M) * ceil_div(l->N, t.TILE_N);
+    uint32_t tiles = tiles_mn > cluster_id
+                         ? ceil_div(tiles_mn - cluster_id, cluster_num)
+                         : 0;
+    uint32_t steps = tiles * ceil_div(l->K, t.TILE_K);
+    static const uint32_t accumulate = 1;
+
+    benchmark_get_cycle();
+
+    // In step `s`, the DMA core writes back the C tile completed in step
+    // `s - 2` and loads the tiles of step `s`, while the compute cores work on
+    // step `s - 1`. A and B alternate between the buffers with the step, C
+    // with the tile.
+    for (uint32_t s = 0; s < steps + 2; s++) {
+        if (snrt_is_dm_core()) {
+            if (s >= 2) {
+                gemm_step st = get_step(l, &t, s - 2);
+                if (st.last) {
+                    snrt_dma_start_2d(
+                        C + (st.m0 * l->N + st.n0) * c_elem, /* dst */
+                        c[st.c_buf],                         /* src */
+                        st.n * c_elem,                       /* size */
+                        l->N * c_elem,                       /* dst_stride */
+                        ldc * c_elem,                        /* src_stride */
+                        st.m);                               /* repetitions */
+                    snrt_dma_wait_all();
+                }
+            }
+            if (s < steps) {
+                gemm_step st = get_step(l, &t, s);
+                uint32_t buf = s % 2;
+                snrt_dma_start_tracking();
+
+                // The padding of partial K tiles has to be zero, as it
+                // contributes to every output
+                if (st.k < t.TILE_K) {
+                    dma_memset(a[buf], 0, a_size);
+                    dma_memset(b[buf], 0, b_size);
+                }
+                if (l->TA)
+                    snrt_dma_start_2d(a[buf], A + (st.k0 * l->M + st.m0) * size,
+                                      st.m * size, lda * size, l->M * size,
+                                      st.k);
+                else
+                    snrt_dma_start_2d(a[buf], A + (st.m0 * l->K + st.k0) * size,
+                                      st.k * size, lda * size, l->K * size,
+                                      st.m);
+                if (l->TB)
+                    snrt_dma_start_2d(b[buf], B + (st.n0 * l->K + st.k0) * size,
+                                      st.k * size, ldb * size, l->K * size,
+                                      st.n);
+                else
+                    snrt_dma_start_2d(b[buf], B + (st.k0 * l->N + st.n0) * size,
+                                      st.n * size, ldb * size, l->N * size,
+                                      st.k);
+                if (st.first && l->ALPHA)
+                    snrt_dma_start_2d(c[st.c_buf],
+                                      C + (st.m0 * l->N + st.n0) * c_elem,
+                                      st.n * c_elem, ldc * c_elem,
+                                      l->N * c_elem, st.m);
+                snrt_dma_wait_all();
+
+                snrt_dma_stop_tracking();
+            }
+        } else if (snrt_is_compute_core() && s >= 1 && s <= steps) {
+            gemm_step st = get_step(l, &t, s - 1);
+            uint32_t buf = (s - 1) % 2;
+            char *c_tile = c[st.c_buf];
+            const uint32_t *alpha = st.first ? &l->ALPHA : &accumulate;
+
+            // Rows of the tile are interleaved across the compute cores
+            uint32_t a_offset =
+                (l->TA ? compute_id : compute_id * lda) * size;
+            uint32_t ld_a = l->TA ? lda : compute_num * lda;
+            uint32_t c_offset = compute_id * ldc * c_elem;
+            uint32_t ld_c = compute_num * ldc;
+            uint32_t m = t.TILE_M / compute_num;
+
+            benchmark_get_cycle();
+            if (l->dtype == FP64) {
+                gemm_fp64_ssr_frep_unroll(
+                    m, t.TILE_N, t.TILE_K, (double *)(a[buf] + a_offset), ld_a,
+                    l->TA, (double *)b[buf], ldb, l->TB,
+                    (double *)(c_tile + c_offset), ld_c, alpha, t.UNROLL, 1);
+            } else if (l->dtype == FP32) {
+                gemm_fp32simd_tb_ssr_frep(
+                    m, t.TILE_N, t.TILE_K, (float *)(a[buf] + a_offset), ld_a,
+                    (float *)b[buf], ldb, (float *)(c_tile + c_offset), ld_c,
+                    alpha, 1);
+            } else if (l->dtype == FP16 && l->expand) {
+                gemm_fp16simd_ex_tb_ssr_frep(
+                    m, t.TILE_N, t.TILE_K, (__fp16 *)(a[buf] + a_offset), ld_a,
+                    (__fp16 *)b[buf], ldb, (float *)(c_tile + c_offset), ld_c,
+                    alpha, 1);
+            } else if (l->dtype == FP16) {
+                gemm_fp16simd_tb_ssr_frep(
+                    m, t.TILE_N, t.TILE_K, (__fp16 *)(a[buf] + a_offset), ld_a,
+                    (__fp16 *)b[buf], ldb, (__fp16 *)(c_tile + c_offset), ld_c,
+                    alpha, 1);
+            } else if (l->dtype == FP8 && l->expand) {
+                gemm_fp8simd_ex_tb_ssr_frep(
+                    m, t.TILE_N, t.TILE_K, a[buf] + a_offset, ld_a, b[buf], ldb,
+                    (__fp16 *)(c_tile + c_offset), ld_c, alpha, 1);
+            } else if (l->dtype == FP8) {
+                gemm_fp8simd_tb_ssr_frep(m, t.TILE_N, t.TILE_K,
+                                         a[buf] + a_offset, ld_a, b[buf], ldb,
+                                         c_tile + c_offset, ld_c, alpha, 1);
+            }
+            benchmark_get_cycle();
+        }
+        snrt_cluster_hw_barrier();
+    }
+
+    benchmark_get_cycle();
+
+    return 0;
+}
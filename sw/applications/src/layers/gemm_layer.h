@@ -0,0 +1,20 @@
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "gemm_tiling.h"
+#include "layer.h"
+
+/**
+ * @brief GEMM layer for matrices of any size in main memory. The problem is
+ * split into tiles (see `gemm_tiling_select`) which are distributed across
+ * the clusters and moved through the TCDM in a double buffered fashion. Edge
+ * tiles are zero-padded, such that the kernels always see full tiles. fp32,
+ * fp16 and fp8 require B to be transposed and A not to be, and a transposed A
+ * requires eight compute cores. With `expand`, fp16 and fp8 accumulate and
+ * store C in fp32 and fp16 respectively.
+ *
+ * @param l gemm_layer struct that holds addresses and parameters
+ * @return uint32_t 0 on success, 1 if the problem has no valid tiling
+ */
+uint32_t tiled_gemm_layer(const gemm_layer *l);
@@ -0,0 +1,268 @@
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "gemm_tiling.h"
+
+#include "gemm_tiling_lut.h"
+
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#define max(a, b) ((a) > (b) ? (a) : (b))
+#define ceil_div(a, b) (((a) + (b)-1) / (b))
+#define align_up(a, b) (ceil_div(a, b) * (b))
+
+// Tile buffers are padded to whole `dma_memset` blocks
+#define GEMM_BUF_ALIGN 64
+
+static const gemm_tiling_lut_entry gemm_tiling_lut[] = {
+    GEMM_TILING_LUT_ENTRIES{0}};
+
+// Elements per 64-bit word, which the K dimension and the padding have to be
+// a multiple of for the SIMD kernels
+static inline uint32_t simd_width(const gemm_layer *l) { return 8 / l->dtype; }
+
+// The fp32 kernel peels the first iteration off its FREP loop, so it needs
+// at least two of them
+static inline uint32_t min_tile_k(const gemm_layer *l) {
+    return l->dtype == FP32 ? 2 * simd_width(l) : simd_width(l);
+}
+
+// Unrolls the kernels support: the FP64 kernel computes 4 or 8 columns of C
+// per FREP block, the SIMD kernels 8
+static const uint32_t unrolls_fp64[] = {4, 8};
+static const uint32_t unrolls_simd[] = {8};
+
+static uint32_t kernel_unrolls(const gemm_layer *l, const uint32_t **unrolls) {
+    if (l->dtype == FP64) {
+        *unrolls = unrolls_fp64;
+        return sizeof(unrolls_fp64) / sizeof(unrolls_fp64[0]);
+    }
+    *unrolls = unrolls_simd;
+    return sizeof(unrolls_simd) / sizeof(unrolls_simd[0]);
+}
+
+static int unroll_supported(const gemm_layer *l, uint32_t unroll) {
+    const uint32_t *unrolls;
+    uint32_t num = kernel_unrolls(l, &unrolls);
+    for (uint32_t i = 0; i < num; i++)
+        if (unrolls[i] == unroll) return 1;
+    return 0;
+}
+
+static int layout_supported(const gemm_layer *l) {
+    switch (l->dtype) {
+        case FP64:
+            return !l->expand;
+        case FP32:
+            return !l->expand && !l->TA && l->TB;
+        case FP16:
+        case FP8:
+            return !l->TA && l->TB;
+        default:
+            return 0;
+    }
+}
+
+// Number of distinct TCDM banks hit by `count` accesses `stride` words apart
+static uint32_t distinct_banks(uint32_t stride, uint32_t count) {
+    uint32_t a = stride % GEMM_TCDM_BANKS, b = GEMM_TCDM_BANKS;
+    while (a) {
+        uint32_t r = b % a;
+        b = a;
+        a = r;
+    }
+    return min(count, GEMM_TCDM_BANKS / b);
+}
+
+static inline uint32_t lda_tile(const gemm_layer *l, const gemm_tiling *t) {
+    return l->TA ? t->TILE_M + t->PAD : t->TILE_K + t->PAD;
+}
+
+static inline uint32_t ldb_tile(const gemm_layer *l, const gemm_tiling *t) {
+    return l->TB ? t->TILE_K + t->PAD : t->TILE_N + t->PAD;
+}
+
+uint32_t gemm_tiling_footprint(const gemm_layer *l, const gemm_tiling *t) {
+    uint32_t a = (l->TA ? t->TILE_K : t->TILE_M) * lda_tile(l, t);
+    uint32_t b = (l->TB ? t->TILE_N : t->TILE_K) * ldb_tile(l, t);
+    uint32_t c = t->TILE_M * t->TILE_N;
+    return 2 * (align_up(a * l->dtype, GEMM_BUF_ALIGN) +
+                align_up(b * l->dtype, GEMM_BUF_ALIGN) +
+                align_up(c * gemm_c_size(l), GEMM_BUF_ALIGN));
+}
+
+// Extra compute cycles per mille due to bank conflicts. All cores stream the
+// same B tile, so a B access collides with the other cores when they read a
+// row in the same bank, which gets less likely the more banks the unrolled
+// rows spread across. A is only read every UNROLL cycles, with the cores
+// accessing rows `lda` apart at the same time.
+static uint32_t conflict_penalty(const gemm_layer *l, const gemm_tiling *t,
+                                 uint32_t compute_num) {
+    uint32_t simd = simd_width(l);
+    uint32_t banks_b = l->TB
+                           ? distinct_banks(ldb_tile(l, t) / simd, t->UNROLL)
+                           : t->UNROLL;
+    uint32_t banks_a = l->TA
+                           ? compute_num
+                           : distinct_banks(lda_tile(l, t) / simd, compute_num);
+    uint32_t others = 1000 * (compute_num - 1) / compute_num;
+    return others / banks_b + others / (banks_a * t->UNROLL);
+}
+
+uint32_t gemm_tiling_cost(const gemm_layer *l, const gemm_tiling *t,
+                          uint32_t cluster_num, uint32_t compute_num) {
+    uint32_t simd = simd_width(l);
+    if (!layout_supported(l) || !unroll_supported(l, t->UNROLL) ||
+        !t->TILE_M || !t->TILE_N || t->TILE_K < min_tile_k(l) ||
+        t->TILE_M % compute_num || t->TILE_N % t->UNROLL ||
+        t->TILE_K % simd || t->PAD % simd)
+        return UINT32_MAX;
+
+    uint32_t tiles_mn =
+        ceil_div(l->M, t->TILE_M) * ceil_div(l->N, t->TILE_N);
+    uint32_t tiles = ceil_div(tiles_mn, cluster_num);
+    uint32_t steps = tiles * ceil_div(l->K, t->TILE_K);
+
+    // Every core computes TILE_M / compute_num rows of the tile in blocks of
+    // UNROLL columns, each taking one FREP iteration per word of K. An
+    // iteration issues UNROLL FMAs, but cannot be shorter than the FMA latency.
+    uint64_t compute =
+        GEMM_KERNEL_SETUP_CYCLES +
+        (uint64_t)(t->TILE_M / compute_num) * (t->TILE_N / t->UNROLL) *
+            (max(t->UNROLL, GEMM_FMA_LATENCY) * t->TILE_K / simd +
+             GEMM_BLOCK_CYCLES);
+    compute += compute * conflict_penalty(l, t, compute_num) / 1000;
+
+    // The A and B tiles are moved row by row in every step, the C tile once
+    // per tile (loaded as well if it is accumulated upon)
+    uint32_t rows = (l->TA ? t->TILE_K : t->TILE_M) +
+                    (l->TB ? t->TILE_N : t->TILE_K);
+    uint32_t bytes = (t->TILE_M + t->TILE_N) * t->TILE_K * l->dtype;
+    uint64_t dma = 2 * GEMM_DMA_SETUP_CYCLES + rows * GEMM_DMA_ROW_CYCLES +
+                   bytes / GEMM_DMA_BYTES_PER_CYCLE;
+    uint64_t dma_c =
+        GEMM_DMA_SETUP_CYCLES + t->TILE_M * GEMM_DMA_ROW_CYCLES +
+        t->TILE_M * t->TILE_N * gemm_c_size(l) / GEMM_DMA_BYTES_PER_CYCLE;
+    dma_c *= l->ALPHA ? 2 : 1;
+
+    // The data mover runs one step ahead of the compute cores
+    uint64_t step = max(compute, dma + dma_c * tiles / steps);
+    uint64_t cycles = dma + steps * step + dma_c;
+    return min(cycles, UINT32_MAX - 1);
+}
+
+void gemm_tiling_pad(const gemm_layer *l, gemm_tiling *t,
+                     uint32_t compute_num) {
+    uint32_t simd = simd_width(l);
+    uint32_t best_pad = 0, best_penalty = UINT32_MAX;
+    for (uint32_t pad = 0; pad < t->UNROLL * simd; pad += simd) {
+        t->PAD = pad;
+        uint32_t penalty = conflict_penalty(l, t, compute_num);
+        if (penalty < best_penalty) {
+            best_penalty = penalty;
+            best_pad = pad;
+        }
+    }
+    t->PAD = best_pad;
+}
+
+// Tile size when splitting `extent` into `splits` tiles of a multiple of
+// `grain`. The number of splits grows by half each time, such that the
+// candidates cover all tile sizes down to `grain` in logarithmic count.
+static inline uint32_t split_size(uint32_t extent, uint32_t splits,
+                                  uint32_t grain) {
+    return align_up(ceil_div(extent, splits), grain);
+}
+
+static inline uint32_t next_split(uint32_t splits) {
+    return splits + max(1, splits / 2);
+}
+
+// Insert `t` with cost `cost` into the candidates sorted by ascending cost
+static void insert_candidate(gemm_tiling *cands, uint32_t *costs,
+                             uint32_t *num, uint32_t max_cands,
+                             const gemm_tiling *t, uint32_t cost) {
+    uint32_t i = *num < max_cands ? (*num)++ : max_cands;
+    if (i == max_cands) {
+        if (cost >= costs[max_cands - 1]) return;
+        i = max_cands - 1;
+    }
+    for (; i > 0 && costs[i - 1] > cost; i--) {
+        cands[i] = cands[i - 1];
+        costs[i] = costs[i - 1];
+    }
+    cands[i] = *t;
+    costs[i] = cost;
+}
+
+uint32_t gemm_tiling_candidates(const gemm_layer *l, uint32_t capacity,
+                                uint32_t cluster_num, uint32_t compute_num,
+                                gemm_tiling *cands, uint32_t max_cands) {
+    uint32_t costs[max_cands];
+    uint32_t num = 0;
+    uint32_t simd = simd_width(l);
+    const uint32_t *unrolls;
+    uint32_t num_unrolls = kernel_unrolls(l, &unrolls);
+    if (!layout_supported(l) || !max_cands) return 0;
+
+    for (uint32_t u = 0; u < num_unrolls; u++) {
+        uint32_t unroll = unrolls[u];
+        if (unroll < GEMM_FMA_LATENCY) continue;
+        for (uint32_t sm = 1;; sm = next_split(sm)) {
+            uint32_t tm = split_size(l->M, sm, compute_num);
+            for (uint32_t sn = 1;; sn = next_split(sn)) {
+                uint32_t tn = split_size(l->N, sn, unroll);
+                uint32_t fitting = 0;
+                for (uint32_t sk = 1; fitting < 2; sk = next_split(sk)) {
+                    gemm_tiling t = {
+                        tm, tn,
+                        max(split_size(l->K, sk, simd), min_tile_k(l)), 0,
+                        unroll};
+                    gemm_tiling_pad(l, &t, compute_num);
+                    if (gemm_tiling_footprint(l, &t) <= capacity) {
+                        fitting++;
+                        insert_candidate(
+                            cands, costs, &num, max_cands, &t,
+                            gemm_tiling_cost(l, &t, cluster_num, compute_num));
+                    }
+                    if (t.TILE_K == min_tile_k(l)) break;
+                }
+                if (tn == unroll) break;
+            }
+            if (tm == compute_num) break;
+        }
+    }
+    return num;
+}
+
+int gemm_tiling_select(const gemm_layer *l, uint32_t capacity,
+                       uint32_t cluster_num, uint32_t compute_num,
+                       gemm_tiling *t) {
+    // Tiles set explicitly in the layer
+    if (l->TILE_M && l->TILE_N && l->TILE_K) {
+        *t = (gemm_tiling){l->TILE_M, l->TILE_N, l->TILE_K, l->TILE_PAD,
+                           l->TILE_UNROLL ? l->TILE_UNROLL : 8};
+        return gemm_tiling_footprint(l, t) <= capacity &&
+                       gemm_tiling_cost(l, t, cluster_num, compute_num) !=
+                           UINT32_MAX
+                   ? 0
+                   : -1;
+    }
+
+    // Tiles found by the tuning mode
+    for (const gemm_tiling_lut_entry *e = gemm_tiling_lut; e->M; e++) {
+        if (e->M == l->M && e->N == l->N && e->K == l->K &&
+            e->dtype == l->dtype && e->TA == l->TA && e->TB == l->TB &&
+            e->clusters == cluster_num && e->cores == compute_num &&
+            gemm_tiling_footprint(l, &e->tiling) <= capacity) {
+            *t = e->tiling;
+            return 0;
+        }
+    }
+
+    // Best tiles of the cost model
+    return gemm_tiling_candidates(l, capacity, cluster_num, compute_num, t,
+                                  1)
+               ? 0
+               : -1;
+}
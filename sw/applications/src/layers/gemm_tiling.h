@@ -0,0 +1,131 @@
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include "layer.h"
+
+// Parameters of the cost model. They describe the default Snitch cluster and
+// only need to rank candidates; the tuning mode measures the real cost.
+#define GEMM_TCDM_BANKS 32
+#define GEMM_TCDM_BANK_WIDTH 8
+#define GEMM_DMA_BYTES_PER_CYCLE 64
+#define GEMM_DMA_SETUP_CYCLES 40
+#define GEMM_DMA_ROW_CYCLES 2
+#define GEMM_KERNEL_SETUP_CYCLES 60
+#define GEMM_BLOCK_CYCLES 24
+
+// Latency of an FMA in cycles. The FREP blocks of the GEMM kernels issue one
+// independent FMA per column of C they compute, so they stall with fewer
+// columns than this.
+#define GEMM_FMA_LATENCY 4
+
+/**
+ * @struct gemm_tiling_struct
+ * @brief Tile sizes and TCDM layout of the tiled GEMM layer.
+ * @var gemm_tiling_struct::TILE_M
+ * Rows of A and C per tile, a multiple of the compute cores
+ * @var gemm_tiling_struct::TILE_N
+ * Columns of B and C per tile, a multiple of UNROLL
+ * @var gemm_tiling_struct::TILE_K
+ * Columns of A and rows of B per tile, a multiple of the SIMD width
+ * @var gemm_tiling_struct::PAD
+ * Padding of the rows of the A and B tiles in elements, a multiple of the
+ * SIMD width
+ * @var gemm_tiling_struct::UNROLL
+ * Columns of C computed per FREP block, 4 or 8 for FP64 and 8 for the SIMD
+ * kernels
+ */
+typedef struct gemm_tiling_struct {
+    uint32_t TILE_M;
+    uint32_t TILE_N;
+    uint32_t TILE_K;
+    uint32_t PAD;
+    uint32_t UNROLL;
+} gemm_tiling;
+
+/**
+ * @struct gemm_tiling_lut_entry_struct
+ * @brief Tuned tiling of a GEMM problem, as emitted by `tune_gemm.py`.
+ */
+typedef struct gemm_tiling_lut_entry_struct {
+    uint32_t M, N, K;
+    precision_t dtype;
+    uint32_t TA, TB;
+    uint32_t clusters, cores;
+    gemm_tiling tiling;
+} gemm_tiling_lut_entry;
+
+// Bytes per element of C, which is twice as wide as A and B when expanding
+static inline uint32_t gemm_c_size(const gemm_layer *l) {
+    return l->expand ? 2 * l->dtype : l->dtype;
+}
+
+/**
+ * @brief bytes of TCDM taken by the double-buffered A, B and C tiles
+ *
+ * @param l gemm_layer struct that holds the problem
+ * @param t tiling
+ * @return uint32_t
+ */
+uint32_t gemm_tiling_footprint(const gemm_layer *l, const gemm_tiling *t);
+
+/**
+ * @brief estimated cycles of the tiled GEMM layer, based on the compute
+ * throughput of the kernels, TCDM bank conflicts between the cores and the DMA
+ * bandwidth
+ *
+ * @param l gemm_layer struct that holds the problem
+ * @param t tiling
+ * @param cluster_num number of clusters sharing the tiles
+ * @param compute_num number of compute cores per cluster
+ * @return uint32_t cycles, or UINT32_MAX if the tiling is not valid
+ */
+uint32_t gemm_tiling_cost(const gemm_layer *l, const gemm_tiling *t,
+                          uint32_t cluster_num, uint32_t compute_num);
+
+/**
+ * @brief padding that spreads the tile rows accessed in parallel across the
+ * most TCDM banks, with ties broken towards the smallest padding
+ *
+ * @param l gemm_layer struct that holds the problem
+ * @param t tiling whose PAD field is set
+ * @param compute_num number of compute cores
+ */
+void gemm_tiling_pad(const gemm_layer *l, gemm_tiling *t, uint32_t compute_num);
+
+/**
+ * @brief collect the cheapest candidate tilings that fit into `capacity` bytes
+ * of TCDM, sorted by ascending estimated cost. For every unroll of the kernel
+ * that is at least GEMM_FMA_LATENCY, every dimension is split into a growing
+ * number of equally sized tiles; for each `TILE_M` and `TILE_N`, the two
+ * largest fitting `TILE_K` are considered.
+ *
+ * @param l gemm_layer struct that holds the problem
+ * @param capacity available TCDM in bytes
+ * @param cluster_num number of clusters sharing the tiles
+ * @param compute_num number of compute cores per cluster
+ * @param cands output array of candidates
+ * @param max_cands capacity of `cands`
+ * @return uint32_t number of candidates written to `cands`
+ */
+uint32_t gemm_tiling_candidates(const gemm_layer *l, uint32_t capacity,
+                                uint32_t cluster_num, uint32_t compute_num,
+                                gemm_tiling *cands, uint32_t max_cands);
+
+/**
+ * @brief choose the tiling of a GEMM problem: the tiles of the layer struct if
+ * set, a tuned tiling from `gemm_tiling_lut.h` if there is one for the problem
+ * and core count, and the best tiling of the cost model otherwise
+ *
+ * @param l gemm_layer struct that holds the problem
+ * @param capacity available TCDM in bytes
+ * @param cluster_num number of clusters sharing the tiles
+ * @param compute_num number of compute cores per cluster
+ * @param t chosen tiling
+ * @return int 0 on success, -1 if no tiling fits
+ */
+int gemm_tiling_select(const gemm_layer *l, uint32_t capacity,
+                       uint32_t cluster_num, uint32_t compute_num,
+                       gemm_tiling *t);
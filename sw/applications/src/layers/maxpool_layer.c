@@ -9,21 +9,62 @@
 #include "printf.h"
 #include "snrt.h"
 
-void maxpool_layer(const conv_layer *l) {
+static void pool(precision_t dtype, uint32_t avg, void *ifmap, void *ofmap,
+                 uint32_t CI, uint32_t FH, uint32_t FW, uint32_t compute_num) {
+    switch (dtype) {
+        case FP64:
+            if (avg)
+                avgpool_fp64(ifmap, ofmap, CI, FH, FW, compute_num);
+            else
+                maxpool_fp64(ifmap, ofmap, CI, FH, FW, compute_num);
+            break;
+        case FP32:
+            if (avg)
+                avgpool_fp32simd(ifmap, ofmap, CI, FH, FW, compute_num);
+            else
+                maxpool_fp32simd(ifmap, ofmap, CI, FH, FW, compute_num);
+            break;
+        case FP16:
+            if (avg)
+                avgpool_fp16simd(ifmap, ofmap, CI, FH, FW, compute_num);
+            else
+                maxpool_fp16simd(ifmap, ofmap, CI, FH, FW, compute_num);
+            break;
+        case FP8:
+            maxpool_fp8simd(ifmap, ofmap, CI, FH, FW, compute_num);
+            break;
+    }
+}
+
+static uint32_t pool_layer(const conv_layer *l, uint32_t avg) {
     uint32_t cluster_num = snrt_cluster_num();
     uint32_t cluster_id = snrt_cluster_idx();
     uint32_t compute_num = snrt_cluster_compute_core_num();
     uint32_t compute_id = snrt_cluster_compute_core_idx();
+    const uint32_t is_main =
+        cluster_id == 0 && snrt_is_compute_core() && compute_id == 0;
+
+    // The kernels reduce at least two pixels per window
+    if (l->FH * l->FW < 2 || (avg && l->dtype == FP8)) {
+        if (is_main) printf("Unsupported pooling layer\n");
+        return 1;
+    }
+
+    // Sizes are given in elements of the layer precision
+    const uint32_t size = l->dtype;
 
     // Each cluster loads one tile of kernel size
     uint32_t ifmap_size = 2 * l->FH * l->FW * l->TILE_CI;
     uint32_t ofmap_size = 2 * l->TILE_CI;
 
-    double *ptr = (double *)snrt_cluster_memory().start;
-    double *ifmap = ptr;
-    ptr += ifmap_size;
-    double *ofmap = ptr;
-    ptr += ofmap_size;
+    char *ptr = (char *)snrt_cluster_memory().start;
+    char *ifmap = ptr;
+    ptr += ifmap_size * size;
+    char *ofmap = ptr;
+    ptr += ofmap_size * size;
+
+    const char *l_ifmap = (const char *)l->ifmap;
+    char *l_ofmap = (char *)l->ofmap;
 
     uint32_t read_buf = 0;
     uint32_t write_buf = 0;
@@ -32,85 +73,116 @@ void maxpool_layer(const conv_layer *l) {
     uint32_t prev_ow;
     uint32_t prev_ci;
 
-    // tiles are distributed across clusters
-    for (uint32_t tile = cluster_id; tile < l->OH * l->OW;
-         tile += cluster_num) {
-        for (uint32_t ci = 0; ci < l->CI; ci += l->TILE_CI) {
-            uint32_t oh = tile / l->OW;
-            uint32_t ow = tile % l->OW;
-
-            if (snrt_is_dm_core()) {
-                for (uint32_t fh = 0; fh < l->FH; fh++) {
-                    if (l->TILE_CI == l->CI) {
-                        snrt_dma_start_1d(
-                            &ifmap[write_buf * (ifmap_size / 2) +
-                                   fh * l->FW * l->TILE_CI], /* dst */
-                            &l->ifmap[((oh * l->FH + fh) * l->IW + ow * l->FW) *
-                                      l->CI], /* src */
-                            sizeof(double) * l->TILE_CI * l->FW /* size */);
-                    } else {
-                        // printf("bubu\n");
-                        snrt_dma_start_2d(
-                            &ifmap[write_buf * (ifmap_size / 2) +
-                                   fh * l->FW * l->TILE_CI], /* dst */
-                            &l->ifmap[((oh * l->FH + fh) * l->IW + ow * l->FW) *
-                                          l->CI +
-                                      ci],               /* src */
-                            sizeof(double) * l->TILE_CI, /* size */
-                            sizeof(double) * l->TILE_CI, /* dst_stride */
-                            sizeof(double) * l->CI,      /* src_stride */
-                            l->FW /* repetitions */);
-                    }
-                }
-                snrt_dma_wait_all();
-
-                // synchronize with compute cores after loading data
-                snrt_cluster_sw_barrier();
-
-                if (!(tile == cluster_id && ci == 0)) {
+    // Windows are non-overlapping by default
+    const uint32_t SH = l->stride ? l->stride : l->FH;
+    const uint32_t SW = l->stride ? l->stride : l->FW;
+
+    // tiles of channels of the output pixels are distributed across clusters,
+    // such that a global pooling with a single output pixel is parallelized
+    // as well
+    const uint32_t ci_tiles = l->CI / l->TILE_CI;
+    const uint32_t tiles = l->OH * l->OW * ci_tiles;
+    for (uint32_t tile = cluster_id; tile < tiles; tile += cluster_num) {
+        uint32_t oh = tile / ci_tiles / l->OW;
+        uint32_t ow = tile / ci_tiles % l->OW;
+        uint32_t ci = tile % ci_tiles * l->TILE_CI;
+
+        if (snrt_is_dm_core()) {
+            for (uint32_t fh = 0; fh < l->FH; fh++) {
+                if (l->TILE_CI == l->CI) {
+                    snrt_dma_start_1d(
+                        ifmap + (write_buf * (ifmap_size / 2) +
+                                 fh * l->FW * l->TILE_CI) *
+                                    size, /* dst */
+                        l_ifmap +
+                            ((oh * SH + fh) * l->IW + ow * SW) *
+                                l->CI * size, /* src */
+                        size * l->TILE_CI * l->FW /* size */);
+                } else {
                     snrt_dma_start_2d(
-                        &l->ofmap[(prev_oh * l->OW + prev_ow) * l->CI +
-                                  prev_ci],                   /* dst */
-                        &ofmap[!read_buf * (ofmap_size / 2)], /* src */
-                        sizeof(double) * l->TILE_CI,          /* size */
-                        sizeof(double) * l->CI,               /* dst_stride */
-                        sizeof(double) * l->TILE_CI,          /* src_stride */
-                        1 /* repetitions */);
+                        ifmap + (write_buf * (ifmap_size / 2) +
+                                 fh * l->FW * l->TILE_CI) *
+                                    size, /* dst */
+                        l_ifmap +
+                            (((oh * SH + fh) * l->IW + ow * SW) *
+                                 l->CI +
+                             ci) *
+                                size,      /* src */
+                        size * l->TILE_CI, /* size */
+                        size * l->TILE_CI, /* dst_stride */
+                        size * l->CI,      /* src_stride */
+                        l->FW /* repetitions */);
                 }
-
-                snrt_dma_wait_all();
-                write_buf = !write_buf;
-                read_buf = !read_buf;
-                prev_ci = ci;
-                prev_oh = oh;
-                prev_ow = ow;
+            }
+            snrt_dma_wait_all();
+
+            // synchronize with compute cores after loading data
+            snrt_cluster_sw_barrier();
+
+            if (tile != cluster_id) {
+                snrt_dma_start_2d(
+                    l_ofmap + ((prev_oh * l->OW + prev_ow) * l->CI +
+                               prev_ci) *
+                                  size,                          /* dst */
+                    ofmap + !read_buf * (ofmap_size / 2) * size, /* src */
+                    size * l->TILE_CI,                           /* size */
+                    size * l->CI,      /* dst_stride */
+                    size * l->TILE_CI, /* src_stride */
+                    1 /* repetitions */);
             }
 
-            if (snrt_is_compute_core()) {
-                // wait for data to arrive
-                snrt_cluster_sw_barrier();
+            snrt_dma_wait_all();
+            write_buf = !write_buf;
+            read_buf = !read_buf;
+            prev_ci = ci;
+            prev_oh = oh;
+            prev_ow = ow;
+        }
 
-                maxpool_fp64(&ifmap[read_buf * ifmap_size / 2 + compute_id],
-                             &ofmap[write_buf * ofmap_size / 2 + compute_id],
-                             l->TILE_CI, l->FH, l->FW, compute_num);
+        if (snrt_is_compute_core()) {
+            // wait for data to arrive
+            snrt_cluster_sw_barrier();
 
-                write_buf = !write_buf;
-                read_buf = !read_buf;
-            }
+            // Every core handles every `compute_num`-th 64-bit word of
+            // channels
+            pool(l->dtype, avg,
+                 ifmap + read_buf * ifmap_size / 2 * size + compute_id * 8,
+                 ofmap + write_buf * ofmap_size / 2 * size + compute_id * 8,
+                 l->TILE_CI, l->FH, l->FW, compute_num);
+
+            write_buf = !write_buf;
+            read_buf = !read_buf;
         }
     }
 
     snrt_cluster_sw_barrier();
 
-    if (snrt_is_dm_core()) {
+    // Write back the last tile of the cluster, if it had any
+    if (snrt_is_dm_core() && cluster_id < tiles) {
         snrt_dma_start_2d(
-            &l->ofmap[(prev_oh * l->OW + prev_ow) * l->CI + prev_ci], /* dst */
-            &ofmap[!read_buf * (ofmap_size / 2)],                     /* src */
-            sizeof(double) * l->TILE_CI,                              /* size */
-            sizeof(double) * l->CI,      /* dst_stride */
-            sizeof(double) * l->TILE_CI, /* src_stride */
+            l_ofmap + ((prev_oh * l->OW + prev_ow) * l->CI + prev_ci) *
+                          size,                              /* dst */
+            ofmap + !read_buf * (ofmap_size / 2) * size,     /* src */
+            size * l->TILE_CI,                               /* size */
+            size * l->CI,      /* dst_stride */
+            size * l->TILE_CI, /* src_stride */
             1 /* repetitions */);
     }
 
     snrt_dma_wait_all();
+
+    return 0;
+}
+
+uint32_t maxpool_layer(const conv_layer *l) { return pool_layer(l, 0); }
+
+uint32_t avgpool_layer(const conv_layer *l) { return pool_layer(l, 1); }
+
+uint32_t global_avgpool_layer(const conv_layer *l) {
+    // A single window covering the whole input feature map
+    conv_layer g = *l;
+    g.OH = g.OW = 1;
+    g.FH = l->IH;
+    g.FW = l->IW;
+    return pool_layer(&g, 1);
 }
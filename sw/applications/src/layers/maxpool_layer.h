@@ -5,8 +5,31 @@
 #include "layer.h"
 
 /**
- * @brief maxpool layer that handles data transfers in a double buffered fashion
+ * @brief maxpool layer that handles data transfers in a double buffered fashion.
+ * The windows of FH x FW pixels are `stride` pixels apart and may overlap.
+ * Windows of a single pixel are not supported.
  *
  * @param l conv_layer struct that holds addresses and parameters
+ * @return 0 on success, 1 if the layer is not supported
  */
-void maxpool_layer(const conv_layer *l);
+uint32_t maxpool_layer(const conv_layer *l);
+
+/**
+ * @brief average pooling layer, the same as the maxpool layer otherwise. Not
+ * supported for FP8.
+ *
+ * @param l conv_layer struct that holds addresses and parameters
+ * @return 0 on success, 1 if the layer is not supported
+ */
+uint32_t avgpool_layer(const conv_layer *l);
+
+/**
+ * @brief global average pooling layer, averaging every channel over the whole
+ * IH x IW input feature map into a single output pixel. The FH, FW, OH, OW and
+ * stride fields of the layer are ignored, and 2 * IH * IW * TILE_CI elements
+ * have to fit into the TCDM. Not supported for FP8 or a single input pixel.
+ *
+ * @param l conv_layer struct that holds addresses and parameters
+ * @return 0 on success, 1 if the layer is not supported
+ */
+uint32_t global_avgpool_layer(const conv_layer *l);
@@ -0,0 +1,281 @@
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "transformer_layer.h"
+
+#include "gemm.h"
+#include "layer.h"
+#include "printf.h"
+#include "snrt.h"
+#include "transformer.h"
+
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#define ceil_div(a, b) (((a) + (b)-1) / (b))
+
+typedef enum { SOFTMAX, LAYERNORM, GELU } row_op_t;
+
+// Row-wise layers, the output tile of a step is written back while the next
+// step is computed, and the input tile of the next step is loaded meanwhile
+static uint32_t row_layer(const transformer_layer *l, row_op_t op) {
+    const uint32_t cluster_num = snrt_cluster_num();
+    const uint32_t cluster_id = snrt_cluster_idx();
+    const uint32_t compute_num = snrt_cluster_compute_core_num();
+    const uint32_t compute_id = snrt_cluster_compute_core_idx();
+    const uint32_t is_main =
+        cluster_id == 0 && snrt_is_compute_core() && compute_id == 0;
+
+    const uint32_t E = l->E;
+    const uint32_t tile_size = l->TILE_S * E;
+
+    if (l->dtype != FP64 || !l->TILE_S || !E) {
+        if (is_main) printf("Unsupported transformer layer\n");
+        return 1;
+    }
+
+    // in[2][TILE_S][E], out[2][TILE_S][E], tmp[compute_num][E], gamma[E],
+    // beta[E]
+    if ((4 * tile_size + (compute_num + 2) * E) * sizeof(double) >
+        snrt_slice_len(snrt_cluster_memory())) {
+        if (is_main) printf("Transformer layer does not fit into TCDM\n");
+        return 1;
+    }
+    double *ptr = (double *)snrt_cluster_memory().start;
+    double *in = ptr;
+    ptr += 2 * tile_size;
+    double *out = ptr;
+    ptr += 2 * tile_size;
+    double *tmp = ptr;
+    ptr += compute_num * E;
+    double *gamma = ptr;
+    ptr += E;
+    double *beta = ptr;
+
+    const uint32_t tiles = ceil_div(l->S, l->TILE_S);
+
+    if (snrt_is_dm_core() && cluster_id < tiles) {
+        if (op == LAYERNORM) {
+            snrt_dma_start_1d(gamma, l->gamma, E * sizeof(double));
+            snrt_dma_start_1d(beta, l->beta, E * sizeof(double));
+        }
+        snrt_dma_start_1d(
+            in, l->ifmap + cluster_id * tile_size,
+            min(l->TILE_S, l->S - cluster_id * l->TILE_S) * E * sizeof(double));
+    }
+
+    uint32_t buf = 0;
+    uint32_t prev = 0;
+    for (uint32_t tile = cluster_id; tile < tiles; tile += cluster_num) {
+        const uint32_t s0 = tile * l->TILE_S;
+        const uint32_t rows = min(l->TILE_S, l->S - s0);
+
+        // Input tile loaded, output tile of two steps ago written back
+        if (snrt_is_dm_core()) snrt_dma_wait_all();
+
+        snrt_cluster_hw_barrier();
+
+        if (snrt_is_dm_core()) {
+            if (tile != cluster_id) {
+                const uint32_t prev_rows = min(l->TILE_S, l->S - prev);
+                snrt_dma_start_1d(l->ofmap + prev * E, out + !buf * tile_size,
+                                  prev_rows * E * sizeof(double));
+            }
+            const uint32_t next = tile + cluster_num;
+            if (next < tiles) {
+                const uint32_t next_rows =
+                    min(l->TILE_S, l->S - next * l->TILE_S);
+                snrt_dma_start_1d(in + !buf * tile_size,
+                                  l->ifmap + next * tile_size,
+                                  next_rows * E * sizeof(double));
+            }
+        } else {
+            double *x = in + buf * tile_size;
+            double *y = out + buf * tile_size;
+            double *t = tmp + compute_id * E;
+            for (uint32_t r = compute_id; r < rows; r += compute_num) {
+                switch (op) {
+                    case SOFTMAX:
+                        softmax_fp64(x + r * E, y + r * E, t, E);
+                        break;
+                    case LAYERNORM:
+                        layernorm_fp64(x + r * E, y + r * E, gamma, beta, E,
+                                       l->eps);
+                        break;
+                    case GELU:
+                        gelu_fp64(x + r * E, y + r * E, t, E);
+                        break;
+                }
+            }
+        }
+
+        prev = s0;
+        buf = !buf;
+    }
+
+    snrt_cluster_hw_barrier();
+
+    // Write back the last tile of the cluster, if it had any
+    if (snrt_is_dm_core() && cluster_id < tiles) {
+        snrt_dma_start_1d(l->ofmap + prev * E, out + !buf * tile_size,
+                          min(l->TILE_S, l->S - prev) * E * sizeof(double));
+        snrt_dma_wait_all();
+    }
+
+    return 0;
+}
+
+uint32_t softmax_layer(const transformer_layer *l) {
+    return row_layer(l, SOFTMAX);
+}
+
+uint32_t layernorm_layer(const transformer_layer *l) {
+    return row_layer(l, LAYERNORM);
+}
+
+uint32_t gelu_layer(const transformer_layer *l) { return row_layer(l, GELU); }
+
+uint32_t attention_layer(const transformer_layer *l) {
+    const uint32_t cluster_num = snrt_cluster_num();
+    const uint32_t cluster_id = snrt_cluster_idx();
+    const uint32_t compute_num = snrt_cluster_compute_core_num();
+    const uint32_t compute_id = snrt_cluster_compute_core_idx();
+    const uint32_t is_main =
+        cluster_id == 0 && snrt_is_compute_core() && compute_id == 0;
+
+    const uint32_t E = l->E;
+    const uint32_t TILE_S = l->TILE_S;
+    const uint32_t TILE_L = l->TILE_L;
+
+    if (l->dtype != FP64 || !TILE_S || !E || E % 8 || !TILE_L ||
+        TILE_L % 8 || l->L % TILE_L) {
+        if (is_main) printf("Unsupported attention layer\n");
+        return 1;
+    }
+
+    // Q[TILE_S][E], K[2][TILE_L][E], V[2][TILE_L][E], P[TILE_S][TILE_L],
+    // O[TILE_S][E], m[TILE_S], l[TILE_S], tmp[compute_num][TILE_L]
+    if (((2 * TILE_S + 4 * TILE_L) * E + (TILE_S + compute_num) * TILE_L +
+         2 * TILE_S) *
+            sizeof(double) >
+        snrt_slice_len(snrt_cluster_memory())) {
+        if (is_main) printf("Attention layer does not fit into TCDM\n");
+        return 1;
+    }
+    double *ptr = (double *)snrt_cluster_memory().start;
+    double *Q = ptr;
+    ptr += TILE_S * E;
+    double *K = ptr;
+    ptr += 2 * TILE_L * E;
+    double *V = ptr;
+    ptr += 2 * TILE_L * E;
+    double *P = ptr;
+    ptr += TILE_S * TILE_L;
+    double *O = ptr;
+    ptr += TILE_S * E;
+    double *row_max = ptr;
+    ptr += TILE_S;
+    double *row_sum = ptr;
+    ptr += TILE_S;
+    double *tmp = ptr + compute_id * TILE_L;
+
+    const uint32_t tiles = ceil_div(l->S, TILE_S);
+    const uint32_t steps = l->L / TILE_L;
+    const uint32_t tile_size = TILE_L * E;
+
+    if (snrt_is_dm_core() && cluster_id < tiles) {
+        const uint32_t rows = min(TILE_S, l->S - cluster_id * TILE_S);
+        snrt_dma_start_1d(Q, l->ifmap + cluster_id * TILE_S * E,
+                          rows * E * sizeof(double));
+        snrt_dma_start_1d(K, l->K, tile_size * sizeof(double));
+        snrt_dma_start_1d(V, l->V, tile_size * sizeof(double));
+    }
+
+    // Every core computes every `compute_num`-th row of the query tile. The
+    // SSRs are reconfigured for every GEMM, as the softmax kernels use them
+    // as well
+    uint32_t buf = 0;
+    for (uint32_t tile = cluster_id; tile < tiles; tile += cluster_num) {
+        const uint32_t s0 = tile * TILE_S;
+        const uint32_t rows = min(TILE_S, l->S - s0);
+        const uint32_t M = rows > compute_id
+                               ? ceil_div(rows - compute_id, compute_num)
+                               : 0;
+
+        for (uint32_t j = 0; j < steps; j++) {
+            if (snrt_is_dm_core()) snrt_dma_wait_all();
+
+            snrt_cluster_hw_barrier();
+
+            if (snrt_is_dm_core()) {
+                // Prefetch the keys and values of the next step, which may
+                // belong to the next query tile
+                const uint32_t next = j + 1 < steps ? j + 1 : 0;
+                if (j + 1 < steps || tile + cluster_num < tiles) {
+                    snrt_dma_start_1d(K + !buf * tile_size,
+                                      l->K + next * tile_size,
+                                      tile_size * sizeof(double));
+                    snrt_dma_start_1d(V + !buf * tile_size,
+                                      l->V + next * tile_size,
+                                      tile_size * sizeof(double));
+                }
+            } else if (M) {
+                const uint32_t alpha = j != 0;
+                const uint32_t zero = 0;
+
+                // Scores of the tile of keys
+                gemm_fp64_ssr_frep(M, TILE_L, E, Q + compute_id * E,
+                                   compute_num * E, 0, K + buf * tile_size, E,
+                                   1, P + compute_id * TILE_L,
+                                   compute_num * TILE_L, &zero, 1);
+
+                // Probabilities, the accumulated output is rescaled to the
+                // new running maximum
+                for (uint32_t r = compute_id; r < rows; r += compute_num) {
+                    if (j == 0) {
+                        row_max[r] = -__builtin_inf();
+                        row_sum[r] = 0.0;
+                    }
+                    const double corr =
+                        online_softmax_fp64(P + r * TILE_L, tmp, TILE_L,
+                                            l->scale, &row_max[r],
+                                            &row_sum[r]);
+                    if (j != 0) scale_fp64(O + r * E, O + r * E, E, corr);
+                }
+
+                // Accumulation of the values, the first tile of keys
+                // overwrites the output
+                gemm_fp64_ssr_frep(M, E, TILE_L, P + compute_id * TILE_L,
+                                   compute_num * TILE_L, 0,
+                                   V + buf * tile_size, E, 0,
+                                   O + compute_id * E, compute_num * E,
+                                   &alpha, 1);
+
+                if (j == steps - 1) {
+                    for (uint32_t r = compute_id; r < rows;
+                         r += compute_num) {
+                        scale_fp64(O + r * E, O + r * E, E, 1.0 / row_sum[r]);
+                    }
+                }
+            }
+
+            buf = !buf;
+        }
+
+        snrt_cluster_hw_barrier();
+
+        // Write back the output and load the next query tile
+        if (snrt_is_dm_core()) {
+            snrt_dma_start_1d(l->ofmap + s0 * E, O,
+                              rows * E * sizeof(double));
+            const uint32_t next = tile + cluster_num;
+            if (next < tiles) {
+                snrt_dma_start_1d(
+                    Q, l->ifmap + next * TILE_S * E,
+                    min(TILE_S, l->S - next * TILE_S) * E * sizeof(double));
+            }
+            snrt_dma_wait_all();
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,59 @@
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "layer.h"
+
+/**
+ * @brief softmax over the E elements of every row of the S x E input. Tiles
+ * of TILE_S rows are distributed across clusters and double buffered, every
+ * compute core handles every `compute_num`-th row of a tile.
+ *
+ * Only supports FP64. (4 * TILE_S + compute_num + 2) * E elements have
+ * to fit into the TCDM.
+ *
+ * @param l transformer_layer struct that holds addresses and parameters
+ * @return uint32_t 0 on success, 1 if the layer is not supported or does not
+ * fit into the TCDM
+ */
+uint32_t softmax_layer(const transformer_layer *l);
+
+/**
+ * @brief layer normalization of every row of the S x E input with the factors
+ * gamma, the offsets beta and eps, the same as the softmax layer otherwise.
+ *
+ * @param l transformer_layer struct that holds addresses and parameters
+ * @return uint32_t 0 on success, 1 if the layer is not supported or does not
+ * fit into the TCDM
+ */
+uint32_t layernorm_layer(const transformer_layer *l);
+
+/**
+ * @brief GELU with the tanh approximation of every element of the S x E
+ * input, the same as the softmax layer otherwise.
+ *
+ * @param l transformer_layer struct that holds addresses and parameters
+ * @return uint32_t 0 on success, 1 if the layer is not supported or does not
+ * fit into the TCDM
+ */
+uint32_t gelu_layer(const transformer_layer *l);
+
+/**
+ * @brief fused scaled dot-product attention, ofmap = softmax(scale * Q K^T) V,
+ * with the S x E queries Q in `ifmap` and the L x E keys K and values V. Tiles
+ * of TILE_S queries are distributed across clusters. For every tile of TILE_L
+ * keys and values, the scores are computed with a GEMM (SSR and FREP) in the
+ * TCDM, turned into probabilities with an online softmax and multiplied with
+ * the values into the output accumulators, which are rescaled with the change
+ * of the running maximum. The score matrix is never written to main memory,
+ * and keys and values are double buffered.
+ *
+ * Only supports FP64. Requires E and TILE_L to be multiples of 8 and TILE_L
+ * to divide L. (2 * TILE_S + 4 * TILE_L) * E + (TILE_S + compute_num) * TILE_L
+ * + 2 * TILE_S elements have to fit into the TCDM.
+ *
+ * @param l transformer_layer struct that holds addresses and parameters
+ * @return uint32_t 0 on success, 1 if the layer is not supported or does not
+ * fit into the TCDM
+ */
+uint32_t attention_layer(const transformer_layer *l);
@@ -0,0 +1,317 @@
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "winograd_layer.h"
+
+#include "gemm.h"
+#include "layer.h"
+#include "printf.h"
+#include "snrt.h"
+#include "utils.h"
+#include "winograd.h"
+
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#define max(a, b) ((a) > (b) ? (a) : (b))
+#define ceil_div(a, b) (((a) + (b)-1) / (b))
+#define align_up(a, b) (ceil_div(a, b) * (b))
+
+/**
+ * @struct winograd_buffers_struct
+ * @brief Buffers of the layer in the TCDM, strides in elements
+ */
+typedef struct winograd_buffers_struct {
+    // ifmap[2][PH][PW][TILE_CI], rows aligned for `dma_memset`
+    char *ifmap;
+    uint32_t ifmap_row_stride;
+    uint32_t ifmap_stride;
+    // V[a*a][T][TILE_CI + row_pad]
+    char *V;
+    // U[a*a][8][TILE_CI + row_pad]
+    char *U;
+    uint32_t ld;
+    // M[a*a][T][8]
+    char *M;
+    // ofmap[BH*m][BW*m][8]
+    char *ofmap;
+    uint32_t ofmap_row_stride;
+    uint32_t bytes;
+} winograd_buffers;
+
+static winograd_buffers get_buffers(const conv_layer *l, uint32_t BH,
+                                    uint32_t BW) {
+    const uint32_t m = l->winograd;
+    const uint32_t a = m + 2;
+    const uint32_t size = l->dtype;
+    const uint32_t T = BH * BW;
+    // Rows are padded by one 64-bit word to prevent banking conflicts
+    const uint32_t row_pad = 8 / size;
+
+    winograd_buffers b;
+    b.ifmap_row_stride =
+        align_up((BW * m + 2) * l->TILE_CI * size, 64) / size;
+    b.ifmap_stride = (BH * m + 2) * b.ifmap_row_stride;
+    b.ld = l->TILE_CI + row_pad;
+    b.ofmap_row_stride = BW * m * 8;
+
+    char *ptr = (char *)snrt_cluster_memory().start;
+    b.ifmap = ptr;
+    ptr += 2 * b.ifmap_stride * size;
+    b.V = ptr;
+    ptr += a * a * T * b.ld * size;
+    b.U = ptr;
+    ptr += a * a * 8 * b.ld * size;
+    b.M = ptr;
+    ptr += a * a * T * 8 * size;
+    b.ofmap = ptr;
+    ptr += BH * m * b.ofmap_row_stride * size;
+    b.bytes = ptr - (char *)snrt_cluster_memory().start;
+    return b;
+}
+
+// Loads the input tile rows [ih0, ih0 + PH) and columns [iw0, iw0 + PW) of
+// the input channels [ci, ci + TILE_CI), zero-padded outside the ifmap
+static void load_ifmap(const conv_layer *l, char *dst, uint32_t row_stride,
+                       uint32_t PH, uint32_t PW, int32_t ih0, int32_t iw0,
+                       uint32_t ci) {
+    const uint32_t size = l->dtype;
+    const int32_t left = max(-iw0, 0);
+    const int32_t right = max(iw0 + (int32_t)PW - (int32_t)l->IW, 0);
+    const int32_t n = (int32_t)PW - left - right;
+
+    for (uint32_t r = 0; r < PH; r++) {
+        const int32_t ih = ih0 + (int32_t)r;
+        const int32_t inside = ih >= 0 && ih < (int32_t)l->IH && n > 0;
+        char *row = dst + r * row_stride * size;
+        if (!inside || left || right) {
+            dma_memset(row, 0, row_stride * size);
+        }
+        if (inside) {
+            snrt_dma_start_2d(
+                row + left * l->TILE_CI * size, /* dst */
+                (const char *)l->ifmap +
+                    ((ih * l->IW + iw0 + left) * l->CI + ci) * size, /* src */
+                size * l->TILE_CI, /* size */
+                size * l->TILE_CI, /* dst_stride */
+                size * l->CI,      /* src_stride */
+                n /* repetitions */);
+        }
+    }
+}
+
+// Multiplies the transformed tiles of element xi with the transformed
+// filters of 8 output channels in the precision of the layer
+static void winograd_gemm(precision_t dtype, uint32_t T, uint32_t K, void *V,
+                          void *U, uint32_t ld, void *M,
+                          const uint32_t *alpha, uint32_t setup_SSR) {
+    switch (dtype) {
+        case FP64:
+            gemm_fp64_ssr_frep(T, 8, K, V, ld, 0, U, ld, 1, M, 8, alpha,
+                               setup_SSR);
+            break;
+        case FP32:
+            gemm_fp32simd_tb_ssr_frep(T, 8, K, V, ld, U, ld, M, 8, alpha,
+                                      setup_SSR);
+            break;
+        default:
+            break;
+    }
+}
+
+uint32_t winograd_conv2d_layer(const conv_layer *l) {
+    const uint32_t cluster_num = snrt_cluster_num();
+    const uint32_t cluster_id = snrt_cluster_idx();
+    const uint32_t compute_num = snrt_cluster_compute_core_num();
+    const uint32_t compute_id = snrt_cluster_compute_core_idx();
+    const uint32_t is_main =
+        cluster_id == 0 && snrt_is_compute_core() && compute_id == 0;
+
+    const uint32_t m = l->winograd;
+    const uint32_t a = m + 2;
+    const uint32_t size = l->dtype;
+
+    if ((m != 2 && m != 4) || l->FH != 3 || l->FW != 3 ||
+        (l->dtype != FP64 && l->dtype != FP32) || l->CO % 8 ||
+        l->CI % l->TILE_CI || l->TILE_CI % (8 / size)) {
+        if (is_main) printf("Unsupported Winograd layer\n");
+        return 1;
+    }
+
+    // Blocks of BH x BW tiles, at most one per compute core, shrunk until
+    // they fit into the TCDM
+    const uint32_t TH = ceil_div(l->OH, m);
+    const uint32_t TW = ceil_div(l->OW, m);
+    uint32_t BW = min(TW, compute_num);
+    uint32_t BH = min(TH, compute_num / BW);
+    winograd_buffers b = get_buffers(l, BH, BW);
+    while (b.bytes > snrt_slice_len(snrt_cluster_memory())) {
+        if (BH > 1) {
+            BH--;
+        } else if (BW > 1) {
+            BW--;
+        } else {
+            if (is_main) printf("Winograd layer does not fit into TCDM\n");
+            return 1;
+        }
+        b = get_buffers(l, BH, BW);
+    }
+    const uint32_t T = BH * BW;
+    const uint32_t PH = BH * m + 2;
+    const uint32_t PW = BW * m + 2;
+
+    // Blocks of tiles times groups of 8 output channels, distributed across
+    // clusters in contiguous chunks such that consecutive blocks of a cluster
+    // share their filters
+    const uint32_t blocks_w = ceil_div(TW, BW);
+    const uint32_t blocks = ceil_div(TH, BH) * blocks_w;
+    const uint32_t items = blocks * (l->CO / 8);
+    const uint32_t chunk = ceil_div(items, cluster_num);
+    const uint32_t first = min(cluster_id * chunk, items);
+    const uint32_t last = min(first + chunk, items);
+
+    const uint32_t n_ci = l->CI / l->TILE_CI;
+    const uint32_t steps = (last - first) * n_ci;
+
+    const char *l_weights = (const char *)l->weights;
+    char *l_ofmap = (char *)l->ofmap;
+
+    // Index of the filter tile in the TCDM
+    int32_t weights_loaded = -1;
+    uint32_t setup_SSR = 1;
+
+    if (snrt_is_dm_core() && steps) {
+        const uint32_t b0 = first % blocks;
+        load_ifmap(l, b.ifmap, b.ifmap_row_stride, PH, PW,
+                   (int32_t)(b0 / blocks_w * BH * m) - (int32_t)l->pad,
+                   (int32_t)(b0 % blocks_w * BW * m) - (int32_t)l->pad, 0);
+        snrt_dma_wait_all();
+    }
+
+    for (uint32_t s = 0; s < steps; s++) {
+        const uint32_t item = first + s / n_ci;
+        const uint32_t k = s % n_ci;
+        const uint32_t co = item / blocks * 8;
+        const uint32_t block = item % blocks;
+        const uint32_t oh0 = block / blocks_w * BH * m;
+        const uint32_t ow0 = block % blocks_w * BW * m;
+        const uint32_t ci = k * l->TILE_CI;
+        char *ifmap = b.ifmap + s % 2 * b.ifmap_stride * size;
+
+        // The filters of the previous step are no longer in use
+        if (snrt_is_dm_core()) {
+            const int32_t weights_idx = item / blocks * n_ci + k;
+            if (weights_idx != weights_loaded) {
+                for (uint32_t xi = 0; xi < a * a; xi++) {
+                    snrt_dma_start_2d(
+                        b.U + xi * 8 * b.ld * size, /* dst */
+                        l_weights + ((xi * l->CO + co) * l->CI + ci) *
+                                        size, /* src */
+                        size * l->TILE_CI,    /* size */
+                        size * b.ld,          /* dst_stride */
+                        size * l->CI,         /* src_stride */
+                        8 /* repetitions */);
+                }
+                weights_loaded = weights_idx;
+            }
+            snrt_dma_wait_all();
+        }
+
+        snrt_cluster_hw_barrier();
+
+        if (snrt_is_dm_core()) {
+            // Prefetch the input tiles of the next step
+            if (s + 1 < steps) {
+                const uint32_t next = first + (s + 1) / n_ci;
+                const uint32_t nb = next % blocks;
+                load_ifmap(l, b.ifmap + (s + 1) % 2 * b.ifmap_stride * size,
+                           b.ifmap_row_stride, PH, PW,
+                           (int32_t)(nb / blocks_w * BH * m) - (int32_t)l->pad,
+                           (int32_t)(nb % blocks_w * BW * m) - (int32_t)l->pad,
+                           (s + 1) % n_ci * l->TILE_CI);
+            }
+        } else {
+            // Every core transforms every `compute_num`-th input channel of
+            // all tiles of the block
+            for (uint32_t t = 0; t < T; t++) {
+                const uint32_t offset =
+                    t / BW * m * b.ifmap_row_stride + t % BW * m * l->TILE_CI +
+                    compute_id;
+                const uint32_t n = l->TILE_CI - min(compute_id, l->TILE_CI);
+                if (size == FP64) {
+                    winograd_input_fp64(m, (double *)ifmap + offset,
+                                        b.ifmap_row_stride, l->TILE_CI,
+                                        (double *)b.V + t * b.ld + compute_id,
+                                        T * b.ld, n, compute_num);
+                } else {
+                    winograd_input_fp32(m, (float *)ifmap + offset,
+                                        b.ifmap_row_stride, l->TILE_CI,
+                                        (float *)b.V + t * b.ld + compute_id,
+                                        T * b.ld, n, compute_num);
+                }
+            }
+        }
+
+        snrt_cluster_hw_barrier();
+
+        // The a * a element-wise GEMMs are distributed across cores, the
+        // first tile of input channels overwrites the accumulators
+        if (snrt_is_compute_core()) {
+            const uint32_t alpha = k != 0;
+            for (uint32_t xi = compute_id; xi < a * a; xi += compute_num) {
+                winograd_gemm(l->dtype, T, l->TILE_CI,
+                              b.V + xi * T * b.ld * size,
+                              b.U + xi * 8 * b.ld * size, b.ld,
+                              b.M + xi * T * 8 * size, &alpha, setup_SSR);
+                setup_SSR = 0;
+            }
+        }
+
+        if (snrt_is_dm_core()) snrt_dma_wait_all();
+
+        snrt_cluster_hw_barrier();
+
+        if (k != n_ci - 1) continue;
+
+        // Every core transforms every `compute_num`-th output channel of all
+        // tiles of the block
+        if (snrt_is_compute_core()) {
+            for (uint32_t t = 0; t < T; t++) {
+                const uint32_t offset = t / BW * m * b.ofmap_row_stride +
+                                        t % BW * m * 8 + compute_id;
+                const uint32_t n = 8 - min(compute_id, 8);
+                if (size == FP64) {
+                    winograd_output_fp64(m, (double *)b.M + t * 8 + compute_id,
+                                         T * 8, (double *)b.ofmap + offset,
+                                         b.ofmap_row_stride, 8, n,
+                                         compute_num);
+                } else {
+                    winograd_output_fp32(m, (float *)b.M + t * 8 + compute_id,
+                                         T * 8, (float *)b.ofmap + offset,
+                                         b.ofmap_row_stride, 8, n,
+                                         compute_num);
+                }
+            }
+        }
+
+        snrt_cluster_hw_barrier();
+
+        // Write back the valid part of the block
+        if (snrt_is_dm_core()) {
+            const uint32_t rows = min(BH * m, l->OH - oh0);
+            const uint32_t cols = min(BW * m, l->OW - ow0);
+            for (uint32_t r = 0; r < rows; r++) {
+                snrt_dma_start_2d(
+                    l_ofmap + (((oh0 + r) * l->OW + ow0) * l->CO + co) *
+                                  size,                      /* dst */
+                    b.ofmap + r * b.ofmap_row_stride * size, /* src */
+                    size * 8,                                /* size */
+                    size * l->CO,                            /* dst_stride */
+                    size * 8,                                /* src_stride */
+                    cols /* repetitions */);
+            }
+            snrt_dma_wait_all();
+        }
+    }
+
+    return 0;
+}
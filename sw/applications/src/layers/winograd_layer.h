@@ -0,0 +1,27 @@
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "layer.h"
+
+/**
+ * @brief Winograd F(m x m, 3 x 3) convolution layer with stride 1, m being
+ * `l->winograd`. The output is split into blocks of up to one m x m tile per
+ * compute core, which are distributed across clusters together with groups of
+ * 8 output channels. For every tile of input channels, the input tiles of a
+ * block are transformed, multiplied with the transformed filters in a * a
+ * element-wise GEMMs (SSR and FREP) and accumulated in the TCDM. After the
+ * last tile of input channels, the output transform writes the block back to
+ * main memory. Input tiles are double buffered.
+ *
+ * Supports FP64 and FP32. Requires CO to be a multiple of 8 and TILE_CI to
+ * divide CI, and to be even for FP32. The weights are the filters transformed
+ * by `data_gen.py` in a*a x CO x CI format, a = m + 2. Blocks are shrunk
+ * until the buffers fit into the TCDM, the transformed filters take
+ * a * a * 8 * TILE_CI elements.
+ *
+ * @param l conv_layer struct that holds addresses and parameters
+ * @return uint32_t 0 on success, 1 if the layer is not supported or does not
+ * fit into the TCDM
+ */
+uint32_t winograd_conv2d_layer(const conv_layer *l);
@@ -2,29 +2,69 @@
 // Licensed under the Apache License, Version 2.0, see LICENSE for details.
 // SPDX-License-Identifier: Apache-2.0
 
-// SW testbench for profiling BatchNorm Layer
-// Automatically checks the correctness of the results
+// SW testbench for profiling BatchNorm Layer in different floating point
+// precisions. Reports the cycles per thousand multiply-adds, and automatically
+// checks the correctness of the results
 
 #include "batchnorm_layer.h"
 #include "data_batchnorm.h"
 #include "layer.h"
 #include "math.h"
+#include "perf_cnt.h"
 #include "printf.h"
 #include "snrt.h"
+#ifdef SNITCH_DATA_BINARY
+#include "tensor_file.h"
+#endif
 #include "utils.h"
 
+#define min(a, b) ((a) < (b) ? (a) : (b))
+
 int main() {
+#ifdef SNITCH_DATA_BINARY
+    // Look the tensors up by name in the linked container
+    const void *file = data_batchnorm_tensors;
+    precision_t dtype = batchnorm_l.dtype;
+    batchnorm_l.ifmap = tensor_file_data(file, "batchnorm_ifmap_dram", dtype);
+    batchnorm_l.ofmap = tensor_file_data(file, "batchnorm_ofmap_dram", dtype);
+    batchnorm_l.gamma = tensor_file_data(file, "batchnorm_gamma_dram", dtype);
+    batchnorm_l.beta = tensor_file_data(file, "batchnorm_beta_dram", dtype);
+    double *checksum = tensor_file_fp64(file, "batchnorm_checksum");
+    if (tensor_file_check(file) || !batchnorm_l.ifmap || !batchnorm_l.ofmap ||
+        !batchnorm_l.gamma || !batchnorm_l.beta || !checksum) {
+        if (snrt_global_core_idx() == 0)
+            printf("Missing tensors in the data container\n");
+        return 1;
+    }
+#else
     batchnorm_l.ifmap = (double *)batchnorm_ifmap_dram;
     batchnorm_l.ofmap = (double *)batchnorm_ofmap_dram;
     batchnorm_l.gamma = (double *)batchnorm_gamma_dram;
     batchnorm_l.beta = (double *)batchnorm_beta_dram;
-    batchnorm_l.TILE_CI = 32;
+    double *checksum = (double *)batchnorm_checksum;
+#endif
+    // Tiles of the same size in bytes for all precisions
+    batchnorm_l.TILE_CI = min(256 / batchnorm_l.dtype, batchnorm_l.CI);
+
+    if (snrt_global_core_idx() == 0) {
+        snrt_reset_perf_counter(SNRT_PERF_CNT0);
+        snrt_start_perf_counter(SNRT_PERF_CNT0, SNRT_PERF_CNT_CYCLES, 0);
+    }
 
     batchnorm_layer(&batchnorm_l);
 
+    if (snrt_global_core_idx() == 0) {
+        snrt_stop_perf_counter(SNRT_PERF_CNT0);
+        uint32_t cycles = snrt_get_perf_counter(SNRT_PERF_CNT0);
+        uint32_t macs = batchnorm_l.OH * batchnorm_l.OW * batchnorm_l.CI;
+        printf("FP%d: %d cycles, %d cycles per 1000 MACs\n",
+               8 * batchnorm_l.dtype, cycles,
+               (uint32_t)((uint64_t)cycles * 1000 / macs));
+    }
+
     snrt_global_barrier();
 
-    uint32_t errors = check_layer(&batchnorm_l, (double *)batchnorm_checksum);
+    uint32_t errors = check_layer(&batchnorm_l, checksum);
 
     snrt_global_barrier();
 
@@ -2,8 +2,15 @@
 // Licensed under the Apache License, Version 2.0, see LICENSE for details.
 // SPDX-License-Identifier: Apache-2.0
 
-// SW testbench for profiling Conv2d Layer
-// Automatically checks the correctness of the results
+// SW testbench for profiling Conv2d Layer in different floating point
+// precisions. Reports the cycles per thousand MACs, and automatically checks
+// the correctness of the results
+//
+// For 3x3 convolutions with stride 1 in FP64 and FP32, the layer is also
+// computed with the Winograd convolutions F(2x2, 3x3) and F(4x4, 3x3). Their
+// cycles per thousand MACs refer to the MACs of the direct convolution, and
+// the maximum error of the pixel sums relative to their magnitude is reported
+// for both the direct and the Winograd convolutions.
 
 #include "conv2d_layer.h"
 #include "data_conv2d.h"
@@ -13,10 +20,78 @@
 #include "printf.h"
 #include "snrt.h"
 #include "utils.h"
+#include "winograd_layer.h"
 
 #define min(a, b) ((a) < (b) ? (a) : (b))
 #define max(a, b) ((a) > (b) ? (a) : (b))
 
+// Maximum error of the pixel sums of the ofmap relative to their magnitude
+static double max_rel_error(const conv_layer *l, const double *checksum) {
+    double max_error = 0.0;
+    for (uint32_t p = 0; p < l->OH * l->OW; p++) {
+        double sum = 0.0, magnitude = 0.0;
+        for (uint32_t co = 0; co < l->CO; co++) {
+            double y = l->dtype == FP64
+                           ? l->ofmap[p * l->CO + co]
+                           : ((const float *)l->ofmap)[p * l->CO + co];
+            sum += y;
+            magnitude += fabs(y);
+        }
+        double error = fabs(sum - checksum[p]) / (magnitude + 0.001);
+        max_error = max(max_error, error);
+    }
+    return max_error;
+}
+
+static uint32_t report(const char *name, const conv_layer *l,
+                       uint32_t cycles) {
+    if (snrt_global_core_idx() == 0) {
+        uint32_t macs = l->OH * l->OW * l->CO * l->CI * l->FH * l->FW;
+        printf("FP%d%s: %d cycles, %d cycles per 1000 MACs\n", 8 * l->dtype,
+               name, cycles, (uint32_t)((uint64_t)cycles * 1000 / macs));
+        if (l->dtype == FP64 || l->dtype == FP32) {
+            printf("Max relative error: %d ppm\n",
+                   (uint32_t)(max_rel_error(l, (double *)conv2d_checksum) *
+                              1000000));
+        }
+    }
+
+    snrt_global_barrier();
+
+    uint32_t errors = check_layer(l, (double *)conv2d_checksum);
+
+    snrt_global_barrier();
+
+    return errors;
+}
+
+#ifdef CONV2D_WINOGRAD
+static uint32_t winograd(uint32_t m, double *weights) {
+    conv_layer l = conv2d_l;
+    l.weights = weights;
+    l.ofmap = (double *)conv2d_result;
+    l.winograd = m;
+    // The transformed filters of a tile of input channels are kept in the
+    // TCDM, a * a * 8 * TILE_CI elements
+    l.TILE_CI = min(128 / l.dtype, l.CI);
+
+    // Clear the results of the previous run
+    if (snrt_global_core_idx() == 0) {
+        snrt_memset(conv2d_result, 0, sizeof(conv2d_result));
+    }
+    snrt_global_barrier();
+
+    uint32_t t0 = benchmark_get_cycle();
+    uint32_t errors = winograd_conv2d_layer(&l);
+    snrt_global_barrier();
+    uint32_t cycles = benchmark_get_cycle() - t0;
+
+    return errors + report(m == 2 ? " Winograd F(2x2, 3x3)"
+                                  : " Winograd F(4x4, 3x3)",
+                           &l, cycles);
+}
+#endif
+
 int main() {
     conv2d_l.ifmap = (double*)conv2d_ifmap_dram;
     conv2d_l.weights = (double*)conv2d_weights_dram;
@@ -49,9 +124,12 @@ int main() {
 
     snrt_global_barrier();
 
-    uint32_t errors = check_layer(&conv2d_l, (double*)conv2d_checksum);
+    uint32_t errors = report("", &conv2d_l, cycles);
 
-    snrt_global_barrier();
+#ifdef CONV2D_WINOGRAD
+    errors += winograd(2, (double *)conv2d_winograd2_weights_dram);
+    errors += winograd(4, (double *)conv2d_winograd4_weights_dram);
+#endif
 
     return errors;
 }
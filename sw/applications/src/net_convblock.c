@@ -0,0 +1,114 @@
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+// SW testbench for comparing a Conv2d + BatchNorm + MaxPool sequence of
+// separate layers against the fused Conv2d + BatchNorm + ReLU + MaxPool block
+// which keeps the intermediate feature maps in the TCDM. Reports the cycles
+// and the bytes moved by the DMA of cluster 0 for both, and automatically
+// checks the correctness of the results.
+
+#include "batchnorm_layer.h"
+#include "conv2d_layer.h"
+#include "conv_block_layer.h"
+#include "data_convblock.h"
+#include "layer.h"
+#include "math.h"
+#include "maxpool_layer.h"
+#include "perf_cnt.h"
+#include "printf.h"
+#include "snrt.h"
+#include "utils.h"
+
+#define min(a, b) ((a) < (b) ? (a) : (b))
+
+// Bytes of the DMA transfers of cluster 0, handed from its DM core to core 0
+static volatile uint32_t dma_bytes;
+
+static void perf_start() {
+    snrt_global_barrier();
+    if (snrt_global_core_idx() == 0) {
+        snrt_reset_perf_counter(SNRT_PERF_CNT0);
+        snrt_start_perf_counter(SNRT_PERF_CNT0, SNRT_PERF_CNT_CYCLES, 0);
+    }
+    snrt_dma_reset_bytes();
+    snrt_global_barrier();
+}
+
+static void perf_stop(const char *name) {
+    snrt_global_barrier();
+    if (snrt_global_core_idx() == 0) snrt_stop_perf_counter(SNRT_PERF_CNT0);
+    if (snrt_is_dm_core() && snrt_cluster_idx() == 0)
+        dma_bytes = snrt_dma_get_bytes();
+    snrt_global_barrier();
+    if (snrt_global_core_idx() == 0) {
+        printf("%s: %d cycles, %d bytes moved by the DMA\n", name,
+               snrt_get_perf_counter(SNRT_PERF_CNT0), dma_bytes);
+    }
+}
+
+int main() {
+    convblock_l.ifmap = (double *)convblock_ifmap_dram;
+    convblock_l.weights = (double *)convblock_weights_dram;
+    convblock_l.gamma = (double *)convblock_gamma_dram;
+    convblock_l.beta = (double *)convblock_beta_dram;
+    convblock_l.TILE_CI = min(32, convblock_l.CI);
+    convblock_l.cluster2cluster = 0;
+
+    const uint32_t P = convblock_l.pool;
+
+    // Conv2d writes the full ofmap to main memory
+    conv_layer conv_l = convblock_l;
+    conv_l.ofmap = (double *)convblock_conv_dram;
+
+    // BatchNorm reads it back and writes a normalized copy
+    conv_layer bn_l = {0};
+    bn_l.CO = bn_l.CI = convblock_l.CO;
+    bn_l.IH = bn_l.OH = convblock_l.OH;
+    bn_l.IW = bn_l.OW = convblock_l.OW;
+    bn_l.ifmap = (double *)convblock_conv_dram;
+    bn_l.ofmap = (double *)convblock_bn_dram;
+    bn_l.gamma = (double *)convblock_gamma_dram;
+    bn_l.beta = (double *)convblock_beta_dram;
+    bn_l.TILE_CI = min(32, bn_l.CI);
+    bn_l.dtype = convblock_l.dtype;
+
+    // MaxPool reads the normalized copy
+    conv_layer pool_l = bn_l;
+    pool_l.OH = convblock_l.OH / P;
+    pool_l.OW = convblock_l.OW / P;
+    pool_l.FH = pool_l.FW = P;
+    pool_l.ifmap = (double *)convblock_bn_dram;
+    pool_l.ofmap = (double *)convblock_pool_dram;
+
+    // The fused block only writes the pooled ofmap
+    conv_layer block_l = convblock_l;
+    block_l.ofmap = (double *)convblock_ofmap_dram;
+
+    perf_start();
+    conv2d_layer(&conv_l);
+    snrt_global_barrier();
+    batchnorm_layer(&bn_l);
+    snrt_global_barrier();
+    uint32_t errors = maxpool_layer(&pool_l);
+    perf_stop("Separate layers");
+
+    perf_start();
+    conv_block_layer(&block_l);
+    perf_stop("Fused block");
+
+    snrt_global_barrier();
+
+    errors += check_layer(&pool_l, (double *)convblock_pool_checksum);
+
+    snrt_global_barrier();
+
+    // The result of the block has the dimensions of the pooled ofmap
+    conv_layer out_l = pool_l;
+    out_l.ofmap = (double *)convblock_ofmap_dram;
+    errors += check_layer(&out_l, (double *)convblock_checksum);
+
+    snrt_global_barrier();
+
+    return errors;
+}
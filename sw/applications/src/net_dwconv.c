@@ -0,0 +1,99 @@
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+// SW testbench for comparing a depthwise separable convolution computed with
+// separate depthwise and pointwise layers against the fused layer which keeps
+// the depthwise output in the TCDM. Reports the cycles and the bytes moved by
+// the DMA of cluster 0 for both, and automatically checks the correctness of
+// the results.
+
+#include "data_dwconv.h"
+#include "dwconv_layer.h"
+#include "layer.h"
+#include "perf_cnt.h"
+#include "printf.h"
+#include "snrt.h"
+#include "utils.h"
+
+// Bytes of the DMA transfers of cluster 0, handed from its DM core to core 0
+static volatile uint32_t dma_bytes;
+
+static void perf_start() {
+    snrt_global_barrier();
+    if (snrt_global_core_idx() == 0) {
+        snrt_reset_perf_counter(SNRT_PERF_CNT0);
+        snrt_start_perf_counter(SNRT_PERF_CNT0, SNRT_PERF_CNT_CYCLES, 0);
+    }
+    snrt_dma_reset_bytes();
+    snrt_global_barrier();
+}
+
+static void perf_stop(const char *name) {
+    snrt_global_barrier();
+    if (snrt_global_core_idx() == 0) snrt_stop_perf_counter(SNRT_PERF_CNT0);
+    if (snrt_is_dm_core() && snrt_cluster_idx() == 0)
+        dma_bytes = snrt_dma_get_bytes();
+    snrt_global_barrier();
+    if (snrt_global_core_idx() == 0) {
+        printf("%s: %d cycles, %d bytes moved by the DMA\n", name,
+               snrt_get_perf_counter(SNRT_PERF_CNT0), dma_bytes);
+    }
+}
+
+int main() {
+    dwconv_l.ifmap = (double *)dwconv_ifmap_dram;
+    dwconv_l.weights = (double *)dwconv_dw_weights_dram;
+
+    // The depthwise layer writes its full ofmap to main memory
+    conv_layer dw_l = dwconv_l;
+    dw_l.CO = dwconv_l.CI;
+    dw_l.ofmap = (double *)dwconv_dw_dram;
+    dw_l.pw_weights = NULL;
+
+    // The pointwise layer reads it back
+    conv_layer pw_l = {0};
+    pw_l.CO = dwconv_l.CO;
+    pw_l.CI = dwconv_l.CI;
+    pw_l.IH = pw_l.OH = dwconv_l.OH;
+    pw_l.IW = pw_l.OW = dwconv_l.OW;
+    pw_l.FH = pw_l.FW = 1;
+    pw_l.ifmap = (double *)dwconv_dw_dram;
+    pw_l.weights = (double *)dwconv_pw_weights_dram;
+    pw_l.ofmap = (double *)dwconv_pw_dram;
+    pw_l.TILE_CI = dwconv_l.TILE_CI;
+    pw_l.dtype = dwconv_l.dtype;
+
+    // The fused layer only writes the pointwise ofmap
+    conv_layer fused_l = dwconv_l;
+    fused_l.pw_weights = (double *)dwconv_pw_weights_dram;
+    fused_l.ofmap = (double *)dwconv_ofmap_dram;
+
+    uint32_t errors = 0;
+
+    perf_start();
+    errors += dwconv_layer(&dw_l);
+    snrt_global_barrier();
+    errors += pwconv_layer(&pw_l);
+    perf_stop("Separate layers");
+
+    perf_start();
+    errors += dwconv_layer(&fused_l);
+    perf_stop("Fused layer");
+
+    snrt_global_barrier();
+
+    errors += check_layer(&dw_l, (double *)dwconv_dw_checksum);
+
+    snrt_global_barrier();
+
+    errors += check_layer(&pw_l, (double *)dwconv_checksum);
+
+    snrt_global_barrier();
+
+    errors += check_layer(&fused_l, (double *)dwconv_checksum);
+
+    snrt_global_barrier();
+
+    return errors;
+}
@@ -3,215 +3,127 @@
 // SPDX-License-Identifier: Apache-2.0
 
 // SW testbench for profiling GEMM kernels in different
-// floating point precisions (fp64, fp32, fp16), as well as
+// floating point precisions (fp64, fp32, fp16, fp8, and the expanding fp16 to
+// fp32 and fp8 to fp16 variants), as well as
 // different memory layouts for matrices (transposed/not-transposed)
-// Correctness of results are checked automatically
+// Correctness of results are checked automatically against a FP64 reference,
+// and the throughput and the maximum error of the row sums are reported
+//
+// The matrices stay in main memory and are tiled through the TCDM by the
+// GEMM layer, such that any problem size can be benchmarked. If the layer
+// struct does not set the tile sizes, they are looked up in
+// `gemm_tiling_lut.h` or chosen by the cost model.
+//
+// When compiled with GEMM_TUNE, the testbench runs in tuning mode instead:
+// it measures the best candidates of the cost model for the problem and
+// prints one `GEMM_TUNE` line per candidate. `tune_gemm.py` turns the output
+// into `gemm_tiling_lut.h`.
 
 #include "data_gemm.h"
-#include "gemm.h"
+#include "gemm_layer.h"
+#include "gemm_tiling.h"
 #include "layer.h"
 #include "math.h"
 #include "perf_cnt.h"
 #include "printf.h"
 #include "snrt.h"
 #include "utils.h"
+#include "verify.h"
 
-// Padding of innermost dimension of a Matrix
-// Useful for preventing banking conflicts between cores
-// that are accessing different rows of the matrix
-#define MAT_ROW_PADDING 4
+#ifdef GEMM_TUNE
+// Number of candidates measured in tuning mode
+#define GEMM_TUNE_CANDIDATES 16
 
-// Padding in between matrices A, B for preventing
-// banking conflicts in the beginning
-#define MAT_PADDING 8
+static uint32_t tune(gemm_layer *l) {
+    const uint32_t cluster_num = snrt_cluster_num();
+    const uint32_t compute_num = snrt_cluster_compute_core_num();
+    const int is_main = snrt_global_core_idx() == 0;
+
+    gemm_tiling cands[GEMM_TUNE_CANDIDATES];
+    uint32_t n = gemm_tiling_candidates(
+        l, snrt_slice_len(snrt_cluster_memory()), cluster_num, compute_num,
+        cands, GEMM_TUNE_CANDIDATES);
+
+    for (uint32_t i = 0; i < n; i++) {
+        l->TILE_M = cands[i].TILE_M;
+        l->TILE_N = cands[i].TILE_N;
+        l->TILE_K = cands[i].TILE_K;
+        l->TILE_PAD = cands[i].PAD;
+        l->TILE_UNROLL = cands[i].UNROLL;
+
+        snrt_global_barrier();
+        uint32_t t0 = benchmark_get_cycle();
+        tiled_gemm_layer(l);
+        snrt_global_barrier();
+        uint32_t t1 = benchmark_get_cycle();
+
+        if (is_main) {
+            printf("GEMM_TUNE %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d\n",
+                   l->M, l->N, l->K, l->dtype, l->TA, l->TB, cluster_num,
+                   compute_num, cands[i].TILE_M, cands[i].TILE_N,
+                   cands[i].TILE_K, cands[i].PAD, cands[i].UNROLL,
+                   gemm_tiling_cost(l, &cands[i], cluster_num, compute_num),
+                   t1 - t0);
+        }
+    }
+    return n == 0;
+}
+#endif
+
+// Allowed error of a row sum of C, absolute and relative to the sum of the
+// absolute values of the row. The FP8 kernels accumulate in FP16 and the
+// non-expanding one rounds its result to FP8.
+static double abs_tolerance(const gemm_layer *l) {
+    switch (l->dtype) {
+        case FP64:
+        case FP32:
+            return 0.001;
+        case FP16:
+            return l->expand ? 0.001 : 0.05;
+        default:
+            return 0.05;
+    }
+}
 
-void *share_ptr;
+static double rel_tolerance(const gemm_layer *l) {
+    if (l->dtype != FP8) return 0.0;
+    return l->expand ? 4e-3 : 0.25;
+}
 
 int main() {
     gemm_l.A = (void *)gemm_A_dram;
     gemm_l.B = (void *)gemm_B_dram;
     gemm_l.C = (void *)gemm_C_dram;
 
-    const gemm_layer l1_gemm_l = gemm_l;
-
-    const uint32_t cluster_num = snrt_cluster_num();
-    const uint32_t cluster_id = snrt_cluster_idx();
-    const uint32_t compute_num = snrt_cluster_compute_core_num();
-    const uint32_t compute_id = snrt_cluster_compute_core_idx();
-
-    void *mat_A, *mat_B, *mat_C;
-
-    uint32_t mat_A_size =
-        (l1_gemm_l.M * (l1_gemm_l.K + MAT_ROW_PADDING) + MAT_PADDING) *
-        l1_gemm_l.dtype;
-    uint32_t mat_B_size =
-        (l1_gemm_l.K + MAT_ROW_PADDING) * l1_gemm_l.N * l1_gemm_l.dtype;
-    uint32_t mat_C_size = l1_gemm_l.M * l1_gemm_l.N * l1_gemm_l.dtype;
-
-    uint32_t total_size = mat_A_size + mat_B_size + mat_C_size;
-
-    void *ptr;
-
-    if (compute_id == 0) {
-        ptr = snrt_l1alloc(total_size);
-        share_ptr = ptr;
-    }
-
-    snrt_cluster_hw_barrier();
-
-    ptr = share_ptr;
-
-    mat_A = ptr;
-    ptr += (l1_gemm_l.M * (l1_gemm_l.K + MAT_ROW_PADDING) + MAT_PADDING) *
-           l1_gemm_l.dtype;
-    mat_B = ptr;
-    ptr += (l1_gemm_l.K + MAT_ROW_PADDING) * l1_gemm_l.N * l1_gemm_l.dtype;
-    mat_C = ptr;
-    ptr += l1_gemm_l.M * l1_gemm_l.N * l1_gemm_l.dtype;
-
-    uint32_t errors = 0;
+    gemm_layer l = gemm_l;
 
+#ifdef GEMM_TUNE
+    return tune(&l);
+#else
     snrt_global_barrier();
-
-    if (snrt_is_dm_core()) {
-        snrt_dma_txid_t txid_A =
-            snrt_dma_start_2d(mat_A, l1_gemm_l.A, l1_gemm_l.dtype * l1_gemm_l.K,
-                              l1_gemm_l.dtype * (l1_gemm_l.K + MAT_ROW_PADDING),
-                              l1_gemm_l.dtype * l1_gemm_l.K, l1_gemm_l.M);
-        snrt_dma_txid_t txid_B =
-            snrt_dma_start_2d(mat_B, l1_gemm_l.B, l1_gemm_l.dtype * l1_gemm_l.K,
-                              l1_gemm_l.dtype * (l1_gemm_l.K + MAT_ROW_PADDING),
-                              l1_gemm_l.dtype * l1_gemm_l.K, l1_gemm_l.N);
-
-        snrt_dma_txid_t txid_C = snrt_dma_start_1d(
-            mat_C, l1_gemm_l.C, l1_gemm_l.dtype * l1_gemm_l.M * l1_gemm_l.N);
-
-        snrt_dma_wait_all();
-    }
-
-    snrt_cluster_hw_barrier();
-
-    if (snrt_is_compute_core() &&
-        snrt_cluster_compute_core_idx() < compute_num) {
-        const uint32_t setup_SSR = 1;
-
-        if (!l1_gemm_l.TA && !l1_gemm_l.TB) {
-            volatile uint32_t A_offset =
-                compute_id * (l1_gemm_l.K + MAT_ROW_PADDING) * l1_gemm_l.dtype;
-            volatile uint32_t C_offset =
-                compute_id * l1_gemm_l.N * l1_gemm_l.dtype;
-            volatile uint32_t ldA =
-                compute_num * (l1_gemm_l.K + MAT_ROW_PADDING);
-            volatile uint32_t ldB = l1_gemm_l.K + MAT_ROW_PADDING;
-            volatile uint32_t ldC = l1_gemm_l.N * compute_num;
-
-            benchmark_get_cycle();
-            gemm_fp64_ssr_frep(l1_gemm_l.M / compute_num, l1_gemm_l.N,
-                               l1_gemm_l.K, &mat_A[A_offset], ldA, l1_gemm_l.TA,
-                               mat_B, ldB, l1_gemm_l.TB, &mat_C[C_offset], ldC,
-                               &l1_gemm_l.ALPHA, setup_SSR);
-            benchmark_get_cycle();
-        } else if (!l1_gemm_l.TA && l1_gemm_l.TB) {
-            volatile uint32_t A_offset =
-                compute_id * (l1_gemm_l.K + MAT_ROW_PADDING) * l1_gemm_l.dtype;
-            volatile uint32_t C_offset =
-                compute_id * l1_gemm_l.N * l1_gemm_l.dtype;
-            volatile uint32_t ldA =
-                compute_num * (l1_gemm_l.K + MAT_ROW_PADDING);
-            volatile uint32_t ldB = l1_gemm_l.K + MAT_ROW_PADDING;
-            volatile uint32_t ldC = l1_gemm_l.N * compute_num;
-
-            benchmark_get_cycle();
-            if (l1_gemm_l.dtype == FP64) {
-                gemm_fp64_ssr_frep(l1_gemm_l.M / compute_num, l1_gemm_l.N,
-                                   l1_gemm_l.K, &mat_A[A_offset], ldA,
-                                   l1_gemm_l.TA, mat_B, ldB, l1_gemm_l.TB,
-                                   &mat_C[C_offset], ldC, &l1_gemm_l.ALPHA,
-                                   setup_SSR);
-            } else if (l1_gemm_l.dtype == FP32) {
-                gemm_fp32simd_tb_ssr_frep(
-                    l1_gemm_l.M / compute_num, l1_gemm_l.N, l1_gemm_l.K,
-                    &mat_A[A_offset], ldA, mat_B, ldB, &mat_C[C_offset], ldC,
-                    &l1_gemm_l.ALPHA, setup_SSR);
-            } else if (l1_gemm_l.dtype == FP16) {
-                gemm_fp16simd_tb_ssr_frep(
-                    l1_gemm_l.M / compute_num, l1_gemm_l.N, l1_gemm_l.K,
-                    &mat_A[A_offset], ldA, mat_B, ldB, &mat_C[C_offset], ldC,
-                    &l1_gemm_l.ALPHA, setup_SSR);
-            }
-            benchmark_get_cycle();
-        } else if (l1_gemm_l.TA && !l1_gemm_l.TB) {
-            volatile uint32_t A_offset = compute_id * l1_gemm_l.dtype;
-            volatile uint32_t C_offset =
-                compute_id * l1_gemm_l.N * l1_gemm_l.dtype;
-            volatile uint32_t ldA = (l1_gemm_l.K + MAT_ROW_PADDING);
-            volatile uint32_t ldB = l1_gemm_l.K + MAT_ROW_PADDING;
-            volatile uint32_t ldC = l1_gemm_l.N * compute_num;
-
-            benchmark_get_cycle();
-            gemm_fp64_ssr_frep(l1_gemm_l.M / compute_num, l1_gemm_l.N,
-                               l1_gemm_l.K, &mat_A[A_offset], ldA, l1_gemm_l.TA,
-                               mat_B, ldB, l1_gemm_l.TB, &mat_C[C_offset], ldC,
-                               &l1_gemm_l.ALPHA, setup_SSR);
-            benchmark_get_cycle();
-        } else if (l1_gemm_l.TA && l1_gemm_l.TB) {
-            volatile uint32_t A_offset = compute_id * l1_gemm_l.dtype;
-            volatile uint32_t C_offset =
-                compute_id * l1_gemm_l.N * l1_gemm_l.dtype;
-            volatile uint32_t ldA = (l1_gemm_l.K + MAT_ROW_PADDING);
-            volatile uint32_t ldB = l1_gemm_l.K + MAT_ROW_PADDING;
-            volatile uint32_t ldC = l1_gemm_l.N * compute_num;
-
-            benchmark_get_cycle();
-            gemm_fp64_ssr_frep(l1_gemm_l.M / compute_num, l1_gemm_l.N,
-                               l1_gemm_l.K, &mat_A[A_offset], ldA, l1_gemm_l.TA,
-                               mat_B, ldB, l1_gemm_l.TB, &mat_C[C_offset], ldC,
-                               &l1_gemm_l.ALPHA, setup_SSR);
-            benchmark_get_cycle();
-        }
-        snrt_cluster_hw_barrier();
-    } else {
-        snrt_cluster_hw_barrier();
-    }
-    snrt_cluster_hw_barrier();
-
-    if (compute_id == 0) {
-        if (l1_gemm_l.dtype == FP64) {
-            for (uint32_t m = 0; m < l1_gemm_l.M; m++) {
-                double checksum = gemm_checksum[m];
-                double sum = 0.0;
-                for (uint32_t n = 0; n < l1_gemm_l.N; n++) {
-                    sum += ((double *)mat_C)[m * l1_gemm_l.N + n];
-                }
-                if (fabs(sum - checksum) > 0.001) {
-                    errors++;
-                }
-            }
-        } else if (l1_gemm_l.dtype == FP32) {
-            for (uint32_t m = 0; m < l1_gemm_l.M; m++) {
-                float checksum = gemm_checksum[m];
-                float sum = 0.0;
-                for (uint32_t n = 0; n < l1_gemm_l.N; n++) {
-                    sum += ((float *)mat_C)[m * l1_gemm_l.N + n];
-                }
-                if (fabs(sum - checksum) > 0.001) {
-                    errors++;
-                }
-            }
-        } else if (l1_gemm_l.dtype == FP16) {
-            for (uint32_t m = 0; m < l1_gemm_l.M; m++) {
-                __fp16 checksum = gemm_checksum[m];
-                float sum = 0.0;
-                for (uint32_t n = 0; n < l1_gemm_l.N; n++) {
-                    sum += ((__fp16 *)mat_C)[m * l1_gemm_l.N + n];
-                }
-                if (fabs(sum - checksum) > 0.05) {
-                    errors++;
-                }
-            }
-        }
-        printf("%d/%d Errors\n", errors, l1_gemm_l.M * l1_gemm_l.N);
+    uint32_t t0 = benchmark_get_cycle();
+    uint32_t errors = tiled_gemm_layer(&l);
+    snrt_global_barrier();
+    uint32_t cycles = benchmark_get_cycle() - t0;
+
+    // Rounding errors grow with the length of the dot products. The row sums
+    // are checked against the FP64 reference by all cores.
+    const double scale = (l.K + 15) / 16;
+    const verify_result r = verify_checksum(
+        l.C, gemm_c_size(&l), l.M, l.N, gemm_checksum,
+        abs_tolerance(&l) * scale, rel_tolerance(&l) * scale);
+    errors += r.errors;
+
+    if (snrt_global_core_idx() == 0) {
+        uint64_t flop = 2ull * l.M * l.N * l.K;
+        printf("FP%d%s: %d cycles, %d FLOP per 100 cycles\n", 8 * l.dtype,
+               l.expand ? " expanding" : "", cycles,
+               (uint32_t)(flop * 100 / cycles));
+        printf("Max relative error: %d ppm\n",
+               (uint32_t)(r.max_error * 1000000));
+        printf("%d/%d Errors\n", errors, l.M * l.N);
     }
 
     return errors;
+#endif
 }
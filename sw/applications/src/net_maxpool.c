@@ -2,29 +2,75 @@
 // Licensed under the Apache License, Version 2.0, see LICENSE for details.
 // SPDX-License-Identifier: Apache-2.0
 
-// SW testbench for profiling MaxPool Layer
-// Automatically checks the correctness of the results
+// SW testbench for profiling the pooling layers in different floating point
+// precisions. The same input is pooled with the MaxPool, the average pooling
+// and the global average pooling layer (the latter two not in FP8). Reports
+// the cycles per thousand output elements of each, and automatically checks
+// the correctness of the results
 
 #include "data_maxpool.h"
 #include "layer.h"
 #include "math.h"
 #include "maxpool_layer.h"
+#include "perf_cnt.h"
 #include "printf.h"
 #include "snrt.h"
 #include "utils.h"
 
-int main() {
-    maxpool_l.ifmap = (double*)maxpool_ifmap_dram;
-    maxpool_l.ofmap = (double*)maxpool_ofmap_dram;
-    maxpool_l.TILE_CI = 32;
+#define min(a, b) ((a) < (b) ? (a) : (b))
+
+static uint32_t benchmark(const char *name,
+                          uint32_t (*layer)(const conv_layer *),
+                          const conv_layer *l, double *checksum) {
+    snrt_global_barrier();
+    if (snrt_global_core_idx() == 0) {
+        snrt_reset_perf_counter(SNRT_PERF_CNT0);
+        snrt_start_perf_counter(SNRT_PERF_CNT0, SNRT_PERF_CNT_CYCLES, 0);
+    }
+
+    uint32_t errors = layer(l);
 
-    maxpool_layer(&maxpool_l);
+    snrt_global_barrier();
+    if (snrt_global_core_idx() == 0) {
+        snrt_stop_perf_counter(SNRT_PERF_CNT0);
+        uint32_t cycles = snrt_get_perf_counter(SNRT_PERF_CNT0);
+        uint32_t outputs = l->OH * l->OW * l->CO;
+        printf("FP%d %s: %d cycles, %d cycles per 1000 outputs\n",
+               8 * l->dtype, name, cycles,
+               (uint32_t)((uint64_t)cycles * 1000 / outputs));
+    }
 
     snrt_global_barrier();
 
-    uint32_t error = check_layer(&maxpool_l, (double*)maxpool_checksum);
+    errors += check_layer(l, checksum);
 
     snrt_global_barrier();
 
-    return error;
+    return errors;
+}
+
+int main() {
+    maxpool_l.ifmap = (double*)maxpool_ifmap_dram;
+    maxpool_l.ofmap = (double*)maxpool_ofmap_dram;
+    // Tiles of the same size in bytes for all precisions
+    maxpool_l.TILE_CI = min(256 / maxpool_l.dtype, maxpool_l.CI);
+
+    conv_layer avg_l = maxpool_l;
+    avg_l.ofmap = (double*)maxpool_avg_ofmap_dram;
+
+    // The global pooling writes a single output pixel
+    conv_layer global_l = maxpool_l;
+    global_l.ofmap = (double*)maxpool_global_ofmap_dram;
+    global_l.OH = global_l.OW = 1;
+
+    uint32_t errors = benchmark("MaxPool", maxpool_layer, &maxpool_l,
+                                (double*)maxpool_checksum);
+    if (maxpool_l.dtype != FP8) {
+        errors += benchmark("AvgPool", avgpool_layer, &avg_l,
+                            (double*)maxpool_avg_checksum);
+        errors += benchmark("GlobalAvgPool", global_avgpool_layer, &global_l,
+                            (double*)maxpool_global_checksum);
+    }
+
+    return errors;
 }
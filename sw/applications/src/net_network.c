@@ -0,0 +1,44 @@
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+// SW testbench for running a whole network with the graph runtime. The nodes,
+// their tiling and the placement of the tensors are generated offline from a
+// torch model by `data_gen.py`. Reports the cycles of every node, the total
+// cycles and the peak memory usage, and automatically checks the correctness
+// of the output of the network
+
+#include "data_network.h"
+#include "graph.h"
+#include "layer.h"
+#include "printf.h"
+#include "snrt.h"
+#include "utils.h"
+
+int main() {
+    uint32_t cycles[sizeof(network_nodes) / sizeof(network_nodes[0])];
+
+    snrt_global_barrier();
+    uint32_t errors = graph_run(&network_graph, cycles);
+
+    if (snrt_global_core_idx() == 0) {
+        uint32_t total = 0;
+        for (uint32_t n = 0; n < network_graph.num_nodes; n++) {
+            printf("%s: %d cycles\n", network_nodes[n].name, cycles[n]);
+            total += cycles[n];
+        }
+        printf("Total: %d cycles\n", total);
+        printf("Peak memory: %d bytes L3 arena, %d bytes TCDM\n",
+               network_graph.l3_size, network_graph.l1_peak);
+    }
+
+    snrt_global_barrier();
+
+    network_out_l.ofmap =
+        graph_tensor_ptr(&network_graph, network_graph.output);
+    errors += check_layer(&network_out_l, (double *)network_checksum);
+
+    snrt_global_barrier();
+
+    return errors;
+}
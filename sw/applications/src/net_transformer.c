@@ -0,0 +1,82 @@
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+// SW testbench for profiling the transformer layers: softmax, layer
+// normalization and GELU over the rows of the input, and the fused attention
+// of the queries to the keys and values. Reports the cycles per thousand
+// output elements of each, and checks the results element-wise against the
+// references of the torch modules with the parallel verification
+
+#include "data_transformer.h"
+#include "layer.h"
+#include "perf_cnt.h"
+#include "printf.h"
+#include "snrt.h"
+#include "transformer_layer.h"
+#include "utils.h"
+#include "verify.h"
+
+// The exponentials are approximated with a relative error of about 1e-13,
+// outputs close to zero are allowed an absolute error instead
+#define TOLERANCE_ULPS (1 << 16)
+#define TOLERANCE 1e-9
+
+static uint32_t benchmark(const char *name,
+                          uint32_t (*layer)(const transformer_layer *),
+                          const transformer_layer *l, const double *ref) {
+    // Clear the results of the previous run
+    if (snrt_global_core_idx() == 0) {
+        snrt_memset(transformer_result, 0, sizeof(transformer_result));
+    }
+
+    snrt_global_barrier();
+    if (snrt_global_core_idx() == 0) {
+        snrt_reset_perf_counter(SNRT_PERF_CNT0);
+        snrt_start_perf_counter(SNRT_PERF_CNT0, SNRT_PERF_CNT_CYCLES, 0);
+    }
+
+    uint32_t errors = layer(l);
+
+    snrt_global_barrier();
+    if (snrt_global_core_idx() == 0) {
+        snrt_stop_perf_counter(SNRT_PERF_CNT0);
+        uint32_t cycles = snrt_get_perf_counter(SNRT_PERF_CNT0);
+        uint32_t outputs = l->S * l->E;
+        printf("FP%d %s: %d cycles, %d cycles per 1000 outputs\n",
+               8 * l->dtype, name, cycles,
+               (uint32_t)((uint64_t)cycles * 1000 / outputs));
+    }
+
+    const verify_result r = verify_ulp(l->ofmap, ref, l->dtype, l->S * l->E,
+                                       TOLERANCE_ULPS, TOLERANCE);
+    if (snrt_global_core_idx() == 0) {
+        printf("Max error: %d ULPs, %d/%d errors\n", (uint32_t)r.max_error,
+               r.errors, r.checked);
+    }
+
+    return errors + r.errors;
+}
+
+int main() {
+    transformer_l.ifmap = (double *)transformer_ifmap_dram;
+    transformer_l.ofmap = (double *)transformer_result;
+    transformer_l.gamma = transformer_gamma_dram;
+    transformer_l.beta = transformer_beta_dram;
+
+    transformer_layer attention_l = transformer_l;
+    attention_l.ifmap = (double *)transformer_q_dram;
+    attention_l.K = (double *)transformer_k_dram;
+    attention_l.V = (double *)transformer_v_dram;
+
+    uint32_t errors = benchmark("Softmax", softmax_layer, &transformer_l,
+                                (double *)transformer_softmax_dram);
+    errors += benchmark("LayerNorm", layernorm_layer, &transformer_l,
+                        (double *)transformer_layernorm_dram);
+    errors += benchmark("GELU", gelu_layer, &transformer_l,
+                        (double *)transformer_gelu_dram);
+    errors += benchmark("Attention", attention_layer, &attention_l,
+                        (double *)transformer_attention_dram);
+
+    return errors;
+}
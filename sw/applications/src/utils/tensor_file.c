@@ -0,0 +1,39 @@
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "tensor_file.h"
+
+#include <stdint.h>
+
+#include "layer.h"
+
+static uint32_t name_equal(const char *a, const char *b) {
+    for (uint32_t i = 0; i < TENSOR_FILE_NAME_LEN; i++) {
+        if (a[i] != b[i]) return 0;
+        if (!a[i]) return 1;
+    }
+    return 0;
+}
+
+uint32_t tensor_file_check(const void *file) {
+    const tensor_file_header *h = file;
+    return h->magic != TENSOR_FILE_MAGIC || h->version != TENSOR_FILE_VERSION;
+}
+
+const tensor_file_entry *tensor_file_find(const void *file, const char *name) {
+    if (tensor_file_check(file)) return 0;
+
+    const tensor_file_header *h = file;
+    const tensor_file_entry *e = (const tensor_file_entry *)(h + 1);
+    for (uint32_t i = 0; i < h->count; i++) {
+        if (name_equal(e[i].name, name)) return &e[i];
+    }
+    return 0;
+}
+
+void *tensor_file_data(const void *file, const char *name, precision_t dtype) {
+    const tensor_file_entry *e = tensor_file_find(file, name);
+    if (!e || e->dtype != dtype) return 0;
+    return (char *)file + e->offset;
+}
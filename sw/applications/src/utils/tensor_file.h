@@ -0,0 +1,127 @@
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <stdint.h>
+
+#include "layer.h"
+
+// Binary container of tensors, written by `data_gen.py --binary`. The file
+// starts with a tensor_file_header, followed by `count` tensor_file_entry
+// structs and the data of the tensors, each aligned to TENSOR_FILE_ALIGN
+// bytes from the start of the file. All fields are little endian.
+#define TENSOR_FILE_MAGIC 0x42544e53  // "SNTB"
+#define TENSOR_FILE_VERSION 1
+#define TENSOR_FILE_ALIGN 64
+#define TENSOR_FILE_NAME_LEN 48
+#define TENSOR_FILE_MAX_DIMS 4
+
+/**
+ * @struct tensor_file_header_struct
+ * @brief Header of a binary tensor container
+ * @var tensor_file_header_struct::magic
+ * TENSOR_FILE_MAGIC
+ * @var tensor_file_header_struct::version
+ * TENSOR_FILE_VERSION
+ * @var tensor_file_header_struct::count
+ * Number of tensors
+ * @var tensor_file_header_struct::size
+ * Size of the whole container in bytes
+ */
+typedef struct tensor_file_header_struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t count;
+    uint32_t size;
+} tensor_file_header;
+
+/**
+ * @struct tensor_file_entry_struct
+ * @brief Description of a tensor in a binary tensor container
+ * @var tensor_file_entry_struct::name
+ * Zero terminated name, the C symbol of the tensor
+ * @var tensor_file_entry_struct::dtype
+ * Size of the elements in bytes, FP8 elements are E5M2 numbers
+ * @var tensor_file_entry_struct::ndim
+ * Number of dimensions
+ * @var tensor_file_entry_struct::shape
+ * Dimensions, outermost first, unused dimensions are 1
+ * @var tensor_file_entry_struct::offset
+ * Offset of the data from the start of the container in bytes
+ * @var tensor_file_entry_struct::size
+ * Size of the data in bytes
+ */
+typedef struct tensor_file_entry_struct {
+    char name[TENSOR_FILE_NAME_LEN];
+    uint32_t dtype;
+    uint32_t ndim;
+    uint32_t shape[TENSOR_FILE_MAX_DIMS];
+    uint64_t offset;
+    uint64_t size;
+} tensor_file_entry;
+
+/**
+ * @brief links the container at `path` into the data section and declares it
+ * as `sym`, to be used at file scope. The path is resolved by the assembler,
+ * relative paths through its include search path (`-Wa,-I`).
+ */
+#define TENSOR_FILE_INCBIN(sym, path)                       \
+    extern char sym[];                                      \
+    asm(".pushsection .data\n"                              \
+        ".balign " TENSOR_FILE_STR(TENSOR_FILE_ALIGN) "\n"  \
+        ".global " #sym "\n" #sym ":\n"                     \
+        ".incbin \"" path "\"\n"                            \
+        ".popsection\n")
+
+/**
+ * @brief defines the symbol `name` of a tensor at `offset` bytes within the
+ * container `sym`, to be used at file scope. The symbol is declared in C with
+ * the type of the tensor.
+ */
+#define TENSOR_FILE_SYMBOL(sym, name, offset) \
+    asm(".global " #name "\n.set " #name ", " #sym " + " #offset "\n")
+
+#define TENSOR_FILE_STR(x) TENSOR_FILE_STR_(x)
+#define TENSOR_FILE_STR_(x) #x
+
+/**
+ * @brief checks the header of a binary tensor container
+ *
+ * @param file pointer to the container, linked or loaded into memory
+ * @return uint32_t 0 if the container is valid, 1 otherwise
+ */
+uint32_t tensor_file_check(const void *file);
+
+/**
+ * @brief looks up a tensor of a binary tensor container by name
+ *
+ * @param file pointer to the container, linked or loaded into memory
+ * @param name name of the tensor
+ * @return const tensor_file_entry* description of the tensor, NULL if the
+ * container does not hold a tensor of this name
+ */
+const tensor_file_entry *tensor_file_find(const void *file, const char *name);
+
+/**
+ * @brief returns the data of a tensor of a binary tensor container, which is
+ * not copied
+ *
+ * @param file pointer to the container, linked or loaded into memory
+ * @param name name of the tensor
+ * @param dtype expected precision of the tensor
+ * @return void* pointer to the data, NULL if the container does not hold a
+ * tensor of this name and precision
+ */
+void *tensor_file_data(const void *file, const char *name, precision_t dtype);
+
+// Typed accessors of tensor_file_data
+#define tensor_file_fp64(file, name) \
+    ((double *)tensor_file_data(file, name, FP64))
+#define tensor_file_fp32(file, name) \
+    ((float *)tensor_file_data(file, name, FP32))
+#define tensor_file_fp16(file, name) \
+    ((__fp16 *)tensor_file_data(file, name, FP16))
+#define tensor_file_fp8(file, name) \
+    ((char *)tensor_file_data(file, name, FP8))
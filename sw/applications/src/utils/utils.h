@@ -30,7 +30,9 @@ void snrt_dma_start_tracking();
 void snrt_dma_stop_tracking();
 
 /**
- * @brief checks correctness of feature map
+ * @brief checks correctness of feature map with the parallel verification,
+ * has to be called by all cores of all clusters. Outputs in a lower precision
+ * than FP64 are allowed a rounding error relative to their magnitude.
  *
  * @param l layer struct (Conv2d, BatchNorm, Maxpool)
  * @param checksum checksum to compare against, reduced over input channels
@@ -0,0 +1,335 @@
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "verify.h"
+
+#include <math.h>
+#include <stdint.h>
+
+#include "layer.h"
+#include "printf.h"
+#include "snrt.h"
+
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#define ceil_div(a, b) (((a) + (b)-1) / (b))
+
+// Results of the clusters, reduced in main memory. The maximum error is kept
+// as the bits of a positive float, which are ordered like the floats.
+static volatile uint32_t verify_errors;
+static volatile uint32_t verify_max_error;
+
+/**
+ * @struct verify_partial_struct
+ * @brief Result of a compute core, reduced in the TCDM
+ */
+typedef struct verify_partial_struct {
+    uint32_t errors;
+    double max_error;
+} verify_partial;
+
+/**
+ * @struct verify_job_struct
+ * @brief Parameters of a verification. `check` checks `count` units (rows
+ * or elements) starting at unit `first`, the chunks of the streams being in
+ * `buf`.
+ */
+typedef struct verify_job_struct {
+    const char *src[2];
+    uint32_t streams;
+    uint32_t units;
+    uint32_t unit_bytes;
+
+    precision_t dtype;
+    uint32_t cols;
+    const double *checksum;
+    double abs_tol;
+    double rel_tol;
+    uint32_t ulps;
+
+    void (*check)(const struct verify_job_struct *j, char *const *buf,
+                  uint32_t first, uint32_t count, verify_partial *p);
+} verify_job;
+
+// Element `i` of a buffer in precision `dtype` as a double. FP8 values are in
+// the E5M2 format, i.e. the upper byte of an FP16 value.
+static double elem(const void *buf, uint32_t i, precision_t dtype) {
+    switch (dtype) {
+        case FP64:
+            return ((const double *)buf)[i];
+        case FP32:
+            return ((const float *)buf)[i];
+        case FP16:
+            return ((const __fp16 *)buf)[i];
+        default: {
+            union {
+                uint16_t u;
+                __fp16 f;
+            } e5m2 = {.u = ((const uint8_t *)buf)[i] << 8};
+            return e5m2.f;
+        }
+    }
+}
+
+// Sum and sum of absolute values of a FP64 row. Every element is streamed
+// twice, to the sum and to the sign injection computing its absolute value,
+// and two elements are interleaved to hide the FPU latency.
+static void row_sum_fp64(const double *x, uint32_t n, double *sum,
+                         double *magnitude) {
+    const uint32_t n2 = n / 2 * 2;
+    register double s0 = 0.0, s1 = 0.0, m0 = 0.0, m1 = 0.0;
+    register const double one = 1.0;
+
+    if (n2) {
+        snrt_ssr_loop_1d(SNRT_SSR_DM0, n2, sizeof(double));
+        snrt_ssr_repeat(SNRT_SSR_DM0, 2);
+        snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_1D, (double *)x);
+        snrt_ssr_enable();
+        asm volatile(
+            "frep.o %[n_frep], 6, 0, 0 \n"
+            "fadd.d %[s0], ft0, %[s0] \n"
+            "fsgnj.d ft3, ft0, %[one] \n"
+            "fadd.d %[s1], ft0, %[s1] \n"
+            "fsgnj.d ft4, ft0, %[one] \n"
+            "fadd.d %[m0], ft3, %[m0] \n"
+            "fadd.d %[m1], ft4, %[m1] \n"
+            : [ s0 ] "+f"(s0), [ s1 ] "+f"(s1), [ m0 ] "+f"(m0),
+              [ m1 ] "+f"(m1)
+            : [ n_frep ] "r"(n2 / 2 - 1), [ one ] "f"(one)
+            : "ft0", "ft1", "ft2", "ft3", "ft4");
+        snrt_fpu_fence();
+        snrt_ssr_disable();
+        snrt_ssr_repeat(SNRT_SSR_DM0, 1);
+    }
+
+    for (uint32_t i = n2; i < n; i++) {
+        s0 += x[i];
+        m0 += fabs(x[i]);
+    }
+    *sum = s0 + s1;
+    *magnitude = m0 + m1;
+}
+
+// Every core checks every `compute_num`-th row of the chunk
+static void check_rows(const verify_job *j, char *const *buf, uint32_t first,
+                       uint32_t count, verify_partial *p) {
+    const uint32_t compute_num = snrt_cluster_compute_core_num();
+    const uint32_t compute_id = snrt_cluster_compute_core_idx();
+
+    for (uint32_t r = compute_id; r < count; r += compute_num) {
+        const char *row = buf[0] + r * j->unit_bytes;
+        double sum = 0.0, magnitude = 0.0;
+        if (j->dtype == FP64) {
+            row_sum_fp64((const double *)row, j->cols, &sum, &magnitude);
+        } else {
+            for (uint32_t c = 0; c < j->cols; c++) {
+                double y = elem(row, c, j->dtype);
+                sum += y;
+                magnitude += fabs(y);
+            }
+        }
+
+        const double error = fabs(sum - j->checksum[first + r]);
+        if (!(error <= j->abs_tol + j->rel_tol * magnitude)) p->errors++;
+        const double rel_error = error / (magnitude + 0.001);
+        if (rel_error > p->max_error) p->max_error = rel_error;
+    }
+}
+
+// Bits of element `i` of a buffer in precision `dtype`, mapped to integers
+// which are ordered like the values, such that their difference is the
+// distance in units in the last place
+static int64_t ordered_bits(const void *buf, uint32_t i, precision_t dtype) {
+    uint64_t bits, sign;
+    switch (dtype) {
+        case FP64:
+            bits = ((const uint64_t *)buf)[i];
+            sign = 1ull << 63;
+            break;
+        case FP32:
+            bits = ((const uint32_t *)buf)[i];
+            sign = 1ull << 31;
+            break;
+        case FP16:
+            bits = ((const uint16_t *)buf)[i];
+            sign = 1ull << 15;
+            break;
+        default:
+            bits = ((const uint8_t *)buf)[i];
+            sign = 1ull << 7;
+            break;
+    }
+    return bits & sign ? -(int64_t)(bits & ~sign) : (int64_t)bits;
+}
+
+// Every core checks a contiguous slice of the chunk
+static void check_elems(const verify_job *j, char *const *buf, uint32_t first,
+                        uint32_t count, verify_partial *p) {
+    const uint32_t compute_num = snrt_cluster_compute_core_num();
+    const uint32_t compute_id = snrt_cluster_compute_core_idx();
+    const uint32_t slice = ceil_div(count, compute_num);
+    const uint32_t start = min(compute_id * slice, count);
+    const uint32_t end = min(start + slice, count);
+
+    for (uint32_t i = start; i < end; i++) {
+        const int64_t a = ordered_bits(buf[0], i, j->dtype);
+        const int64_t b = ordered_bits(buf[1], i, j->dtype);
+        const uint64_t dist = a > b ? (uint64_t)a - b : (uint64_t)b - a;
+        if (fabs(elem(buf[0], i, j->dtype) - elem(buf[1], i, j->dtype)) <=
+            j->abs_tol) {
+            continue;
+        }
+        if (dist > j->ulps) p->errors++;
+        if ((double)dist > p->max_error) p->max_error = dist;
+    }
+}
+
+static verify_result verify(const verify_job *j) {
+    const uint32_t cluster_num = snrt_cluster_num();
+    const uint32_t cluster_id = snrt_cluster_idx();
+    const uint32_t compute_num = snrt_cluster_compute_core_num();
+    const uint32_t compute_id = snrt_cluster_compute_core_idx();
+
+    // partial[compute_num], followed by two buffers per stream
+    char *ptr = (char *)snrt_cluster_memory().start;
+    verify_partial *partial = (verify_partial *)ptr;
+    const uint32_t partial_bytes =
+        ceil_div(compute_num * sizeof(verify_partial), 64) * 64;
+    const uint32_t buf_bytes =
+        (snrt_slice_len(snrt_cluster_memory()) - partial_bytes) /
+        (2 * j->streams) / 64 * 64;
+    ptr += partial_bytes;
+    char *buf[2][2];
+    for (uint32_t b = 0; b < 2; b++) {
+        for (uint32_t s = 0; s < j->streams; s++) {
+            buf[b][s] = ptr + (b * j->streams + s) * buf_bytes;
+        }
+    }
+
+    verify_result result = {.errors = j->units, .checked = j->units};
+    const uint32_t chunk = buf_bytes / j->unit_bytes;
+    if (!chunk) {
+        if (snrt_global_core_idx() == 0) {
+            printf("Verification does not fit into TCDM\n");
+        }
+        result.max_error = INFINITY;
+        return result;
+    }
+
+    if (snrt_global_core_idx() == 0) {
+        verify_errors = 0;
+        verify_max_error = 0;
+    }
+    if (snrt_is_compute_core()) {
+        partial[compute_id].errors = 0;
+        partial[compute_id].max_error = 0.0;
+    }
+
+    snrt_global_barrier();
+
+    // Contiguous ranges of units per cluster
+    const uint32_t per_cluster = ceil_div(j->units, cluster_num);
+    const uint32_t first = min(cluster_id * per_cluster, j->units);
+    const uint32_t last = min(first + per_cluster, j->units);
+    const uint32_t chunks = ceil_div(last - first, chunk);
+
+    if (snrt_is_dm_core() && chunks) {
+        for (uint32_t s = 0; s < j->streams; s++) {
+            snrt_dma_start_1d(buf[0][s], j->src[s] + first * j->unit_bytes,
+                              min(chunk, last - first) * j->unit_bytes);
+        }
+    }
+
+    for (uint32_t k = 0; k < chunks; k++) {
+        const uint32_t u0 = first + k * chunk;
+        const uint32_t count = min(chunk, last - u0);
+
+        if (snrt_is_dm_core()) snrt_dma_wait_all();
+
+        snrt_cluster_hw_barrier();
+
+        if (snrt_is_dm_core()) {
+            // Prefetch the next chunk while the current one is checked
+            if (k + 1 < chunks) {
+                const uint32_t u1 = u0 + chunk;
+                for (uint32_t s = 0; s < j->streams; s++) {
+                    snrt_dma_start_1d(buf[!(k % 2)][s],
+                                      j->src[s] + u1 * j->unit_bytes,
+                                      min(chunk, last - u1) * j->unit_bytes);
+                }
+            }
+        } else {
+            j->check(j, buf[k % 2], u0, count, &partial[compute_id]);
+        }
+    }
+
+    snrt_cluster_hw_barrier();
+
+    // The first core reduces the results of the cluster
+    if (snrt_is_compute_core() && compute_id == 0 && chunks) {
+        uint32_t errors = 0;
+        double max_error = 0.0;
+        for (uint32_t c = 0; c < compute_num; c++) {
+            errors += partial[c].errors;
+            if (partial[c].max_error > max_error) {
+                max_error = partial[c].max_error;
+            }
+        }
+        __atomic_add_fetch(&verify_errors, errors, __ATOMIC_RELAXED);
+
+        union {
+            float f;
+            uint32_t u;
+        } bits = {.f = (float)max_error};
+        uint32_t old = verify_max_error;
+        while (bits.u > old &&
+               !__atomic_compare_exchange_n(&verify_max_error, &old, bits.u,
+                                            0, __ATOMIC_RELAXED,
+                                            __ATOMIC_RELAXED)) {
+        }
+    }
+
+    snrt_global_barrier();
+
+    union {
+        float f;
+        uint32_t u;
+    } bits = {.u = verify_max_error};
+    result.errors = verify_errors;
+    result.max_error = bits.f;
+
+    // The results are reset by the next verification
+    snrt_global_barrier();
+
+    return result;
+}
+
+verify_result verify_checksum(const void *data, precision_t dtype,
+                              uint32_t rows, uint32_t cols,
+                              const double *checksum, double abs_tol,
+                              double rel_tol) {
+    const verify_job j = {.src = {data},
+                          .streams = 1,
+                          .units = rows,
+                          .unit_bytes = cols * dtype,
+                          .dtype = dtype,
+                          .cols = cols,
+                          .checksum = checksum,
+                          .abs_tol = abs_tol,
+                          .rel_tol = rel_tol,
+                          .check = check_rows};
+    return verify(&j);
+}
+
+verify_result verify_ulp(const void *data, const void *ref, precision_t dtype,
+                         uint32_t n, uint32_t ulps, double abs_tol) {
+    const verify_job j = {.src = {data, ref},
+                          .streams = 2,
+                          .units = n,
+                          .unit_bytes = dtype,
+                          .dtype = dtype,
+                          .abs_tol = abs_tol,
+                          .ulps = ulps,
+                          .check = check_elems};
+    return verify(&j);
+}
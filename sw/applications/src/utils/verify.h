@@ -0,0 +1,70 @@
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <stdint.h>
+
+#include "layer.h"
+
+// Parallel verification of results in main memory. The data is split across
+// clusters, and the DM core of every cluster streams it through the TCDM in
+// double-buffered chunks while the compute cores check disjoint slices of
+// each chunk. The results of the cores are reduced in the TCDM, and the ones
+// of the clusters in main memory. All cores of all clusters have to call the
+// functions, which return the same result on every core.
+
+/**
+ * @struct verify_result_struct
+ * @brief Result of a verification
+ * @var verify_result_struct::errors
+ * Number of rows (checksum mode) or elements (ULP mode) out of tolerance
+ * @var verify_result_struct::checked
+ * Number of rows or elements checked
+ * @var verify_result_struct::max_error
+ * Maximum error of a row sum relative to the magnitude of the row (checksum
+ * mode), or maximum distance in units in the last place of the elements
+ * which are not within the absolute tolerance (ULP mode)
+ */
+typedef struct verify_result_struct {
+    uint32_t errors;
+    uint32_t checked;
+    double max_error;
+} verify_result;
+
+/**
+ * @brief checks the sums of the rows of a matrix against precomputed
+ * checksums. A row is correct if its sum is within abs_tol + rel_tol *
+ * magnitude of the checksum, the magnitude being the sum of the absolute
+ * values of the row. FP64 rows are reduced with SSR and FREP.
+ *
+ * @param data pointer to the rows x cols matrix in main memory
+ * @param dtype precision of the matrix
+ * @param rows number of rows
+ * @param cols number of columns, a row has to fit into half of the TCDM
+ * @param checksum pointer to the rows FP64 checksums
+ * @param abs_tol absolute tolerance
+ * @param rel_tol tolerance relative to the magnitude of a row
+ * @return verify_result
+ */
+verify_result verify_checksum(const void *data, precision_t dtype,
+                              uint32_t rows, uint32_t cols,
+                              const double *checksum, double abs_tol,
+                              double rel_tol);
+
+/**
+ * @brief checks a tensor element-wise against a reference of the same
+ * precision. An element is correct if it is at most `ulps` units in the last
+ * place of the precision away from the reference, or within abs_tol of it.
+ *
+ * @param data pointer to the n elements in main memory
+ * @param ref pointer to the n reference elements in main memory
+ * @param dtype precision of data and ref, FP8 elements are E5M2 numbers
+ * @param n number of elements
+ * @param ulps tolerance in units in the last place
+ * @param abs_tol absolute tolerance, e.g. for results close to zero
+ * @return verify_result
+ */
+verify_result verify_ulp(const void *data, const void *ref, precision_t dtype,
+                         uint32_t n, uint32_t ulps, double abs_tol);
@@ -0,0 +1,124 @@
+#!/usr/bin/env python3
+# Copyright 2020 ETH Zurich and University of Bologna.
+# Licensed under the Apache License, Version 2.0, see LICENSE for details.
+# SPDX-License-Identifier: Apache-2.0
+
+# Collects the `GEMM_TUNE` lines printed by the GEMM testbench in tuning mode
+# (built with `-DSNITCH_GEMM_TUNE=ON`) and emits the fastest tiling of every
+# problem into `include/gemm_tiling_lut.h`. Entries of problems that were not
+# measured again are kept.
+
+import argparse
+import pathlib
+import re
+import sys
+
+LUT_FILE = pathlib.Path(__file__).parent / 'include' / 'gemm_tiling_lut.h'
+
+HEADER = """\
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+// Tuned GEMM tilings, generated by `tune_gemm.py` from the output of the GEMM
+// testbench in tuning mode. Problems without an entry use the cost model.
+// Format: {M, N, K, dtype, TA, TB, clusters, cores, {TILE_M, TILE_N, TILE_K,
+// PAD, UNROLL}},
+
+#pragma once
+
+"""
+
+DTYPES = {8: 'FP64', 4: 'FP32', 2: 'FP16', 1: 'FP8'}
+
+# M, N, K, dtype, TA, TB, clusters, cores, TILE_M, TILE_N, TILE_K, PAD,
+# UNROLL, estimated cycles, measured cycles
+TUNE_RE = re.compile(r'GEMM_TUNE((?:\s+\d+){15})')
+ENTRY_RE = re.compile(
+    r'\{(\d+), (\d+), (\d+), FP(\d+), (\d+), (\d+), (\d+), (\d+), '
+    r'\{(\d+), (\d+), (\d+), (\d+), (\d+)\}\}')
+
+
+def parse_runs(lines):
+    """Return the fastest measured tiling per problem."""
+    best = {}
+    for line in lines:
+        m = TUNE_RE.search(line)
+        if not m:
+            continue
+        fields = [int(f) for f in m.group(1).split()]
+        key, tiling, cycles = tuple(fields[:8]), tuple(fields[8:13]), fields[14]
+        if key not in best or cycles < best[key][1]:
+            best[key] = (tiling, cycles)
+    return best
+
+
+def parse_lut(path):
+    """Return the tilings of an existing LUT header."""
+    lut = {}
+    if not path.exists():
+        return lut
+    for m in ENTRY_RE.finditer(path.read_text()):
+        fields = [int(f) for f in m.groups()]
+        fields[3] //= 8
+        lut[tuple(fields[:8])] = tuple(fields[8:])
+    return lut
+
+
+def emit_lut(lut):
+    out = HEADER
+    out += '#define GEMM_TILING_LUT_ENTRIES'
+    for key in sorted(lut):
+        m, n, k, dtype, ta, tb, clusters, cores = key
+        out += ' \\\n    {{{}, {}, {}, {}, {}, {}, {}, {}, {{{}, {}, {}, {}, {}}}}},'.format(
+            m, n, k, DTYPES[dtype], ta, tb, clusters, cores, *lut[key])
+    return out + '\n'
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Generate the GEMM tiling LUT')
+    parser.add_argument(
+        'logs',
+        type=pathlib.Path,
+        nargs='*',
+        help='Output of the tuning runs (default: stdin)'
+    )
+    parser.add_argument(
+        '-o',
+        '--output',
+        type=pathlib.Path,
+        default=LUT_FILE,
+        help='LUT header to update'
+    )
+    parser.add_argument(
+        '-v',
+        '--verbose',
+        action='store_true',
+        help='Print the fastest tiling and its measured cycles for every problem'
+    )
+    args = parser.parse_args()
+
+    lines = []
+    if args.logs:
+        for log in args.logs:
+            lines += log.read_text().splitlines()
+    else:
+        lines = sys.stdin.read().splitlines()
+
+    best = parse_runs(lines)
+    if not best:
+        print('No GEMM_TUNE lines found', file=sys.stderr)
+        return 1
+
+    lut = parse_lut(args.output)
+    for key, (tiling, cycles) in best.items():
+        lut[key] = tiling
+        if args.verbose:
+            print('{}: {} in {} cycles'.format(key, tiling, cycles))
+
+    args.output.write_text(emit_lut(lut))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
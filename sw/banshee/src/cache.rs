@@ -0,0 +1,148 @@
+// Copyright 2021 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+//! On-disk cache of translated binaries
+//!
+//! Translating and optimizing a binary takes a large share of the startup
+//! time, which test suites running the same binary over and over pay every
+//! time. The optimized module of each cluster is therefore stored as bitcode
+//! in a cache directory, under a key covering everything the translation
+//! depends on: the loaded sections of the binary, the banshee executable and
+//! runtime, the configuration, the options affecting the translation
+//! including those passed to LLVM, and the host CPU. Later runs parse the
+//! bitcode instead of translating again.
+
+use crate::engine::Engine;
+use llvm_sys::{bit_reader::*, bit_writer::*, core::*, prelude::*, target_machine::*};
+use std::{
+    collections::hash_map::DefaultHasher,
+    ffi::{CStr, CString},
+    hash::{Hash, Hasher},
+    path::PathBuf,
+};
+
+/// The cached translations of a binary.
+pub struct TranslationCache {
+    dir: PathBuf,
+    key: u64,
+}
+
+impl TranslationCache {
+    /// Compute the cache key of a binary translated by an engine.
+    pub fn new(dir: PathBuf, engine: &Engine, elf: &elf::File) -> Self {
+        let mut h = DefaultHasher::new();
+
+        // The translator and runtime
+        env!("CARGO_PKG_VERSION").hash(&mut h);
+        if let Ok(meta) = std::env::current_exe().and_then(std::fs::metadata) {
+            meta.len().hash(&mut h);
+            meta.modified().ok().hash(&mut h);
+        }
+        crate::runtime::JIT_INITIAL.hash(&mut h);
+        crate::runtime::JIT_GENERATED.hash(&mut h);
+
+        // The configuration; a JSON value sorts the instruction latencies
+        serde_json::to_value(&engine.config)
+            .map(|v| v.to_string())
+            .unwrap_or_default()
+            .hash(&mut h);
+        (
+            engine.num_clusters,
+            engine.num_cores,
+            engine.base_hartid,
+            engine.opt_llvm,
+            engine.interrupt,
+            engine.latency,
+            engine.trace,
+        )
+            .hash(&mut h);
+        engine.llvm_args.hash(&mut h);
+
+        // The host the IR is optimized for
+        unsafe {
+            for s in [LLVMGetHostCPUName(), LLVMGetHostCPUFeatures()] {
+                CStr::from_ptr(s).to_bytes().hash(&mut h);
+                LLVMDisposeMessage(s);
+            }
+        }
+
+        // The binary
+        for section in &elf.sections {
+            section.shdr.name.hash(&mut h);
+            section.shdr.addr.hash(&mut h);
+            section.shdr.flags.0.hash(&mut h);
+            section.data.hash(&mut h);
+        }
+
+        let key = h.finish();
+        debug!("Translation cache key {:016x}", key);
+        Self { dir, key }
+    }
+
+    fn path(&self, cluster: usize) -> PathBuf {
+        self.dir.join(format!("{:016x}-{}.bc", self.key, cluster))
+    }
+
+    /// Load the translation of a cluster into a context, if cached.
+    pub unsafe fn load(&self, context: LLVMContextRef, cluster: usize) -> Option<LLVMModuleRef> {
+        let path = self.path(cluster);
+        if !path.exists() {
+            return None;
+        }
+        let cpath = CString::new(path.to_str()?).ok()?;
+        let mut buf = std::ptr::null_mut();
+        let mut errmsg = std::ptr::null_mut();
+        if LLVMCreateMemoryBufferWithContentsOfFile(cpath.as_ptr(), &mut buf, &mut errmsg) != 0 {
+            warn!(
+                "Cannot read cached translation {}: {:?}",
+                path.display(),
+                CStr::from_ptr(errmsg)
+            );
+            LLVMDisposeMessage(errmsg);
+            return None;
+        }
+        let mut module = std::ptr::null_mut();
+        let failed = LLVMParseBitcodeInContext2(context, buf, &mut module) != 0;
+        LLVMDisposeMemoryBuffer(buf);
+        if failed {
+            warn!("Cannot parse cached translation {}", path.display());
+            return None;
+        }
+        debug!("Loaded cached translation {}", path.display());
+        Some(module)
+    }
+
+    /// Store the translation of a cluster.
+    ///
+    /// The bitcode is written to a temporary file first and then renamed, such
+    /// that concurrent runs never see a partially written translation.
+    pub unsafe fn store(&self, module: LLVMModuleRef, cluster: usize) {
+        if let Err(e) = std::fs::create_dir_all(&self.dir) {
+            warn!(
+                "Cannot create cache directory {}: {}",
+                self.dir.display(),
+                e
+            );
+            return;
+        }
+        let path = self.path(cluster);
+        let tmp = path.with_extension(format!("{}.tmp", std::process::id()));
+        let ctmp = match tmp.to_str().and_then(|s| CString::new(s).ok()) {
+            Some(s) => s,
+            None => return,
+        };
+        if LLVMWriteBitcodeToFile(module, ctmp.as_ptr()) != 0 {
+            warn!("Cannot write cached translation {}", tmp.display());
+            let _ = std::fs::remove_file(&tmp);
+            return;
+        }
+        match std::fs::rename(&tmp, &path) {
+            Ok(()) => debug!("Stored translation in {}", path.display()),
+            Err(e) => {
+                warn!("Cannot store translation in {}: {}", path.display(), e);
+                let _ = std::fs::remove_file(&tmp);
+            }
+        }
+    }
+}
@@ -26,6 +26,8 @@ pub struct Configuration {
     pub ssr: Ssr,
     #[serde(default)]
     pub interrupt_latency: u32,
+    #[serde(default)]
+    pub dma: Dma,
 }
 
 impl Default for Configuration {
@@ -38,6 +40,7 @@ impl Default for Configuration {
             inst_latency: Default::default(),
             ssr: Default::default(),
             interrupt_latency: 10,
+            dma: Default::default(),
         }
     }
 }
@@ -58,6 +61,7 @@ impl Configuration {
             inst_latency: Default::default(),
             ssr: Default::default(),
             interrupt_latency: 10,
+            dma: Default::default(),
         }
     }
     /// Parse a json/yaml file into a `Configuration` struct
@@ -242,6 +246,24 @@ impl Default for Ssr {
     }
 }
 
+/// Struct to configure the DMA timing model
+#[derive(Debug, serde::Serialize, serde::Deserialize)]
+pub struct Dma {
+    /// Bytes moved per cycle; zero completes transfers immediately
+    pub bandwidth: u32,
+    /// Cycles from issuing a transfer until its first bytes move
+    pub latency: u32,
+}
+
+impl Default for Dma {
+    fn default() -> Dma {
+        Dma {
+            bandwidth: 0,
+            latency: 0,
+        }
+    }
+}
+
 /// Description of the hierarchy
 #[derive(Debug, serde::Serialize, serde::Deserialize, Clone)]
 pub struct Architecture {
@@ -0,0 +1,179 @@
+// Copyright 2021 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+//! Global memory shared by all harts
+//!
+//! The DRAM ranges of the configuration are backed by flat arrays of atomic
+//! words, which all harts access concurrently without taking a lock. The
+//! arrays are allocated zeroed, which the system allocator serves with fresh
+//! pages from the OS for sizes like these; the pages are only committed on
+//! first touch, so a large but sparsely used DRAM costs little memory. Any
+//! other address is kept in a hash map behind a lock.
+
+use std::{
+    alloc::{alloc_zeroed, dealloc, Layout},
+    collections::HashMap,
+    sync::{
+        atomic::{AtomicU32, Ordering},
+        Mutex,
+    },
+};
+
+/// A flat range of memory.
+struct Region {
+    start: u32,
+    end: u32,
+    words: *mut AtomicU32,
+    layout: Layout,
+}
+
+// SAFETY: The words of a region are only ever accessed atomically.
+unsafe impl Send for Region {}
+unsafe impl Sync for Region {}
+
+impl Region {
+    /// Allocate a region for the word-aligned range `[start, end)`.
+    fn new(start: u32, end: u32) -> Option<Self> {
+        let num_words = ((end as u64 - start as u64) / 4) as usize;
+        let layout = Layout::array::<AtomicU32>(num_words).ok()?;
+        if layout.size() == 0 {
+            return None;
+        }
+        let words = unsafe { alloc_zeroed(layout) } as *mut AtomicU32;
+        if words.is_null() {
+            return None;
+        }
+        Some(Self {
+            start,
+            end,
+            words,
+            layout,
+        })
+    }
+
+    fn contains(&self, addr: u32) -> bool {
+        addr >= self.start && addr < self.end
+    }
+
+    fn word(&self, addr: u32) -> &AtomicU32 {
+        unsafe { &*self.words.add(((addr - self.start) / 4) as usize) }
+    }
+}
+
+impl Drop for Region {
+    fn drop(&mut self) {
+        unsafe { dealloc(self.words as *mut u8, self.layout) }
+    }
+}
+
+/// The memory outside of the TCDMs and peripherals.
+#[derive(Default)]
+pub struct Dram {
+    /// The flat regions, sorted by address.
+    regions: Vec<Region>,
+    /// The words of all other addresses.
+    fallback: Mutex<HashMap<u64, u32>>,
+}
+
+impl Dram {
+    /// Back a range of addresses by a flat region.
+    ///
+    /// Ranges overlapping a previously mapped one are merged with it. Must be
+    /// called before anything is stored to the range.
+    pub fn map(&mut self, start: u32, end: u32) {
+        let mut start = start & !3;
+        let mut end = ((end as u64 + 3) & !3).min(u32::MAX as u64 & !3) as u32;
+        let mut i = 0;
+        while i < self.regions.len() {
+            let r = &self.regions[i];
+            if r.start <= end && start <= r.end {
+                start = start.min(r.start);
+                end = end.max(r.end);
+                self.regions.remove(i);
+            } else {
+                i += 1;
+            }
+        }
+        match Region::new(start, end) {
+            Some(region) => {
+                debug!("Mapping DRAM 0x{:08x}..0x{:08x}", start, end);
+                let pos = self
+                    .regions
+                    .iter()
+                    .position(|r| r.start > start)
+                    .unwrap_or(self.regions.len());
+                self.regions.insert(pos, region);
+            }
+            None => warn!(
+                "Cannot allocate DRAM 0x{:08x}..0x{:08x}; falling back to a hash map",
+                start, end
+            ),
+        }
+    }
+
+    fn region(&self, addr: u32) -> Option<&Region> {
+        self.regions.iter().find(|r| r.contains(addr))
+    }
+
+    /// Get the `len` words starting at a word-aligned address, if they all lie
+    /// in the same flat region.
+    pub fn words(&self, addr: u32, len: usize) -> Option<&[AtomicU32]> {
+        let r = self.region(addr)?;
+        if (r.end as u64 - addr as u64) / 4 < len as u64 {
+            return None;
+        }
+        Some(unsafe { std::slice::from_raw_parts(r.word(addr), len) })
+    }
+
+    /// Load the word at a word-aligned address.
+    pub fn load(&self, addr: u32) -> u32 {
+        match self.region(addr) {
+            Some(r) => r.word(addr).load(Ordering::Acquire),
+            None => self
+                .fallback
+                .lock()
+                .unwrap()
+                .get(&(addr as u64))
+                .copied()
+                .unwrap_or(0),
+        }
+    }
+
+    /// Store the bits of `value` selected by `mask` to a word-aligned address.
+    pub fn store(&self, addr: u32, value: u32, mask: u32) {
+        match self.region(addr) {
+            Some(r) if mask == u32::MAX => r.word(addr).store(value, Ordering::Release),
+            Some(r) => {
+                r.word(addr)
+                    .fetch_update(Ordering::AcqRel, Ordering::Acquire, |word| {
+                        Some((word & !mask) | (value & mask))
+                    })
+                    .unwrap();
+            }
+            None => {
+                let mut data = self.fallback.lock().unwrap();
+                let data = data.entry(addr as u64).or_default();
+                *data &= !mask;
+                *data |= value & mask;
+            }
+        }
+    }
+
+    /// Atomically replace the word at a word-aligned address by `f` applied to
+    /// it, unless `f` returns `None`. Returns the previous word on success.
+    pub fn update(&self, addr: u32, mut f: impl FnMut(u32) -> Option<u32>) -> Result<u32, u32> {
+        match self.region(addr) {
+            Some(r) => r
+                .word(addr)
+                .fetch_update(Ordering::SeqCst, Ordering::SeqCst, f),
+            None => {
+                let mut data = self.fallback.lock().unwrap();
+                let prev = data.get(&(addr as u64)).copied().unwrap_or(0);
+                let next = f(prev).ok_or(prev)?;
+                data.insert(addr as u64, next);
+                Ok(prev)
+            }
+        }
+    }
+}
@@ -5,7 +5,15 @@
 //! Engine for dynamic binary translation and execution
 
 use crate::{
-    bootroms::Bootroms, peripherals::Peripherals, riscv, tran::ElfTranslator, util::SiUnit,
+    bootroms::Bootroms,
+    cache::TranslationCache,
+    dram::Dram,
+    pages::{Page, PageTable},
+    peripherals::Peripherals,
+    riscv,
+    sched::{Scheduler, QUANTUM},
+    tran::ElfTranslator,
+    util::SiUnit,
     Configuration,
 };
 extern crate flexfloat;
@@ -18,6 +26,7 @@ use llvm_sys::{
 };
 use std::{
     collections::HashMap,
+    path::PathBuf,
     sync::{
         atomic::{AtomicBool, AtomicU32, AtomicUsize, Ordering},
         Mutex,
@@ -33,6 +42,13 @@ pub struct Engine {
     pub context: LLVMContextRef,
     /// The LLVM modules which contains the translated code for each cluster.
     pub modules: Vec<LLVMModuleRef>,
+    /// The cluster whose module each cluster executes. Clusters translated
+    /// alike share the module of the first of them.
+    pub module_of: Vec<usize>,
+    /// The directory caching translated binaries, if any.
+    pub cache_dir: Option<PathBuf>,
+    /// The command line options passed to LLVM.
+    pub llvm_args: Vec<String>,
     /// The exit code set by the binary.
     pub exit_code: AtomicU32,
     /// Whether an error occurred during execution.
@@ -53,17 +69,24 @@ pub struct Engine {
     pub num_cores: usize,
     /// The number of clusters.
     pub num_clusters: usize,
+    /// The number of harts executing at the same time, or zero for one per
+    /// host core.
+    pub workers: usize,
     /// The system configuration.
     pub config: Configuration,
     // pub config: Configuration,
     /// The global memory.
-    pub memory: Mutex<HashMap<u64, u32>>,
+    pub memory: Dram,
+    /// The memory backing each page of the address space.
+    pub pages: PageTable,
     /// The per-core putchar buffers (per hartid).
     pub putchar_buffer: Mutex<HashMap<usize, Vec<u8>>>,
     /// The peripherals for each cluster
     peripherals: Peripherals,
     /// The bootrom
     bootrom: Bootroms,
+    /// The scheduler of the harts onto host threads
+    scheduler: Scheduler,
 }
 
 // SAFETY: This is safe because only `context` and `module`
@@ -77,6 +100,9 @@ impl Engine {
         Self {
             context,
             modules: Default::default(),
+            module_of: Default::default(),
+            cache_dir: None,
+            llvm_args: Default::default(),
             exit_code: Default::default(),
             had_error: Default::default(),
             opt_llvm: true,
@@ -87,17 +113,54 @@ impl Engine {
             base_hartid: 0,
             num_cores: 1,
             num_clusters: 1,
+            workers: 0,
             config: Default::default(),
             memory: Default::default(),
+            pages: Default::default(),
             putchar_buffer: Default::default(),
             peripherals: Peripherals::new(),
             bootrom: Bootroms::new(),
+            scheduler: Default::default(),
         }
     }
 
+    /// Describe everything the translation of a cluster depends on beyond the
+    /// options common to all clusters.
+    fn translation_key(&self, cluster: usize) -> String {
+        let m = &self.config.memory;
+        let ext_tcdm: Vec<_> = m[cluster]
+            .ext_tcdm
+            .iter()
+            .map(|x| (x.cluster, x.start, &m[x.cluster as usize].tcdm))
+            .collect();
+        format!("{:?} {:?} {:?}", m[cluster].tcdm, m[cluster].dram, ext_tcdm)
+    }
+
+    /// Get the clusters which own a module, i.e. are translated.
+    fn translated_clusters(&self) -> impl Iterator<Item = usize> + '_ {
+        (0..self.num_clusters).filter(move |&i| self.module_of[i] == i)
+    }
+
     /// Create a Module for each cluster
+    ///
+    /// Clusters translated alike share a single module.
     pub fn create_modules(&mut self) {
+        let keys: Vec<_> = (0..self.num_clusters)
+            .map(|i| self.translation_key(i))
+            .collect();
+        self.module_of = (0..self.num_clusters)
+            .map(|i| keys.iter().position(|k| *k == keys[i]).unwrap())
+            .collect();
+        debug!(
+            "Translating {} modules for {} clusters",
+            self.translated_clusters().count(),
+            self.num_clusters
+        );
         for i in 0..self.num_clusters {
+            if self.module_of[i] != i {
+                self.modules.push(self.modules[self.module_of[i]]);
+                continue;
+            }
             let module = unsafe {
                 // Wrap the runtime IR up in an LLVM memory buffer.
                 let mut initial_ir = crate::runtime::JIT_INITIAL
@@ -134,9 +197,34 @@ impl Engine {
         }
     }
 
-    /// Translate an ELF binary.
-    pub fn translate_elf(&self, elf: &elf::File) -> Result<()> {
-        for i in 0..self.num_clusters {
+    /// Translate an ELF binary, or load its translation from the cache.
+    pub fn translate_elf(&mut self, elf: &elf::File) -> Result<()> {
+        let cache = self
+            .cache_dir
+            .clone()
+            .map(|dir| TranslationCache::new(dir, self, elf));
+
+        // Replace the modules of the clusters with a cached translation.
+        let mut cached = vec![false; self.num_clusters];
+        if let Some(cache) = &cache {
+            for i in self.translated_clusters().collect::<Vec<_>>() {
+                if let Some(module) = unsafe { cache.load(self.context, i) } {
+                    unsafe { LLVMDisposeModule(self.modules[i]) };
+                    for j in 0..self.num_clusters {
+                        if self.module_of[j] == i {
+                            self.modules[j] = module;
+                        }
+                    }
+                    cached[i] = true;
+                }
+            }
+        }
+        let pending: Vec<_> = self.translated_clusters().filter(|&i| !cached[i]).collect();
+        if pending.is_empty() {
+            info!("Loaded translation from the cache");
+        }
+
+        for &i in &pending {
             let mut tran = ElfTranslator::new(elf, self, i);
 
             // Dump the contents of the binary.
@@ -212,41 +300,39 @@ impl Engine {
 
         // Optimize the translation.
         if self.opt_llvm {
-            unsafe { self.optimize() };
+            unsafe { self.optimize(&pending) };
+        }
+
+        // Store the translation for later runs.
+        if let Some(cache) = &cache {
+            for &i in &pending {
+                unsafe { cache.store(self.modules[i], i) };
+            }
         }
 
         // Copy the executable sections into memory.
-        {
-            let mut mem = self.memory.lock().unwrap();
-            for section in &elf.sections {
-                if (section.shdr.flags.0 & elf::types::SHF_ALLOC.0) == 0 {
-                    continue;
-                }
-                use byteorder::{LittleEndian, ReadBytesExt};
-                trace!("Preloading ELF section `{}`", section.shdr.name);
-                mem.extend(
-                    section
-                        .data
-                        .chunks(4)
-                        .enumerate()
-                        .map(|(offset, mut value)| {
-                            let addr = section.shdr.addr + offset as u64 * 4;
-                            let value = value.read_u32::<LittleEndian>().unwrap_or(0);
-                            trace!("  - 0x{:x} = 0x{:x}", addr, value);
-                            (addr, value)
-                        }),
-                );
+        for section in &elf.sections {
+            if (section.shdr.flags.0 & elf::types::SHF_ALLOC.0) == 0 {
+                continue;
+            }
+            use byteorder::{LittleEndian, ReadBytesExt};
+            trace!("Preloading ELF section `{}`", section.shdr.name);
+            for (offset, mut value) in section.data.chunks(4).enumerate() {
+                let addr = section.shdr.addr + offset as u64 * 4;
+                let value = value.read_u32::<LittleEndian>().unwrap_or(0);
+                trace!("  - 0x{:x} = 0x{:x}", addr, value);
+                self.memory.store(addr as u32, value, u32::max_value());
             }
         }
 
         Ok(())
     }
 
-    unsafe fn optimize(&self) {
+    unsafe fn optimize(&self, clusters: &[usize]) {
         debug!("Optimizing IR");
 
         // Create the pass managers.
-        for i in 0..self.num_clusters {
+        for &i in clusters {
             let func_passes = LLVMCreateFunctionPassManagerForModule(self.modules[i]);
             let module_passes = LLVMCreatePassManager();
 
@@ -318,6 +404,19 @@ impl Engine {
         })
     }
 
+    pub fn init_memory(&mut self) {
+        debug!("Mapping DRAM");
+        for i in 0..self.num_clusters {
+            let dram = &self.config.memory[i].dram;
+            self.memory.map(dram.start, dram.end);
+        }
+    }
+
+    pub fn init_pages(&mut self) {
+        debug!("Mapping pages");
+        self.pages = PageTable::new(&self.config, self.num_clusters, &self.memory);
+    }
+
     pub fn init_bootrom(&mut self) {
         debug!("Adding bootrom");
         if self.config.bootrom.callbacks.is_empty() {
@@ -333,10 +432,13 @@ impl Engine {
     }
 
     unsafe fn execute_inner<'b>(&'b self) -> Result<u32> {
-        // Create a JIT compiler for the module (and consumes it).
+        // Create a JIT compiler for each module (and consumes it).
         debug!("Creating JIT compiler for translated code");
-        let execs: Vec<_> = (0..self.num_clusters)
-            .map(|i| {
+        let mut execs: Vec<for<'c> extern "C" fn(&'c Cpu<'b, 'c>)> = vec![];
+        for i in 0..self.num_clusters {
+            let exec = if self.module_of[i] != i {
+                execs[self.module_of[i]]
+            } else {
                 let mut ee = std::mem::MaybeUninit::uninit().assume_init();
                 let mut errmsg = std::mem::MaybeUninit::zeroed().assume_init();
                 let optlevel = if self.opt_jit { 3 } else { 0 };
@@ -354,28 +456,18 @@ impl Engine {
                 );
                 debug!("Translated binary is at {:?}", exec as *const i8);
                 exec
-            })
-            .collect();
+            };
+            execs.push(exec);
+        }
 
         // Allocate some TCDM memories.
         let tcdms: Vec<_> = (0..self.num_clusters)
             .map(|i| {
-                let mut tcdm = vec![
-                    0u32;
-                    ((self.config.memory[i].tcdm.end - self.config.memory[i].tcdm.start) / 4)
-                        as usize
-                ];
-
-                for (&addr, &value) in self.memory.lock().unwrap().iter() {
-                    if (addr as u32) >= self.config.memory[i].tcdm.start
-                        && (addr as u32) < self.config.memory[i].tcdm.end
-                    {
-                        tcdm[((addr - (self.config.memory[i].tcdm.start as u64)) / 4) as usize] =
-                            value;
-                    }
-                }
-
-                tcdm
+                let tcdm = &self.config.memory[i].tcdm;
+                (tcdm.start..tcdm.end)
+                    .step_by(4)
+                    .map(|addr| self.memory.load(addr))
+                    .collect::<Vec<u32>>()
             })
             .collect();
 
@@ -431,6 +523,12 @@ impl Engine {
             cpus[0].state
         );
 
+        let workers = match self.workers {
+            0 => std::thread::available_parallelism().map_or(1, |n| n.get()),
+            n => n,
+        };
+        self.scheduler.reset(workers.min(cpus.len()));
+
         // Execute the binary.
         info!("Launching binary on {} harts", cpus.len());
         let t0 = std::time::Instant::now();
@@ -438,7 +536,9 @@ impl Engine {
             for cpu in &cpus {
                 let exec = execs[cpu.cluster_id];
                 s.spawn(move |_| {
+                    self.scheduler.acquire();
                     exec(cpu);
+                    self.scheduler.release();
                     debug!("Hart {} finished", cpu.hartid);
                 });
             }
@@ -491,6 +591,10 @@ pub unsafe fn add_llvm_symbols() {
         b"banshee_rmw\0".as_ptr() as *const _,
         Cpu::binary_rmw as *mut _,
     );
+    LLVMAddSymbol(
+        b"banshee_dma_copy\0".as_ptr() as *const _,
+        Cpu::binary_dma_copy as *mut _,
+    );
     LLVMAddSymbol(
         b"banshee_csr_read\0".as_ptr() as *const _,
         Cpu::binary_csr_read as *mut _,
@@ -527,6 +631,10 @@ pub unsafe fn add_llvm_symbols() {
         b"banshee_check_cl_clint\0".as_ptr() as *const _,
         Cpu::binary_check_cl_clint as *mut _,
     );
+    LLVMAddSymbol(
+        b"banshee_yield\0".as_ptr() as *const _,
+        Cpu::binary_yield as *mut _,
+    );
     LLVMAddSymbol(
         b"banshee_fp16_op_cvt_from_f\0".as_ptr() as *const _,
         Cpu::binary_fp16_op_cvt_from_f as *mut _,
@@ -610,6 +718,17 @@ impl CpuState {
     }
 }
 
+/// A range of memory resolved to its backing store for DMA copies. Its words
+/// are indexed from the word holding the first byte of the range.
+enum DmaSpan<'s> {
+    /// Words of a TCDM.
+    Tcdm(*mut u32),
+    /// Words of a flat DRAM region.
+    Dram(&'s [AtomicU32]),
+    /// Words of any other memory, accessed through the address decoding.
+    Bus(u32),
+}
+
 impl<'a, 'b> Cpu<'a, 'b> {
     /// Create a new CPU in a default state.
     pub fn new(
@@ -625,13 +744,18 @@ impl<'a, 'b> Cpu<'a, 'b> {
         clint: &'b Vec<AtomicU32>,
         cl_clint: &'b AtomicUsize,
     ) -> Self {
+        let mut state = CpuState::new(
+            engine.config.ssr.num_dm,
+            hartid,
+            engine.config.bootrom.start,
+        );
+        // The DMA timing model needs the cycle counter of the latency model
+        if engine.latency {
+            state.dma = DmaState::new(engine.config.dma.bandwidth, engine.config.dma.latency);
+        }
         Self {
             engine,
-            state: CpuState::new(
-                engine.config.ssr.num_dm,
-                hartid,
-                engine.config.bootrom.start,
-            ),
+            state,
             tcdm_ptr,
             tcdm_ext_ptr,
             hartid,
@@ -645,7 +769,48 @@ impl<'a, 'b> Cpu<'a, 'b> {
         }
     }
 
+    /// Get the cluster whose TCDM serves an address of a `Page::Tcdm(id)`.
+    fn tcdm_cluster(&self, addr: u32, id: u16) -> usize {
+        let tcdm = &self.engine.config.memory[self.cluster_id].tcdm;
+        if addr >= tcdm.start && addr < tcdm.end {
+            self.cluster_id
+        } else {
+            id as usize
+        }
+    }
+
+    fn tcdm_load(&self, id: usize, addr: u32, size: u8) -> u32 {
+        let tcdm_addr = addr - self.engine.config.memory[id].tcdm.start;
+        let word_addr = tcdm_addr / 4;
+        let word_offs = tcdm_addr - 4 * word_addr;
+        let ptr: *const u32 = self.tcdm_ext_ptr[id];
+        let word = unsafe { *ptr.offset(word_addr as isize) };
+        (word >> (8 * word_offs)) & ((((1 as u64) << (8 << size)) - 1) as u32)
+    }
+
+    // TODO: this is *not* thread-safe and *will* lead to undefined behavior on simultaneous access
+    // by 2 harts. However, changing `tcdm_ptr` to a locked structure would require pervasive redesign.
+    fn tcdm_store(&self, id: usize, addr: u32, value: u32, size: u8) {
+        let tcdm_addr = addr - self.engine.config.memory[id].tcdm.start;
+        let word_addr = tcdm_addr / 4;
+        let word_offs = tcdm_addr - 4 * word_addr;
+        let ptr = self.tcdm_ext_ptr[id] as *const u32;
+        let ptr_mut = ptr as *mut u32;
+        let wmask = ((((1 as u64) << (8 << size)) - 1) as u32) << (8 * word_offs);
+        unsafe {
+            let word_ptr = ptr_mut.offset(word_addr as isize);
+            let word = *word_ptr;
+            *word_ptr = (word & !wmask) | ((value << (8 * word_offs)) & wmask);
+        }
+    }
+
     fn binary_load(&self, addr: u32, size: u8) -> u32 {
+        // Serve plain memory without decoding the address in full
+        match self.engine.pages.lookup(addr) {
+            Page::Tcdm(id) => return self.tcdm_load(self.tcdm_cluster(addr, id), addr, size),
+            Page::Dram => return self.engine.memory.load(addr),
+            Page::Decode => (),
+        }
         match addr {
             x if x == self.engine.config.address.tcdm_start => {
                 self.engine.config.memory[self.cluster_id].tcdm.start
@@ -670,12 +835,7 @@ impl<'a, 'b> Cpu<'a, 'b> {
             x if x >= self.engine.config.memory[self.cluster_id].tcdm.start
                 && x < self.engine.config.memory[self.cluster_id].tcdm.end =>
             {
-                let tcdm_addr = addr - self.engine.config.memory[self.cluster_id].tcdm.start;
-                let word_addr = tcdm_addr / 4;
-                let word_offs = tcdm_addr - 4 * word_addr;
-                let ptr: *const u32 = self.tcdm_ptr;
-                let word = unsafe { *ptr.offset(word_addr as isize) };
-                (word >> (8 * word_offs)) & ((((1 as u64) << (8 << size)) - 1) as u32)
+                self.tcdm_load(self.cluster_id, addr, size)
             }
             // TCDM External
             x if self
@@ -692,12 +852,7 @@ impl<'a, 'b> Cpu<'a, 'b> {
                     .iter()
                     .position(|m| addr >= m.tcdm.start && addr < m.tcdm.end)
                     .unwrap();
-                let tcdm_addr = addr - self.engine.config.memory[id].tcdm.start;
-                let word_addr = tcdm_addr / 4;
-                let word_offs = tcdm_addr - 4 * word_addr;
-                let ptr: *const u32 = self.tcdm_ext_ptr[id];
-                let word = unsafe { *ptr.offset(word_addr as isize) };
-                (word >> (8 * word_offs)) & ((((1 as u64) << (8 << size)) - 1) as u32)
+                self.tcdm_load(id, addr, size)
             }
             // Peripherals
             x if x >= self.engine.config.memory[self.cluster_id].periphs.start
@@ -744,18 +899,20 @@ impl<'a, 'b> Cpu<'a, 'b> {
                     );
                 }
                 // trace!("Load 0x{:x} ({}B)", addr, 8 << size);
-                self.engine
-                    .memory
-                    .lock()
-                    .unwrap()
-                    .get(&(addr as u64))
-                    .copied()
-                    .unwrap_or(0)
+                self.engine.memory.load(addr)
             }
         }
     }
 
     fn binary_store(&self, addr: u32, value: u32, mask: u32, size: u8) {
+        // Serve plain memory without decoding the address in full
+        match self.engine.pages.lookup(addr) {
+            Page::Tcdm(id) => {
+                return self.tcdm_store(self.tcdm_cluster(addr, id), addr, value, size);
+            }
+            Page::Dram => return self.engine.memory.store(addr, value, mask),
+            Page::Decode => (),
+        }
         match addr {
             x if x == self.engine.config.address.tcdm_start => (), // tcdm_start
             x if x == self.engine.config.address.tcdm_end => (),   // tcdm_end
@@ -789,22 +946,10 @@ impl<'a, 'b> Cpu<'a, 'b> {
                 }
             }
             // TCDM
-            // TODO: this is *not* thread-safe and *will* lead to undefined behavior on simultaneous access
-            // by 2 harts. However, changing `tcdm_ptr` to a locked structure would require pervasive redesign.
             x if x >= self.engine.config.memory[self.cluster_id].tcdm.start
                 && x < self.engine.config.memory[self.cluster_id].tcdm.end =>
             {
-                let tcdm_addr = addr - self.engine.config.memory[self.cluster_id].tcdm.start;
-                let word_addr = tcdm_addr / 4;
-                let word_offs = tcdm_addr - 4 * word_addr;
-                let ptr = self.tcdm_ptr as *const u32;
-                let ptr_mut = ptr as *mut u32;
-                let wmask = ((((1 as u64) << (8 << size)) - 1) as u32) << (8 * word_offs);
-                unsafe {
-                    let word_ptr = ptr_mut.offset(word_addr as isize);
-                    let word = *word_ptr;
-                    *word_ptr = (word & !wmask) | ((value << (8 * word_offs)) & wmask);
-                }
+                self.tcdm_store(self.cluster_id, addr, value, size)
             }
             // TCDM External
             x if self
@@ -821,17 +966,7 @@ impl<'a, 'b> Cpu<'a, 'b> {
                     .iter()
                     .position(|m| addr >= m.tcdm.start && addr < m.tcdm.end)
                     .unwrap();
-                let tcdm_addr = addr - self.engine.config.memory[id].tcdm.start;
-                let word_addr = tcdm_addr / 4;
-                let word_offs = tcdm_addr - 4 * word_addr;
-                let ptr = self.tcdm_ext_ptr[id] as *const u32;
-                let ptr_mut = ptr as *mut u32;
-                let wmask = ((((1 as u64) << (8 << size)) - 1) as u32) << (8 * word_offs);
-                unsafe {
-                    let word_ptr = ptr_mut.offset(word_addr as isize);
-                    let word = *word_ptr;
-                    *word_ptr = (word & !wmask) | ((value << (8 * word_offs)) & wmask);
-                }
+                self.tcdm_store(id, addr, value, size)
             }
             // Peripherals
             x if x >= self.engine.config.memory[self.cluster_id].periphs.start
@@ -909,40 +1044,161 @@ impl<'a, 'b> Cpu<'a, 'b> {
                     mask,
                     8 << size
                 );
-                let mut data = self.engine.memory.lock().unwrap();
-                let data = data.entry(addr as u64).or_default();
-                *data &= !mask;
-                *data |= value & mask;
+                self.engine.memory.store(addr, value, mask);
             }
         }
     }
 
     fn binary_rmw(&self, addr: u32, value: u32, op: AtomicOp) -> u32 {
         trace!("RMW 0x{:x} (op={})= 0x{:x} (32B)", addr, op as u8, value);
-        let mut data = self.engine.memory.lock().unwrap();
-        let mut prev = data.get(&(addr as u64)).copied().unwrap_or(0);
-        // Atomics
-        let result = match op {
-            AtomicOp::Amoadd => prev.wrapping_add(value),
-            AtomicOp::Amoxor => prev ^ value,
-            AtomicOp::Amoor => prev | value,
-            AtomicOp::Amoand => prev & value,
-            AtomicOp::Amomin => std::cmp::min(prev as i32, value as i32) as u32,
-            AtomicOp::Amomax => std::cmp::max(prev as i32, value as i32) as u32,
-            AtomicOp::Amominu => std::cmp::min(prev as u32, value as u32),
-            AtomicOp::Amomaxu => std::cmp::max(prev as u32, value as u32),
-            AtomicOp::Amoswap => value,
-            AtomicOp::ScW => {
-                if prev == self.state.cas_value {
-                    prev = 0; // Store-conditional success
+        let result = self.engine.memory.update(addr, |prev| {
+            // Atomics
+            Some(match op {
+                AtomicOp::Amoadd => prev.wrapping_add(value),
+                AtomicOp::Amoxor => prev ^ value,
+                AtomicOp::Amoor => prev | value,
+                AtomicOp::Amoand => prev & value,
+                AtomicOp::Amomin => std::cmp::min(prev as i32, value as i32) as u32,
+                AtomicOp::Amomax => std::cmp::max(prev as i32, value as i32) as u32,
+                AtomicOp::Amominu => std::cmp::min(prev as u32, value as u32),
+                AtomicOp::Amomaxu => std::cmp::max(prev as u32, value as u32),
+                AtomicOp::Amoswap => value,
+                AtomicOp::ScW if prev == self.state.cas_value => value,
+                AtomicOp::ScW => return None,
+            })
+        });
+        match (op, result) {
+            (AtomicOp::ScW, Ok(_)) => 0,  // Store-conditional success
+            (AtomicOp::ScW, Err(_)) => 1, // Store-conditional failed
+            (_, result) => result.unwrap(),
+        }
+    }
+
+    /// Resolve the `size` bytes at `addr` to the memory backing all of them.
+    fn dma_span(&self, addr: u32, size: u32) -> DmaSpan {
+        let base = addr & !3;
+        let end = addr as u64 + size as u64;
+        let len = ((end - base as u64 + 3) / 4) as usize;
+        // The own TCDM takes precedence over external ones at the same address
+        let memory = &self.engine.config.memory;
+        for id in std::iter::once(self.cluster_id).chain(0..memory.len()) {
+            let tcdm = &memory[id].tcdm;
+            if base >= tcdm.start && end <= tcdm.end as u64 {
+                let ptr = if id == self.cluster_id {
+                    self.tcdm_ptr
+                } else {
+                    self.tcdm_ext_ptr[id]
+                } as *const u32 as *mut u32;
+                return DmaSpan::Tcdm(unsafe { ptr.add(((base - tcdm.start) / 4) as usize) });
+            }
+        }
+        match self.engine.memory.words(base, len) {
+            Some(words) => DmaSpan::Dram(words),
+            None => DmaSpan::Bus(base),
+        }
+    }
+
+    fn dma_load(&self, span: &DmaSpan, i: usize) -> u32 {
+        match *span {
+            DmaSpan::Tcdm(ptr) => unsafe { *ptr.add(i) },
+            DmaSpan::Dram(words) => words[i].load(Ordering::Acquire),
+            DmaSpan::Bus(base) => self.binary_load(base + 4 * i as u32, 2),
+        }
+    }
+
+    fn dma_store(&self, span: &DmaSpan, i: usize, value: u32, mask: u32) {
+        match *span {
+            DmaSpan::Tcdm(ptr) => unsafe {
+                let word = ptr.add(i);
+                *word = (*word & !mask) | (value & mask);
+            },
+            DmaSpan::Dram(words) if mask == u32::max_value() => {
+                words[i].store(value, Ordering::Release)
+            }
+            DmaSpan::Dram(words) => {
+                words[i]
+                    .fetch_update(Ordering::AcqRel, Ordering::Acquire, |word| {
+                        Some((word & !mask) | (value & mask))
+                    })
+                    .unwrap();
+            }
+            DmaSpan::Bus(base) => {
+                // Word stores to the TCDMs ignore the mask, so merge here
+                let addr = base + 4 * i as u32;
+                let value = if mask == u32::max_value() {
                     value
                 } else {
-                    return 1 as u32; // Store-conditional failed
-                }
+                    (self.binary_load(addr, 2) & !mask) | (value & mask)
+                };
+                self.binary_store(addr, value, u32::max_value(), 2);
             }
+        }
+    }
+
+    /// Copy `size` bytes from `src` to `dst` on behalf of the DMA.
+    ///
+    /// Both ranges are resolved to their backing memory once, such that the
+    /// words in between are copied without decoding their addresses. Partial
+    /// words at the head and tail of the destination are merged with masks,
+    /// and differently aligned ranges are copied by funnel-shifting the source
+    /// words.
+    fn binary_dma_copy(&self, dst: u32, src: u32, size: u32) {
+        trace!("DMA copy 0x{:x} -> 0x{:x} ({}B)", src, dst, size);
+        if size == 0 {
+            return;
+        }
+        let d = self.dma_span(dst, size);
+        let s = self.dma_span(src, size);
+        let dst_offs = (dst & 3) as u64;
+        let src_offs = (src & 3) as u64;
+        let end = dst_offs + size as u64;
+        let dst_words = ((end + 3) / 4) as usize;
+        let src_words = ((src_offs + size as u64 + 3) / 4) as usize;
+
+        // The bytes of destination word `i` which lie within the range.
+        let mask = |i: usize| {
+            let lo = dst_offs.max(4 * i as u64) - 4 * i as u64;
+            let hi = end.min(4 * i as u64 + 4) - 4 * i as u64;
+            (((1u64 << (8 * hi)) - 1) & !((1u64 << (8 * lo)) - 1)) as u32
         };
-        data.insert(addr as u64, result);
-        prev as u32
+
+        if dst_offs == src_offs {
+            // Full words in between the partial head and tail, if any
+            let first = (dst_offs != 0) as usize;
+            let last = (dst_words - (end % 4 != 0) as usize).max(first);
+            match (&d, &s) {
+                (DmaSpan::Tcdm(d), DmaSpan::Tcdm(s)) => unsafe {
+                    std::ptr::copy(s.add(first), d.add(first), last - first)
+                },
+                _ => {
+                    for i in first..last {
+                        self.dma_store(&d, i, self.dma_load(&s, i), u32::max_value());
+                    }
+                }
+            }
+            for i in (0..first).chain(last..dst_words) {
+                self.dma_store(&d, i, self.dma_load(&s, i), mask(i));
+            }
+        } else {
+            let word = |k: i64| {
+                if k >= 0 && k < src_words as i64 {
+                    self.dma_load(&s, k as usize)
+                } else {
+                    0
+                }
+            };
+            for i in 0..dst_words {
+                // Destination word `i` starts at byte `pos` of the source words
+                let pos = 4 * i as i64 + src_offs as i64 - dst_offs as i64;
+                let (k, shift) = (pos.div_euclid(4), 8 * pos.rem_euclid(4));
+                let value = if shift == 0 {
+                    word(k)
+                } else {
+                    (word(k) >> shift) | (word(k + 1) << (32 - shift))
+                };
+                self.dma_store(&d, i, value, mask(i));
+            }
+        }
     }
 
     fn binary_csr_read(&self, csr: riscv::Csr, notrace: u32) -> u32 {
@@ -1068,22 +1324,21 @@ impl<'a, 'b> Cpu<'a, 'b> {
         self.state.wfi = true;
         wus.wfi[hartid] = true;
         wus.num += 1;
-        // Wait for the wake up call: poll while this hart is not requested to wake and
-        // exit iff all harts are in the WFI loop and no requests are outstanding
-        let mut do_poll = wus.req[hartid] == 0;
-        let mut do_exit =
-            wus.num == wus.req.len() && wus.req.iter().filter(|&n| *n != 0).count() == 0;
         std::mem::drop(wus);
-        while do_poll {
-            // Check if everyone is sleeping
-            if do_exit {
-                return 1;
-            }
-            std::thread::yield_now();
+        // Sleep until this hart is requested to wake, and exit iff all harts
+        // are in the WFI loop and no requests are outstanding
+        let key = self.wakeup_state as *const _ as usize;
+        let mut do_exit = false;
+        self.engine.scheduler.wait(key, || {
             let wus = self.wakeup_state.lock().unwrap();
-            do_poll = wus.req[hartid] == 0;
-            do_exit = wus.num == wus.req.len() && wus.req.iter().filter(|&n| *n != 0).count() == 0;
-            std::mem::drop(wus);
+            do_exit =
+                wus.req[hartid] == 0 && wus.num == wus.req.len() && wus.req.iter().all(|&n| n == 0);
+            wus.req[hartid] != 0 || do_exit
+        });
+        if do_exit {
+            // Let the other sleeping harts notice that everyone is sleeping
+            self.engine.scheduler.wake(key);
+            return 1;
         }
         let mut wus = self.wakeup_state.lock().unwrap();
         // Someone woke us up --> Clear the flag
@@ -1099,12 +1354,21 @@ impl<'a, 'b> Cpu<'a, 'b> {
     }
 
     fn binary_check_clint(&mut self) -> u32 {
+        // Called before every instruction; hand on the worker now and then
+        if self.state.instret % QUANTUM == 0 {
+            self.engine.scheduler.yield_now();
+        }
         // read the clint software interrupt and return 1 if interrupt pending
         let hartid = self.hartid;
         return (self.clint[(hartid / 32) as usize].load(Ordering::SeqCst) & (1 << (hartid % 32)))
             >> (hartid % 32);
     }
 
+    fn binary_yield(&mut self) {
+        // Called after every quantum of instructions without interrupts
+        self.engine.scheduler.yield_now();
+    }
+
     fn binary_check_cl_clint(&mut self) -> u32 {
         // read the cluster-local clint software interrupt and return 1 if interrupt pending
         let hartid = self.hartid - self.engine.base_hartid - self.cluster_id * self.num_cores;
@@ -1114,31 +1378,20 @@ impl<'a, 'b> Cpu<'a, 'b> {
 
     /// A simple barrier across all cores in the cluster.
     ///
-    /// Uses an atomic barrier flag shared across all CPU threads in a cluster.
-    /// Core 0 coordinates. In a first phase, it waits until all cores but
-    /// itself have bumped the flag, then bumps itself and waits for all cores
-    /// to make it through.
+    /// Uses an atomic counter shared across all CPU threads in a cluster,
+    /// which every core bumps on arrival. The core completing a multiple of
+    /// the core count releases the others, which sleep until then.
     fn cluster_barrier(&self) {
-        let core_id = self.hartid - self.cluster_base_hartid;
         let core_num = self.num_cores;
-        if core_id == 0 {
-            while self.barrier.load(Ordering::Relaxed) < core_num - 1 {
-                std::thread::yield_now();
-            }
-            self.barrier.fetch_add(1, Ordering::Relaxed);
-            while self.barrier.load(Ordering::Relaxed) < 2 * core_num - 1 {
-                std::thread::yield_now();
-            }
-            self.barrier.store(0, Ordering::Relaxed);
+        let key = self.barrier as *const _ as usize;
+        let arrived = self.barrier.fetch_add(1, Ordering::SeqCst) + 1;
+        let release = (arrived + core_num - 1) / core_num * core_num;
+        if arrived == release {
+            self.engine.scheduler.wake(key);
         } else {
-            while self.barrier.load(Ordering::Relaxed) >= core_num {
-                std::thread::yield_now();
-            }
-            self.barrier.fetch_add(1, Ordering::Relaxed);
-            while self.barrier.load(Ordering::Relaxed) < core_num {
-                std::thread::yield_now();
-            }
-            self.barrier.fetch_add(1, Ordering::Relaxed);
+            self.engine
+                .scheduler
+                .wait(key, || self.barrier.load(Ordering::SeqCst) >= release);
         }
     }
 
@@ -1159,6 +1412,10 @@ impl<'a, 'b> Cpu<'a, 'b> {
             wus.req,
             wus.wfi,
         );
+        std::mem::drop(wus);
+        self.engine
+            .scheduler
+            .wake(self.wakeup_state as *const _ as usize);
     }
 
     /*
@@ -17,11 +17,15 @@ use llvm_sys::{
 use std::{ffi::CString, os::raw::c_int, path::Path, ptr::null_mut};
 
 pub mod bootroms;
+pub mod cache;
 pub mod configuration;
+pub mod dram;
 pub mod engine;
+pub mod pages;
 pub mod peripherals;
 pub mod riscv;
 mod runtime;
+pub mod sched;
 mod softfloat;
 pub mod tran;
 pub mod util;
@@ -112,6 +116,12 @@ fn main() -> Result<()> {
                 .takes_value(true)
                 .help("Number of clusters to simulate"),
         )
+        .arg(
+            Arg::with_name("workers")
+                .long("workers")
+                .takes_value(true)
+                .help("Number of harts executing at the same time (default: host cores)"),
+        )
         .arg(
             Arg::with_name("configuration")
                 .long("configuration")
@@ -130,6 +140,12 @@ fn main() -> Result<()> {
                 .takes_value(true)
                 .help("The hartid of the first core"),
         )
+        .arg(
+            Arg::with_name("cache-dir")
+                .long("cache-dir")
+                .takes_value(true)
+                .help("Cache translated binaries in this directory"),
+        )
         .arg(
             Arg::with_name("llvm-args")
                 .short("L")
@@ -215,6 +231,14 @@ fn main() -> Result<()> {
     matches
         .value_of("base-hartid")
         .map(|x| engine.base_hartid = x.parse().unwrap());
+    matches
+        .value_of("workers")
+        .map(|x| engine.workers = x.parse().unwrap());
+    engine.cache_dir = matches.value_of("cache-dir").map(Into::into);
+    engine.llvm_args = matches
+        .values_of("llvm-args")
+        .map(|args| args.map(Into::into).collect())
+        .unwrap_or_default();
 
     if let Some(file) = matches.value_of("create-configuration") {
         Configuration::print_default(file)?;
@@ -243,6 +267,9 @@ fn main() -> Result<()> {
         Configuration::new(engine.num_clusters, engine.num_cores, engine.base_hartid)
     };
     debug!("Configuration used:\n{}", engine.config);
+    if engine.config.dma.bandwidth != 0 && !engine.latency {
+        warn!("DMA timing model requires --latency; transfers complete immediately");
+    }
 
     // Read the binary.
     let path = Path::new(matches.value_of("binary").unwrap());
@@ -255,6 +282,9 @@ fn main() -> Result<()> {
     // Create a module for each cluster
     engine.create_modules();
 
+    // Back the DRAM by flat memory
+    engine.init_memory();
+
     // Translate the binary.
     engine
         .translate_elf(&elf)
@@ -292,6 +322,9 @@ fn main() -> Result<()> {
     // Init the Bootrom
     engine.init_bootrom();
 
+    // Map the pages of the address space to the memories backing them
+    engine.init_pages();
+
     // Execute the binary.
     if !matches.is_present("dry-run") {
         let return_code = engine.execute().context("Failed to execute ELF binary")?;
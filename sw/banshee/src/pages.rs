@@ -0,0 +1,177 @@
+// Copyright 2021 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+//! Page-granular dispatch of memory accesses
+//!
+//! The loads and stores which the translated binary does not serve itself are
+//! decoded by the engine against all registers and memories of the
+//! configuration. To spare accesses to other clusters' TCDMs and to DRAM from
+//! comparing against every range, the address space is split into pages which
+//! are mapped to their backing memory once at startup. Pages holding a
+//! register, a peripheral, the bootrom, or the boundary of a memory are left
+//! to the full address decoding.
+
+use crate::{configuration::Configuration, dram::Dram};
+use std::ops::Range;
+
+/// The log2 of the page size.
+pub const PAGE_SHIFT: u32 = 12;
+const PAGE_SIZE: u64 = 1 << PAGE_SHIFT;
+
+/// The memory backing a page.
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum Page {
+    /// Decode every access to the page in full.
+    Decode,
+    /// The TCDM of a cluster, unless shadowed by the accessing core's own.
+    Tcdm(u16),
+    /// A flat DRAM region within the memory map of every cluster.
+    Dram,
+}
+
+/// The backing memory of every page of the address space.
+#[derive(Default)]
+pub struct PageTable {
+    pages: Vec<Page>,
+}
+
+impl PageTable {
+    /// Map the pages of the first `num_clusters` memories of a configuration.
+    pub fn new(config: &Configuration, num_clusters: usize, memory: &Dram) -> Self {
+        let mut pages = vec![Page::Decode; 1 << (32 - PAGE_SHIFT)];
+        let memories = &config.memory[..num_clusters];
+        let mut decode = vec![];
+
+        // DRAM, unless an access would warn about leaving the memory map
+        let dram_start = memories.iter().map(|m| m.dram.start).max().unwrap_or(0);
+        let dram_end = memories.iter().map(|m| m.dram.end).min().unwrap_or(0);
+        for p in full_pages(dram_start as u64, dram_end as u64) {
+            let addr = (p as u64 * PAGE_SIZE) as u32;
+            if memory.words(addr, (PAGE_SIZE / 4) as usize).is_some() {
+                pages[p] = Page::Dram;
+            }
+        }
+
+        // TCDMs; the first matching cluster serves an address
+        for (id, m) in memories.iter().enumerate() {
+            let (start, end) = (m.tcdm.start as u64, m.tcdm.end as u64);
+            for p in full_pages(start, end) {
+                if let Page::Tcdm(_) = pages[p] {
+                    continue;
+                }
+                pages[p] = Page::Tcdm(id as u16);
+            }
+            // Pages partially covered by the TCDM may hold other memory
+            if start % PAGE_SIZE != 0 {
+                decode.push((start, start + 1));
+            }
+            if end % PAGE_SIZE != 0 {
+                decode.push((end - 1, end));
+            }
+        }
+
+        // Registers and memories with callbacks
+        let a = &config.address;
+        for &reg in &[
+            a.tcdm_start,
+            a.tcdm_end,
+            a.nr_cores,
+            a.scratch_reg,
+            a.wakeup_reg,
+            a.barrier_reg,
+            a.cluster_base_hartid,
+            a.cluster_num,
+            a.cluster_id,
+            a.uart,
+        ] {
+            decode.push((reg as u64, reg as u64 + 4));
+        }
+        decode.push((a.clint as u64, a.clint as u64 + 0x1000));
+        decode.push((a.cl_clint as u64, a.cl_clint as u64 + 0x10));
+        decode.push((config.bootrom.start as u64, config.bootrom.end as u64));
+        for m in memories {
+            decode.push((m.periphs.start as u64, m.periphs.end as u64));
+        }
+        for (start, end) in decode {
+            for p in touched_pages(start, end) {
+                pages[p] = Page::Decode;
+            }
+        }
+
+        let num_tcdm = pages.iter().filter(|p| matches!(p, Page::Tcdm(_))).count();
+        let num_dram = pages.iter().filter(|&&p| p == Page::Dram).count();
+        debug!(
+            "Mapped {} TCDM and {} DRAM pages of {} KiB",
+            num_tcdm,
+            num_dram,
+            PAGE_SIZE / 1024
+        );
+        Self { pages }
+    }
+
+    /// Get the memory backing an address.
+    #[inline]
+    pub fn lookup(&self, addr: u32) -> Page {
+        self.pages
+            .get((addr >> PAGE_SHIFT) as usize)
+            .copied()
+            .unwrap_or(Page::Decode)
+    }
+}
+
+/// The pages lying entirely within `[start, end)`.
+fn full_pages(start: u64, end: u64) -> Range<usize> {
+    let first = (start + PAGE_SIZE - 1) / PAGE_SIZE;
+    let last = end / PAGE_SIZE;
+    first as usize..last.max(first) as usize
+}
+
+/// The pages holding any address of `[start, end)`.
+fn touched_pages(start: u64, end: u64) -> Range<usize> {
+    let last = (end.min(1 << 32) + PAGE_SIZE - 1) / PAGE_SIZE;
+    let first = (start / PAGE_SIZE).min(last);
+    first as usize..last as usize
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn table(config: &Configuration) -> PageTable {
+        let mut memory = Dram::default();
+        for m in &config.memory {
+            memory.map(m.dram.start, m.dram.end);
+        }
+        PageTable::new(config, config.memory.len(), &memory)
+    }
+
+    #[test]
+    fn default_map() {
+        let mut config = Configuration::new(2, 8, 0);
+        config.bootrom.end = 0;
+        let pages = table(&config);
+        // Both clusters see their own TCDM at the same addresses
+        assert_eq!(pages.lookup(0x100000), Page::Tcdm(0));
+        assert_eq!(pages.lookup(0x11ffff), Page::Tcdm(0));
+        assert_eq!(pages.lookup(0x120000), Page::Decode);
+        assert_eq!(pages.lookup(0x80000000), Page::Dram);
+        assert_eq!(pages.lookup(0x8fffffff), Page::Dram);
+        assert_eq!(pages.lookup(0x90000000), Page::Decode);
+        assert_eq!(pages.lookup(0x40000000), Page::Decode);
+        assert_eq!(pages.lookup(0xffff0000), Page::Decode);
+    }
+
+    #[test]
+    fn distinct_tcdms() {
+        let mut config = Configuration::new(2, 8, 0);
+        config.bootrom.end = 0;
+        config.memory[1].tcdm.start = 0x120000;
+        config.memory[1].tcdm.end = 0x140800;
+        let pages = table(&config);
+        assert_eq!(pages.lookup(0x110000), Page::Tcdm(0));
+        assert_eq!(pages.lookup(0x120000), Page::Tcdm(1));
+        // Pages partially covered by a TCDM are decoded in full
+        assert_eq!(pages.lookup(0x140000), Page::Decode);
+    }
+}
@@ -86,6 +86,10 @@ pub struct SsrState {
     accessed: bool,
 }
 
+/// The number of transfers the DMA timing model tracks. Issuing a transfer
+/// while as many are in flight stalls the core until the oldest completes.
+pub const DMA_QUEUE_DEPTH: usize = 16;
+
 /// A representation of a DMA backend's state.
 #[derive(Default)]
 #[repr(C)]
@@ -96,7 +100,16 @@ pub struct DmaState {
     dst_stride: u32,
     reps: u32,
     size: u32,
-    done_id: u32,
+    /// The number of transfers issued so far.
+    issued: u32,
+    /// Bytes moved per cycle by the timing model, or zero if disabled.
+    bandwidth: u32,
+    /// Cycles from issuing a transfer until its first bytes move.
+    latency: u32,
+    /// Cycle at which the last issued transfer has moved all bytes.
+    busy_until: u64,
+    /// Completion cycles of the last transfers, indexed by ID modulo depth.
+    done_cycles: [u64; DMA_QUEUE_DEPTH],
 }
 
 /// Store IRQ relevant CSRs
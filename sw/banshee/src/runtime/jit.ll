@@ -20,6 +20,7 @@
 declare i32 @banshee_load(%Cpu* %cpu, i32 %addr, i8 %size)
 declare void @banshee_store(%Cpu* %cpu, i32 %addr, i32 %value, i32 %mask, i8 %size)
 declare i32 @banshee_rmw(%Cpu* %cpu, i32 %addr, i32 %value, i8 %op)
+declare void @banshee_dma_copy(%Cpu* %cpu, i32 %dst, i32 %src, i32 %size)
 declare i32 @banshee_csr_read(%Cpu* %cpu, i16 %csr, i32 %notrace)
 declare void @banshee_csr_write(%Cpu* %cpu, i16 %csr, i32 %value, i32 %notrace)
 declare void @banshee_abort_escape(%Cpu* %cpu, i32 %addr)
@@ -29,6 +30,7 @@ declare void @banshee_trace(%Cpu* %cpu, i32 %addr, i32 %raw, [2 x i64] %access_s
 declare i32 @banshee_wfi(%Cpu* %cpu)
 declare i32 @banshee_check_clint(%Cpu* %cpu)
 declare i32 @banshee_check_cl_clint(%Cpu* %cpu)
+declare void @banshee_yield(%Cpu* %cpu)
 declare i64 @banshee_faddh(i64 %rs1, i64 %rs2, i8 %op)
 declare i64 @banshee_fhop(i64 %rs1, i64 %rs2, i8 %op)
 declare i16 @banshee_foph(i16 %rs1, i16 %rs2, i16 %rs3, i8 %op)
@@ -68,7 +70,7 @@ declare void @banshee_dma_dst(%DmaState* writeonly %dma, i32 %lo, i32 %hi)
 declare i32 @banshee_dma_strt(%DmaState* %dma, %Cpu* %cpu, i32 %size, i32 %flags)
 declare void @banshee_dma_str(%DmaState* writeonly %dma, i32 %src, i32 %dst)
 declare void @banshee_dma_rep(%DmaState* writeonly %dma, i32 %reps)
-declare i32 @banshee_dma_stat(%DmaState* readonly %dma, i32 %addr)
+declare i32 @banshee_dma_stat(%DmaState* readonly %dma, %Cpu* readonly %cpu, i32 %addr)
 
 declare i32* @banshee_reg_ptr(%Cpu* %cpu, i32 %reg)
 declare i64* @banshee_reg_cycle_ptr(%Cpu* %cpu, i32 %reg)
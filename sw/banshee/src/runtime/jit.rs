@@ -275,44 +275,72 @@ pub unsafe fn banshee_dma_rep(dma: &mut DmaState, reps: u32) {
 #[no_mangle]
 pub unsafe fn banshee_dma_strt(dma: &mut DmaState, cpu: &mut Cpu, size: u32, flags: u32) -> u32 {
     extern "C" {
-        fn banshee_load(cpu: &mut Cpu, addr: u32, size: u8) -> u32;
-        fn banshee_store(cpu: &mut Cpu, addr: u32, value: u32, mask: u32, size: u8);
+        fn banshee_dma_copy(cpu: &mut Cpu, dst: u32, src: u32, size: u32);
     }
 
-    let id = dma.done_id;
-    dma.done_id += 1;
+    let id = dma.issued;
+    dma.issued += 1;
     dma.size = size;
 
-    // assert_eq!(
-    //     size % 4,
-    //     0,
-    //     "DMA transfer size must be a multiple of 4B for now"
-    // );
-    let num_beats = size / 4;
     let enable_2d = (flags & (1 << 1)) != 0;
     let steps = if enable_2d { dma.reps } else { 1 };
 
     for i in 0..steps as u64 {
         let src = dma.src + i * dma.src_stride as u64;
         let dst = dma.dst + i * dma.dst_stride as u64;
-        // assert_eq!(src % 4, 0, "DMA src transfer block must be 4-byte-aligned");
-        // assert_eq!(dst % 4, 0, "DMA dst transfer block must be 4-byte-aligned");
-        for j in 0..num_beats as u64 {
-            let tmp = banshee_load(cpu, (src + j * 4) as u32, 2);
-            banshee_store(cpu, (dst + j * 4) as u32, tmp, u32::max_value(), 2);
+        banshee_dma_copy(cpu, dst as u32, src as u32, size);
+    }
+
+    // The data is copied right away, but the transfer only completes once
+    // the timing model has moved all its bytes. Transfers are served in
+    // order, each starting after its latency or when the previous one is
+    // done, whichever is later.
+    if dma.bandwidth != 0 {
+        let done = dma
+            .done_cycles
+            .get_unchecked_mut(id as usize % DMA_QUEUE_DEPTH);
+        // The slot holds the transfer issued `DMA_QUEUE_DEPTH` before; wait
+        // for it if it is still in flight.
+        if *done > cpu.state.cycle {
+            cpu.state.cycle = *done;
         }
+        let bytes = size as u64 * steps as u64;
+        let beats = (bytes + dma.bandwidth as u64 - 1) / dma.bandwidth as u64;
+        let start = cpu.state.cycle + dma.latency as u64;
+        let start = if start > dma.busy_until {
+            start
+        } else {
+            dma.busy_until
+        };
+        dma.busy_until = start + beats;
+        *done = dma.busy_until;
     }
 
     id
 }
 
+/// Get the number of transfers completed at the current cycle.
+unsafe fn dma_completed(dma: &DmaState, cpu: &Cpu) -> u32 {
+    // Transfers complete in order, and the ones older than the queue depth
+    // have completed before the newer ones were issued.
+    let mut completed = dma.issued;
+    let mut id = dma.issued;
+    while id > 0 && dma.issued - id < DMA_QUEUE_DEPTH as u32 {
+        id -= 1;
+        if *dma.done_cycles.get_unchecked(id as usize % DMA_QUEUE_DEPTH) > cpu.state.cycle {
+            completed = id;
+        }
+    }
+    completed
+}
+
 /// Implementation of the `dm.stat` and `dm.stati` instructions.
 #[no_mangle]
-pub unsafe fn banshee_dma_stat(dma: &DmaState, addr: u32) -> u32 {
+pub unsafe fn banshee_dma_stat(dma: &DmaState, cpu: &Cpu, addr: u32) -> u32 {
     match addr & 0x3 {
-        0 => dma.done_id,     // completed_id
-        1 => dma.done_id + 1, // next_id
-        2 | 3 => 0,           // busy
+        0 => dma_completed(dma, cpu),                            // completed_id
+        1 => dma.issued + 1,                                     // next_id
+        2 | 3 => (dma_completed(dma, cpu) != dma.issued) as u32, // busy
         _ => 0,
     }
 }
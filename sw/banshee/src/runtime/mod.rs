@@ -108,6 +108,18 @@ impl std::fmt::Debug for SsrState {
     }
 }
 
+impl DmaState {
+    /// Create a DMA backend moving `bandwidth` bytes per cycle after a latency
+    /// of `latency` cycles. A zero bandwidth completes transfers immediately.
+    pub fn new(bandwidth: u32, latency: u32) -> Self {
+        Self {
+            bandwidth,
+            latency,
+            ..Default::default()
+        }
+    }
+}
+
 impl std::fmt::Debug for DmaState {
     fn fmt(&self, f: &mut std::fmt::Formatter) -> std::fmt::Result {
         f.debug_struct("DmaState")
@@ -117,7 +129,8 @@ impl std::fmt::Debug for DmaState {
             .field("dst stride", &format_args!("{:08x}", self.dst_stride))
             .field("reps", &self.reps)
             .field("size", &self.size)
-            .field("done_id", &self.done_id)
+            .field("issued", &self.issued)
+            .field("busy_until", &self.busy_until)
             .finish()
     }
 }
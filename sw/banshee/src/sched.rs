@@ -0,0 +1,168 @@
+// Copyright 2021 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+//! Scheduling of the simulated harts onto the host
+//!
+//! Every hart executes the translated binary on a thread of its own, which
+//! holds the native stack of the binary. To keep hundreds of harts from
+//! thrashing the host, only as many of them execute at a time as there are
+//! workers: a hart needs a worker to run, gives it up while it is blocked at
+//! the barrier or in `wfi`, and hands it on after every quantum of
+//! instructions if other harts are waiting for one. Workers are handed out in
+//! the order they were asked for.
+//!
+//! Blocked harts sleep in futex-style wait queues keyed by the address of the
+//! state they wait on, and are woken by whoever changes that state.
+
+use std::sync::{
+    atomic::{AtomicUsize, Ordering},
+    Condvar, Mutex,
+};
+
+/// The number of instructions after which a hart hands on its worker, a power
+/// of two since translated code masks the instruction count with it.
+pub const QUANTUM: u64 = 1 << 12;
+
+/// The number of wait queues that keys are hashed to.
+const NUM_QUEUES: usize = 64;
+
+#[derive(Default)]
+struct Workers {
+    /// The workers not held by any hart.
+    free: usize,
+    /// The next ticket to hand out.
+    next: u64,
+    /// The ticket to be served next.
+    serving: u64,
+}
+
+/// Hands out workers to harts and parks blocked harts.
+pub struct Scheduler {
+    workers: Mutex<Workers>,
+    workers_cond: Condvar,
+    /// The number of harts waiting for a worker.
+    waiting: AtomicUsize,
+    queues: Vec<(Mutex<()>, Condvar)>,
+}
+
+impl Default for Scheduler {
+    fn default() -> Self {
+        Self {
+            workers: Default::default(),
+            workers_cond: Condvar::new(),
+            waiting: AtomicUsize::new(0),
+            queues: (0..NUM_QUEUES).map(|_| Default::default()).collect(),
+        }
+    }
+}
+
+impl Scheduler {
+    /// Set the number of workers. Must be called before any hart starts.
+    pub fn reset(&self, workers: usize) {
+        debug!("Scheduling harts onto {} workers", workers);
+        *self.workers.lock().unwrap() = Workers {
+            free: workers,
+            ..Default::default()
+        };
+    }
+
+    /// Block until the calling hart gets a worker.
+    pub fn acquire(&self) {
+        let mut w = self.workers.lock().unwrap();
+        let ticket = w.next;
+        w.next += 1;
+        self.waiting.fetch_add(1, Ordering::Relaxed);
+        while w.free == 0 || w.serving != ticket {
+            w = self.workers_cond.wait(w).unwrap();
+        }
+        self.waiting.fetch_sub(1, Ordering::Relaxed);
+        w.free -= 1;
+        w.serving += 1;
+        // The next ticket may be served by another free worker
+        if w.free > 0 && w.serving != w.next {
+            self.workers_cond.notify_all();
+        }
+    }
+
+    /// Give up the worker of the calling hart.
+    pub fn release(&self) {
+        self.workers.lock().unwrap().free += 1;
+        self.workers_cond.notify_all();
+    }
+
+    /// Hand on the worker of the calling hart if another hart waits for one.
+    pub fn yield_now(&self) {
+        if self.waiting.load(Ordering::Relaxed) > 0 {
+            self.release();
+            self.acquire();
+        }
+    }
+
+    fn queue(&self, key: usize) -> &(Mutex<()>, Condvar) {
+        &self.queues[(key >> 3) % NUM_QUEUES]
+    }
+
+    /// Block the calling hart until `until` holds, giving up its worker in
+    /// the meantime. `until` is checked again whenever `key` is woken.
+    pub fn wait(&self, key: usize, mut until: impl FnMut() -> bool) {
+        let (lock, cond) = self.queue(key);
+        let mut guard = lock.lock().unwrap();
+        if until() {
+            return;
+        }
+        self.release();
+        while !until() {
+            guard = cond.wait(guard).unwrap();
+        }
+        std::mem::drop(guard);
+        self.acquire();
+    }
+
+    /// Wake all harts waiting on `key`. Must be called after changing the
+    /// state they wait on.
+    pub fn wake(&self, key: usize) {
+        let (lock, cond) = self.queue(key);
+        let _guard = lock.lock().unwrap();
+        cond.notify_all();
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::sync::atomic::AtomicU64;
+
+    #[test]
+    fn barrier_on_fewer_workers() {
+        let sched = Scheduler::default();
+        sched.reset(2);
+        let barrier = AtomicUsize::new(0);
+        let running = AtomicUsize::new(0);
+        let max_running = AtomicU64::new(0);
+        let num = 8;
+        crossbeam_utils::thread::scope(|s| {
+            for _ in 0..num {
+                s.spawn(|_| {
+                    sched.acquire();
+                    for round in 0..16 {
+                        let now = running.fetch_add(1, Ordering::SeqCst) + 1;
+                        max_running.fetch_max(now as u64, Ordering::SeqCst);
+                        running.fetch_sub(1, Ordering::SeqCst);
+                        let release = (round + 1) * num;
+                        let key = &barrier as *const _ as usize;
+                        if barrier.fetch_add(1, Ordering::SeqCst) + 1 == release {
+                            sched.wake(key);
+                        } else {
+                            sched.wait(key, || barrier.load(Ordering::SeqCst) >= release);
+                        }
+                    }
+                    sched.release();
+                });
+            }
+        })
+        .unwrap();
+        assert_eq!(barrier.load(Ordering::SeqCst), 16 * num);
+        assert!(max_running.load(Ordering::SeqCst) <= 2);
+    }
+}
@@ -7,6 +7,7 @@
 use crate::{
     engine::{AtomicOp, Engine, TraceAccess},
     riscv,
+    sched::QUANTUM,
 };
 use anyhow::{anyhow, bail, Context, Result};
 use llvm_sys::{
@@ -985,6 +986,12 @@ impl<'a> InstructionTranslator<'a> {
         );
         LLVMBuildStore(self.builder, instret, self.instret_ptr());
 
+        // Hand on the worker now and then, which the interrupt check does
+        // otherwise
+        if !self.section.engine.interrupt {
+            self.emit_yield_check(instret);
+        }
+
         // reset ssr streamer flags to serve new values for SSR registers
         for i in 0..self.section.engine.config.ssr.num_dm as u32 {
             self.section.emit_call("banshee_ssr_eoi", [self.ssr_ptr(i)]);
@@ -1639,9 +1646,10 @@ impl<'a> InstructionTranslator<'a> {
         let _name = name.as_ptr() as *const _;
 
         let value = match data.op {
-            riscv::OpcodeImm5Rd::Dmstati => self
-                .section
-                .emit_call("banshee_dma_stat", [self.dma_ptr(), imm]),
+            riscv::OpcodeImm5Rd::Dmstati => self.section.emit_call(
+                "banshee_dma_stat",
+                [self.dma_ptr(), self.section.state_ptr, imm],
+            ),
         };
         self.write_reg(data.rd, value);
         Ok(())
@@ -2156,9 +2164,10 @@ impl<'a> InstructionTranslator<'a> {
                     true,
                 )
             }
-            riscv::OpcodeRdRs2::Dmstat => self
-                .section
-                .emit_call("banshee_dma_stat", [self.dma_ptr(), rs2]),
+            riscv::OpcodeRdRs2::Dmstat => self.section.emit_call(
+                "banshee_dma_stat",
+                [self.dma_ptr(), self.section.state_ptr, rs2],
+            ),
             // _ => bail!("Unsupported opcode {}", data.op),
         };
 
@@ -5709,6 +5718,34 @@ impl<'a> InstructionTranslator<'a> {
         self.read_mem(LLVMBuildAdd(self.builder, base, offset, NONAME), size, sext)
     }
 
+    /// Emit the code to hand on the worker of the hart after every quantum of
+    /// retired instructions
+    unsafe fn emit_yield_check(&self, instret: LLVMValueRef) {
+        let phase = LLVMBuildAnd(
+            self.builder,
+            instret,
+            LLVMConstInt(LLVMTypeOf(instret), QUANTUM - 1, 0),
+            NONAME,
+        );
+        let is_yield = LLVMBuildICmp(
+            self.builder,
+            LLVMIntEQ,
+            phase,
+            LLVMConstInt(LLVMTypeOf(instret), 0, 0),
+            NONAME,
+        );
+        let bb_noyield = LLVMCreateBasicBlockInContext(self.section.engine.context, NONAME);
+        let bb_yield = LLVMCreateBasicBlockInContext(self.section.engine.context, NONAME);
+        LLVMInsertExistingBasicBlockAfterInsertBlock(self.builder, bb_noyield);
+        LLVMInsertExistingBasicBlockAfterInsertBlock(self.builder, bb_yield);
+        LLVMBuildCondBr(self.builder, is_yield, bb_yield, bb_noyield);
+        LLVMPositionBuilderAtEnd(self.builder, bb_yield);
+        self.section
+            .emit_call("banshee_yield", [self.section.state_ptr]);
+        LLVMBuildBr(self.builder, bb_noyield);
+        LLVMPositionBuilderAtEnd(self.builder, bb_noyield);
+    }
+
     /// Emit the code to check for any interrupt
     unsafe fn emit_irq_check(&self) {
         // Update MIP CSR (machine interrupt pending)
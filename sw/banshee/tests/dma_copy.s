@@ -0,0 +1,142 @@
+# Copyright 2021 ETH Zurich and University of Bologna.
+# Licensed under the Apache License, Version 2.0, see LICENSE for details.
+# SPDX-License-Identifier: Apache-2.0
+
+# Copies between DRAM and TCDM with the DMA at all combinations of source and
+# destination alignment, and checks that exactly the bytes of each transfer
+# are written. The transfers are waited for through their completion IDs,
+# such that the test also passes with the DMA timing model enabled.
+
+.set TCDM, 0x100000
+.set GUARD, 0xa5
+.set SPAN, 96
+
+# dmsrc rs1, x0
+.macro dmsrc rs1
+    .word (0b0000000 << 25) | (\rs1 << 15) | (0b0101011 << 0)
+.endm
+# dmdst rs1, x0
+.macro dmdst rs1
+    .word (0b0000001 << 25) | (\rs1 << 15) | (0b0101011 << 0)
+.endm
+# dmcpyi rd, rs1, 0
+.macro dmcpyi rd, rs1
+    .word (0b0000010 << 25) | (\rs1 << 15) | (\rd << 7) | (0b0101011 << 0)
+.endm
+# dmstati rd, 0 (number of completed transfers)
+.macro dmstati rd
+    .word (0b0000100 << 25) | (\rd << 7) | (0b0101011 << 0)
+.endm
+
+# Check a transfer of s7 bytes from src + s9 to dst + s8.
+.macro check dst, src
+    mv      a0, \dst
+    mv      a1, \src
+    mv      a2, s8
+    mv      a3, s9
+    mv      a4, s7
+    jal     check
+    add     s4, s4, a0
+.endm
+
+.globl _start
+.section .text.init;
+_start:
+    csrr    t0, mhartid
+    lw      t1, cluster_base_hart_id_reg
+    bne     t0, t1, halt
+
+    # Fill the sources
+    la      s0, dram_src
+    li      s1, TCDM
+    li      s2, TCDM + 128
+    la      s3, dram_dst
+    li      t0, 0
+    li      t1, 3
+    li      t2, 1
+    li      t3, 128
+1:  add     t4, s0, t0
+    sb      t1, 0(t4)
+    add     t4, s1, t0
+    sb      t2, 0(t4)
+    addi    t1, t1, 7
+    addi    t2, t2, 5
+    addi    t0, t0, 1
+    bne     t0, t3, 1b
+
+    # All sizes (s7) and offsets into the destination (s8) and source (s9)
+    li      s4, 0
+    la      s5, sizes
+    la      s6, sizes_end
+1:  lw      s7, 0(s5)
+    li      s8, 0
+2:  li      s9, 0
+    # DRAM to TCDM, TCDM to TCDM, and TCDM to DRAM
+3:  check   s2, s0
+    check   s2, s1
+    check   s3, s1
+    li      t0, 4
+    addi    s9, s9, 1
+    bne     s9, t0, 3b
+    addi    s8, s8, 1
+    bne     s8, t0, 2b
+    addi    s5, s5, 4
+    bne     s5, s6, 1b
+
+    slli    a0, s4, 1
+    ori     a0, a0, 1
+    la      t0, scratch_reg
+    sw      a0, 0(t0)
+halt:
+    wfi
+    j       halt
+
+# Copy a4 bytes from a1 + a3 to a0 + a2 with the DMA and return the number of
+# bytes in the first SPAN bytes of the destination that differ from a
+# byte-wise copy.
+check:
+    li      t0, 0
+    li      t1, GUARD
+    li      t2, SPAN
+1:  add     t3, a0, t0
+    sb      t1, 0(t3)
+    addi    t0, t0, 1
+    bne     t0, t2, 1b
+
+    add     t3, a1, a3
+    add     t4, a0, a2
+    dmsrc   28 # t3
+    dmdst   29 # t4
+    dmcpyi  30, 14 # t5, a4
+1:  dmstati 31 # t6
+    sub     t6, t6, t5
+    blez    t6, 1b
+
+    li      a5, 0
+    li      t0, 0
+    add     t6, a2, a4
+1:  li      t1, GUARD
+    bltu    t0, a2, 2f
+    bgeu    t0, t6, 2f
+    sub     t3, t0, a2
+    add     t3, t3, a3
+    add     t3, t3, a1
+    lbu     t1, 0(t3)
+2:  add     t3, a0, t0
+    lbu     t4, 0(t3)
+    beq     t4, t1, 3f
+    addi    a5, a5, 1
+3:  addi    t0, t0, 1
+    bne     t0, t2, 1b
+    mv      a0, a5
+    ret
+
+.section .data
+.align 2
+sizes:
+    .word 1, 2, 3, 4, 5, 7, 8, 61, 64, 67
+sizes_end:
+dram_src:
+    .zero 128
+dram_dst:
+    .zero 128
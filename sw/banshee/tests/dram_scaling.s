@@ -0,0 +1,102 @@
+# Copyright 2021 ETH Zurich and University of Bologna.
+# Licensed under the Apache License, Version 2.0, see LICENSE for details.
+# SPDX-License-Identifier: Apache-2.0
+
+# Every hart updates its own slice of a buffer in DRAM, such that the
+# simulation rate with many clusters is dominated by DRAM accesses. Used by
+# `make bench-dram` to report how the simulation scales with the hart count.
+#
+# Every hart applies x <- 3 * x + hartid to its 512 words for 64 rounds and
+# counts the words not holding the expected value. Hart 0 sleeps until all
+# harts are done and reports the total as exit code.
+
+.set MAX_HARTS, 256
+.set WORDS, 512
+.set ROUNDS, 64
+.set cluster_num_reg, 0x40000048
+
+.globl _start
+.section .text.init;
+_start:
+    csrr    s0, mhartid
+    li      t0, MAX_HARTS
+    bgeu    s0, t0, halt
+    # Number of harts in the system
+    la      t0, nr_cores_address_reg
+    lw      t0, 0(t0)
+    li      t1, cluster_num_reg
+    lw      t1, 0(t1)
+    mul     s1, t0, t1
+    # Slice of the hart: s2 to s3
+    la      s2, buffer
+    slli    t0, s0, 11 # WORDS * 4
+    add     s2, s2, t0
+    li      t0, WORDS * 4
+    add     s3, s2, t0
+
+    # Update the slice
+    li      t2, ROUNDS
+    li      t3, 0
+1:  mv      t4, s2
+2:  lw      t0, 0(t4)
+    slli    t1, t0, 1
+    add     t0, t0, t1
+    add     t0, t0, s0
+    sw      t0, 0(t4)
+    addi    t4, t4, 4
+    bne     t4, s3, 2b
+    addi    t3, t3, 1
+    bne     t3, t2, 1b
+
+    # All words hold x(ROUNDS) for x(0) = 0 and x(n+1) = 3 * x(n) + hartid
+    li      t0, 0
+    li      t3, 0
+1:  slli    t1, t0, 1
+    add     t0, t0, t1
+    add     t0, t0, s0
+    addi    t3, t3, 1
+    bne     t3, t2, 1b
+    li      t5, 0
+    mv      t4, s2
+1:  lw      t1, 0(t4)
+    beq     t1, t0, 2f
+    addi    t5, t5, 1
+2:  addi    t4, t4, 4
+    bne     t4, s3, 1b
+    la      t0, errors
+    amoadd.w zero, t5, (t0)
+
+    # Only hart 0 reports the exit code: the last hart to finish wakes it
+    la      t0, done
+    li      t1, 1
+    amoadd.w t1, t1, (t0)
+    addi    t2, s1, -1
+    bne     t1, t2, 1f
+    la      t1, wake_up_reg
+    sw      zero, 0(t1)
+1:  bnez    s0, halt
+2:  lw      t1, 0(t0)
+    beq     t1, s1, 3f
+    wfi
+    j       2b
+3:  la      t0, errors
+    lw      a0, 0(t0)
+    slli    a0, a0, 1
+    ori     a0, a0, 1
+    la      t0, scratch_reg
+    sw      a0, 0(t0)
+halt:
+    wfi
+    j       halt
+
+.section .data
+.align 2
+errors:
+    .word 0
+done:
+    .word 0
+
+.section .bss
+.align 4
+buffer:
+    .zero MAX_HARTS * WORDS * 4
@@ -1,6 +1,298 @@
 // Copyright 2020 ETH Zurich and University of Bologna.
 // Licensed under the Apache License, Version 2.0, see LICENSE for details.
 // SPDX-License-Identifier: Apache-2.0
+
+// Basic linear algebra subprograms for Snitch.
+//
+// The interface follows CBLAS with all matrices in row-major order. Routines
+// are prefixed with the precision they operate on:
+// - `d`: fp64,
+// - `s`: fp32,
+// - `h`: fp16 (IEEE binary16),
+// - `b`: fp8 (binary8 with 5 exponent and 2 mantissa bits).
+// Scalars of the `s`, `h` and `b` routines are passed as `float`, and the `h`
+// and `b` routines accumulate in fp32. Increments and leading dimensions are
+// given in elements and must be positive.
 #pragma once
 
+#include <stddef.h>
+#include <stdint.h>
+
 double snblas_hello();
+
+/// An fp16 value, stored as its bit pattern.
+typedef uint16_t snblas_fp16_t;
+/// An fp8 value, stored as its bit pattern. This is the upper byte of the
+/// equivalent fp16 value.
+typedef uint8_t snblas_fp8_t;
+
+/// Whether a matrix operand is used as is or transposed.
+enum snblas_trans {
+    SNBLAS_NO_TRANS = 0,
+    SNBLAS_TRANS = 1,
+};
+
+/// Which triangle of a matrix is referenced.
+enum snblas_uplo {
+    SNBLAS_UPPER = 0,
+    SNBLAS_LOWER = 1,
+};
+
+/// Whether a triangular matrix is multiplied from the left or the right.
+enum snblas_side {
+    SNBLAS_LEFT = 0,
+    SNBLAS_RIGHT = 1,
+};
+
+/// Whether a triangular matrix has an implicit unit diagonal.
+enum snblas_diag {
+    SNBLAS_NON_UNIT = 0,
+    SNBLAS_UNIT = 1,
+};
+
+//================================================================================
+// Level 1
+//================================================================================
+
+/// `y = alpha * x + y`
+extern void snblas_daxpy(uint32_t n, double alpha, const double *x,
+                         uint32_t incx, double *y, uint32_t incy);
+extern void snblas_saxpy(uint32_t n, float alpha, const float *x,
+                         uint32_t incx, float *y, uint32_t incy);
+extern void snblas_haxpy(uint32_t n, float alpha, const snblas_fp16_t *x,
+                         uint32_t incx, snblas_fp16_t *y, uint32_t incy);
+extern void snblas_baxpy(uint32_t n, float alpha, const snblas_fp8_t *x,
+                         uint32_t incx, snblas_fp8_t *y, uint32_t incy);
+
+/// `x^T y`
+extern double snblas_ddot(uint32_t n, const double *x, uint32_t incx,
+                          const double *y, uint32_t incy);
+extern float snblas_sdot(uint32_t n, const float *x, uint32_t incx,
+                         const float *y, uint32_t incy);
+extern float snblas_hdot(uint32_t n, const snblas_fp16_t *x, uint32_t incx,
+                         const snblas_fp16_t *y, uint32_t incy);
+extern float snblas_bdot(uint32_t n, const snblas_fp8_t *x, uint32_t incx,
+                         const snblas_fp8_t *y, uint32_t incy);
+
+/// `||x||_2`
+extern double snblas_dnrm2(uint32_t n, const double *x, uint32_t incx);
+extern float snblas_snrm2(uint32_t n, const float *x, uint32_t incx);
+extern float snblas_hnrm2(uint32_t n, const snblas_fp16_t *x, uint32_t incx);
+extern float snblas_bnrm2(uint32_t n, const snblas_fp8_t *x, uint32_t incx);
+
+//================================================================================
+// Level 2
+//================================================================================
+
+/// `y = alpha * op(A) x + beta * y`, with `A` an `m` x `n` matrix. `y` is not
+/// read if `beta` is zero.
+extern void snblas_dgemv(enum snblas_trans trans, uint32_t m, uint32_t n,
+                         double alpha, const double *A, uint32_t lda,
+                         const double *x, uint32_t incx, double beta,
+                         double *y, uint32_t incy);
+extern void snblas_sgemv(enum snblas_trans trans, uint32_t m, uint32_t n,
+                         float alpha, const float *A, uint32_t lda,
+                         const float *x, uint32_t incx, float beta, float *y,
+                         uint32_t incy);
+extern void snblas_hgemv(enum snblas_trans trans, uint32_t m, uint32_t n,
+                         float alpha, const snblas_fp16_t *A, uint32_t lda,
+                         const snblas_fp16_t *x, uint32_t incx, float beta,
+                         snblas_fp16_t *y, uint32_t incy);
+extern void snblas_bgemv(enum snblas_trans trans, uint32_t m, uint32_t n,
+                         float alpha, const snblas_fp8_t *A, uint32_t lda,
+                         const snblas_fp8_t *x, uint32_t incx, float beta,
+                         snblas_fp8_t *y, uint32_t incy);
+
+//================================================================================
+// Level 3
+//================================================================================
+
+/// `C = alpha * op(A) op(B) + beta * C`, with `op(A)` an `m` x `k` and `op(B)`
+/// a `k` x `n` matrix. `C` is not read if `beta` is zero.
+///
+/// The `s`, `h` and `b` routines use packed SIMD when `A` is not and `B` is
+/// transposed and the rows of `A` and `B` are 64-bit aligned. The `b` routine
+/// rounds the pairwise sums of two fp8 products to fp16 before accumulating
+/// them in fp32.
+extern void snblas_dgemm(enum snblas_trans transa, enum snblas_trans transb,
+                         uint32_t m, uint32_t n, uint32_t k, double alpha,
+                         const double *A, uint32_t lda, const double *B,
+                         uint32_t ldb, double beta, double *C, uint32_t ldc);
+extern void snblas_sgemm(enum snblas_trans transa, enum snblas_trans transb,
+                         uint32_t m, uint32_t n, uint32_t k, float alpha,
+                         const float *A, uint32_t lda, const float *B,
+                         uint32_t ldb, float beta, float *C, uint32_t ldc);
+extern void snblas_hgemm(enum snblas_trans transa, enum snblas_trans transb,
+                         uint32_t m, uint32_t n, uint32_t k, float alpha,
+                         const snblas_fp16_t *A, uint32_t lda,
+                         const snblas_fp16_t *B, uint32_t ldb, float beta,
+                         snblas_fp16_t *C, uint32_t ldc);
+extern void snblas_bgemm(enum snblas_trans transa, enum snblas_trans transb,
+                         uint32_t m, uint32_t n, uint32_t k, float alpha,
+                         const snblas_fp8_t *A, uint32_t lda,
+                         const snblas_fp8_t *B, uint32_t ldb, float beta,
+                         snblas_fp8_t *C, uint32_t ldc);
+
+/// `C = alpha * A A^T + beta * C` (`SNBLAS_NO_TRANS`, `A` is `n` x `k`) or
+/// `C = alpha * A^T A + beta * C` (`SNBLAS_TRANS`, `A` is `k` x `n`). Only the
+/// `uplo` triangle of the `n` x `n` matrix `C` is referenced.
+extern void snblas_dsyrk(enum snblas_uplo uplo, enum snblas_trans trans,
+                         uint32_t n, uint32_t k, double alpha, const double *A,
+                         uint32_t lda, double beta, double *C, uint32_t ldc);
+extern void snblas_ssyrk(enum snblas_uplo uplo, enum snblas_trans trans,
+                         uint32_t n, uint32_t k, float alpha, const float *A,
+                         uint32_t lda, float beta, float *C, uint32_t ldc);
+
+/// Solve `op(A) X = alpha * B` (`SNBLAS_LEFT`) or `X op(A) = alpha * B`
+/// (`SNBLAS_RIGHT`) for the `m` x `n` matrix `X`, which overwrites `B`. `A` is
+/// triangular as given by `uplo` and `diag`.
+extern void snblas_dtrsm(enum snblas_side side, enum snblas_uplo uplo,
+                         enum snblas_trans transa, enum snblas_diag diag,
+                         uint32_t m, uint32_t n, double alpha, const double *A,
+                         uint32_t lda, double *B, uint32_t ldb);
+extern void snblas_strsm(enum snblas_side side, enum snblas_uplo uplo,
+                         enum snblas_trans transa, enum snblas_diag diag,
+                         uint32_t m, uint32_t n, float alpha, const float *A,
+                         uint32_t lda, float *B, uint32_t ldb);
+
+//================================================================================
+// Cluster drivers
+//================================================================================
+
+/// Cluster-parallel `daxpy` and `ddot` on contiguous vectors. All cores of the
+/// cluster must call these; every compute core processes a contiguous slice.
+extern void snblas_daxpy_cluster(uint32_t n, double alpha, const double *x,
+                                 double *y);
+extern double snblas_ddot_cluster(uint32_t n, const double *x,
+                                  const double *y);
+
+/// Cluster-parallel GEMM on operands anywhere in memory. All cores of the
+/// cluster must call these with the same arguments.
+///
+/// `C` is computed in tiles, and the tiles of `A`, `B` and `C` are
+/// double-buffered in the `l1_len` bytes at `l1_buf` by the DMA core, while the
+/// compute cores split the rows of the current tile. The `h` and `b` routines
+/// keep an fp32 accumulator tile in the buffer as well and round C once, after
+/// the last tile of `k`. Returns -1 if the buffer is too small to hold one
+/// tile.
+extern int snblas_dgemm_cluster(enum snblas_trans transa,
+                                enum snblas_trans transb, uint32_t m,
+                                uint32_t n, uint32_t k, double alpha,
+                                const double *A, uint32_t lda, const double *B,
+                                uint32_t ldb, double beta, double *C,
+                                uint32_t ldc, void *l1_buf, size_t l1_len);
+extern int snblas_sgemm_cluster(enum snblas_trans transa,
+                                enum snblas_trans transb, uint32_t m,
+                                uint32_t n, uint32_t k, float alpha,
+                                const float *A, uint32_t lda, const float *B,
+                                uint32_t ldb, float beta, float *C,
+                                uint32_t ldc, void *l1_buf, size_t l1_len);
+extern int snblas_hgemm_cluster(enum snblas_trans transa,
+                                enum snblas_trans transb, uint32_t m,
+                                uint32_t n, uint32_t k, float alpha,
+                                const snblas_fp16_t *A, uint32_t lda,
+                                const snblas_fp16_t *B, uint32_t ldb,
+                                float beta, snblas_fp16_t *C, uint32_t ldc,
+                                void *l1_buf, size_t l1_len);
+extern int snblas_bgemm_cluster(enum snblas_trans transa,
+                                enum snblas_trans transb, uint32_t m,
+                                uint32_t n, uint32_t k, float alpha,
+                                const snblas_fp8_t *A, uint32_t lda,
+                                const snblas_fp8_t *B, uint32_t ldb,
+                                float beta, snblas_fp8_t *C, uint32_t ldc,
+                                void *l1_buf, size_t l1_len);
+
+/// Multi-cluster GEMM. All cores of all clusters must call these, each cluster
+/// with a buffer in its own TCDM. The rows of `C` are split evenly across the
+/// clusters, which run the cluster driver on their share and synchronize in a
+/// global barrier. Returns -1 if the share of the calling cluster failed.
+extern int snblas_dgemm_multicluster(
+    enum snblas_trans transa, enum snblas_trans transb, uint32_t m, uint32_t n,
+    uint32_t k, double alpha, const double *A, uint32_t lda, const double *B,
+    uint32_t ldb, double beta, double *C, uint32_t ldc, void *l1_buf,
+    size_t l1_len);
+extern int snblas_sgemm_multicluster(
+    enum snblas_trans transa, enum snblas_trans transb, uint32_t m, uint32_t n,
+    uint32_t k, float alpha, const float *A, uint32_t lda, const float *B,
+    uint32_t ldb, float beta, float *C, uint32_t ldc, void *l1_buf,
+    size_t l1_len);
+extern int snblas_hgemm_multicluster(
+    enum snblas_trans transa, enum snblas_trans transb, uint32_t m, uint32_t n,
+    uint32_t k, float alpha, const snblas_fp16_t *A, uint32_t lda,
+    const snblas_fp16_t *B, uint32_t ldb, float beta, snblas_fp16_t *C,
+    uint32_t ldc, void *l1_buf, size_t l1_len);
+extern int snblas_bgemm_multicluster(
+    enum snblas_trans transa, enum snblas_trans transb, uint32_t m, uint32_t n,
+    uint32_t k, float alpha, const snblas_fp8_t *A, uint32_t lda,
+    const snblas_fp8_t *B, uint32_t ldb, float beta, snblas_fp8_t *C,
+    uint32_t ldc, void *l1_buf, size_t l1_len);
+
+//================================================================================
+// Conversions
+//================================================================================
+
+/// Reinterpret the bits of an fp32 value and back.
+static inline uint32_t snblas_float_bits(float f) {
+    union {
+        float f;
+        uint32_t u;
+    } v = {.f = f};
+    return v.u;
+}
+static inline float snblas_bits_float(uint32_t u) {
+    union {
+        uint32_t u;
+        float f;
+    } v = {.u = u};
+    return v.f;
+}
+
+static inline float snblas_fp16_to_float(snblas_fp16_t h) {
+    uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+    uint32_t exp = (h >> 10) & 0x1f;
+    uint32_t man = h & 0x3ff;
+    if (exp == 0x1f) return snblas_bits_float(sign | 0x7f800000 | man << 13);
+    if (exp != 0) return snblas_bits_float(sign | (exp + 112) << 23 | man << 13);
+    if (man == 0) return snblas_bits_float(sign);
+    // Normalize subnormals.
+    exp = 113;
+    while (!(man & 0x400)) {
+        man <<= 1;
+        exp--;
+    }
+    return snblas_bits_float(sign | exp << 23 | (man & 0x3ff) << 13);
+}
+
+static inline float snblas_fp8_to_float(snblas_fp8_t b) {
+    return snblas_fp16_to_float((snblas_fp16_t)b << 8);
+}
+
+/// Round an fp32 value to nearest even with `man_bits` mantissa bits and a
+/// 5-bit exponent, i.e. to fp16 (10) or fp8 (2).
+static inline uint32_t snblas_round_e5(float f, uint32_t man_bits) {
+    uint32_t u = snblas_float_bits(f);
+    uint32_t sign = (u >> 31) << (man_bits + 5);
+    uint32_t abs = u & 0x7fffffff;
+    uint32_t inf = 0x1fu << man_bits;
+    uint32_t drop = 23 - man_bits;
+    // Inf and NaN, and values rounding beyond the largest finite value.
+    if (abs > 0x7f800000) return sign | inf | 1u << (man_bits - 1);
+    if (abs >= 0x47800000 - (1u << (drop - 1))) return sign | inf;
+    if (abs < 0x38800000) {
+        // Subnormal: let the FPU round at the subnormal ULP by adding a
+        // power of two whose ULP is 2^-14 / 2^man_bits.
+        float magic = snblas_bits_float((127 - 14 - man_bits + 23) << 23);
+        return sign | (snblas_float_bits(snblas_bits_float(abs) + magic) -
+                       snblas_float_bits(magic));
+    }
+    abs += (1u << (drop - 1)) - 1 + ((abs >> drop) & 1);
+    return sign | (abs - 0x38000000) >> drop;
+}
+
+static inline snblas_fp16_t snblas_float_to_fp16(float f) {
+    return snblas_round_e5(f, 10);
+}
+
+static inline snblas_fp8_t snblas_float_to_fp8(float f) {
+    return snblas_round_e5(f, 2);
+}
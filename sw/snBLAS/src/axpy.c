@@ -1,6 +1,113 @@
 // Copyright 2020 ETH Zurich and University of Bologna.
 // Licensed under the Apache License, Version 2.0, see LICENSE for details.
 // SPDX-License-Identifier: Apache-2.0
-#include <snblas.h>
+#include "blas.h"
 
 double snblas_hello() { return 42.3141; }
+
+void snblas_daxpy(uint32_t n, double alpha, const double *x, uint32_t incx,
+                  double *y, uint32_t incy) {
+    if (n == 0) return;
+    // Stream x on ft0 and y on ft1, and write y back through ft2. The write
+    // stream trails the read stream, so every element is read before it is
+    // overwritten.
+    snrt_ssr_loop_1d(SNRT_SSR_DM0, n, incx * sizeof(double));
+    snrt_ssr_loop_1d(SNRT_SSR_DM1, n, incy * sizeof(double));
+    snrt_ssr_loop_1d(SNRT_SSR_DM2, n, incy * sizeof(double));
+    snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_1D, (void *)x);
+    snrt_ssr_read(SNRT_SSR_DM1, SNRT_SSR_1D, y);
+    snrt_ssr_write(SNRT_SSR_DM2, SNRT_SSR_1D, y);
+    register uint32_t reps asm("t1") = n - 1;
+    asm volatile(SSR_ENABLE
+                 // frep.o t1, 1, 0, 0
+                 FREP_O(6, 1, 0, 0)
+                 "fmadd.d ft2, %[alpha], ft0, ft1 \n"
+                 SSR_FENCE_DISABLE
+                 :
+                 : [ alpha ] "f"(alpha), "r"(reps)
+                 : "memory", "t0", "ft0", "ft1", "ft2");
+}
+
+/// Packed SIMD `y += alpha * x` on `words` 64-bit words at `x` and `y`, with
+/// `alpha` replicated over all lanes of `alpha_w`. `op` is `VFMAC_S`, `VFMAC_H`
+/// or `VFMAC_B` and rounds every lane once to the element format. The packed
+/// FMA accumulates into its destination, so y is copied from its read stream
+/// into ft4 first.
+#define AXPY_SIMD(op, words, x, y, alpha_w)                                 \
+    do {                                                                    \
+        snrt_ssr_loop_1d(SNRT_SSR_DM0, words, 8);                           \
+        snrt_ssr_loop_1d(SNRT_SSR_DM1, words, 8);                           \
+        snrt_ssr_loop_1d(SNRT_SSR_DM2, words, 8);                           \
+        snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_1D, (void *)(x));              \
+        snrt_ssr_read(SNRT_SSR_DM1, SNRT_SSR_1D, (void *)(y));              \
+        snrt_ssr_write(SNRT_SSR_DM2, SNRT_SSR_1D, (void *)(y));             \
+        volatile uint64_t a_w = (alpha_w);                                  \
+        register uint32_t reps asm("t1") = (words)-1;                       \
+        asm volatile("fld        ft3, 0(%[a_w])       \n" SSR_ENABLE        \
+                     /* frep.o t1, 3, 0, 0 */                               \
+                     FREP_O(6, 3, 0, 0)                                     \
+                     "fmv.d      ft4, ft1             \n" op(4, 0, 3)       \
+                     "fmv.d      ft2, ft4             \n" SSR_FENCE_DISABLE \
+                     :                                                      \
+                     : [ a_w ] "r"(&a_w), "r"(reps)                         \
+                     : "memory", "t0", "ft0", "ft1", "ft2", "ft3", "ft4");  \
+    } while (0)
+
+void snblas_saxpy(uint32_t n, float alpha, const float *x, uint32_t incx,
+                  float *y, uint32_t incy) {
+    uint32_t i = 0;
+    if (simd_ok(n, sizeof(float), x, incx, y, incy)) {
+        uint64_t a = snblas_float_bits(alpha);
+        AXPY_SIMD(VFMAC_S, n / 2, x, y, a << 32 | a);
+        i = n & ~1;
+    }
+    for (; i < n; i++) y[i * incy] += alpha * x[i * incx];
+}
+
+// The packed fp16 and fp8 FMAs take `alpha` in the element format, so they
+// are only used if it is exactly representable there.
+
+void snblas_haxpy(uint32_t n, float alpha, const snblas_fp16_t *x,
+                  uint32_t incx, snblas_fp16_t *y, uint32_t incy) {
+    uint32_t i = 0;
+    snblas_fp16_t ah = snblas_float_to_fp16(alpha);
+    if (snblas_fp16_to_float(ah) == alpha &&
+        simd_ok(n, sizeof(snblas_fp16_t), x, incx, y, incy)) {
+        uint64_t a = ah * 0x0001000100010001ull;
+        AXPY_SIMD(VFMAC_H, n / 4, x, y, a);
+        i = n & ~3;
+    }
+    for (; i < n; i++) {
+        float r = snblas_fp16_to_float(y[i * incy]) +
+                  alpha * snblas_fp16_to_float(x[i * incx]);
+        y[i * incy] = snblas_float_to_fp16(r);
+    }
+}
+
+void snblas_baxpy(uint32_t n, float alpha, const snblas_fp8_t *x,
+                  uint32_t incx, snblas_fp8_t *y, uint32_t incy) {
+    uint32_t i = 0;
+    snblas_fp8_t ab = snblas_float_to_fp8(alpha);
+    if (snblas_fp8_to_float(ab) == alpha &&
+        simd_ok(n, sizeof(snblas_fp8_t), x, incx, y, incy)) {
+        uint64_t a = ab * 0x0101010101010101ull;
+        AXPY_SIMD(VFMAC_B, n / 8, x, y, a);
+        i = n & ~7;
+    }
+    for (; i < n; i++) {
+        float r = snblas_fp8_to_float(y[i * incy]) +
+                  alpha * snblas_fp8_to_float(x[i * incx]);
+        y[i * incy] = snblas_float_to_fp8(r);
+    }
+}
+
+void snblas_daxpy_cluster(uint32_t n, double alpha, const double *x,
+                          double *y) {
+    if (snrt_is_compute_core()) {
+        uint32_t num = snrt_cluster_compute_core_num();
+        uint32_t idx = snrt_cluster_compute_core_idx();
+        uint32_t lo = n * idx / num, hi = n * (idx + 1) / num;
+        snblas_daxpy(hi - lo, alpha, x + lo, 1, y + lo, 1);
+    }
+    snrt_cluster_hw_barrier();
+}
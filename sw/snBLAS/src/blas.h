@@ -0,0 +1,95 @@
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+// Internal helpers shared by the snBLAS routines.
+#pragma once
+
+#include <snblas.h>
+#include <snrt.h>
+
+/// Offset of element `(i, j)` of `op(M)` for a row-major `M`.
+static inline uint32_t op_ofs(enum snblas_trans trans, uint32_t i, uint32_t j,
+                              uint32_t ld) {
+    return trans ? j * ld + i : i * ld + j;
+}
+
+/// Enable the SSRs at the start of an inline assembly kernel.
+#define SSR_ENABLE "csrsi 0x7C0, 1 \n"
+
+/// Wait for the FPU to retire all instructions, in particular those issued by
+/// the FREP sequencer, then disable the SSRs. Clobbers t0.
+#define SSR_FENCE_DISABLE   \
+    "fmv.x.w t0, fa0    \n" \
+    "csrci   0x7C0, 1   \n" \
+    "bne     t0, zero, 9f \n9: \n"
+
+/// Encode `frep.o rs1, max_inst, stagger_max, stagger_mask`, which the GCC
+/// toolchain does not know. `rs1` is a register number, e.g. 6 for t1.
+#define FREP_O(rs1, max_inst, stagger_max, stagger_mask)                   \
+    ".word (" #max_inst " - 1) << 20 | " #rs1 " << 15 | " #stagger_max     \
+    " << 12 | " #stagger_mask " << 8 | 1 << 7 | 0b0001011 \n"
+
+/// Encode a packed SIMD instruction of the OP-FP vector extensions (see
+/// opcodes-flt-occamy), which the GCC toolchain does not know. The operands are
+/// FP register numbers, e.g. 3 for ft3, and `rs2` is the fixed field of the
+/// unary instructions.
+#define XFVEC(funct7, funct3, rd, rs1, rs2)                                  \
+    ".word " #funct7 " << 25 | " #rs2 " << 20 | " #rs1 " << 15 | " #funct3 \
+    " << 12 | " #rd " << 7 | 0b0110011 \n"
+
+/// `rd += rs1 * rs2` on two fp32 lanes.
+#define VFMAC_S(rd, rs1, rs2) XFVEC(0b1001000, 0, rd, rs1, rs2)
+/// `rd += rs1 * rs2` on four fp16 lanes.
+#define VFMAC_H(rd, rs1, rs2) XFVEC(0b1001000, 2, rd, rs1, rs2)
+/// `rd += rs1 * rs2` on eight fp8 lanes.
+#define VFMAC_B(rd, rs1, rs2) XFVEC(0b1001000, 3, rd, rs1, rs2)
+/// `rd += rs1 . rs2` with two pairs of fp16 products per fp32 lane.
+#define VFDOTPEX_S_H(rd, rs1, rs2) XFVEC(0b1001011, 0, rd, rs1, rs2)
+/// `rd += rs1 . rs2` with two pairs of fp8 products per fp16 lane.
+#define VFDOTPEX_H_B(rd, rs1, rs2) XFVEC(0b1001011, 2, rd, rs1, rs2)
+/// `rd += rs1 + rs2` on two fp32 lanes.
+#define VFADD_S(rd, rs1, rs2) XFVEC(0b1000001, 0, rd, rs1, rs2)
+/// Add the two fp32 lanes of `rs1` to the low lane of `rd`.
+#define VFSUM_S(rd, rs1) XFVEC(0b1000111, 0, rd, rs1, 0b11100)
+/// Add each pair of fp16 lanes of `rs1` to an fp32 lane of `rd`.
+#define VFSUMEX_S_H(rd, rs1) XFVEC(0b1000111, 0, rd, rs1, 0b10110)
+
+/// Dot product of `n` elements streamed on ft0 and ft1 by already configured
+/// SSRs. The FREP sequencer staggers the accumulation over six registers to
+/// hide the FMA latency. `n` must be positive.
+double ddot_ssr(uint32_t n);
+
+/// Dot products of `words` 64-bit words of packed fp32, fp16 or fp8 values
+/// streamed on ft0 and ft1 by already configured SSRs, accumulated in fp32.
+/// `words` must be positive.
+float sdot_simd(uint32_t words);
+float hdot_simd(uint32_t words);
+float bdot_simd(uint32_t words);
+
+/// Whether `n` elements of `size` bytes at `x` and `y`, with the increments
+/// `incx` and `incy`, are contiguous, start word-aligned and cover at least one
+/// 64-bit word, such that the packed SIMD kernels apply.
+static inline int simd_ok(uint32_t n, uint32_t size, const void *x,
+                          uint32_t incx, const void *y, uint32_t incy) {
+    return incx == 1 && incy == 1 && n * size >= 8 &&
+           (((uintptr_t)x | (uintptr_t)y) & 7) == 0;
+}
+
+/// `snblas_hgemm` and `snblas_bgemm` with an fp32 `C`, in which the cluster
+/// driver accumulates across tiles of `k`.
+void hgemm_f32(enum snblas_trans transa, enum snblas_trans transb, uint32_t m,
+               uint32_t n, uint32_t k, float alpha, const snblas_fp16_t *A,
+               uint32_t lda, const snblas_fp16_t *B, uint32_t ldb, float beta,
+               float *C, uint32_t ldc);
+void bgemm_f32(enum snblas_trans transa, enum snblas_trans transb, uint32_t m,
+               uint32_t n, uint32_t k, float alpha, const snblas_fp8_t *A,
+               uint32_t lda, const snblas_fp8_t *B, uint32_t ldb, float beta,
+               float *C, uint32_t ldc);
+
+/// Type-erased GEMM as dispatched by the cluster drivers. The scalars are
+/// narrowed to the precision of the routine.
+typedef void (*gemm_fn_t)(enum snblas_trans transa, enum snblas_trans transb,
+                          uint32_t m, uint32_t n, uint32_t k, double alpha,
+                          const void *A, uint32_t lda, const void *B,
+                          uint32_t ldb, double beta, void *C, uint32_t ldc);
@@ -0,0 +1,226 @@
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+#include <float.h>
+#include <math.h>
+
+#include "blas.h"
+
+#define MAX_CLUSTERS 32
+#define MAX_CLUSTER_CORES 16
+
+double ddot_ssr(uint32_t n) {
+    volatile double res;
+    register uint32_t reps asm("t1") = n - 1;
+    asm volatile(
+        "fcvt.d.w   ft3, zero           \n"
+        SSR_ENABLE
+        "fmv.d      ft4, ft3            \n"
+        "fmv.d      ft5, ft3            \n"
+        "fmv.d      ft6, ft3            \n"
+        "fmv.d      ft7, ft3            \n"
+        "fmv.d      fs0, ft3            \n"
+        // frep.o t1, 1, 5, 0b1001
+        FREP_O(6, 1, 5, 0b1001)
+        "fmadd.d    ft3, ft1, ft0, ft3  \n"
+        // Reduction
+        "fadd.d     ft9, ft6, ft7       \n"
+        "fadd.d     ft6, ft4, ft5       \n"
+        "fadd.d     ft7, fs0, ft3       \n"
+        "fadd.d     ft4, ft6, ft7       \n"
+        "fadd.d     ft8, ft4, ft9       \n"
+        "fsd        ft8, 0(%[res])      \n"
+        SSR_FENCE_DISABLE
+        :
+        : [ res ] "r"(&res), "r"(reps)
+        : "memory", "t0", "ft0", "ft1", "ft2", "ft3", "ft4", "ft5", "ft6",
+          "ft7", "ft8", "ft9", "fs0");
+    return res;
+}
+
+double snblas_ddot(uint32_t n, const double *x, uint32_t incx,
+                   const double *y, uint32_t incy) {
+    if (n == 0) return 0.0;
+    snrt_ssr_loop_1d(SNRT_SSR_DM0, n, incx * sizeof(double));
+    snrt_ssr_loop_1d(SNRT_SSR_DM1, n, incy * sizeof(double));
+    snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_1D, (void *)x);
+    snrt_ssr_read(SNRT_SSR_DM1, SNRT_SSR_1D, (void *)y);
+    return ddot_ssr(n);
+}
+
+/// Smallest sum of squares that the unscaled norm accepts. Squares that
+/// underflow below it cannot change the result in double precision.
+#define DNRM2_SSQ_MIN 0x1p-900
+
+double snblas_dnrm2(uint32_t n, const double *x, uint32_t incx) {
+    // The streamed sum of squares is accurate unless it overflows or
+    // underflows, in which case the norm is recomputed with the scaled
+    // accumulation of the reference BLAS: `scale^2 * ssq` is the sum of
+    // squares so far, with `scale` the largest magnitude seen.
+    double ssq = snblas_ddot(n, x, incx, x, incx);
+    if (ssq >= DNRM2_SSQ_MIN && ssq <= DBL_MAX) return sqrt(ssq);
+    double scale = 0.0;
+    ssq = 1.0;
+    for (uint32_t i = 0; i < n; i++) {
+        double a = fabs(x[i * incx]);
+        if (a == 0.0) continue;
+        if (scale < a) {
+            ssq = 1.0 + ssq * (scale / a) * (scale / a);
+            scale = a;
+        } else {
+            ssq += (a / scale) * (a / scale);
+        }
+    }
+    return scale * sqrt(ssq);
+}
+
+/// Packed SIMD dot product of `words` 64-bit words streamed on ft0 and ft1,
+/// accumulated in fp32 lanes. `op` multiplies and accumulates one word pair
+/// into a packed fp32 accumulator, e.g. `VFMAC_S(3, 0, 1)`. The FREP sequencer
+/// staggers the accumulator over ft3 to ft6.
+#define SIMD_DOT(op, words)                                                 \
+    ({                                                                      \
+        volatile float res;                                                 \
+        register uint32_t reps asm("t1") = (words)-1;                       \
+        asm volatile("fcvt.d.w   ft3, zero            \n" SSR_ENABLE        \
+                     "fmv.d      ft4, ft3             \n"                   \
+                     "fmv.d      ft5, ft3             \n"                   \
+                     "fmv.d      ft6, ft3             \n"                   \
+                     "fmv.d      ft7, ft3             \n"                   \
+                     /* frep.o t1, 1, 3, 0b0001 */                          \
+                     FREP_O(6, 1, 3, 0b0001) op                             \
+                     VFADD_S(3, 3, 4)                                       \
+                     VFADD_S(5, 5, 6)                                       \
+                     VFADD_S(3, 3, 5)                                       \
+                     VFSUM_S(7, 3)                                          \
+                     "fsw        ft7, 0(%[res])       \n" SSR_FENCE_DISABLE \
+                     :                                                      \
+                     : [ res ] "r"(&res), "r"(reps)                         \
+                     : "memory", "t0", "ft0", "ft1", "ft2", "ft3", "ft4",   \
+                       "ft5", "ft6", "ft7");                                \
+        res;                                                                \
+    })
+
+float sdot_simd(uint32_t words) { return SIMD_DOT(VFMAC_S(3, 0, 1), words); }
+
+float hdot_simd(uint32_t words) {
+    return SIMD_DOT(VFDOTPEX_S_H(3, 0, 1), words);
+}
+
+/// There is no fp8 to fp32 expanding dot product: every word pair is reduced
+/// to four fp16 lanes in ft4, which are widened into the fp32 accumulator ft3
+/// right away. Only the pairwise sums of two fp8 products are rounded to fp16.
+float bdot_simd(uint32_t words) {
+    volatile float res;
+    register uint32_t reps asm("t1") = words - 1;
+    asm volatile(
+        "fcvt.d.w   ft3, zero           \n"
+        SSR_ENABLE
+        "fmv.d      ft5, ft3            \n"
+        "fmv.d      ft7, ft3            \n"
+        // frep.o t1, 3, 0, 0
+        FREP_O(6, 3, 0, 0)
+        "fmv.d      ft4, ft5            \n"
+        VFDOTPEX_H_B(4, 0, 1)
+        VFSUMEX_S_H(3, 4)
+        VFSUM_S(7, 3)
+        "fsw        ft7, 0(%[res])      \n"
+        SSR_FENCE_DISABLE
+        :
+        : [ res ] "r"(&res), "r"(reps)
+        : "memory", "t0", "ft0", "ft1", "ft2", "ft3", "ft4", "ft5", "ft6",
+          "ft7");
+    return res;
+}
+
+/// Configure ft0 and ft1 to stream `words` 64-bit words from `x` and `y`.
+static void setup_simd(uint32_t words, const void *x, const void *y) {
+    snrt_ssr_loop_1d(SNRT_SSR_DM0, words, 8);
+    snrt_ssr_loop_1d(SNRT_SSR_DM1, words, 8);
+    snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_1D, (void *)x);
+    snrt_ssr_read(SNRT_SSR_DM1, SNRT_SSR_1D, (void *)y);
+}
+
+float snblas_sdot(uint32_t n, const float *x, uint32_t incx, const float *y,
+                  uint32_t incy) {
+    float acc = 0.0f;
+    uint32_t i = 0;
+    if (simd_ok(n, sizeof(float), x, incx, y, incy)) {
+        setup_simd(n / 2, x, y);
+        acc = sdot_simd(n / 2);
+        i = n & ~1;
+    }
+    for (; i < n; i++) acc += x[i * incx] * y[i * incy];
+    return acc;
+}
+
+float snblas_hdot(uint32_t n, const snblas_fp16_t *x, uint32_t incx,
+                  const snblas_fp16_t *y, uint32_t incy) {
+    float acc = 0.0f;
+    uint32_t i = 0;
+    if (simd_ok(n, sizeof(snblas_fp16_t), x, incx, y, incy)) {
+        setup_simd(n / 4, x, y);
+        acc = hdot_simd(n / 4);
+        i = n & ~3;
+    }
+    for (; i < n; i++)
+        acc += snblas_fp16_to_float(x[i * incx]) *
+               snblas_fp16_to_float(y[i * incy]);
+    return acc;
+}
+
+float snblas_bdot(uint32_t n, const snblas_fp8_t *x, uint32_t incx,
+                  const snblas_fp8_t *y, uint32_t incy) {
+    float acc = 0.0f;
+    uint32_t i = 0;
+    if (simd_ok(n, sizeof(snblas_fp8_t), x, incx, y, incy)) {
+        setup_simd(n / 8, x, y);
+        acc = bdot_simd(n / 8);
+        i = n & ~7;
+    }
+    for (; i < n; i++)
+        acc += snblas_fp8_to_float(x[i * incx]) *
+               snblas_fp8_to_float(y[i * incy]);
+    return acc;
+}
+
+float snblas_snrm2(uint32_t n, const float *x, uint32_t incx) {
+    // The squares of all fp32 values are normal doubles, so recomputing an
+    // overflowed or underflowed sum in double precision needs no scaling.
+    float ssq = snblas_sdot(n, x, incx, x, incx);
+    if (ssq >= 0x1p-100f && ssq <= FLT_MAX) return sqrtf(ssq);
+    double acc = 0.0;
+    for (uint32_t i = 0; i < n; i++)
+        acc += (double)x[i * incx] * x[i * incx];
+    return sqrt(acc);
+}
+
+float snblas_hnrm2(uint32_t n, const snblas_fp16_t *x, uint32_t incx) {
+    return sqrtf(snblas_hdot(n, x, incx, x, incx));
+}
+
+float snblas_bnrm2(uint32_t n, const snblas_fp8_t *x, uint32_t incx) {
+    return sqrtf(snblas_bdot(n, x, incx, x, incx));
+}
+
+double snblas_ddot_cluster(uint32_t n, const double *x, const double *y) {
+    // Partial sums of the compute cores, reduced by the first one. The slots
+    // are per cluster such that clusters may run this concurrently.
+    static double partial[MAX_CLUSTERS][MAX_CLUSTER_CORES];
+    static volatile double result[MAX_CLUSTERS];
+    uint32_t cl = snrt_cluster_idx() % MAX_CLUSTERS;
+    uint32_t num = snrt_min(snrt_cluster_compute_core_num(), MAX_CLUSTER_CORES);
+    uint32_t idx = snrt_cluster_compute_core_idx();
+    if (snrt_is_compute_core() && idx < num) {
+        uint32_t lo = n * idx / num, hi = n * (idx + 1) / num;
+        partial[cl][idx] = snblas_ddot(hi - lo, x + lo, 1, y + lo, 1);
+    }
+    snrt_cluster_hw_barrier();
+    if (snrt_is_compute_core() && idx == 0) {
+        double acc = 0.0;
+        for (uint32_t i = 0; i < num; i++) acc += partial[cl][i];
+        result[cl] = acc;
+    }
+    snrt_cluster_hw_barrier();
+    return result[cl];
+}
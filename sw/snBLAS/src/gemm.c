@@ -0,0 +1,314 @@
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+#include "blas.h"
+
+// All GEMMs compute the columns of C in blocks of `*_UNROLL`, with one
+// accumulator per column such that consecutive FMAs are independent. The
+// streams walk the four loops `u` (column in block, B only), `k`, block and
+// row of C; A repeats each element for all columns of a block. Columns left
+// over by the blocking are computed as strided dot products afterwards, as
+// these reconfigure the SSRs.
+
+#define DGEMM_UNROLL 8
+#define SIMD_UNROLL 4
+
+/// `alpha * acc + beta * c`, without reading `c` if `beta` is zero.
+static inline double axpby(double acc, double alpha, double beta,
+                           const double *c) {
+    return beta == 0.0 ? alpha * acc : alpha * acc + beta * *c;
+}
+
+static inline float axpbys(float acc, float alpha, float beta,
+                           const float *c) {
+    return beta == 0.0f ? alpha * acc : alpha * acc + beta * *c;
+}
+
+void snblas_dgemm(enum snblas_trans transa, enum snblas_trans transb,
+                  uint32_t m, uint32_t n, uint32_t k, double alpha,
+                  const double *A, uint32_t lda, const double *B, uint32_t ldb,
+                  double beta, double *C, uint32_t ldc) {
+    // Element strides of op(A) along m and k, and of op(B) along k and n.
+    const uint32_t sam = transa ? 1 : lda, sak = transa ? lda : 1;
+    const uint32_t sbk = transb ? 1 : ldb, sbn = transb ? ldb : 1;
+    const uint32_t U = DGEMM_UNROLL;
+    const uint32_t blocks = k > 0 ? n / U : 0;
+
+    if (m > 0 && blocks > 0) {
+        snrt_ssr_loop_3d(SNRT_SSR_DM0, k, blocks, m, sak * sizeof(double), 0,
+                         sam * sizeof(double));
+        snrt_ssr_repeat(SNRT_SSR_DM0, U);
+        snrt_ssr_loop_4d(SNRT_SSR_DM1, U, k, blocks, m, sbn * sizeof(double),
+                         sbk * sizeof(double), U * sbn * sizeof(double), 0);
+        snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_3D, (void *)A);
+        snrt_ssr_read(SNRT_SSR_DM1, SNRT_SSR_4D, (void *)B);
+
+        double acc[DGEMM_UNROLL];
+        register uint32_t reps asm("t1") = k - 1;
+        for (uint32_t i = 0; i < m; i++) {
+            for (uint32_t b = 0; b < blocks; b++) {
+                asm volatile(
+                    "fcvt.d.w   ft3, zero           \n"
+                    "fmv.d      ft4, ft3            \n"
+                    "fmv.d      ft5, ft3            \n"
+                    "fmv.d      ft6, ft3            \n"
+                    "fmv.d      ft7, ft3            \n"
+                    "fmv.d      ft8, ft3            \n"
+                    "fmv.d      ft9, ft3            \n"
+                    "fmv.d      ft10, ft3           \n"
+                    SSR_ENABLE
+                    // frep.o t1, 8, 0, 0
+                    FREP_O(6, 8, 0, 0)
+                    "fmadd.d    ft3, ft0, ft1, ft3  \n"
+                    "fmadd.d    ft4, ft0, ft1, ft4  \n"
+                    "fmadd.d    ft5, ft0, ft1, ft5  \n"
+                    "fmadd.d    ft6, ft0, ft1, ft6  \n"
+                    "fmadd.d    ft7, ft0, ft1, ft7  \n"
+                    "fmadd.d    ft8, ft0, ft1, ft8  \n"
+                    "fmadd.d    ft9, ft0, ft1, ft9  \n"
+                    "fmadd.d    ft10, ft0, ft1, ft10\n"
+                    "fsd        ft3, 0(%[acc])      \n"
+                    "fsd        ft4, 8(%[acc])      \n"
+                    "fsd        ft5, 16(%[acc])     \n"
+                    "fsd        ft6, 24(%[acc])     \n"
+                    "fsd        ft7, 32(%[acc])     \n"
+                    "fsd        ft8, 40(%[acc])     \n"
+                    "fsd        ft9, 48(%[acc])     \n"
+                    "fsd        ft10, 56(%[acc])    \n"
+                    SSR_FENCE_DISABLE
+                    :
+                    : [ acc ] "r"(acc), "r"(reps)
+                    : "memory", "t0", "ft0", "ft1", "ft2", "ft3", "ft4", "ft5",
+                      "ft6", "ft7", "ft8", "ft9", "ft10");
+                double *c = C + i * ldc + b * U;
+                for (uint32_t u = 0; u < U; u++)
+                    c[u] = axpby(acc[u], alpha, beta, c + u);
+            }
+        }
+        snrt_ssr_repeat(SNRT_SSR_DM0, 1);
+    }
+
+    for (uint32_t i = 0; i < m; i++) {
+        for (uint32_t j = blocks * U; j < n; j++) {
+            double acc = k > 0 ? snblas_ddot(k, A + i * sam, sak, B + j * sbn,
+                                             sbk)
+                               : 0.0;
+            C[i * ldc + j] = axpby(acc, alpha, beta, C + i * ldc + j);
+        }
+    }
+}
+
+/// Output formats of the packed SIMD GEMM.
+enum simd_out { OUT_S, OUT_H, OUT_B };
+
+/// Element `i` of a vector of fp32 (`size == 4`), fp16 or fp8 values.
+static inline float elem(uint32_t size, const void *p, uint32_t i) {
+    if (size == sizeof(float)) return ((const float *)p)[i];
+    if (size == sizeof(snblas_fp16_t))
+        return snblas_fp16_to_float(((const snblas_fp16_t *)p)[i]);
+    return snblas_fp8_to_float(((const snblas_fp8_t *)p)[i]);
+}
+
+/// `c = alpha * acc + beta * c` in the output format `out`, without reading
+/// `c` if `beta` is zero.
+static inline void store(enum simd_out out, void *C, uint32_t ofs, float acc,
+                         float alpha, float beta) {
+    if (out == OUT_S) {
+        float *c = (float *)C + ofs;
+        *c = axpbys(acc, alpha, beta, c);
+    } else if (out == OUT_H) {
+        snblas_fp16_t *c = (snblas_fp16_t *)C + ofs;
+        float r = alpha * acc;
+        if (beta != 0.0f) r += beta * snblas_fp16_to_float(*c);
+        *c = snblas_float_to_fp16(r);
+    } else {
+        snblas_fp8_t *c = (snblas_fp8_t *)C + ofs;
+        float r = alpha * acc;
+        if (beta != 0.0f) r += beta * snblas_fp8_to_float(*c);
+        *c = snblas_float_to_fp8(r);
+    }
+}
+
+/// One block of `SIMD_UNROLL` columns for fp32 or fp16 inputs: `op` is
+/// `VFMAC_S` or `VFDOTPEX_S_H` and accumulates into two fp32 lanes per column.
+#define SIMD_GEMM_BLOCK(op)                                                \
+    asm volatile("fcvt.d.w   ft3, zero           \n"                       \
+                 "fmv.d      ft4, ft3            \n"                       \
+                 "fmv.d      ft5, ft3            \n"                       \
+                 "fmv.d      ft6, ft3            \n"                       \
+                 "fmv.d      ft7, ft3            \n"                       \
+                 "fmv.d      ft8, ft3            \n"                       \
+                 "fmv.d      ft9, ft3            \n"                       \
+                 "fmv.d      ft10, ft3           \n" SSR_ENABLE            \
+                 /* frep.o t1, 4, 0, 0 */                                  \
+                 FREP_O(6, 4, 0, 0) op(3, 0, 1) op(4, 0, 1) op(5, 0, 1)    \
+                 op(6, 0, 1) VFSUM_S(7, 3) VFSUM_S(8, 4) VFSUM_S(9, 5)     \
+                 VFSUM_S(10, 6)                                            \
+                 "fsw        ft7, 0(%[acc])      \n"                       \
+                 "fsw        ft8, 4(%[acc])      \n"                       \
+                 "fsw        ft9, 8(%[acc])      \n"                       \
+                 "fsw        ft10, 12(%[acc])    \n" SSR_FENCE_DISABLE     \
+                 :                                                         \
+                 : [ acc ] "r"(acc), "r"(reps)                             \
+                 : "memory", "t0", "ft0", "ft1", "ft2", "ft3", "ft4", "ft5", \
+                   "ft6", "ft7", "ft8", "ft9", "ft10")
+
+/// One block of `SIMD_UNROLL` columns for fp8 inputs. Every word pair is
+/// reduced to four fp16 lanes in ft7 to ft10, which are widened into the fp32
+/// accumulators ft3 to ft6 right away, as in `bdot_simd`.
+#define SIMD_GEMM_BLOCK_B()                                                \
+    asm volatile("fcvt.d.w   ft3, zero           \n"                       \
+                 "fmv.d      ft4, ft3            \n"                       \
+                 "fmv.d      ft5, ft3            \n"                       \
+                 "fmv.d      ft6, ft3            \n"                       \
+                 "fmv.d      ft11, ft3           \n" SSR_ENABLE            \
+                 /* frep.o t1, 12, 0, 0 */                                 \
+                 FREP_O(6, 12, 0, 0)                                       \
+                 "fmv.d      ft7, ft11           \n"                       \
+                 "fmv.d      ft8, ft11           \n"                       \
+                 "fmv.d      ft9, ft11           \n"                       \
+                 "fmv.d      ft10, ft11          \n"                       \
+                 VFDOTPEX_H_B(7, 0, 1) VFDOTPEX_H_B(8, 0, 1)               \
+                 VFDOTPEX_H_B(9, 0, 1) VFDOTPEX_H_B(10, 0, 1)              \
+                 VFSUMEX_S_H(3, 7) VFSUMEX_S_H(4, 8) VFSUMEX_S_H(5, 9)     \
+                 VFSUMEX_S_H(6, 10)                                        \
+                 "fmv.d      ft7, ft11           \n"                       \
+                 "fmv.d      ft8, ft11           \n"                       \
+                 "fmv.d      ft9, ft11           \n"                       \
+                 "fmv.d      ft10, ft11          \n"                       \
+                 VFSUM_S(7, 3) VFSUM_S(8, 4) VFSUM_S(9, 5) VFSUM_S(10, 6)  \
+                 "fsw        ft7, 0(%[acc])      \n"                       \
+                 "fsw        ft8, 4(%[acc])      \n"                       \
+                 "fsw        ft9, 8(%[acc])      \n"                       \
+                 "fsw        ft10, 12(%[acc])    \n" SSR_FENCE_DISABLE     \
+                 :                                                         \
+                 : [ acc ] "r"(acc), "r"(reps)                             \
+                 : "memory", "t0", "ft0", "ft1", "ft2", "ft3", "ft4", "ft5", \
+                   "ft6", "ft7", "ft8", "ft9", "ft10", "ft11")
+
+/// Packed SIMD GEMM for `C = alpha * A B^T + beta * C`, where a 64-bit word of
+/// A and B holds two fp32, four fp16 or eight fp8 values (`size` of 4, 2 or 1)
+/// and C is stored in the format `out`. The products are accumulated in fp32
+/// lanes and summed up at the end; the elements of `k` beyond the last full
+/// word are added by scalar code. Returns the number of leading columns of C
+/// computed.
+static uint32_t gemm_simd(uint32_t size, enum simd_out out, uint32_t m,
+                          uint32_t n, uint32_t k, float alpha, const void *A,
+                          uint32_t lda, const void *B, uint32_t ldb,
+                          float beta, void *C, uint32_t ldc) {
+    const uint32_t lanes = 8 / size;
+    const uint32_t U = SIMD_UNROLL;
+    const uint32_t blocks = n / U;
+    const uint32_t words = k / lanes;
+    if (m == 0 || blocks == 0 || words == 0 ||
+        ((uintptr_t)A | (uintptr_t)B | lda * size | ldb * size) & 7)
+        return 0;
+
+    snrt_ssr_loop_3d(SNRT_SSR_DM0, words, blocks, m, 8, 0, lda * size);
+    snrt_ssr_repeat(SNRT_SSR_DM0, U);
+    snrt_ssr_loop_4d(SNRT_SSR_DM1, U, words, blocks, m, ldb * size, 8,
+                     U * ldb * size, 0);
+    snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_3D, (void *)A);
+    snrt_ssr_read(SNRT_SSR_DM1, SNRT_SSR_4D, (void *)B);
+
+    float acc[SIMD_UNROLL];
+    register uint32_t reps asm("t1") = words - 1;
+    for (uint32_t i = 0; i < m; i++) {
+        for (uint32_t b = 0; b < blocks; b++) {
+            if (size == sizeof(float))
+                SIMD_GEMM_BLOCK(VFMAC_S);
+            else if (size == sizeof(snblas_fp16_t))
+                SIMD_GEMM_BLOCK(VFDOTPEX_S_H);
+            else
+                SIMD_GEMM_BLOCK_B();
+            for (uint32_t u = 0; u < U; u++) {
+                uint32_t j = b * U + u;
+                for (uint32_t l = words * lanes; l < k; l++)
+                    acc[u] += elem(size, A, i * lda + l) *
+                              elem(size, B, j * ldb + l);
+                store(out, C, i * ldc + j, acc[u], alpha, beta);
+            }
+        }
+    }
+    snrt_ssr_repeat(SNRT_SSR_DM0, 1);
+    return blocks * U;
+}
+
+#undef SIMD_GEMM_BLOCK
+#undef SIMD_GEMM_BLOCK_B
+
+void snblas_sgemm(enum snblas_trans transa, enum snblas_trans transb,
+                  uint32_t m, uint32_t n, uint32_t k, float alpha,
+                  const float *A, uint32_t lda, const float *B, uint32_t ldb,
+                  float beta, float *C, uint32_t ldc) {
+    const uint32_t sam = transa ? 1 : lda, sak = transa ? lda : 1;
+    const uint32_t sbk = transb ? 1 : ldb, sbn = transb ? ldb : 1;
+    uint32_t done = 0;
+    if (!transa && transb)
+        done = gemm_simd(sizeof(float), OUT_S, m, n, k, alpha, A, lda, B, ldb,
+                         beta, C, ldc);
+    for (uint32_t i = 0; i < m; i++) {
+        for (uint32_t j = done; j < n; j++) {
+            float acc = snblas_sdot(k, A + i * sam, sak, B + j * sbn, sbk);
+            C[i * ldc + j] = axpbys(acc, alpha, beta, C + i * ldc + j);
+        }
+    }
+}
+
+/// GEMM on fp16 (`size == 2`) or fp8 (`size == 1`) operands, with C stored in
+/// the format `out`.
+static void gemm_hb(uint32_t size, enum simd_out out, enum snblas_trans transa,
+                    enum snblas_trans transb, uint32_t m, uint32_t n,
+                    uint32_t k, float alpha, const void *A, uint32_t lda,
+                    const void *B, uint32_t ldb, float beta, void *C,
+                    uint32_t ldc) {
+    const uint32_t sam = transa ? 1 : lda, sak = transa ? lda : 1;
+    const uint32_t sbk = transb ? 1 : ldb, sbn = transb ? ldb : 1;
+    uint32_t done = 0;
+    if (!transa && transb)
+        done = gemm_simd(size, out, m, n, k, alpha, A, lda, B, ldb, beta, C,
+                         ldc);
+    for (uint32_t i = 0; i < m; i++) {
+        for (uint32_t j = done; j < n; j++) {
+            const uint8_t *a = (const uint8_t *)A + i * sam * size;
+            const uint8_t *b = (const uint8_t *)B + j * sbn * size;
+            float acc = size == sizeof(snblas_fp16_t)
+                            ? snblas_hdot(k, (const snblas_fp16_t *)a, sak,
+                                          (const snblas_fp16_t *)b, sbk)
+                            : snblas_bdot(k, a, sak, b, sbk);
+            store(out, C, i * ldc + j, acc, alpha, beta);
+        }
+    }
+}
+
+void snblas_hgemm(enum snblas_trans transa, enum snblas_trans transb,
+                  uint32_t m, uint32_t n, uint32_t k, float alpha,
+                  const snblas_fp16_t *A, uint32_t lda, const snblas_fp16_t *B,
+                  uint32_t ldb, float beta, snblas_fp16_t *C, uint32_t ldc) {
+    gemm_hb(sizeof(snblas_fp16_t), OUT_H, transa, transb, m, n, k, alpha, A,
+            lda, B, ldb, beta, C, ldc);
+}
+
+void snblas_bgemm(enum snblas_trans transa, enum snblas_trans transb,
+                  uint32_t m, uint32_t n, uint32_t k, float alpha,
+                  const snblas_fp8_t *A, uint32_t lda, const snblas_fp8_t *B,
+                  uint32_t ldb, float beta, snblas_fp8_t *C, uint32_t ldc) {
+    gemm_hb(sizeof(snblas_fp8_t), OUT_B, transa, transb, m, n, k, alpha, A,
+            lda, B, ldb, beta, C, ldc);
+}
+
+void hgemm_f32(enum snblas_trans transa, enum snblas_trans transb, uint32_t m,
+               uint32_t n, uint32_t k, float alpha, const snblas_fp16_t *A,
+               uint32_t lda, const snblas_fp16_t *B, uint32_t ldb, float beta,
+               float *C, uint32_t ldc) {
+    gemm_hb(sizeof(snblas_fp16_t), OUT_S, transa, transb, m, n, k, alpha, A,
+            lda, B, ldb, beta, C, ldc);
+}
+
+void bgemm_f32(enum snblas_trans transa, enum snblas_trans transb, uint32_t m,
+               uint32_t n, uint32_t k, float alpha, const snblas_fp8_t *A,
+               uint32_t lda, const snblas_fp8_t *B, uint32_t ldb, float beta,
+               float *C, uint32_t ldc) {
+    gemm_hb(sizeof(snblas_fp8_t), OUT_S, transa, transb, m, n, k, alpha, A,
+            lda, B, ldb, beta, C, ldc);
+}
@@ -0,0 +1,359 @@
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+#include "blas.h"
+
+#define ALIGN_UP(addr, size) (((addr) + (size)-1) & ~((size)-1))
+
+/// Tile sizes are multiples of this, such that the tile rows of the SIMD
+/// kernels stay 64-bit aligned.
+#define TILE_GRAIN 8
+
+/// A GEMM precision as seen by the tiled driver. The precisions narrower than
+/// fp32 accumulate across the tiles of `k` in an fp32 tile through `acc_fn`,
+/// which takes an fp32 C, and round to the element format once at the end.
+struct gemm_prec {
+    uint32_t size;
+    gemm_fn_t fn;
+    gemm_fn_t acc_fn;
+};
+
+static void dgemm_fn(enum snblas_trans ta, enum snblas_trans tb, uint32_t m,
+                     uint32_t n, uint32_t k, double alpha, const void *A,
+                     uint32_t lda, const void *B, uint32_t ldb, double beta,
+                     void *C, uint32_t ldc) {
+    snblas_dgemm(ta, tb, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+}
+
+static void sgemm_fn(enum snblas_trans ta, enum snblas_trans tb, uint32_t m,
+                     uint32_t n, uint32_t k, double alpha, const void *A,
+                     uint32_t lda, const void *B, uint32_t ldb, double beta,
+                     void *C, uint32_t ldc) {
+    snblas_sgemm(ta, tb, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+}
+
+static void hgemm_fn(enum snblas_trans ta, enum snblas_trans tb, uint32_t m,
+                     uint32_t n, uint32_t k, double alpha, const void *A,
+                     uint32_t lda, const void *B, uint32_t ldb, double beta,
+                     void *C, uint32_t ldc) {
+    snblas_hgemm(ta, tb, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+}
+
+static void bgemm_fn(enum snblas_trans ta, enum snblas_trans tb, uint32_t m,
+                     uint32_t n, uint32_t k, double alpha, const void *A,
+                     uint32_t lda, const void *B, uint32_t ldb, double beta,
+                     void *C, uint32_t ldc) {
+    snblas_bgemm(ta, tb, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+}
+
+static void hgemm_acc_fn(enum snblas_trans ta, enum snblas_trans tb,
+                         uint32_t m, uint32_t n, uint32_t k, double alpha,
+                         const void *A, uint32_t lda, const void *B,
+                         uint32_t ldb, double beta, void *C, uint32_t ldc) {
+    hgemm_f32(ta, tb, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+}
+
+static void bgemm_acc_fn(enum snblas_trans ta, enum snblas_trans tb,
+                         uint32_t m, uint32_t n, uint32_t k, double alpha,
+                         const void *A, uint32_t lda, const void *B,
+                         uint32_t ldb, double beta, void *C, uint32_t ldc) {
+    bgemm_f32(ta, tb, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+}
+
+static const struct gemm_prec prec_d = {sizeof(double), dgemm_fn, NULL};
+static const struct gemm_prec prec_s = {sizeof(float), sgemm_fn, NULL};
+static const struct gemm_prec prec_h = {sizeof(snblas_fp16_t), hgemm_fn,
+                                        hgemm_acc_fn};
+static const struct gemm_prec prec_b = {sizeof(snblas_fp8_t), bgemm_fn,
+                                        bgemm_acc_fn};
+
+/// Tile sizes and the TCDM layout of the tiled driver. Every core derives the
+/// same plan from the arguments, so the cores need not share any state.
+struct plan {
+    uint32_t tm, tn, tk;
+    uint32_t tiles_m, tiles_n, tiles_k;
+    uint8_t *a[2], *b[2], *c[2];
+    float *acc;
+};
+
+/// Bytes taken by the two A, B and C buffers and the fp32 accumulator tile,
+/// if any, for the given tile sizes. A single accumulator suffices, as only
+/// the compute cores touch it.
+static size_t footprint(const struct gemm_prec *pr, uint32_t tm, uint32_t tn,
+                        uint32_t tk) {
+    uint32_t size = pr->size;
+    return 2 * (ALIGN_UP(tm * tk * size, 8) + ALIGN_UP(tk * tn * size, 8) +
+                ALIGN_UP(tm * tn * size, 8)) +
+           (pr->acc_fn ? tm * tn * sizeof(float) : 0);
+}
+
+/// Pick the largest square tiles (clamped to the problem) that fit into the
+/// buffer. Returns -1 if not even the smallest tile fits.
+static int make_plan(struct plan *p, const struct gemm_prec *pr, uint32_t m,
+                     uint32_t n, uint32_t k, void *l1_buf, size_t l1_len) {
+    const uint32_t size = pr->size;
+    uint32_t m_up = ALIGN_UP(m, TILE_GRAIN), n_up = ALIGN_UP(n, TILE_GRAIN);
+    uint32_t k_up = ALIGN_UP(k, TILE_GRAIN);
+    uint32_t dim_max = snrt_max(m_up, snrt_max(n_up, k_up));
+    uint32_t t = TILE_GRAIN;
+    if (footprint(pr, snrt_min(t, m_up), snrt_min(t, n_up),
+                  snrt_min(t, k_up)) > l1_len)
+        return -1;
+    while (t < dim_max &&
+           footprint(pr, snrt_min(t + TILE_GRAIN, m_up),
+                     snrt_min(t + TILE_GRAIN, n_up),
+                     snrt_min(t + TILE_GRAIN, k_up)) <= l1_len)
+        t += TILE_GRAIN;
+
+    p->tm = snrt_min(t, m_up);
+    p->tn = snrt_min(t, n_up);
+    p->tk = snrt_min(t, k_up);
+    p->tiles_m = (m + p->tm - 1) / p->tm;
+    p->tiles_n = (n + p->tn - 1) / p->tn;
+    // A zero `k` still takes one step per tile to scale C by beta.
+    p->tiles_k = k > 0 ? (k + p->tk - 1) / p->tk : 1;
+
+    uint8_t *q = l1_buf;
+    for (int i = 0; i < 2; i++) {
+        p->a[i] = q;
+        q += ALIGN_UP(p->tm * p->tk * size, 8);
+        p->b[i] = q;
+        q += ALIGN_UP(p->tk * p->tn * size, 8);
+        p->c[i] = q;
+        q += ALIGN_UP(p->tm * p->tn * size, 8);
+    }
+    p->acc = pr->acc_fn ? (float *)q : NULL;
+    return 0;
+}
+
+/// One step of the tiled driver: the product of a `tm` x `tk` tile of op(A)
+/// and a `tk` x `tn` tile of op(B) accumulated into the C tile `tile`.
+struct step {
+    uint32_t tile;
+    uint32_t i0, j0, k0;
+    uint32_t tm, tn, tk;
+    int first, last;
+};
+
+static struct step get_step(const struct plan *p, uint32_t s, uint32_t m,
+                            uint32_t n, uint32_t k) {
+    struct step st;
+    st.tile = s / p->tiles_k;
+    uint32_t kk = s % p->tiles_k;
+    st.i0 = st.tile / p->tiles_n * p->tm;
+    st.j0 = st.tile % p->tiles_n * p->tn;
+    st.k0 = kk * p->tk;
+    st.tm = snrt_min(p->tm, m - st.i0);
+    st.tn = snrt_min(p->tn, n - st.j0);
+    st.tk = k > 0 ? snrt_min(p->tk, k - st.k0) : 0;
+    st.first = kk == 0;
+    st.last = kk + 1 == p->tiles_k;
+    return st;
+}
+
+/// Leading dimensions of the A and B tiles in TCDM, which keep the transposed
+/// layout of their source.
+static inline uint32_t tile_lda(enum snblas_trans ta, const struct step *st) {
+    return ta ? st->tm : st->tk;
+}
+static inline uint32_t tile_ldb(enum snblas_trans tb, const struct step *st) {
+    return tb ? st->tk : st->tn;
+}
+
+/// Copy the `rows` x `cols` submatrix at `src` (leading dimension `ld`) into
+/// the dense buffer `dst`, or the other way around if `store` is set.
+static void dma_tile(const struct gemm_prec *pr, void *dst, const void *src,
+                     uint32_t rows, uint32_t cols, uint32_t ld, int store) {
+    size_t row_len = cols * pr->size;
+    if (rows == 0 || row_len == 0) return;
+    if (store)
+        snrt_dma_start_2d(dst, src, row_len, ld * pr->size, row_len, rows);
+    else
+        snrt_dma_start_2d(dst, src, row_len, row_len, ld * pr->size, rows);
+}
+
+/// `c = acc + beta * c` for `n` elements of the fp16 or fp8 C tile `c`, without
+/// reading `c` if `beta` is zero.
+static void round_tile(const struct gemm_prec *pr, const float *acc,
+                       uint8_t *c, uint32_t n, float beta) {
+    for (uint32_t i = 0; i < n; i++) {
+        if (pr->size == sizeof(snblas_fp16_t)) {
+            snblas_fp16_t *h = (snblas_fp16_t *)c + i;
+            float r = acc[i];
+            if (beta != 0.0f) r += beta * snblas_fp16_to_float(*h);
+            *h = snblas_float_to_fp16(r);
+        } else {
+            float r = acc[i];
+            if (beta != 0.0f) r += beta * snblas_fp8_to_float(c[i]);
+            c[i] = snblas_float_to_fp8(r);
+        }
+    }
+}
+
+static int gemm_cluster(const struct gemm_prec *pr, enum snblas_trans ta,
+                        enum snblas_trans tb, uint32_t m, uint32_t n,
+                        uint32_t k, double alpha, const void *A, uint32_t lda,
+                        const void *B, uint32_t ldb, double beta, void *C,
+                        uint32_t ldc, void *l1_buf, size_t l1_len) {
+    if (m == 0 || n == 0) return 0;
+    struct plan p;
+    if (make_plan(&p, pr, m, n, k, l1_buf, l1_len)) return -1;
+    const uint32_t size = pr->size;
+    const uint32_t steps = p.tiles_m * p.tiles_n * p.tiles_k;
+    const uint8_t *a = A, *b = B;
+    uint8_t *c = C;
+
+    // In step `s`, the data mover writes back the C tile completed in step
+    // `s - 2` and loads the A and B tiles of step `s` (and its C tile, on the
+    // first step of a tile), while the compute cores work on step `s - 1`. The
+    // A and B tiles alternate between the two buffers with the step, the C
+    // tiles with the tile. The fp16 and fp8 products accumulate in the fp32
+    // tile, which the compute cores round into the C tile on its last step.
+    for (uint32_t s = 0; s < steps + 2; s++) {
+        if (snrt_is_dm_core()) {
+            if (s >= 2) {
+                struct step st = get_step(&p, s - 2, m, n, k);
+                if (st.last) {
+                    dma_tile(pr, c + (st.i0 * ldc + st.j0) * size,
+                             p.c[st.tile & 1], st.tm, st.tn, ldc, 1);
+                    snrt_dma_wait_all();
+                }
+            }
+            if (s < steps) {
+                struct step st = get_step(&p, s, m, n, k);
+                uint32_t buf = s & 1;
+                if (ta)
+                    dma_tile(pr, p.a[buf], a + (st.k0 * lda + st.i0) * size,
+                             st.tk, st.tm, lda, 0);
+                else
+                    dma_tile(pr, p.a[buf], a + (st.i0 * lda + st.k0) * size,
+                             st.tm, st.tk, lda, 0);
+                if (tb)
+                    dma_tile(pr, p.b[buf], b + (st.j0 * ldb + st.k0) * size,
+                             st.tn, st.tk, ldb, 0);
+                else
+                    dma_tile(pr, p.b[buf], b + (st.k0 * ldb + st.j0) * size,
+                             st.tk, st.tn, ldb, 0);
+                if (st.first && beta != 0.0)
+                    dma_tile(pr, p.c[st.tile & 1],
+                             c + (st.i0 * ldc + st.j0) * size, st.tm, st.tn,
+                             ldc, 0);
+                snrt_dma_wait_all();
+            }
+        } else if (snrt_is_compute_core() && s >= 1 && s <= steps) {
+            struct step st = get_step(&p, s - 1, m, n, k);
+            uint32_t buf = (s - 1) & 1;
+            uint32_t num = snrt_cluster_compute_core_num();
+            uint32_t idx = snrt_cluster_compute_core_idx();
+            uint32_t r0 = st.tm * idx / num, r1 = st.tm * (idx + 1) / num;
+            uint32_t lda_t = tile_lda(ta, &st), ldb_t = tile_ldb(tb, &st);
+            const uint8_t *a_t = p.a[buf] + op_ofs(ta, r0, 0, lda_t) * size;
+            uint8_t *c_t = p.c[st.tile & 1] + r0 * st.tn * size;
+            if (r1 > r0 && pr->acc_fn) {
+                float *acc = p.acc + r0 * st.tn;
+                pr->acc_fn(ta, tb, r1 - r0, st.tn, st.tk, alpha, a_t, lda_t,
+                           p.b[buf], ldb_t, st.first ? 0.0 : 1.0, acc, st.tn);
+                if (st.last) round_tile(pr, acc, c_t, (r1 - r0) * st.tn, beta);
+            } else if (r1 > r0) {
+                pr->fn(ta, tb, r1 - r0, st.tn, st.tk, alpha, a_t, lda_t,
+                       p.b[buf], ldb_t, st.first ? beta : 1.0, c_t, st.tn);
+            }
+        }
+        snrt_cluster_hw_barrier();
+    }
+    return 0;
+}
+
+static int gemm_multicluster(const struct gemm_prec *pr, enum snblas_trans ta,
+                             enum snblas_trans tb, uint32_t m, uint32_t n,
+                             uint32_t k, double alpha, const void *A,
+                             uint32_t lda, const void *B, uint32_t ldb,
+                             double beta, void *C, uint32_t ldc, void *l1_buf,
+                             size_t l1_len) {
+    uint32_t num = snrt_cluster_num(), idx = snrt_cluster_idx();
+    uint32_t lo = m * idx / num, hi = m * (idx + 1) / num;
+    int err = gemm_cluster(
+        pr, ta, tb, hi - lo, n, k, alpha,
+        (const uint8_t *)A + op_ofs(ta, lo, 0, lda) * pr->size, lda, B, ldb,
+        beta, (uint8_t *)C + lo * ldc * pr->size, ldc, l1_buf, l1_len);
+    snrt_global_barrier();
+    return err;
+}
+
+int snblas_dgemm_cluster(enum snblas_trans transa, enum snblas_trans transb,
+                         uint32_t m, uint32_t n, uint32_t k, double alpha,
+                         const double *A, uint32_t lda, const double *B,
+                         uint32_t ldb, double beta, double *C, uint32_t ldc,
+                         void *l1_buf, size_t l1_len) {
+    return gemm_cluster(&prec_d, transa, transb, m, n, k, alpha, A, lda, B,
+                        ldb, beta, C, ldc, l1_buf, l1_len);
+}
+
+int snblas_sgemm_cluster(enum snblas_trans transa, enum snblas_trans transb,
+                         uint32_t m, uint32_t n, uint32_t k, float alpha,
+                         const float *A, uint32_t lda, const float *B,
+                         uint32_t ldb, float beta, float *C, uint32_t ldc,
+                         void *l1_buf, size_t l1_len) {
+    return gemm_cluster(&prec_s, transa, transb, m, n, k, alpha, A, lda, B,
+                        ldb, beta, C, ldc, l1_buf, l1_len);
+}
+
+int snblas_hgemm_cluster(enum snblas_trans transa, enum snblas_trans transb,
+                         uint32_t m, uint32_t n, uint32_t k, float alpha,
+                         const snblas_fp16_t *A, uint32_t lda,
+                         const snblas_fp16_t *B, uint32_t ldb, float beta,
+                         snblas_fp16_t *C, uint32_t ldc, void *l1_buf,
+                         size_t l1_len) {
+    return gemm_cluster(&prec_h, transa, transb, m, n, k, alpha, A, lda, B,
+                        ldb, beta, C, ldc, l1_buf, l1_len);
+}
+
+int snblas_bgemm_cluster(enum snblas_trans transa, enum snblas_trans transb,
+                         uint32_t m, uint32_t n, uint32_t k, float alpha,
+                         const snblas_fp8_t *A, uint32_t lda,
+                         const snblas_fp8_t *B, uint32_t ldb, float beta,
+                         snblas_fp8_t *C, uint32_t ldc, void *l1_buf,
+                         size_t l1_len) {
+    return gemm_cluster(&prec_b, transa, transb, m, n, k, alpha, A, lda, B,
+                        ldb, beta, C, ldc, l1_buf, l1_len);
+}
+
+int snblas_dgemm_multicluster(enum snblas_trans transa,
+                              enum snblas_trans transb, uint32_t m, uint32_t n,
+                              uint32_t k, double alpha, const double *A,
+                              uint32_t lda, const double *B, uint32_t ldb,
+                              double beta, double *C, uint32_t ldc,
+                              void *l1_buf, size_t l1_len) {
+    return gemm_multicluster(&prec_d, transa, transb, m, n, k, alpha, A, lda,
+                             B, ldb, beta, C, ldc, l1_buf, l1_len);
+}
+
+int snblas_sgemm_multicluster(enum snblas_trans transa,
+                              enum snblas_trans transb, uint32_t m, uint32_t n,
+                              uint32_t k, float alpha, const float *A,
+                              uint32_t lda, const float *B, uint32_t ldb,
+                              float beta, float *C, uint32_t ldc, void *l1_buf,
+                              size_t l1_len) {
+    return gemm_multicluster(&prec_s, transa, transb, m, n, k, alpha, A, lda,
+                             B, ldb, beta, C, ldc, l1_buf, l1_len);
+}
+
+int snblas_hgemm_multicluster(enum snblas_trans transa,
+                              enum snblas_trans transb, uint32_t m, uint32_t n,
+                              uint32_t k, float alpha, const snblas_fp16_t *A,
+                              uint32_t lda, const snblas_fp16_t *B,
+                              uint32_t ldb, float beta, snblas_fp16_t *C,
+                              uint32_t ldc, void *l1_buf, size_t l1_len) {
+    return gemm_multicluster(&prec_h, transa, transb, m, n, k, alpha, A, lda,
+                             B, ldb, beta, C, ldc, l1_buf, l1_len);
+}
+
+int snblas_bgemm_multicluster(enum snblas_trans transa,
+                              enum snblas_trans transb, uint32_t m, uint32_t n,
+                              uint32_t k, float alpha, const snblas_fp8_t *A,
+                              uint32_t lda, const snblas_fp8_t *B, uint32_t ldb,
+                              float beta, snblas_fp8_t *C, uint32_t ldc,
+                              void *l1_buf, size_t l1_len) {
+    return gemm_multicluster(&prec_b, transa, transb, m, n, k, alpha, A, lda,
+                             B, ldb, beta, C, ldc, l1_buf, l1_len);
+}
@@ -0,0 +1,102 @@
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+#include "blas.h"
+
+// Every element of `y` is the dot product of a row (`SNBLAS_NO_TRANS`) or a
+// column (`SNBLAS_TRANS`) of `A` with `x`. The two cases only differ in the
+// strides along and across the dot products. The packed SIMD kernels need
+// contiguous rows, so they only apply to `SNBLAS_NO_TRANS` with a unit `incx`;
+// `SNBLAS_TRANS` takes strided dot products.
+
+/// Configure ft0 and ft1 to stream the leading full 64-bit words of the `outs`
+/// rows of `A` and of `x` once per row, for the dot products of `len` elements
+/// of `size` bytes. Returns the number of words per row, or zero if the rows or
+/// `x` are not contiguous and word-aligned.
+static uint32_t setup_rows(uint32_t outs, uint32_t len, uint32_t size,
+                           const void *A, uint32_t lda, const void *x,
+                           uint32_t incx) {
+    uint32_t words = len * size / 8;
+    if (outs == 0 || words == 0 || incx != 1 ||
+        ((uintptr_t)A | (uintptr_t)x | lda * size) & 7)
+        return 0;
+    snrt_ssr_loop_2d(SNRT_SSR_DM0, words, outs, 8, lda * size);
+    snrt_ssr_loop_2d(SNRT_SSR_DM1, words, outs, 8, 0);
+    snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_2D, (void *)A);
+    snrt_ssr_read(SNRT_SSR_DM1, SNRT_SSR_2D, (void *)x);
+    return words;
+}
+
+void snblas_dgemv(enum snblas_trans trans, uint32_t m, uint32_t n,
+                  double alpha, const double *A, uint32_t lda, const double *x,
+                  uint32_t incx, double beta, double *y, uint32_t incy) {
+    uint32_t outs = trans ? n : m, len = trans ? m : n;
+    uint32_t along = trans ? lda : 1, across = trans ? 1 : lda;
+    if (len > 0 && outs > 0) {
+        // A streams the dot products one after the other, x repeats for each.
+        snrt_ssr_loop_2d(SNRT_SSR_DM0, len, outs, along * sizeof(double),
+                         across * sizeof(double));
+        snrt_ssr_loop_2d(SNRT_SSR_DM1, len, outs, incx * sizeof(double), 0);
+        snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_2D, (void *)A);
+        snrt_ssr_read(SNRT_SSR_DM1, SNRT_SSR_2D, (void *)x);
+    }
+    for (uint32_t i = 0; i < outs; i++) {
+        double acc = len > 0 ? alpha * ddot_ssr(len) : 0.0;
+        y[i * incy] = beta == 0.0 ? acc : acc + beta * y[i * incy];
+    }
+}
+
+void snblas_sgemv(enum snblas_trans trans, uint32_t m, uint32_t n,
+                  float alpha, const float *A, uint32_t lda, const float *x,
+                  uint32_t incx, float beta, float *y, uint32_t incy) {
+    uint32_t outs = trans ? n : m, len = trans ? m : n;
+    uint32_t along = trans ? lda : 1, across = trans ? 1 : lda;
+    uint32_t words = trans ? 0 : setup_rows(outs, len, sizeof(*A), A, lda, x,
+                                            incx);
+    uint32_t head = words * 8 / sizeof(*A);
+    for (uint32_t i = 0; i < outs; i++) {
+        float acc = words > 0 ? sdot_simd(words) : 0.0f;
+        acc += snblas_sdot(len - head, A + i * across + head, along, x + head,
+                           incx);
+        acc *= alpha;
+        y[i * incy] = beta == 0.0f ? acc : acc + beta * y[i * incy];
+    }
+}
+
+void snblas_hgemv(enum snblas_trans trans, uint32_t m, uint32_t n,
+                  float alpha, const snblas_fp16_t *A, uint32_t lda,
+                  const snblas_fp16_t *x, uint32_t incx, float beta,
+                  snblas_fp16_t *y, uint32_t incy) {
+    uint32_t outs = trans ? n : m, len = trans ? m : n;
+    uint32_t along = trans ? lda : 1, across = trans ? 1 : lda;
+    uint32_t words = trans ? 0 : setup_rows(outs, len, sizeof(*A), A, lda, x,
+                                            incx);
+    uint32_t head = words * 8 / sizeof(*A);
+    for (uint32_t i = 0; i < outs; i++) {
+        float acc = words > 0 ? hdot_simd(words) : 0.0f;
+        acc += snblas_hdot(len - head, A + i * across + head, along, x + head,
+                           incx);
+        acc *= alpha;
+        if (beta != 0.0f) acc += beta * snblas_fp16_to_float(y[i * incy]);
+        y[i * incy] = snblas_float_to_fp16(acc);
+    }
+}
+
+void snblas_bgemv(enum snblas_trans trans, uint32_t m, uint32_t n,
+                  float alpha, const snblas_fp8_t *A, uint32_t lda,
+                  const snblas_fp8_t *x, uint32_t incx, float beta,
+                  snblas_fp8_t *y, uint32_t incy) {
+    uint32_t outs = trans ? n : m, len = trans ? m : n;
+    uint32_t along = trans ? lda : 1, across = trans ? 1 : lda;
+    uint32_t words = trans ? 0 : setup_rows(outs, len, sizeof(*A), A, lda, x,
+                                            incx);
+    uint32_t head = words * 8 / sizeof(*A);
+    for (uint32_t i = 0; i < outs; i++) {
+        float acc = words > 0 ? bdot_simd(words) : 0.0f;
+        acc += snblas_bdot(len - head, A + i * across + head, along, x + head,
+                           incx);
+        acc *= alpha;
+        if (beta != 0.0f) acc += beta * snblas_fp8_to_float(y[i * incy]);
+        y[i * incy] = snblas_float_to_fp8(acc);
+    }
+}
@@ -0,0 +1,40 @@
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+#include "blas.h"
+
+/// Rows of C per block. The part of a block row left or right of the diagonal
+/// block is one GEMM, the triangle within the diagonal block is computed as
+/// dot products.
+#define SYRK_BLOCK 8
+
+// `A` provides the rows of op(A) = A (`SNBLAS_NO_TRANS`) or A^T, and C(i, j)
+// is the dot product of rows i and j of op(A), which start at `A + i * ld`
+// and are `inc` apart.
+#define DEFINE_SYRK(name, T, gemm, dot)                                      \
+    void name(enum snblas_uplo uplo, enum snblas_trans trans, uint32_t n,    \
+              uint32_t k, T alpha, const T *A, uint32_t lda, T beta, T *C,   \
+              uint32_t ldc) {                                                \
+        const uint32_t ld = trans ? 1 : lda, inc = trans ? lda : 1;          \
+        const enum snblas_trans other = trans ? SNBLAS_NO_TRANS : SNBLAS_TRANS; \
+        for (uint32_t i0 = 0; i0 < n; i0 += SYRK_BLOCK) {                    \
+            uint32_t i1 = snrt_min(i0 + SYRK_BLOCK, n);                      \
+            uint32_t j0 = uplo == SNBLAS_LOWER ? 0 : i1;                     \
+            uint32_t j1 = uplo == SNBLAS_LOWER ? i0 : n;                     \
+            if (j1 > j0)                                                     \
+                gemm(trans, other, i1 - i0, j1 - j0, k, alpha, A + i0 * ld,  \
+                     lda, A + j0 * ld, lda, beta, C + i0 * ldc + j0, ldc);   \
+            for (uint32_t i = i0; i < i1; i++) {                             \
+                uint32_t lo = uplo == SNBLAS_LOWER ? i0 : i;                 \
+                uint32_t hi = uplo == SNBLAS_LOWER ? i + 1 : i1;             \
+                for (uint32_t j = lo; j < hi; j++) {                         \
+                    T *c = C + i * ldc + j;                                  \
+                    T acc = alpha * dot(k, A + i * ld, inc, A + j * ld, inc); \
+                    *c = beta == 0 ? acc : acc + beta * *c;                  \
+                }                                                            \
+            }                                                                \
+        }                                                                    \
+    }
+
+DEFINE_SYRK(snblas_dsyrk, double, snblas_dgemm, snblas_ddot)
+DEFINE_SYRK(snblas_ssyrk, float, snblas_sgemm, snblas_sdot)
@@ -0,0 +1,64 @@
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+#include "blas.h"
+
+/// Rows (`SNBLAS_LEFT`) or columns (`SNBLAS_RIGHT`) of X solved per block.
+/// Each block is first updated with the already solved part of X in one GEMM,
+/// then solved by substitution against the diagonal block of op(A).
+#define TRSM_BLOCK 8
+
+// Whether op(A) is lower triangular decides the direction of the
+// substitution: forward for a lower op(A) on the left and an upper op(A) on
+// the right, backward otherwise. The solution vectors of X are its columns
+// (`SNBLAS_LEFT`) or rows (`SNBLAS_RIGHT`).
+#define DEFINE_TRSM(name, T, gemm)                                            \
+    void name(enum snblas_side side, enum snblas_uplo uplo,                   \
+              enum snblas_trans transa, enum snblas_diag diag, uint32_t m,    \
+              uint32_t n, T alpha, const T *A, uint32_t lda, T *B,            \
+              uint32_t ldb) {                                                 \
+        const int lower = (uplo == SNBLAS_LOWER) != (transa == SNBLAS_TRANS); \
+        const int forward = lower == (side == SNBLAS_LEFT);                   \
+        const uint32_t dim = side == SNBLAS_LEFT ? m : n;                     \
+        for (uint32_t i = 0; i < m; i++)                                      \
+            for (uint32_t j = 0; j < n; j++) B[i * ldb + j] *= alpha;         \
+        for (uint32_t b = 0; b < dim; b += TRSM_BLOCK) {                      \
+            /* Block [lo, hi) and the solved range [s_lo, s_hi). */           \
+            uint32_t len = snrt_min(TRSM_BLOCK, dim - b);                     \
+            uint32_t lo = forward ? b : dim - b - len, hi = lo + len;         \
+            uint32_t s_lo = forward ? 0 : hi, s_hi = forward ? lo : dim;      \
+            if (s_hi > s_lo && side == SNBLAS_LEFT)                           \
+                gemm(transa, SNBLAS_NO_TRANS, len, n, s_hi - s_lo, -1,        \
+                     A + op_ofs(transa, lo, s_lo, lda), lda,                  \
+                     B + s_lo * ldb, ldb, 1, B + lo * ldb, ldb);              \
+            if (s_hi > s_lo && side == SNBLAS_RIGHT)                          \
+                gemm(SNBLAS_NO_TRANS, transa, m, len, s_hi - s_lo, -1,        \
+                     B + s_lo, ldb, A + op_ofs(transa, s_lo, lo, lda), lda,   \
+                     1, B + lo, ldb);                                         \
+            for (uint32_t t = 0; t < len; t++) {                              \
+                uint32_t i = forward ? lo + t : hi - 1 - t;                   \
+                T d = A[op_ofs(transa, i, i, lda)];                           \
+                uint32_t p_lo = forward ? lo : i + 1;                         \
+                uint32_t p_hi = forward ? i : hi;                             \
+                uint32_t vecs = side == SNBLAS_LEFT ? n : m;                  \
+                for (uint32_t v = 0; v < vecs; v++) {                         \
+                    /* Element i of the solution vector v of X. */            \
+                    T *x = side == SNBLAS_LEFT ? B + i * ldb + v              \
+                                               : B + v * ldb + i;             \
+                    T acc = *x;                                               \
+                    for (uint32_t p = p_lo; p < p_hi; p++) {                  \
+                        if (side == SNBLAS_LEFT)                              \
+                            acc -= A[op_ofs(transa, i, p, lda)] *             \
+                                   B[p * ldb + v];                            \
+                        else                                                  \
+                            acc -= B[v * ldb + p] *                           \
+                                   A[op_ofs(transa, p, i, lda)];              \
+                    }                                                         \
+                    *x = diag == SNBLAS_UNIT ? acc : acc / d;                 \
+                }                                                             \
+            }                                                                 \
+        }                                                                     \
+    }
+
+DEFINE_TRSM(snblas_dtrsm, double, snblas_dgemm)
+DEFINE_TRSM(snblas_strsm, float, snblas_sgemm)
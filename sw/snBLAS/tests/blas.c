@@ -0,0 +1,270 @@
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+// Single-core snBLAS routines against naive references. All values are small
+// integers, such that every summation order and all precisions yield the exact
+// same result.
+#include <snblas.h>
+#include <snrt.h>
+
+#include "printf.h"
+
+#define M 13
+#define N 19
+#define K 12
+#define LD 24
+
+static double *dA, *dB, *dC, *dR;
+static float *sA, *sB, *sC;
+static snblas_fp16_t *hA, *hB, *hC;
+static snblas_fp8_t *bA, *bB, *bC;
+
+static uint32_t lcg(uint32_t *state) {
+    *state = *state * 1664525 + 1013904223;
+    return *state >> 8;
+}
+
+/// Fill an `LD` x `LD` matrix with values in [-2, 2], with a diagonal that
+/// keeps triangular solves exact.
+static void generate(uint32_t seed) {
+    for (uint32_t i = 0; i < LD * LD; i++) {
+        double v = (double)((int)(lcg(&seed) % 5) - 2);
+        dA[i] = v;
+        dB[i] = (double)((int)(lcg(&seed) % 5) - 2);
+        dC[i] = (double)((int)(lcg(&seed) % 5) - 2);
+    }
+    for (uint32_t i = 0; i < LD; i++) dA[i * LD + i] = i % 2 ? -1.0 : 1.0;
+    for (uint32_t i = 0; i < LD * LD; i++) {
+        sA[i] = dA[i];
+        sB[i] = dB[i];
+        sC[i] = dC[i];
+        hA[i] = snblas_float_to_fp16(sA[i]);
+        hB[i] = snblas_float_to_fp16(sB[i]);
+        hC[i] = snblas_float_to_fp16(sC[i]);
+        bA[i] = snblas_float_to_fp8(sA[i]);
+        bB[i] = snblas_float_to_fp8(sB[i]);
+        bC[i] = snblas_float_to_fp8(sC[i]);
+    }
+}
+
+/// `C = alpha * op(A) op(B) + beta * C` in the reference buffer.
+static void ref_gemm(enum snblas_trans ta, enum snblas_trans tb, uint32_t m,
+                     uint32_t n, uint32_t k, double alpha, double beta) {
+    for (uint32_t i = 0; i < m; i++) {
+        for (uint32_t j = 0; j < n; j++) {
+            double acc = 0.0;
+            for (uint32_t p = 0; p < k; p++)
+                acc += dA[ta ? p * LD + i : i * LD + p] *
+                       dB[tb ? j * LD + p : p * LD + j];
+            dR[i * LD + j] = alpha * acc + beta * dC[i * LD + j];
+        }
+    }
+}
+
+static uint32_t check(const char *what, uint32_t m, uint32_t n) {
+    uint32_t errors = 0;
+    for (uint32_t i = 0; i < m; i++) {
+        for (uint32_t j = 0; j < n; j++) {
+            double r = dR[i * LD + j];
+            uint32_t o = i * LD + j;
+            errors += dC[o] != r;
+            errors += sC[o] != (float)r;
+            errors += snblas_fp16_to_float(hC[o]) != (float)r;
+            errors += snblas_fp8_to_float(bC[o]) !=
+                      snblas_fp8_to_float(snblas_float_to_fp8(r));
+        }
+    }
+    if (errors) printf("%s: %d errors\n", what, errors);
+    return errors;
+}
+
+static uint32_t test_gemm(enum snblas_trans ta, enum snblas_trans tb,
+                          uint32_t k, double beta) {
+    generate(ta * 2 + tb + k);
+    ref_gemm(ta, tb, M, N, k, 2.0, beta);
+    snblas_dgemm(ta, tb, M, N, k, 2.0, dA, LD, dB, LD, beta, dC, LD);
+    snblas_sgemm(ta, tb, M, N, k, 2.0f, sA, LD, sB, LD, beta, sC, LD);
+    snblas_hgemm(ta, tb, M, N, k, 2.0f, hA, LD, hB, LD, beta, hC, LD);
+    snblas_bgemm(ta, tb, M, N, k, 2.0f, bA, LD, bB, LD, beta, bC, LD);
+    return check("gemm", M, N);
+}
+
+static uint32_t test_level12(void) {
+    uint32_t errors = 0;
+    generate(7);
+
+    // Dot products and norms over rows and strided columns.
+    for (uint32_t inc = 1; inc <= LD; inc += LD - 1) {
+        double ref = 0.0, nrm = 0.0;
+        for (uint32_t i = 0; i < N; i++) {
+            ref += dA[i * inc] * dB[i * inc];
+            nrm += dA[i * inc] * dA[i * inc];
+        }
+        errors += snblas_ddot(N, dA, inc, dB, inc) != ref;
+        errors += snblas_sdot(N, sA, inc, sB, inc) != (float)ref;
+        errors += snblas_hdot(N, hA, inc, hB, inc) != (float)ref;
+        errors += snblas_bdot(N, bA, inc, bB, inc) != (float)ref;
+        double d = snblas_dnrm2(N, dA, inc);
+        errors += d * d < nrm - 1e-9 || d * d > nrm + 1e-9;
+        float s = snblas_snrm2(N, sA, inc);
+        errors += s * s < nrm - 1e-3 || s * s > nrm + 1e-3;
+    }
+    if (errors) printf("dot: %d errors\n", errors);
+
+    // axpy, with y as a column of C.
+    for (uint32_t i = 0; i < M; i++)
+        dR[i * LD] = dC[i * LD] + 2.0 * dA[i];
+    snblas_daxpy(M, 2.0, dA, 1, dC, LD);
+    snblas_saxpy(M, 2.0f, sA, 1, sC, LD);
+    snblas_haxpy(M, 2.0f, hA, 1, hC, LD);
+    snblas_baxpy(M, 2.0f, bA, 1, bC, LD);
+    errors += check("axpy", M, 1);
+
+    // axpy with y as the first row of C, which takes the packed kernels.
+    for (uint32_t j = 0; j < N; j++) dR[j] = dC[j] + 2.0 * dA[j];
+    snblas_daxpy(N, 2.0, dA, 1, dC, 1);
+    snblas_saxpy(N, 2.0f, sA, 1, sC, 1);
+    snblas_haxpy(N, 2.0f, hA, 1, hC, 1);
+    snblas_baxpy(N, 2.0f, bA, 1, bC, 1);
+    errors += check("axpy", 1, N);
+
+    // gemv in both orientations, with x as a column or a row of B and y as a
+    // row of C.
+    for (int t = 0; t < 4; t++) {
+        generate(11 + t);
+        uint32_t trans = t & 1, incx = t & 2 ? 1 : LD;
+        uint32_t outs = trans ? N : M, len = trans ? M : N;
+        for (uint32_t i = 0; i < outs; i++) {
+            double acc = 0.0;
+            for (uint32_t p = 0; p < len; p++)
+                acc += dA[trans ? p * LD + i : i * LD + p] * dB[p * incx];
+            dR[i] = -1.0 * acc + 3.0 * dC[i];
+        }
+        snblas_dgemv(trans, M, N, -1.0, dA, LD, dB, incx, 3.0, dC, 1);
+        snblas_sgemv(trans, M, N, -1.0f, sA, LD, sB, incx, 3.0f, sC, 1);
+        snblas_hgemv(trans, M, N, -1.0f, hA, LD, hB, incx, 3.0f, hC, 1);
+        snblas_bgemv(trans, M, N, -1.0f, bA, LD, bB, incx, 3.0f, bC, 1);
+        errors += check("gemv", 1, outs);
+    }
+
+    // Norms whose sums of squares overflow or underflow.
+    for (int big = 0; big < 2; big++) {
+        double dsc = big ? 1e200 : 1e-200;
+        float ssc = big ? 1e30f : 1e-30f;
+        dR[0] = 3.0 * dsc;
+        dR[1] = -4.0 * dsc;
+        sA[0] = 3.0f * ssc;
+        sA[1] = -4.0f * ssc;
+        double d = snblas_dnrm2(2, dR, 1) / (5.0 * dsc);
+        float s = snblas_snrm2(2, sA, 1) / (5.0f * ssc);
+        uint32_t e = (d < 1.0 - 1e-12 || d > 1.0 + 1e-12) +
+                     (s < 1.0f - 1e-6f || s > 1.0f + 1e-6f);
+        if (e) printf("nrm2 scaling: %d errors\n", e);
+        errors += e;
+    }
+    return errors;
+}
+
+static uint32_t test_syrk(enum snblas_uplo uplo, enum snblas_trans trans) {
+    generate(3 + uplo * 2 + trans);
+    for (uint32_t i = 0; i < N; i++) {
+        for (uint32_t j = 0; j < N; j++) {
+            double acc = 0.0;
+            for (uint32_t p = 0; p < K; p++)
+                acc += dA[trans ? p * LD + i : i * LD + p] *
+                       dA[trans ? p * LD + j : j * LD + p];
+            int in = uplo == SNBLAS_LOWER ? j <= i : j >= i;
+            dR[i * LD + j] = in ? acc - dC[i * LD + j] : dC[i * LD + j];
+        }
+    }
+    snblas_dsyrk(uplo, trans, N, K, 1.0, dA, LD, -1.0, dC, LD);
+    snblas_ssyrk(uplo, trans, N, K, 1.0f, sA, LD, -1.0f, sC, LD);
+    uint32_t errors = 0;
+    for (uint32_t i = 0; i < N; i++) {
+        for (uint32_t j = 0; j < N; j++) {
+            errors += dC[i * LD + j] != dR[i * LD + j];
+            errors += sC[i * LD + j] != (float)dR[i * LD + j];
+        }
+    }
+    if (errors) printf("syrk: %d errors\n", errors);
+    return errors;
+}
+
+static uint32_t test_trsm(enum snblas_side side, enum snblas_uplo uplo,
+                          enum snblas_trans trans, enum snblas_diag diag) {
+    // Pick X, compute B = op(A) X or X op(A) with the referenced triangle of
+    // A, solve and compare against X.
+    generate(17 + side * 8 + uplo * 4 + trans * 2 + diag);
+    uint32_t dim = side == SNBLAS_LEFT ? M : N;
+    for (uint32_t i = 0; i < dim; i++) {
+        for (uint32_t j = 0; j < dim; j++) {
+            int in = uplo == SNBLAS_LOWER ? j <= i : j >= i;
+            if (!in) dA[i * LD + j] = 0.0;
+            if (i == j && diag == SNBLAS_UNIT) dA[i * LD + j] = 1.0;
+            sA[i * LD + j] = dA[i * LD + j];
+        }
+    }
+    for (uint32_t i = 0; i < M; i++) {
+        for (uint32_t j = 0; j < N; j++) {
+            double acc = 0.0;
+            for (uint32_t p = 0; p < dim; p++) {
+                if (side == SNBLAS_LEFT)
+                    acc += dA[trans ? p * LD + i : i * LD + p] * dB[p * LD + j];
+                else
+                    acc += dB[i * LD + p] * dA[trans ? j * LD + p : p * LD + j];
+            }
+            dC[i * LD + j] = acc * 0.5;
+            sC[i * LD + j] = acc * 0.5;
+        }
+    }
+    snblas_dtrsm(side, uplo, trans, diag, M, N, 2.0, dA, LD, dC, LD);
+    snblas_strsm(side, uplo, trans, diag, M, N, 2.0f, sA, LD, sC, LD);
+    uint32_t errors = 0;
+    for (uint32_t i = 0; i < M; i++) {
+        for (uint32_t j = 0; j < N; j++) {
+            errors += dC[i * LD + j] != dB[i * LD + j];
+            errors += sC[i * LD + j] != (float)dB[i * LD + j];
+        }
+    }
+    if (errors) printf("trsm %d%d%d%d: %d errors\n", side, uplo, trans, diag,
+                       errors);
+    return errors;
+}
+
+int main() {
+    if (snrt_global_core_idx() != 0) return 0;
+
+    size_t len = LD * LD;
+    dA = snrt_l1alloc(len * sizeof(double));
+    dB = snrt_l1alloc(len * sizeof(double));
+    dC = snrt_l1alloc(len * sizeof(double));
+    dR = snrt_l1alloc(len * sizeof(double));
+    sA = snrt_l1alloc(len * sizeof(float));
+    sB = snrt_l1alloc(len * sizeof(float));
+    sC = snrt_l1alloc(len * sizeof(float));
+    hA = snrt_l1alloc(len * sizeof(snblas_fp16_t));
+    hB = snrt_l1alloc(len * sizeof(snblas_fp16_t));
+    hC = snrt_l1alloc(len * sizeof(snblas_fp16_t));
+    bA = snrt_l1alloc(len);
+    bB = snrt_l1alloc(len);
+    bC = snrt_l1alloc(len);
+
+    uint32_t errors = test_level12();
+    for (int ta = 0; ta < 2; ta++) {
+        for (int tb = 0; tb < 2; tb++) {
+            errors += test_gemm(ta, tb, K, 0.0);
+            errors += test_gemm(ta, tb, K - 1, -1.0);
+        }
+    }
+    errors += test_gemm(SNBLAS_NO_TRANS, SNBLAS_NO_TRANS, 0, 2.0);
+    for (int uplo = 0; uplo < 2; uplo++)
+        for (int trans = 0; trans < 2; trans++)
+            errors += test_syrk(uplo, trans);
+    for (int side = 0; side < 2; side++)
+        for (int uplo = 0; uplo < 2; uplo++)
+            for (int trans = 0; trans < 2; trans++)
+                for (int diag = 0; diag < 2; diag++)
+                    errors += test_trsm(side, uplo, trans, diag);
+    return errors;
+}
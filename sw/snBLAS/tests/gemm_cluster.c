@@ -0,0 +1,157 @@
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+// Cluster drivers with operands in L3. The TCDM buffer only holds a few tiles
+// of the wider precisions, such that every dimension is split and left with a
+// remainder tile. fp16 and fp8 accumulate across the K tiles in fp32 and
+// round C once, so their results stay exact as well.
+#include <snblas.h>
+#include <snrt.h>
+
+#include "printf.h"
+
+#define M 21
+#define N 27
+#define K 35
+#define BUF_LEN 8192
+
+/// Operands shared by all cores. Every precision gets its own copy of the
+/// same small integer matrices.
+static struct {
+    double *dA, *dB, *dC, *R;
+    float *sA, *sB, *sC;
+    snblas_fp16_t *hA, *hB, *hC;
+    snblas_fp8_t *bA, *bB, *bC;
+    void *buf;
+} data;
+
+static uint32_t lcg(uint32_t *state) {
+    *state = *state * 1664525 + 1013904223;
+    return *state >> 8;
+}
+
+static void generate(uint32_t seed) {
+    uint32_t len = K * snrt_max(M, N);
+    for (uint32_t i = 0; i < len; i++) {
+        data.dA[i] = (double)((int)(lcg(&seed) % 3) - 1);
+        data.dB[i] = (double)((int)(lcg(&seed) % 3) - 1);
+    }
+    for (uint32_t i = 0; i < M * N; i++)
+        data.dC[i] = (double)((int)(lcg(&seed) % 5) - 2);
+    for (uint32_t i = 0; i < len; i++) {
+        data.sA[i] = data.dA[i];
+        data.sB[i] = data.dB[i];
+        data.hA[i] = snblas_float_to_fp16(data.dA[i]);
+        data.hB[i] = snblas_float_to_fp16(data.dB[i]);
+        data.bA[i] = snblas_float_to_fp8(data.dA[i]);
+        data.bB[i] = snblas_float_to_fp8(data.dB[i]);
+    }
+    for (uint32_t i = 0; i < M * N; i++) {
+        data.sC[i] = data.dC[i];
+        data.hC[i] = snblas_float_to_fp16(data.dC[i]);
+        data.bC[i] = snblas_float_to_fp8(data.dC[i]);
+    }
+}
+
+/// Reference `C = 2 op(A) op(B) - C` with `lda = op(A) cols` and so on.
+static void reference(enum snblas_trans ta, enum snblas_trans tb) {
+    for (uint32_t i = 0; i < M; i++) {
+        for (uint32_t j = 0; j < N; j++) {
+            double acc = 0.0;
+            for (uint32_t p = 0; p < K; p++)
+                acc += data.dA[ta ? p * M + i : i * K + p] *
+                       data.dB[tb ? j * K + p : p * N + j];
+            data.R[i * N + j] = 2.0 * acc - data.dC[i * N + j];
+        }
+    }
+}
+
+static uint32_t check(enum snblas_trans ta, enum snblas_trans tb) {
+    uint32_t errors = 0;
+    for (uint32_t i = 0; i < M * N; i++) {
+        double r = data.R[i];
+        errors += data.dC[i] != r;
+        errors += data.sC[i] != (float)r;
+        errors += snblas_fp16_to_float(data.hC[i]) != (float)r;
+        errors += data.bC[i] != snblas_float_to_fp8(r);
+    }
+    if (errors) printf("gemm %d%d: %d errors\n", ta, tb, errors);
+    return errors;
+}
+
+int main() {
+    uint32_t errors = 0;
+    int is_main = snrt_global_core_idx() == 0;
+
+    if (is_main) {
+        uint32_t len = K * snrt_max(M, N);
+        data.dA = snrt_l3alloc(len * sizeof(double));
+        data.dB = snrt_l3alloc(len * sizeof(double));
+        data.dC = snrt_l3alloc(M * N * sizeof(double));
+        data.R = snrt_l3alloc(M * N * sizeof(double));
+        data.sA = snrt_l3alloc(len * sizeof(float));
+        data.sB = snrt_l3alloc(len * sizeof(float));
+        data.sC = snrt_l3alloc(M * N * sizeof(float));
+        data.hA = snrt_l3alloc(len * sizeof(snblas_fp16_t));
+        data.hB = snrt_l3alloc(len * sizeof(snblas_fp16_t));
+        data.hC = snrt_l3alloc(M * N * sizeof(snblas_fp16_t));
+        data.bA = snrt_l3alloc(len);
+        data.bB = snrt_l3alloc(len);
+        data.bC = snrt_l3alloc(M * N);
+        data.buf = snrt_l1alloc(BUF_LEN);
+    }
+
+    // Level 1 drivers on the leading M x N elements of A and B.
+    if (is_main) {
+        generate(42);
+        for (uint32_t i = 0; i < M * N; i++) data.R[i] = data.dB[i];
+    }
+    snrt_cluster_hw_barrier();
+    double dot = snblas_ddot_cluster(M * N, data.dA, data.dB);
+    snblas_daxpy_cluster(M * N, 3.0, data.dA, data.dB);
+    if (is_main) {
+        double ref = 0.0;
+        uint32_t axpy_errors = 0;
+        for (uint32_t i = 0; i < M * N; i++) {
+            ref += data.dA[i] * data.R[i];
+            axpy_errors += data.dB[i] != data.R[i] + 3.0 * data.dA[i];
+        }
+        if (dot != ref) printf("ddot_cluster mismatch\n");
+        if (axpy_errors) printf("daxpy_cluster: %d errors\n", axpy_errors);
+        errors += (dot != ref) + axpy_errors;
+    }
+    snrt_cluster_hw_barrier();
+
+    for (int t = 0; t < 4; t++) {
+        enum snblas_trans ta = t >> 1, tb = t & 1;
+        uint32_t lda = ta ? M : K, ldb = tb ? K : N;
+        if (is_main) {
+            generate(t);
+            reference(ta, tb);
+        }
+        snrt_cluster_hw_barrier();
+
+        errors += snblas_dgemm_cluster(ta, tb, M, N, K, 2.0, data.dA, lda,
+                                       data.dB, ldb, -1.0, data.dC, N,
+                                       data.buf, BUF_LEN) != 0;
+        errors += snblas_sgemm_cluster(ta, tb, M, N, K, 2.0f, data.sA, lda,
+                                       data.sB, ldb, -1.0f, data.sC, N,
+                                       data.buf, BUF_LEN) != 0;
+        errors += snblas_hgemm_cluster(ta, tb, M, N, K, 2.0f, data.hA, lda,
+                                       data.hB, ldb, -1.0f, data.hC, N,
+                                       data.buf, BUF_LEN) != 0;
+        errors += snblas_bgemm_multicluster(ta, tb, M, N, K, 2.0f, data.bA,
+                                            lda, data.bB, ldb, -1.0f, data.bC,
+                                            N, data.buf, BUF_LEN) != 0;
+        if (is_main) errors += check(ta, tb);
+        snrt_cluster_hw_barrier();
+    }
+
+    // A buffer too small for a single tile is rejected.
+    errors += snblas_dgemm_cluster(SNBLAS_NO_TRANS, SNBLAS_NO_TRANS, M, N, K,
+                                   1.0, data.dA, K, data.dB, N, 0.0, data.dC,
+                                   N, data.buf, 64) != -1;
+
+    return is_main ? errors : 0;
+}
@@ -128,6 +128,10 @@ extern snrt_dma_txid_t snrt_dma_start_2d(void *dst, const void *src,
 extern void snrt_dma_wait(snrt_dma_txid_t tid);
 /// Block until all operation on the DMA ceases.
 extern void snrt_dma_wait_all();
+/// Bytes of the DMA transfers started by this core since the last reset.
+extern size_t snrt_dma_get_bytes();
+/// Reset the count of the bytes of the DMA transfers started by this core.
+extern void snrt_dma_reset_bytes();
 
 /// The different SSR data movers.
 enum snrt_ssr_dm {
@@ -144,6 +148,19 @@ enum snrt_ssr_dim {
     SNRT_SSR_4D = 3,
 };
 
+/// The index widths of indirect streams.
+enum snrt_ssr_idx_size {
+    SNRT_SSR_IDX8 = 0,
+    SNRT_SSR_IDX16 = 1,
+    SNRT_SSR_IDX32 = 2,
+};
+
+/// How the two index streams of an intersection are merged.
+enum snrt_ssr_merge {
+    SNRT_SSR_INTERSECT = 0,
+    SNRT_SSR_UNION = 1,
+};
+
 extern void snrt_ssr_loop_1d(enum snrt_ssr_dm dm, size_t b0, size_t i0);
 extern void snrt_ssr_loop_2d(enum snrt_ssr_dm dm, size_t b0, size_t b1,
                              size_t i0, size_t i1);
@@ -159,6 +176,23 @@ extern void snrt_ssr_read(enum snrt_ssr_dm dm, enum snrt_ssr_dim dim,
                           volatile void *ptr);
 extern void snrt_ssr_write(enum snrt_ssr_dm dm, enum snrt_ssr_dim dim,
                            volatile void *ptr);
+extern int snrt_ssr_indir_supported(enum snrt_ssr_dm dm);
+extern int snrt_ssr_gather(enum snrt_ssr_dm dm, enum snrt_ssr_idx_size size,
+                           volatile void *idx, size_t len,
+                           volatile void *base, uint32_t shift);
+extern int snrt_ssr_scatter(enum snrt_ssr_dm dm, enum snrt_ssr_idx_size size,
+                            volatile void *idx, size_t len,
+                            volatile void *base, uint32_t shift);
+extern int snrt_ssr_isect_master(enum snrt_ssr_dm dm, enum snrt_ssr_merge merge,
+                                 enum snrt_ssr_idx_size size,
+                                 volatile void *idx, size_t len,
+                                 volatile void *base, uint32_t shift,
+                                 int with_slave);
+extern int snrt_ssr_isect_slave(enum snrt_ssr_dm dm,
+                                enum snrt_ssr_idx_size size,
+                                volatile void *idx_out, volatile void *base,
+                                uint32_t shift, int write);
+extern size_t snrt_ssr_isect_count(enum snrt_ssr_dm dm);
 extern void snrt_fpu_fence();
 
 /**
@@ -0,0 +1,253 @@
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+// Header-only SSR configuration through precomputed stream descriptors.
+//
+// The `snrt_ssr_loop_*d` functions recompute the relative strides and issue
+// one out-of-line `scfgw` per register on every call. A stream descriptor
+// holds the register-ready bound and stride words of a stream, such that it
+// can be computed once (or entirely at compile time with the
+// `SNRT_SSR_DESC_*D` initializers) and then written with a short sequence of
+// `scfgwi` instructions. Moving a configured stream to a new base address only
+// takes a single `scfgwi`.
+//
+// The immediate form is used whenever the data mover, the register and the
+// descriptor dimension are known at compile time, which is the case when the
+// functions are inlined with constant arguments. Otherwise the register
+// address is materialized and `scfgw` is used.
+#pragma once
+
+#include "snrt.h"
+
+/// The SSR configuration registers.
+enum snrt_ssr_reg {
+    SNRT_SSR_REG_STATUS = 0,
+    SNRT_SSR_REG_REPEAT = 1,
+    SNRT_SSR_REG_BOUNDS = 2,       // + loop index
+    SNRT_SSR_REG_STRIDES = 6,      // + loop index
+    SNRT_SSR_REG_IDX_CFG = 10,     // {merge, shift, size}
+    SNRT_SSR_REG_IDX_BASE = 11,    // base address of the indexed data
+    SNRT_SSR_REG_IDX_ISECT = 12,   // intersection count (read-only)
+    SNRT_SSR_REG_RPTR_INDIR = 16,  // + isect role
+    SNRT_SSR_REG_WPTR_INDIR = 20,  // + isect role
+    SNRT_SSR_REG_RPTR = 24,        // + snrt_ssr_dim
+    SNRT_SSR_REG_WPTR = 28,        // + snrt_ssr_dim
+};
+
+/// A precomputed SSR stream configuration.
+///
+/// `dims` holds the highest loop index (`enum snrt_ssr_dim`), `repeat`,
+/// `bounds` and `strides` hold the values exactly as written to the
+/// configuration registers, i.e. bounds and repetitions are decremented by one
+/// and strides are relative to the end of the next inner loop.
+typedef struct snrt_ssr_desc {
+    uint32_t dims;
+    uint32_t repeat;
+    uint32_t bounds[4];
+    uint32_t strides[4];
+} snrt_ssr_desc_t;
+
+/// Constant initializer for a 1D stream descriptor.
+#define SNRT_SSR_DESC_1D(b0, i0)                                          \
+    {                                                                     \
+        .dims = SNRT_SSR_1D, .repeat = 0, .bounds = {(b0)-1, 0, 0, 0},   \
+        .strides = {(i0), 0, 0, 0}                                        \
+    }
+
+/// Constant initializer for a 2D stream descriptor.
+#define SNRT_SSR_DESC_2D(b0, b1, i0, i1)                               \
+    {                                                                  \
+        .dims = SNRT_SSR_2D, .repeat = 0,                              \
+        .bounds = {(b0)-1, (b1)-1, 0, 0},                              \
+        .strides = {(i0), (i1) - (i0) * ((b0)-1), 0, 0}                \
+    }
+
+/// Constant initializer for a 3D stream descriptor.
+#define SNRT_SSR_DESC_3D(b0, b1, b2, i0, i1, i2)                         \
+    {                                                                    \
+        .dims = SNRT_SSR_3D, .repeat = 0,                                \
+        .bounds = {(b0)-1, (b1)-1, (b2)-1, 0},                           \
+        .strides = {(i0), (i1) - (i0) * ((b0)-1),                        \
+                    (i2) - (i0) * ((b0)-1) - (i1) * ((b1)-1), 0}         \
+    }
+
+/// Constant initializer for a 4D stream descriptor.
+#define SNRT_SSR_DESC_4D(b0, b1, b2, b3, i0, i1, i2, i3)                 \
+    {                                                                    \
+        .dims = SNRT_SSR_4D, .repeat = 0,                                \
+        .bounds = {(b0)-1, (b1)-1, (b2)-1, (b3)-1},                      \
+        .strides = {(i0), (i1) - (i0) * ((b0)-1),                        \
+                    (i2) - (i0) * ((b0)-1) - (i1) * ((b1)-1),            \
+                    (i3) - (i0) * ((b0)-1) - (i1) * ((b1)-1) -           \
+                        (i2) * ((b2)-1)}                                 \
+    }
+
+//================================================================================
+// Register access
+//================================================================================
+
+#ifdef __TOOLCHAIN_LLVM__
+#define __SNRT_SSR_SCFGWI "scfgwi %0, %1"
+#define __SNRT_SSR_SCFGW "scfgw %0, %1"
+#else
+// scfgwi rs1, imm12 / scfgw rs1, rs2 (custom-1 opcode, see opcodes-ssr)
+#define __SNRT_SSR_SCFGWI ".insn i 0x2b, 2, x0, %0, %1"
+#define __SNRT_SSR_SCFGW ".insn r 0x2b, 2, 0, x1, %0, %1"
+#endif
+
+// One `scfgwi` case per register address. The immediate is a literal in each
+// case, so this also compiles when the switch is not folded (e.g. at -O0).
+#define __SNRT_SSR_CFGWI_CASE(addr)                            \
+    case (addr):                                               \
+        asm volatile(__SNRT_SSR_SCFGWI ::"r"(value), "i"(addr) \
+                     : "memory");                              \
+        break;
+#define __SNRT_SSR_CFGWI_REG(reg)                    \
+    __SNRT_SSR_CFGWI_CASE((reg) << 5 | SNRT_SSR_DM0) \
+    __SNRT_SSR_CFGWI_CASE((reg) << 5 | SNRT_SSR_DM1) \
+    __SNRT_SSR_CFGWI_CASE((reg) << 5 | SNRT_SSR_DM2)
+#define __SNRT_SSR_CFGWI_REG4(reg)  \
+    __SNRT_SSR_CFGWI_REG((reg) + 0) \
+    __SNRT_SSR_CFGWI_REG((reg) + 1) \
+    __SNRT_SSR_CFGWI_REG((reg) + 2) \
+    __SNRT_SSR_CFGWI_REG((reg) + 3)
+
+/// Write an SSR configuration register.
+static inline __attribute__((always_inline)) void snrt_ssr_cfg_write(
+    uint32_t reg, enum snrt_ssr_dm dm, uint32_t value) {
+    if (__builtin_constant_p(reg) && __builtin_constant_p(dm)) {
+        switch (reg << 5 | dm) {
+            __SNRT_SSR_CFGWI_REG(SNRT_SSR_REG_STATUS)
+            __SNRT_SSR_CFGWI_REG(SNRT_SSR_REG_REPEAT)
+            __SNRT_SSR_CFGWI_REG4(SNRT_SSR_REG_BOUNDS)
+            __SNRT_SSR_CFGWI_REG4(SNRT_SSR_REG_STRIDES)
+            __SNRT_SSR_CFGWI_REG(SNRT_SSR_REG_IDX_CFG)
+            __SNRT_SSR_CFGWI_REG(SNRT_SSR_REG_IDX_BASE)
+            __SNRT_SSR_CFGWI_REG(SNRT_SSR_REG_IDX_ISECT)
+            __SNRT_SSR_CFGWI_REG4(SNRT_SSR_REG_RPTR_INDIR)
+            __SNRT_SSR_CFGWI_REG4(SNRT_SSR_REG_WPTR_INDIR)
+            __SNRT_SSR_CFGWI_REG4(SNRT_SSR_REG_RPTR)
+            __SNRT_SSR_CFGWI_REG4(SNRT_SSR_REG_WPTR)
+            default:
+                asm volatile(__SNRT_SSR_SCFGW ::"r"(value),
+                             "r"(reg << 5 | dm)
+                             : "memory");
+        }
+    } else {
+        asm volatile(__SNRT_SSR_SCFGW ::"r"(value), "r"(reg << 5 | dm)
+                     : "memory");
+    }
+}
+
+//================================================================================
+// Descriptor construction
+//================================================================================
+
+/// Build a descriptor for a 1D loop nest.
+static inline snrt_ssr_desc_t snrt_ssr_desc_1d(size_t b0, size_t i0) {
+    snrt_ssr_desc_t d = SNRT_SSR_DESC_1D(b0, i0);
+    return d;
+}
+
+/// Build a descriptor for a 2D loop nest.
+static inline snrt_ssr_desc_t snrt_ssr_desc_2d(size_t b0, size_t b1,
+                                               size_t i0, size_t i1) {
+    snrt_ssr_desc_t d = SNRT_SSR_DESC_2D(b0, b1, i0, i1);
+    return d;
+}
+
+/// Build a descriptor for a 3D loop nest.
+static inline snrt_ssr_desc_t snrt_ssr_desc_3d(size_t b0, size_t b1,
+                                               size_t b2, size_t i0,
+                                               size_t i1, size_t i2) {
+    snrt_ssr_desc_t d = SNRT_SSR_DESC_3D(b0, b1, b2, i0, i1, i2);
+    return d;
+}
+
+/// Build a descriptor for a 4D loop nest.
+/// b0: Inner-most bound (limit of loop)
+/// b3: Outer-most bound (limit of loop)
+/// i0: increment size of inner-most loop
+static inline snrt_ssr_desc_t snrt_ssr_desc_4d(size_t b0, size_t b1,
+                                               size_t b2, size_t b3,
+                                               size_t i0, size_t i1,
+                                               size_t i2, size_t i3) {
+    snrt_ssr_desc_t d = SNRT_SSR_DESC_4D(b0, b1, b2, b3, i0, i1, i2, i3);
+    return d;
+}
+
+/// Set the repetition count of a descriptor.
+static inline void snrt_ssr_desc_repeat(snrt_ssr_desc_t *d, size_t count) {
+    d->repeat = count - 1;
+}
+
+//================================================================================
+// Descriptor application
+//================================================================================
+
+/// Write the bounds, strides and repetition count of a descriptor to a data
+/// mover. Only the registers of the used loop dimensions are written.
+static inline __attribute__((always_inline)) void snrt_ssr_desc_apply(
+    enum snrt_ssr_dm dm, const snrt_ssr_desc_t *d) {
+    snrt_ssr_cfg_write(SNRT_SSR_REG_REPEAT, dm, d->repeat);
+    switch (d->dims) {
+        case SNRT_SSR_4D:
+            snrt_ssr_cfg_write(SNRT_SSR_REG_BOUNDS + 3, dm, d->bounds[3]);
+            snrt_ssr_cfg_write(SNRT_SSR_REG_STRIDES + 3, dm, d->strides[3]);
+            // fall through
+        case SNRT_SSR_3D:
+            snrt_ssr_cfg_write(SNRT_SSR_REG_BOUNDS + 2, dm, d->bounds[2]);
+            snrt_ssr_cfg_write(SNRT_SSR_REG_STRIDES + 2, dm, d->strides[2]);
+            // fall through
+        case SNRT_SSR_2D:
+            snrt_ssr_cfg_write(SNRT_SSR_REG_BOUNDS + 1, dm, d->bounds[1]);
+            snrt_ssr_cfg_write(SNRT_SSR_REG_STRIDES + 1, dm, d->strides[1]);
+            // fall through
+        default:
+            snrt_ssr_cfg_write(SNRT_SSR_REG_BOUNDS + 0, dm, d->bounds[0]);
+            snrt_ssr_cfg_write(SNRT_SSR_REG_STRIDES + 0, dm, d->strides[0]);
+    }
+}
+
+/// Start a streaming read at `ptr` on an already configured data mover.
+/// Inline counterpart of `snrt_ssr_read`.
+static inline __attribute__((always_inline)) void snrt_ssr_rebase_read(
+    enum snrt_ssr_dm dm, enum snrt_ssr_dim dim, volatile void *ptr) {
+    snrt_ssr_cfg_write(SNRT_SSR_REG_RPTR + dim, dm, (uintptr_t)ptr);
+}
+
+/// Start a streaming write at `ptr` on an already configured data mover.
+/// Inline counterpart of `snrt_ssr_write`.
+static inline __attribute__((always_inline)) void snrt_ssr_rebase_write(
+    enum snrt_ssr_dm dm, enum snrt_ssr_dim dim, volatile void *ptr) {
+    snrt_ssr_cfg_write(SNRT_SSR_REG_WPTR + dim, dm, (uintptr_t)ptr);
+}
+
+/// Start a streaming read on a data mover configured with `d`. This only
+/// rebases the stream; bounds and strides are left untouched.
+static inline __attribute__((always_inline)) void snrt_ssr_desc_read(
+    enum snrt_ssr_dm dm, const snrt_ssr_desc_t *d, volatile void *ptr) {
+    snrt_ssr_rebase_read(dm, (enum snrt_ssr_dim)d->dims, ptr);
+}
+
+/// Start a streaming write on a data mover configured with `d`. This only
+/// rebases the stream; bounds and strides are left untouched.
+static inline __attribute__((always_inline)) void snrt_ssr_desc_write(
+    enum snrt_ssr_dm dm, const snrt_ssr_desc_t *d, volatile void *ptr) {
+    snrt_ssr_rebase_write(dm, (enum snrt_ssr_dim)d->dims, ptr);
+}
+
+/// Configure a data mover with `d` and start a streaming read at `ptr`.
+static inline __attribute__((always_inline)) void snrt_ssr_desc_start_read(
+    enum snrt_ssr_dm dm, const snrt_ssr_desc_t *d, volatile void *ptr) {
+    snrt_ssr_desc_apply(dm, d);
+    snrt_ssr_desc_read(dm, d, ptr);
+}
+
+/// Configure a data mover with `d` and start a streaming write at `ptr`.
+static inline __attribute__((always_inline)) void snrt_ssr_desc_start_write(
+    enum snrt_ssr_dm dm, const snrt_ssr_desc_t *d, volatile void *ptr) {
+    snrt_ssr_desc_apply(dm, d);
+    snrt_ssr_desc_write(dm, d, ptr);
+}
@@ -3,9 +3,15 @@
 // SPDX-License-Identifier: Apache-2.0
 #include <snrt.h>
 
+/// Bytes of the DMA transfers started by this core, counted from the transfer
+/// sizes since not every platform has the DMA performance counters.
+static __thread size_t dma_bytes;
+
 /// Initiate an asynchronous 1D DMA transfer with wide 64-bit pointers.
 snrt_dma_txid_t snrt_dma_start_1d_wideptr(uint64_t dst, uint64_t src,
                                           size_t size) {
+    dma_bytes += size;
+
     register uint32_t reg_dst_low asm("a0") = dst >> 0;    // 10
     register uint32_t reg_dst_high asm("a1") = dst >> 32;  // 11
     register uint32_t reg_src_low asm("a2") = src >> 0;    // 12
@@ -54,6 +60,8 @@ snrt_dma_txid_t snrt_dma_start_1d(void *dst, const void *src, size_t size) {
 snrt_dma_txid_t snrt_dma_start_2d_wideptr(uint64_t dst, uint64_t src,
                                           size_t size, size_t dst_stride,
                                           size_t src_stride, size_t repeat) {
+    dma_bytes += size * repeat;
+
     register uint32_t reg_dst_low asm("a0") = dst >> 0;       // 10
     register uint32_t reg_dst_high asm("a1") = dst >> 32;     // 11
     register uint32_t reg_src_low asm("a2") = src >> 0;       // 12
@@ -151,3 +159,9 @@ void snrt_dma_wait_all() {
         "bne t0, zero, 1b \n" ::
             : "t0");
 }
+
+/// Bytes of the DMA transfers started by this core since the last reset.
+size_t snrt_dma_get_bytes() { return dma_bytes; }
+
+/// Reset the count of the bytes of the DMA transfers started by this core.
+void snrt_dma_reset_bytes() { dma_bytes = 0; }
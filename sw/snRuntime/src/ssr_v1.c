@@ -12,12 +12,20 @@ typedef struct {
     ssr_reg32_t repeat;
     ssr_reg32_t bounds[4];
     ssr_reg32_t stride[4];
-    ssr_reg32_t _reserved4[14];
+    ssr_reg32_t idx_size;
+    ssr_reg32_t idx_base;
+    ssr_reg32_t idx_shift;
+    ssr_reg32_t _reserved13[3];
+    ssr_reg32_t rptr_indir[4];
+    ssr_reg32_t wptr_indir[4];
     ssr_reg32_t rptr[4];
     ssr_reg32_t wptr[4];
 } ssr_cfg_t;
 static volatile ssr_cfg_t *const ssr_config_reg = (void *)0x204800;
 
+/// Largest index shift supported by the indirector (`shift_width` of 3).
+#define IDX_SHIFT_MAX 7
+
 // Configure an SSR data mover for a 1D loop nest.
 void snrt_ssr_loop_1d(enum snrt_ssr_dm dm, size_t b0, size_t i0) {
     --b0;
@@ -100,3 +108,83 @@ void snrt_ssr_write(enum snrt_ssr_dm dm, enum snrt_ssr_dim dim,
                     volatile void *ptr) {
     ssr_config_reg[dm].wptr[dim].value = (size_t)ptr;
 }
+
+/// Whether a data mover has an indirector. The index base register of a data
+/// mover without one reads back as zero.
+int snrt_ssr_indir_supported(enum snrt_ssr_dm dm) {
+    if (dm > SNRT_SSR_DM2) return 0;
+    ssr_config_reg[dm].idx_base.value = 8;
+    return ssr_config_reg[dm].idx_base.value != 0;
+}
+
+/// Check an indirect stream configuration. Indices must be naturally aligned,
+/// the indexed data must be word aligned and the data mover must have an
+/// indirector.
+static int check_indir(enum snrt_ssr_dm dm, enum snrt_ssr_idx_size size,
+                       volatile void *idx, volatile void *base,
+                       uint32_t shift) {
+    if (dm > SNRT_SSR_DM2 || size > SNRT_SSR_IDX32) return -1;
+    if ((uintptr_t)idx & ((1 << size) - 1)) return -1;
+    if ((uintptr_t)base & 7) return -1;
+    if (shift > IDX_SHIFT_MAX) return -1;
+    if (!snrt_ssr_indir_supported(dm)) return -1;
+    return 0;
+}
+
+/// Configure the index format and the indexed data of an indirect stream.
+/// This data mover addresses `base + (idx << shift) * stride`, so the stride
+/// is the word size.
+static void setup_indir(enum snrt_ssr_dm dm, enum snrt_ssr_idx_size size,
+                        size_t len, volatile void *base, uint32_t shift) {
+    // Every index is streamed once, whatever a previous stream repeated.
+    ssr_config_reg[dm].repeat.value = 0;
+    ssr_config_reg[dm].bounds[0].value = len - 1;
+    ssr_config_reg[dm].stride[0].value = 8;
+    ssr_config_reg[dm].idx_size.value = size;
+    ssr_config_reg[dm].idx_shift.value = shift;
+    ssr_config_reg[dm].idx_base.value = (uintptr_t)base;
+}
+
+/// Start an indirect streaming read (gather) of `len` elements
+/// `base[idx[i]]`, where elements are `8 << shift` bytes wide.
+/// Returns nonzero and leaves the data mover untouched if the configuration
+/// is not supported.
+int snrt_ssr_gather(enum snrt_ssr_dm dm, enum snrt_ssr_idx_size size,
+                    volatile void *idx, size_t len, volatile void *base,
+                    uint32_t shift) {
+    if (len == 0 || check_indir(dm, size, idx, base, shift)) return -1;
+    setup_indir(dm, size, len, base, shift);
+    ssr_config_reg[dm].rptr_indir[0].value = (uintptr_t)idx;
+    return 0;
+}
+
+/// Start an indirect streaming write (scatter) of `len` elements
+/// `base[idx[i]]`, where elements are `8 << shift` bytes wide.
+/// Returns nonzero and leaves the data mover untouched if the configuration
+/// is not supported.
+int snrt_ssr_scatter(enum snrt_ssr_dm dm, enum snrt_ssr_idx_size size,
+                     volatile void *idx, size_t len, volatile void *base,
+                     uint32_t shift) {
+    if (len == 0 || check_indir(dm, size, idx, base, shift)) return -1;
+    setup_indir(dm, size, len, base, shift);
+    ssr_config_reg[dm].wptr_indir[0].value = (uintptr_t)idx;
+    return 0;
+}
+
+/// This data mover has no intersector: always fails.
+int snrt_ssr_isect_master(enum snrt_ssr_dm dm, enum snrt_ssr_merge merge,
+                          enum snrt_ssr_idx_size size, volatile void *idx,
+                          size_t len, volatile void *base, uint32_t shift,
+                          int with_slave) {
+    return -1;
+}
+
+/// This data mover has no intersector: always fails.
+int snrt_ssr_isect_slave(enum snrt_ssr_dm dm, enum snrt_ssr_idx_size size,
+                         volatile void *idx_out, volatile void *base,
+                         uint32_t shift, int write) {
+    return -1;
+}
+
+/// This data mover has no intersector: no index is ever emitted.
+size_t snrt_ssr_isect_count(enum snrt_ssr_dm dm) { return 0; }
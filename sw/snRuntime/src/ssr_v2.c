@@ -35,12 +35,29 @@ static void write_ssr_cfg(uint32_t reg, uint32_t dm, uint32_t value) {
 enum {
     REG_STATUS = 0,
     REG_REPEAT = 1,
-    REG_BOUNDS = 2,   // + loop index
-    REG_STRIDES = 6,  // + loop index
-    REG_RPTR = 24,    // + snrt_ssr_dim
-    REG_WPTR = 28,    // + snrt_ssr_dim
+    REG_BOUNDS = 2,       // + loop index
+    REG_STRIDES = 6,      // + loop index
+    REG_IDX_CFG = 10,     // {merge, shift, size}
+    REG_IDX_BASE = 11,    // base address of the indexed data
+    REG_IDX_ISECT = 12,   // number of intersected indices (read-only)
+    REG_RPTR_INDIR = 16,  // + isect role
+    REG_WPTR_INDIR = 20,  // + isect role
+    REG_RPTR = 24,        // + snrt_ssr_dim
+    REG_WPTR = 28,        // + snrt_ssr_dim
 };
 
+/// The role of an indirect stream, selected through the `dims` field of the
+/// indirect pointer alias registers.
+enum {
+    INDIR_PLAIN = 0,       // plain gather or scatter
+    INDIR_ISECT_SLV = 1,   // consumes the indices of the intersector
+    INDIR_ISECT_MST = 2,   // feeds indices to the intersector
+    INDIR_ISECT_MSTW = 3,  // as master, but also waits for the slave
+};
+
+/// Largest index shift supported by the indirector (`shift_width` of 3).
+#define IDX_SHIFT_MAX 7
+
 // Configure an SSR data mover for a 1D loop nest.
 void snrt_ssr_loop_1d(enum snrt_ssr_dm dm, size_t b0, size_t i0) {
     --b0;
@@ -123,3 +140,111 @@ void snrt_ssr_write(enum snrt_ssr_dm dm, enum snrt_ssr_dim dim,
                     volatile void *ptr) {
     write_ssr_cfg(REG_WPTR + dim, dm, (uintptr_t)ptr);
 }
+
+/// Whether a data mover has an indirector. The index registers of a data mover
+/// built without one read back as zero.
+int snrt_ssr_indir_supported(enum snrt_ssr_dm dm) {
+    if (dm > SNRT_SSR_DM2) return 0;
+    write_ssr_cfg(REG_IDX_BASE, dm, 8);
+    return read_ssr_cfg(REG_IDX_BASE, dm) != 0;
+}
+
+/// Check an indirect stream configuration. Indices must be naturally aligned
+/// and the indexed data must be word aligned, since the indirector addresses
+/// `base + (idx << 3 << shift)`, and the data mover must have an indirector.
+static int check_indir(enum snrt_ssr_dm dm, enum snrt_ssr_idx_size size,
+                       volatile void *idx, volatile void *base,
+                       uint32_t shift) {
+    if (dm > SNRT_SSR_DM2 || size > SNRT_SSR_IDX32) return -1;
+    if ((uintptr_t)idx & ((1 << size) - 1)) return -1;
+    if ((uintptr_t)base & 7) return -1;
+    if (shift > IDX_SHIFT_MAX) return -1;
+    if (!snrt_ssr_indir_supported(dm)) return -1;
+    return 0;
+}
+
+/// Configure the index format and the indexed data of an indirect stream.
+static void setup_indir(enum snrt_ssr_dm dm, enum snrt_ssr_idx_size size,
+                        size_t len, volatile void *base, uint32_t shift,
+                        enum snrt_ssr_merge merge) {
+    // Every index is streamed once, whatever a previous stream repeated.
+    write_ssr_cfg(REG_REPEAT, dm, 0);
+    write_ssr_cfg(REG_BOUNDS + 0, dm, len - 1);
+    // The indirector always walks the index array in words; the stride is
+    // only set for tools that derive the element size from it.
+    write_ssr_cfg(REG_STRIDES + 0, dm, 8 << shift);
+    write_ssr_cfg(REG_IDX_CFG, dm, merge << 16 | shift << 8 | size);
+    write_ssr_cfg(REG_IDX_BASE, dm, (uintptr_t)base);
+}
+
+/// Start an indirect streaming read (gather) of `len` elements
+/// `base[idx[i]]`, where elements are `8 << shift` bytes wide.
+/// Returns nonzero and leaves the data mover untouched if the configuration
+/// is not supported.
+int snrt_ssr_gather(enum snrt_ssr_dm dm, enum snrt_ssr_idx_size size,
+                    volatile void *idx, size_t len, volatile void *base,
+                    uint32_t shift) {
+    if (len == 0 || check_indir(dm, size, idx, base, shift)) return -1;
+    setup_indir(dm, size, len, base, shift, SNRT_SSR_INTERSECT);
+    write_ssr_cfg(REG_RPTR_INDIR + INDIR_PLAIN, dm, (uintptr_t)idx);
+    return 0;
+}
+
+/// Start an indirect streaming write (scatter) of `len` elements
+/// `base[idx[i]]`, where elements are `8 << shift` bytes wide.
+/// Returns nonzero and leaves the data mover untouched if the configuration
+/// is not supported.
+int snrt_ssr_scatter(enum snrt_ssr_dm dm, enum snrt_ssr_idx_size size,
+                     volatile void *idx, size_t len, volatile void *base,
+                     uint32_t shift) {
+    if (len == 0 || check_indir(dm, size, idx, base, shift)) return -1;
+    setup_indir(dm, size, len, base, shift, SNRT_SSR_INTERSECT);
+    write_ssr_cfg(REG_WPTR_INDIR + INDIR_PLAIN, dm, (uintptr_t)idx);
+    return 0;
+}
+
+/// Start one side of a sparse-sparse intersection or union.
+///
+/// The two masters (`SNRT_SSR_DM0` and `SNRT_SSR_DM1`) each stream a sorted
+/// index array of `len` entries and read `base[idx[i]]` for every index
+/// emitted by the intersector. For a union, elements missing on one side are
+/// streamed as zero. Both masters must use the same `merge` mode. If
+/// `with_slave` is set, the masters are throttled by the slave stream
+/// configured with `snrt_ssr_isect_slave`.
+int snrt_ssr_isect_master(enum snrt_ssr_dm dm, enum snrt_ssr_merge merge,
+                          enum snrt_ssr_idx_size size, volatile void *idx,
+                          size_t len, volatile void *base, uint32_t shift,
+                          int with_slave) {
+    if (dm > SNRT_SSR_DM1 || merge > SNRT_SSR_UNION) return -1;
+    if (len == 0 || check_indir(dm, size, idx, base, shift)) return -1;
+    setup_indir(dm, size, len, base, shift, merge);
+    write_ssr_cfg(REG_RPTR_INDIR + (with_slave ? INDIR_ISECT_MSTW
+                                               : INDIR_ISECT_MST),
+                  dm, (uintptr_t)idx);
+    return 0;
+}
+
+/// Start the slave stream of an intersection on `SNRT_SSR_DM2`.
+///
+/// The slave writes the indices emitted by the intersector to `idx_out` and
+/// streams `base[idx]` for each of them, as a write stream if `write` is set
+/// and as a read stream otherwise. The number of emitted indices can be
+/// queried with `snrt_ssr_isect_count` once the stream is done.
+int snrt_ssr_isect_slave(enum snrt_ssr_dm dm, enum snrt_ssr_idx_size size,
+                         volatile void *idx_out, volatile void *base,
+                         uint32_t shift, int write) {
+    if (dm != SNRT_SSR_DM2) return -1;
+    if (check_indir(dm, size, idx_out, base, shift)) return -1;
+    write_ssr_cfg(REG_REPEAT, dm, 0);
+    write_ssr_cfg(REG_IDX_CFG, dm, shift << 8 | size);
+    write_ssr_cfg(REG_IDX_BASE, dm, (uintptr_t)base);
+    write_ssr_cfg((write ? REG_WPTR_INDIR : REG_RPTR_INDIR) + INDIR_ISECT_SLV,
+                  dm, (uintptr_t)idx_out);
+    return 0;
+}
+
+/// Number of indices emitted by the last completed intersection, as counted
+/// by the slave data mover.
+size_t snrt_ssr_isect_count(enum snrt_ssr_dm dm) {
+    return read_ssr_cfg(REG_IDX_ISECT, dm);
+}
@@ -0,0 +1,53 @@
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <snrt.h>
+
+#include "ssr.h"
+
+// Stream a 4x8 matrix column-wise through a 2D descriptor and compare the
+// sum of every column against a scalar reference.
+static const snrt_ssr_desc_t col_desc =
+    SNRT_SSR_DESC_2D(4, 8, 8 * sizeof(double), sizeof(double));
+
+int main() {
+    if (snrt_global_core_idx() != 0) return 0;
+
+    int errors = 0;
+    double *mat = (void *)snrt_cluster_memory().start;
+    double col_sum[8];
+
+    for (uint32_t i = 0; i < 32; i++) mat[i] = (double)(i + 1);
+
+    snrt_ssr_desc_apply(SNRT_SSR_DM0, &col_desc);
+    snrt_ssr_desc_read(SNRT_SSR_DM0, &col_desc, mat);
+    snrt_ssr_enable();
+    for (uint32_t c = 0; c < 8; c++) {
+        double acc = 0.0;
+        for (uint32_t r = 0; r < 4; r++) {
+            asm volatile("fadd.d %[acc], %[acc], ft0"
+                         : [ acc ] "+f"(acc)::"ft0");
+        }
+        col_sum[c] = acc;
+    }
+    snrt_ssr_disable();
+
+    for (uint32_t c = 0; c < 8; c++) {
+        double ref = 0.0;
+        for (uint32_t r = 0; r < 4; r++) ref += mat[r * 8 + c];
+        errors += col_sum[c] != ref;
+    }
+
+    // Rebasing the configured stream must not touch bounds or strides.
+    snrt_ssr_rebase_read(SNRT_SSR_DM0, SNRT_SSR_2D, &mat[1]);
+    snrt_ssr_enable();
+    double acc = 0.0;
+    for (uint32_t r = 0; r < 4; r++) {
+        asm volatile("fadd.d %[acc], %[acc], ft0" : [ acc ] "+f"(acc)::"ft0");
+    }
+    snrt_ssr_disable();
+    errors += acc != (2.0 + 10.0 + 18.0 + 26.0);
+
+    return errors;
+}
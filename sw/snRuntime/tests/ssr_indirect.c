@@ -0,0 +1,110 @@
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <snrt.h>
+
+// Gather through DM0 and scatter through DM2, check that unsupported
+// configurations are rejected, and run an intersection if the data movers
+// have an intersector.
+
+static const uint16_t idx[8] = {5, 0, 7, 7, 2, 11, 1, 3};
+static const uint32_t idx_a[4] = {1, 3, 4, 8};
+static const uint32_t idx_b[5] = {0, 3, 5, 8, 9};
+
+int main() {
+    if (snrt_global_core_idx() != 0) return 0;
+
+    int errors = 0;
+    double *x = (void *)snrt_cluster_memory().start;
+    double *y = x + 16;
+    double *z = y + 16;
+    uint32_t *idx_out = (void *)(z + 16);
+    double g[8];
+
+    for (uint32_t i = 0; i < 16; i++) {
+        x[i] = (double)(i + 1);
+        y[i] = 0.0;
+        z[i] = 0.0;
+    }
+
+    // Gather x[idx[i]], ignoring the repetition of an earlier stream
+    snrt_ssr_repeat(SNRT_SSR_DM0, 2);
+    errors += snrt_ssr_gather(SNRT_SSR_DM0, SNRT_SSR_IDX16, (void *)idx, 8, x,
+                              0) != 0;
+    snrt_ssr_enable();
+    for (uint32_t i = 0; i < 8; i++) {
+        asm volatile("fmv.d %[g], ft0" : [ g ] "=f"(g[i])::"ft0");
+    }
+    snrt_ssr_disable();
+    for (uint32_t i = 0; i < 8; i++) errors += g[i] != x[idx[i]];
+
+    // Scatter y[idx[i]] = i for the distinct leading indices
+    errors += snrt_ssr_scatter(SNRT_SSR_DM2, SNRT_SSR_IDX16, (void *)idx, 3, y,
+                               0) != 0;
+    snrt_ssr_enable();
+    for (uint32_t i = 0; i < 3; i++) {
+        double v = (double)i;
+        asm volatile("fmv.d ft2, %[v]" ::[v] "f"(v) : "ft2");
+    }
+    snrt_ssr_disable();
+    snrt_fpu_fence();
+    errors += y[5] != 0.0 || y[0] != 1.0 || y[7] != 2.0;
+
+    // Gather pairs of words through an index shift
+    errors += snrt_ssr_gather(SNRT_SSR_DM0, SNRT_SSR_IDX32, (void *)idx_a, 2, x,
+                              1) != 0;
+    snrt_ssr_enable();
+    for (uint32_t i = 0; i < 2; i++) {
+        asm volatile("fmv.d %[g], ft0" : [ g ] "=f"(g[i])::"ft0");
+    }
+    snrt_ssr_disable();
+    errors += g[0] != x[2] || g[1] != x[6];
+
+    // Unsupported configurations
+    errors += snrt_ssr_gather(SNRT_SSR_DM0, SNRT_SSR_IDX16, (void *)idx, 0, x,
+                              0) == 0;
+    errors += snrt_ssr_gather(SNRT_SSR_DM0, SNRT_SSR_IDX16,
+                              (void *)((uintptr_t)idx + 1), 4, x, 0) == 0;
+    errors += snrt_ssr_gather(SNRT_SSR_DM0, SNRT_SSR_IDX16, (void *)idx, 4,
+                              (void *)((uintptr_t)x + 4), 0) == 0;
+    errors += snrt_ssr_gather(SNRT_SSR_DM0, SNRT_SSR_IDX16, (void *)idx, 4, x,
+                              8) == 0;
+    errors += snrt_ssr_gather(SNRT_SSR_DM0, SNRT_SSR_IDX32 + 1, (void *)idx,
+                              4, x, 0) == 0;
+    errors += snrt_ssr_scatter(SNRT_SSR_DM2 + 1, SNRT_SSR_IDX16, (void *)idx,
+                               4, y, 0) == 0;
+    errors += snrt_ssr_isect_master(SNRT_SSR_DM2, SNRT_SSR_INTERSECT,
+                                    SNRT_SSR_IDX32, (void *)idx_a, 4, x, 0,
+                                    1) == 0;
+    errors += snrt_ssr_isect_slave(SNRT_SSR_DM0, SNRT_SSR_IDX32, idx_out, z, 0,
+                                   1) == 0;
+
+    // z[i] = x[i] * x[i] for the two common indices 3 and 8
+    int ret = snrt_ssr_isect_master(SNRT_SSR_DM0, SNRT_SSR_INTERSECT,
+                                    SNRT_SSR_IDX32, (void *)idx_a, 4, x, 0, 1);
+    ret |= snrt_ssr_isect_master(SNRT_SSR_DM1, SNRT_SSR_INTERSECT,
+                                 SNRT_SSR_IDX32, (void *)idx_b, 5, x, 0, 1);
+    ret |= snrt_ssr_isect_slave(SNRT_SSR_DM2, SNRT_SSR_IDX32, idx_out, z, 0, 1);
+    if (ret == 0) {
+        snrt_ssr_enable();
+        for (uint32_t i = 0; i < 2; i++) {
+            asm volatile("fmul.d ft2, ft0, ft1" ::: "ft0", "ft1", "ft2");
+        }
+        snrt_ssr_disable();
+        snrt_fpu_fence();
+        errors += snrt_ssr_isect_count(SNRT_SSR_DM2) != 2;
+        errors += idx_out[0] != 3 || idx_out[1] != 8;
+        errors += z[3] != x[3] * x[3] || z[8] != x[8] * x[8];
+    } else {
+        // Without an intersector, the triple is rejected as a whole
+        errors += snrt_ssr_isect_master(SNRT_SSR_DM0, SNRT_SSR_INTERSECT,
+                                        SNRT_SSR_IDX32, (void *)idx_a, 4, x, 0,
+                                        1) == 0;
+        errors += snrt_ssr_isect_slave(SNRT_SSR_DM2, SNRT_SSR_IDX32, idx_out,
+                                       z, 0, 1) == 0;
+        errors += snrt_ssr_isect_count(SNRT_SSR_DM2) != 0;
+    }
+
+    return errors;
+}
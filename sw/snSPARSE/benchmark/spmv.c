@@ -0,0 +1,155 @@
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+// Cluster SpMV benchmark over a set of sparsity patterns.
+//
+// For every pattern and index width, the compute cores run their
+// nnz-balanced share of `y = A x` and report:
+// - the cluster cycles and the achieved flop/cycle (equal to GFLOP/s at 1 GHz),
+// - the SSR utilization of every core, i.e. the fraction of its cycles in
+//   which a nonzero was consumed from the value and the gathered stream.
+#include <snrt.h>
+#include <snsparse.h>
+
+#include "printf.h"
+
+#define DIM 256
+#define MAX_NNZ 4096
+#define MAX_CORES 16
+
+enum pattern { UNIFORM, BANDED, POWERLAW, BLOCKDIAG, NUM_PATTERNS };
+
+static const char *pattern_names[NUM_PATTERNS] = {"uniform", "banded",
+                                                  "powerlaw", "blockdiag"};
+
+static struct {
+    snsparse_csr_t a;
+    double *x, *y;
+    uint32_t cycles[MAX_CORES];
+    uint32_t nnz[MAX_CORES];
+} bench;
+
+static uint32_t lcg(uint32_t *state) {
+    *state = *state * 1664525 + 1013904223;
+    return *state >> 8;
+}
+
+/// Number of nonzeros of row `r`.
+static uint32_t row_len(enum pattern p, uint32_t r, uint32_t *seed) {
+    switch (p) {
+        case UNIFORM:
+            return lcg(seed) % 11;
+        case BANDED:
+            return snrt_min(r, 4) + 1 + snrt_min(DIM - 1 - r, 4);
+        case POWERLAW:
+            return snrt_max(64 / (1 + r % 64), 1);
+        default:
+            return 16;
+    }
+}
+
+/// Column of the `i`-th nonzero of row `r`.
+static uint32_t col_of(enum pattern p, uint32_t r, uint32_t i,
+                       uint32_t *seed) {
+    switch (p) {
+        case UNIFORM:
+        case POWERLAW:
+            return lcg(seed) % DIM;
+        case BANDED:
+            return r - snrt_min(r, 4) + i;
+        default:
+            return r / 16 * 16 + i;
+    }
+}
+
+static void generate(enum pattern p, enum snrt_ssr_idx_size idx_size) {
+    snsparse_csr_t *a = &bench.a;
+    uint32_t seed = 1234;
+    a->rows = DIM;
+    a->cols = DIM;
+    a->idx_size = idx_size;
+    a->ptrs[0] = 0;
+    for (uint32_t r = 0; r < DIM; r++) {
+        uint32_t len = row_len(p, r, &seed);
+        uint32_t e = a->ptrs[r];
+        for (uint32_t i = 0; i < len; i++, e++) {
+            uint32_t c = col_of(p, r, i, &seed);
+            a->vals[e] = (double)((int)(lcg(&seed) % 9) - 4);
+            if (idx_size == SNRT_SSR_IDX16)
+                ((uint16_t *)a->idcs)[e] = c;
+            else
+                ((uint32_t *)a->idcs)[e] = c;
+        }
+        a->ptrs[r + 1] = e;
+    }
+}
+
+static uint32_t check(void) {
+    const snsparse_csr_t *a = &bench.a;
+    uint32_t errors = 0;
+    for (uint32_t r = 0; r < a->rows; r++) {
+        double acc = 0.0;
+        for (uint32_t e = a->ptrs[r]; e < a->ptrs[r + 1]; e++)
+            acc += a->vals[e] * bench.x[snsparse_idx(a->idcs, a->idx_size, e)];
+        errors += acc != bench.y[r];
+    }
+    return errors;
+}
+
+int main() {
+    uint32_t errors = 0;
+    uint32_t core_idx = snrt_cluster_compute_core_idx();
+    uint32_t core_num = snrt_min(snrt_cluster_compute_core_num(), MAX_CORES);
+    int is_main = snrt_global_core_idx() == 0;
+
+    if (is_main) {
+        bench.a.vals = snrt_l1alloc(MAX_NNZ * sizeof(double));
+        bench.a.idcs = snrt_l1alloc(MAX_NNZ * sizeof(uint32_t));
+        bench.a.ptrs = snrt_l1alloc((DIM + 1) * sizeof(uint32_t));
+        bench.x = snrt_l1alloc(DIM * sizeof(double));
+        bench.y = snrt_l1alloc(DIM * sizeof(double));
+        for (uint32_t c = 0; c < DIM; c++) bench.x[c] = (double)(c % 5) - 2;
+        printf("pattern    idx nnz   cycles flop/cycle*1000 util%% min/avg\n");
+    }
+
+    for (uint32_t p = 0; p < NUM_PATTERNS; p++) {
+        for (uint32_t s = SNRT_SSR_IDX16; s <= SNRT_SSR_IDX32; s++) {
+            if (is_main) generate(p, s);
+            snrt_cluster_hw_barrier();
+
+            uint32_t t0 = read_csr(mcycle);
+            if (snrt_is_compute_core() && core_idx < core_num) {
+                uint32_t lo, hi;
+                snsparse_csr_partition(&bench.a, core_num, core_idx, &lo, &hi);
+                uint32_t t_lo = read_csr(mcycle);
+                snsparse_csrmv(&bench.a, lo, hi, bench.x, bench.y, 1);
+                uint32_t t_hi = read_csr(mcycle);
+                bench.cycles[core_idx] = t_hi - t_lo;
+                bench.nnz[core_idx] = bench.a.ptrs[hi] - bench.a.ptrs[lo];
+            }
+            snrt_cluster_hw_barrier();
+            uint32_t t1 = read_csr(mcycle);
+
+            if (is_main) {
+                uint32_t nnz = snsparse_csr_nnz(&bench.a);
+                uint32_t cycles = snrt_max(t1 - t0, 1);
+                uint32_t util_min = 1000, util_sum = 0;
+                for (uint32_t i = 0; i < core_num; i++) {
+                    uint32_t util =
+                        bench.nnz[i] * 1000 / snrt_max(bench.cycles[i], 1);
+                    util_min = snrt_min(util_min, util);
+                    util_sum += util;
+                }
+                printf("%-10s %2d  %5d %6d %6d %3d.%d/%3d.%d\n",
+                       pattern_names[p], 8 << s, nnz, cycles,
+                       2 * nnz * 1000 / cycles, util_min / 10, util_min % 10,
+                       util_sum / core_num / 10, util_sum / core_num % 10);
+                errors += check();
+            }
+            snrt_cluster_hw_barrier();
+        }
+    }
+
+    return is_main ? errors : 0;
+}
@@ -0,0 +1,134 @@
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <snrt.h>
+
+//================================================================================
+// Formats
+//================================================================================
+
+/// A sparse vector of `nnz` nonzeros out of `len` elements.
+typedef struct snsparse_svec {
+    uint32_t len;
+    uint32_t nnz;
+    enum snrt_ssr_idx_size idx_size;
+    double *vals;
+    void *idcs;
+} snsparse_svec_t;
+
+/// A compressed sparse matrix of `rows` x `cols` elements.
+///
+/// In CSR format, `ptrs` holds `rows + 1` offsets into `vals` and `idcs`, and
+/// `idcs` holds the column of every nonzero. In CSC format, `ptrs` holds
+/// `cols + 1` offsets and `idcs` the row of every nonzero. Indices are either
+/// 16 or 32 bits wide as given by `idx_size`.
+typedef struct snsparse_csr {
+    uint32_t rows;
+    uint32_t cols;
+    enum snrt_ssr_idx_size idx_size;
+    double *vals;
+    void *idcs;
+    uint32_t *ptrs;
+} snsparse_csr_t;
+
+/// A compressed sparse column matrix; see `snsparse_csr_t`.
+typedef snsparse_csr_t snsparse_csc_t;
+
+/// A sparse matrix in coordinate format.
+typedef struct snsparse_coo {
+    uint32_t rows;
+    uint32_t cols;
+    uint32_t nnz;
+    enum snrt_ssr_idx_size idx_size;
+    double *vals;
+    void *row_idcs;
+    void *col_idcs;
+} snsparse_coo_t;
+
+/// Number of nonzeros of a CSR matrix.
+static inline uint32_t snsparse_csr_nnz(const snsparse_csr_t *a) {
+    return a->ptrs[a->rows] - a->ptrs[0];
+}
+
+/// Read index `i` of an index array of the given width.
+static inline uint32_t snsparse_idx(const void *idcs,
+                                    enum snrt_ssr_idx_size idx_size,
+                                    uint32_t i) {
+    if (idx_size == SNRT_SSR_IDX16) return ((const uint16_t *)idcs)[i];
+    return ((const uint32_t *)idcs)[i];
+}
+
+/// Convert a COO matrix to CSR. `csr` must provide `vals`, `idcs` and `ptrs`
+/// buffers for `coo->nnz` nonzeros and `coo->rows` rows; the index width is
+/// taken over from `coo`. Duplicate coordinates are kept.
+extern void snsparse_coo_to_csr(const snsparse_coo_t *coo,
+                                snsparse_csr_t *csr);
+
+//================================================================================
+// Partitioning
+//================================================================================
+
+/// Split the rows of `a` into `num` contiguous ranges holding roughly the same
+/// number of nonzeros, and return range `idx` as `[*row_lo, *row_hi)`.
+extern void snsparse_csr_partition(const snsparse_csr_t *a, uint32_t num,
+                                   uint32_t idx, uint32_t *row_lo,
+                                   uint32_t *row_hi);
+
+//================================================================================
+// Single-core kernels
+//================================================================================
+// The kernels fall back to scalar loops if the data movers have no
+// indirection (see `snrt_ssr_indir_supported`).
+
+/// Sparse-dense dot product `a . x`.
+extern double snsparse_spvv(const snsparse_svec_t *a, const double *x);
+
+/// Sparse matrix-vector product `y[r * incy] = (A x)[r]` for the rows
+/// `[row_lo, row_hi)` of the CSR matrix `a`.
+extern void snsparse_csrmv(const snsparse_csr_t *a, uint32_t row_lo,
+                           uint32_t row_hi, const double *x, double *y,
+                           uint32_t incy);
+
+/// Sparse matrix-vector product `y = A x` for a CSC matrix `a`. Every column
+/// is scatter-accumulated into `y`, so the rows within a column must be
+/// distinct.
+extern void snsparse_cscmv(const snsparse_csc_t *a, const double *x,
+                           double *y);
+
+/// Sparse matrix-vector product `y = A x` for a COO matrix `a`. This is a
+/// scalar reference implementation for testing.
+extern void snsparse_coomv(const snsparse_coo_t *a, const double *x,
+                           double *y);
+
+/// Sparse-dense matrix product `C = A B` for the rows `[row_lo, row_hi)` of
+/// the CSR matrix `a`. `B` is column-major with `a->cols` rows, `n` columns
+/// and leading dimension `ldb`; `C` is row-major with leading dimension `ldc`.
+extern void snsparse_csrmm(const snsparse_csr_t *a, uint32_t row_lo,
+                           uint32_t row_hi, uint32_t n, const double *B,
+                           uint32_t ldb, double *C, uint32_t ldc);
+
+//================================================================================
+// Cluster drivers
+//================================================================================
+// These must be called by all cores of a cluster. The work is split across the
+// compute cores by nonzeros; the data mover core only joins the barriers.
+
+/// Cluster-parallel `y = A x` for data residing in the TCDM.
+extern void snsparse_csrmv_cluster(const snsparse_csr_t *a, const double *x,
+                                   double *y);
+
+/// Cluster-parallel `C = A B` for data residing in the TCDM.
+extern void snsparse_csrmm_cluster(const snsparse_csr_t *a, uint32_t n,
+                                   const double *B, uint32_t ldb, double *C,
+                                   uint32_t ldc);
+
+/// Cluster-parallel `y = A x` for a matrix that does not fit into the TCDM.
+///
+/// The data mover core copies `x` into the TCDM once and streams row tiles of
+/// `a` through two buffers in the `l1_len` bytes at `l1_buf`, overlapping the
+/// transfers with the computation of the previous tile. Returns nonzero if `x`
+/// and a single row do not fit into the buffer.
+extern int snsparse_csrmv_tiled(const snsparse_csr_t *a, const double *x,
+                                double *y, void *l1_buf, size_t l1_len);
@@ -0,0 +1,46 @@
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+#include <snsparse.h>
+
+static inline void set_idx(void *idcs, enum snrt_ssr_idx_size idx_size,
+                           uint32_t i, uint32_t value) {
+    if (idx_size == SNRT_SSR_IDX16)
+        ((uint16_t *)idcs)[i] = value;
+    else
+        ((uint32_t *)idcs)[i] = value;
+}
+
+void snsparse_coo_to_csr(const snsparse_coo_t *coo, snsparse_csr_t *csr) {
+    enum snrt_ssr_idx_size idx_size = coo->idx_size;
+    csr->rows = coo->rows;
+    csr->cols = coo->cols;
+    csr->idx_size = idx_size;
+
+    // Count the nonzeros per row and turn the counts into row offsets.
+    for (uint32_t r = 0; r <= coo->rows; r++) csr->ptrs[r] = 0;
+    for (uint32_t e = 0; e < coo->nnz; e++)
+        csr->ptrs[snsparse_idx(coo->row_idcs, idx_size, e) + 1]++;
+    for (uint32_t r = 0; r < coo->rows; r++) csr->ptrs[r + 1] += csr->ptrs[r];
+
+    // Scatter the nonzeros, using the row offsets as insertion cursors.
+    for (uint32_t e = 0; e < coo->nnz; e++) {
+        uint32_t p = csr->ptrs[snsparse_idx(coo->row_idcs, idx_size, e)]++;
+        csr->vals[p] = coo->vals[e];
+        set_idx(csr->idcs, idx_size, p,
+                snsparse_idx(coo->col_idcs, idx_size, e));
+    }
+
+    // Shift the cursors back to the row offsets.
+    for (uint32_t r = coo->rows; r > 0; r--) csr->ptrs[r] = csr->ptrs[r - 1];
+    csr->ptrs[0] = 0;
+}
+
+void snsparse_coomv(const snsparse_coo_t *a, const double *x, double *y) {
+    for (uint32_t r = 0; r < a->rows; r++) y[r] = 0.0;
+    for (uint32_t e = 0; e < a->nnz; e++) {
+        uint32_t r = snsparse_idx(a->row_idcs, a->idx_size, e);
+        uint32_t c = snsparse_idx(a->col_idcs, a->idx_size, e);
+        y[r] += a->vals[e] * x[c];
+    }
+}
@@ -0,0 +1,277 @@
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+#include <snsparse.h>
+
+#include "ssr.h"
+
+/// Stream `nnz` values from `vals` on ft0 and gather `x[idcs[i]]` on ft1.
+/// Returns nonzero without configuring any stream if the data movers have no
+/// indirection or the indirector does not support the index array or `x`.
+static inline int setup_issr(const double *vals, const void *idcs,
+                             enum snrt_ssr_idx_size idx_size, uint32_t nnz,
+                             const double *x) {
+    if (snrt_ssr_gather(SNRT_SSR_DM1, idx_size, (void *)idcs, nnz, (void *)x,
+                        0))
+        return -1;
+    snrt_ssr_cfg_write(SNRT_SSR_REG_REPEAT, SNRT_SSR_DM0, 0);
+    snrt_ssr_cfg_write(SNRT_SSR_REG_BOUNDS, SNRT_SSR_DM0, nnz - 1);
+    snrt_ssr_cfg_write(SNRT_SSR_REG_STRIDES, SNRT_SSR_DM0, sizeof(double));
+    snrt_ssr_cfg_write(SNRT_SSR_REG_RPTR + SNRT_SSR_1D, SNRT_SSR_DM0,
+                       (uintptr_t)vals);
+    return 0;
+}
+
+double snsparse_spvv(const snsparse_svec_t *a, const double *x) {
+    volatile double res = 0.0;
+    if (a->nnz == 0) return res;
+    if (setup_issr(a->vals, a->idcs, a->idx_size, a->nnz, x)) {
+        for (uint32_t i = 0; i < a->nnz; i++)
+            res += a->vals[i] * x[snsparse_idx(a->idcs, a->idx_size, i)];
+        return res;
+    }
+    register uint32_t ldec asm("t1") = a->nnz - 1;
+    asm volatile(
+        // Setup zero register
+        "fcvt.d.w   ft3, zero           \n"
+        // Enable SSRs
+        "csrsi      0x7C0, 1            \n"
+        // Init target registers
+        "fmv.d      ft4, ft3            \n"
+        "fmv.d      ft5, ft3            \n"
+        "fmv.d      ft6, ft3            \n"
+        "fmv.d      ft7, ft3            \n"
+        "fmv.d      fs0, ft3            \n"
+        // Computation: frep.o t1, 1, 5, 0b1001
+        ".word (0 << 20)|(6 << 15)|(5 << 12)|(0b1001 << 8)|(1 << 7)|"
+        "(0b0001011 << 0) \n"
+        "fmadd.d    ft3, ft1, ft0, ft3  \n"
+        // Reduction
+        "fadd.d     ft9, ft6, ft7       \n"
+        "fadd.d     ft6, ft4, ft5       \n"
+        "fadd.d     ft7, fs0, ft3       \n"
+        "fadd.d     ft4, ft6, ft7       \n"
+        "fadd.d     ft8, ft4, ft9       \n"
+        // Writeback
+        "fsd        ft8, 0(%[res])      \n"
+        // Fence, disable SSRs
+        "fmv.x.w    t0, fa0             \n"
+        "csrci      0x7C0, 1            \n"
+        "bne t0,    zero, 9f            \n9:" ::[res] "r"(&res),
+        [ ldec ] "r"(ldec)
+        : "memory", "t0", "ft0", "ft1", "ft2", "ft3", "ft4", "ft5", "ft6",
+          "ft7", "ft8", "ft9", "fs0");
+    return res;
+}
+
+/// CSR SpMV over `rows` rows starting at `ptrs`, writing every `incy`-th
+/// element of `y`. Rows are unrolled up to five nonzeros; longer rows are
+/// handed to the FREP sequencer with staggered accumulators.
+static void csrmv_issr(const double *vals, const void *idcs,
+                       enum snrt_ssr_idx_size idx_size, const uint32_t *ptrs,
+                       uint32_t rows, const double *x, double *y,
+                       uint32_t incy) {
+    if (rows == 0) return;
+    const uint32_t *rlst = ptrs + rows;
+    const uint32_t ofst = ptrs[0];
+    const uint32_t nnz = *rlst - ofst;
+    if (nnz == 0) {
+        for (uint32_t r = 0; r < rows; r++) y[r * incy] = 0.0;
+        return;
+    }
+    if (setup_issr(vals + ofst, (const uint8_t *)idcs + (ofst << idx_size),
+                   idx_size, nnz, x)) {
+        for (uint32_t r = 0; r < rows; r++) {
+            double acc = 0.0;
+            for (uint32_t e = ptrs[r]; e < ptrs[r + 1]; e++)
+                acc += vals[e] * x[snsparse_idx(idcs, idx_size, e)];
+            y[r * incy] = acc;
+        }
+        return;
+    }
+    asm volatile(
+        // Preload ptrs[0], reset base accumulator
+        "lw         t4, 0(%[rptr])      \n"
+        "fmv.d      ft3, %[f0]          \n"
+        // Enable SSRs
+        "csrsi      0x7C0, 1            \n"
+        "j          20f                 \n"
+        // Joint reentry points for loop
+        "10:"  // Reentry with row result in ft9
+        "fsd        ft9, 0 (%[res])     \n"
+        "11:"  // Reentry with row result already stored
+        "add        %[res], %[res], %[rstr]\n"
+        // Row loop
+        "20:"
+        "lw         t5, 4(%[rptr])      \n"
+        "ble        t5, t4, 0f          \n"  // empty row
+        "addi       %[rptr], %[rptr], 4 \n"
+        "sub        t6, t5, t4          \n"
+        "mv         t4, t5              \n"
+        "fmadd.d    ft4, ft1, ft0, %[f0]\n"
+        "beq        t6, %[c1], 1f       \n"  // 1 elem
+        "fmadd.d    ft5, ft1, ft0, %[f0]\n"
+        "beq        t6, %[c2], 2f       \n"  // 2 elems
+        "fmadd.d    ft6, ft1, ft0, %[f0]\n"
+        "beq        t6, %[c3], 3f       \n"  // 3 elems
+        "fmadd.d    ft7, ft1, ft0, %[f0]\n"
+        "beq        t6, %[c4], 4f       \n"  // 4 elems
+        "fmadd.d    fs0, ft1, ft0, %[f0]\n"
+        "beq        t6, %[c5], 5f       \n"  // 5 elems
+        // If more than 5 elements: commit to FREP
+        "addi       t6, t6, -6          \n"
+        // frep.o t6, 1, 5, 0b1001
+        ".word (0 << 20)|(31 << 15)|(5 << 12)|(0b1001 << 8)|(1 << 7)|"
+        "(0b0001011 << 0) \n"
+        "fmadd.d    ft3, ft1, ft0, ft3  \n"
+        "fadd.d     ft10, ft7, fs0      \n"
+        "fadd.d     ft7, ft5, ft6       \n"
+        "fadd.d     fs0, ft3, ft4       \n"
+        "fadd.d     ft5, ft7, fs0       \n"
+        "fmv.d      ft3, %[f0]          \n"  // Reset ft3, only used by FREP
+        "fadd.d     ft9, ft5, ft10      \n"
+        "bne        %[rptr], %[rlst], 10b\n"
+        "j          30f                 \n"
+        // 5 elems
+        "5:"
+        "fadd.d     ft10, ft4, ft5      \n"
+        "fadd.d     ft4, ft6, ft7       \n"
+        "fadd.d     ft5, ft10, fs0      \n"
+        "fadd.d     ft9, ft5, ft4       \n"
+        "bne        %[rptr], %[rlst], 10b\n"
+        "j          30f                 \n"
+        // 4 elems
+        "4:"
+        "fadd.d     ft10, ft4, ft5      \n"
+        "fadd.d     ft4, ft6, ft7       \n"
+        "fadd.d     ft9, ft4, ft10      \n"
+        "bne        %[rptr], %[rlst], 10b\n"
+        "j          30f                 \n"
+        // 3 elems
+        "3:"
+        "fadd.d     ft7, ft4, ft5       \n"
+        "fadd.d     ft9, ft6, ft7       \n"
+        "bne        %[rptr], %[rlst], 10b\n"
+        "j          30f                 \n"
+        // 2 elems
+        "2:"
+        "fadd.d     ft9, ft4, ft5       \n"
+        "bne        %[rptr], %[rlst], 10b\n"
+        "j          30f                 \n"
+        // 1 elem
+        "1:"
+        "fsd        ft4, 0 (%[res])     \n"
+        "bne        %[rptr], %[rlst], 11b\n"
+        "j          30f                 \n"
+        // empty
+        "0:"
+        "addi       %[rptr], %[rptr], 4 \n"
+        "fsd        %[f0], 0 (%[res])   \n"
+        "bne        %[rptr], %[rlst], 11b\n"
+        // Fence, disable SSRs
+        "30:"
+        "fmv.x.w    t0, fa0             \n"
+        "csrci      0x7C0, 1            \n"
+        "bne t0,    zero, 9f            \n9:"
+        : [ rptr ] "+&r"(ptrs), [ res ] "+&r"(y), [ rlst ] "+&r"(rlst)
+        : [ c1 ] "r"(1), [ c2 ] "r"(2), [ c3 ] "r"(3), [ c4 ] "r"(4),
+          [ c5 ] "r"(5), [ f0 ] "f"(0.0), [ rstr ] "r"(incy * sizeof(double))
+        : "memory", "t0", "t4", "t5", "t6", "ft0", "ft1", "ft2", "ft3", "ft4",
+          "ft5", "ft6", "ft7", "fs0", "ft9", "ft10");
+}
+
+void snsparse_csrmv(const snsparse_csr_t *a, uint32_t row_lo, uint32_t row_hi,
+                    const double *x, double *y, uint32_t incy) {
+    csrmv_issr(a->vals, a->idcs, a->idx_size, a->ptrs + row_lo,
+               row_hi - row_lo, x, y + row_lo * incy, incy);
+}
+
+void snsparse_cscmv(const snsparse_csc_t *a, const double *x, double *y) {
+    for (uint32_t r = 0; r < a->rows; r++) y[r] = 0.0;
+    for (uint32_t c = 0; c < a->cols; c++) {
+        const uint32_t ofst = a->ptrs[c];
+        const uint32_t nnz = a->ptrs[c + 1] - ofst;
+        if (nnz == 0) continue;
+        const void *idcs = (const uint8_t *)a->idcs + (ofst << a->idx_size);
+        // Gather y[idcs[i]] on ft1 and scatter the updated values back
+        // through ft2 with the same indices.
+        if (setup_issr(a->vals + ofst, idcs, a->idx_size, nnz, y) ||
+            snrt_ssr_scatter(SNRT_SSR_DM2, a->idx_size, (void *)idcs, nnz, y,
+                             0)) {
+            for (uint32_t e = ofst; e < ofst + nnz; e++)
+                y[snsparse_idx(a->idcs, a->idx_size, e)] += a->vals[e] * x[c];
+            continue;
+        }
+        // Consecutive columns can share rows, so the scatter of one column
+        // is drained before the next column gathers y.
+        register uint32_t ldec asm("t1") = nnz - 1;
+        asm volatile(
+            // Enable SSRs
+            "csrsi      0x7C0, 1            \n"
+            // Computation: frep.o t1, 1, 0, 0
+            ".word (0 << 20)|(6 << 15)|(0 << 12)|(0 << 8)|(1 << 7)|"
+            "(0b0001011 << 0) \n"
+            "fmadd.d    ft2, ft0, %[xc], ft1\n"
+            // Fence, disable SSRs
+            "fmv.x.w    t0, fa0             \n"
+            "csrci      0x7C0, 1            \n"
+            "bne t0,    zero, 9f            \n9:" ::[xc] "f"(x[c]),
+            [ ldec ] "r"(ldec)
+            : "memory", "t0", "ft0", "ft1", "ft2");
+    }
+}
+
+void snsparse_csrmm(const snsparse_csr_t *a, uint32_t row_lo, uint32_t row_hi,
+                    uint32_t n, const double *B, uint32_t ldb, double *C,
+                    uint32_t ldc) {
+    // Every column of B is a dense vector; the columns of C are strided.
+    for (uint32_t j = 0; j < n; j++) {
+        snsparse_csrmv(a, row_lo, row_hi, B + j * ldb, C + j, ldc);
+    }
+}
+
+/// First row `r` of `a` for which `ptrs[r]` reaches `target`.
+static uint32_t row_at_nnz(const snsparse_csr_t *a, uint32_t target) {
+    uint32_t lo = 0, hi = a->rows;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        if (a->ptrs[mid] < target)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+void snsparse_csr_partition(const snsparse_csr_t *a, uint32_t num,
+                            uint32_t idx, uint32_t *row_lo,
+                            uint32_t *row_hi) {
+    uint32_t base = a->ptrs[0];
+    uint64_t nnz = snsparse_csr_nnz(a);
+    *row_lo = idx == 0 ? 0 : row_at_nnz(a, base + nnz * idx / num);
+    *row_hi = idx + 1 >= num ? a->rows
+                             : row_at_nnz(a, base + nnz * (idx + 1) / num);
+}
+
+void snsparse_csrmv_cluster(const snsparse_csr_t *a, const double *x,
+                            double *y) {
+    if (snrt_is_compute_core()) {
+        uint32_t lo, hi;
+        snsparse_csr_partition(a, snrt_cluster_compute_core_num(),
+                               snrt_cluster_compute_core_idx(), &lo, &hi);
+        snsparse_csrmv(a, lo, hi, x, y, 1);
+    }
+    snrt_cluster_hw_barrier();
+}
+
+void snsparse_csrmm_cluster(const snsparse_csr_t *a, uint32_t n,
+                            const double *B, uint32_t ldb, double *C,
+                            uint32_t ldc) {
+    if (snrt_is_compute_core()) {
+        uint32_t lo, hi;
+        snsparse_csr_partition(a, snrt_cluster_compute_core_num(),
+                               snrt_cluster_compute_core_idx(), &lo, &hi);
+        snsparse_csrmm(a, lo, hi, n, B, ldb, C, ldc);
+    }
+    snrt_cluster_hw_barrier();
+}
@@ -0,0 +1,159 @@
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+#include <snsparse.h>
+
+#define ALIGN_UP(addr, size) (((addr) + (size)-1) & ~((size)-1))
+
+/// A row tile `[row_lo, row_hi)` held in one of the two TCDM buffers. `last`
+/// marks the final step, after which no tile is left to compute or write back.
+struct tile {
+    uint32_t row_lo;
+    uint32_t row_hi;
+    uint32_t last;
+};
+
+/// State shared by the cores of the cluster, at the start of the TCDM buffer.
+struct tiled_state {
+    struct tile tiles[2];
+    uint32_t error;
+};
+
+/// Layout of one tile buffer.
+struct tile_buf {
+    double *y;
+    double *vals;
+    uint32_t *ptrs;
+    uint8_t *idcs;
+};
+
+/// Largest row `hi` such that the rows `[lo, hi)` fit into a tile buffer, or
+/// `lo` if not even row `lo` fits.
+static uint32_t tile_end(const snsparse_csr_t *a, uint32_t lo,
+                         uint32_t max_rows, uint32_t max_nnz) {
+    uint32_t limit = a->ptrs[lo] + max_nnz;
+    if (a->ptrs[lo + 1] > limit) return lo;
+    uint32_t l = lo + 1, h = snrt_min(a->rows, lo + max_rows);
+    while (l < h) {
+        uint32_t mid = (l + h + 1) / 2;
+        if (a->ptrs[mid] <= limit)
+            l = mid;
+        else
+            h = mid - 1;
+    }
+    return l;
+}
+
+int snsparse_csrmv_tiled(const snsparse_csr_t *a, const double *x, double *y,
+                         void *l1_buf, size_t l1_len) {
+    volatile struct tiled_state *st = l1_buf;
+    const uint32_t idx_size = a->idx_size;
+    const uint32_t nnz = snsparse_csr_nnz(a);
+
+    // Carve out the header and the TCDM copy of x.
+    uintptr_t p = ALIGN_UP((uintptr_t)l1_buf + sizeof(*st), 8);
+    double *x_l1 = (double *)p;
+    p += a->cols * sizeof(double);
+    uintptr_t end = (uintptr_t)l1_buf + l1_len;
+    if (p >= end) return -1;
+
+    // Split each of the two tile buffers between per-row data (offset and
+    // result) and per-nonzero data (value and index) in the proportion the
+    // matrix has on average.
+    size_t buf_len = ((end - p) / 2) & ~7;
+    uint64_t row_bytes = (uint64_t)a->rows * 12;
+    uint64_t nz_bytes = (uint64_t)nnz * (8 + (1 << idx_size));
+    uint32_t max_rows = buf_len * row_bytes / (row_bytes + nz_bytes + 1) / 12;
+    if (max_rows == 0) max_rows = 1;
+    size_t row_len = ALIGN_UP(max_rows * 12 + 4, 8);
+    if (row_len >= buf_len) return -1;
+    uint32_t max_nnz = (buf_len - row_len) / (8 + (1 << idx_size));
+    if (max_nnz == 0) return -1;
+
+    struct tile_buf bufs[2];
+    for (int b = 0; b < 2; b++) {
+        uintptr_t q = p + b * buf_len;
+        bufs[b].y = (double *)q;
+        q += max_rows * sizeof(double);
+        bufs[b].vals = (double *)q;
+        q += max_nnz * sizeof(double);
+        bufs[b].ptrs = (uint32_t *)q;
+        q += (max_rows + 1) * sizeof(uint32_t);
+        bufs[b].idcs = (uint8_t *)q;
+    }
+
+    uint32_t next = 0;
+    if (snrt_is_dm_core()) {
+        snrt_dma_start_1d(x_l1, x, a->cols * sizeof(double));
+        st->tiles[0] = (struct tile){a->rows, a->rows, 0};
+        st->tiles[1] = (struct tile){a->rows, a->rows, 0};
+        st->error = 0;
+    }
+
+    // In step `s`, the data mover writes back the results of tile `s - 2` and
+    // loads tile `s` into the same buffer, while the compute cores work on tile
+    // `s - 1` in the other one. Only the tile loaded in step `s` is inspected
+    // after the barrier, as the other one is overwritten in step `s + 1`.
+    for (uint32_t s = 0;; s++) {
+        uint32_t b = s & 1;
+        if (snrt_is_dm_core()) {
+            volatile struct tile *t = &st->tiles[b];
+            if (t->row_hi > t->row_lo)
+                snrt_dma_start_1d(y + t->row_lo, bufs[b].y,
+                                  (t->row_hi - t->row_lo) * sizeof(double));
+            uint32_t lo = next, hi = next;
+            if (next < a->rows) {
+                hi = tile_end(a, lo, max_rows, max_nnz);
+                if (hi == lo) {
+                    st->error = 1;
+                    lo = hi = a->rows;
+                }
+            }
+            if (hi > lo) {
+                uint32_t nz_lo = a->ptrs[lo], nz_hi = a->ptrs[hi];
+                snrt_dma_start_1d(bufs[b].ptrs, a->ptrs + lo,
+                                  (hi - lo + 1) * sizeof(uint32_t));
+                snrt_dma_start_1d(bufs[b].vals, a->vals + nz_lo,
+                                  (nz_hi - nz_lo) * sizeof(double));
+                snrt_dma_start_1d(bufs[b].idcs,
+                                  (uint8_t *)a->idcs + (nz_lo << idx_size),
+                                  (nz_hi - nz_lo) << idx_size);
+            }
+            volatile struct tile *prev = &st->tiles[b ^ 1];
+            t->last = hi == lo && prev->row_hi == prev->row_lo;
+            t->row_lo = lo;
+            t->row_hi = hi;
+            next = hi;
+            snrt_dma_wait_all();
+        } else if (s > 0) {
+            uint32_t lo = st->tiles[b ^ 1].row_lo;
+            uint32_t hi = st->tiles[b ^ 1].row_hi;
+            if (hi > lo) {
+                // The tile keeps the global offsets in `ptrs`, so rebase the
+                // value and index arrays to the first nonzero of the tile.
+                const struct tile_buf *tb = &bufs[b ^ 1];
+                uint32_t nz_lo = tb->ptrs[0];
+                snsparse_csr_t tile = {
+                    .rows = hi - lo,
+                    .cols = a->cols,
+                    .idx_size = a->idx_size,
+                    .vals = (double *)((uintptr_t)tb->vals -
+                                       nz_lo * sizeof(double)),
+                    .idcs = (void *)((uintptr_t)tb->idcs - (nz_lo << idx_size)),
+                    .ptrs = tb->ptrs,
+                };
+                uint32_t row_lo, row_hi;
+                snsparse_csr_partition(&tile, snrt_cluster_compute_core_num(),
+                                       snrt_cluster_compute_core_idx(), &row_lo,
+                                       &row_hi);
+                snsparse_csrmv(&tile, row_lo, row_hi, x_l1, tb->y, 1);
+            }
+        }
+        snrt_cluster_hw_barrier();
+        if (st->tiles[b].last) break;
+    }
+
+    int error = st->error;
+    snrt_cluster_hw_barrier();
+    return error ? -1 : 0;
+}
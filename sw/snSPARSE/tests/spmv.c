@@ -0,0 +1,166 @@
+// Copyright 2020 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+#include <snrt.h>
+#include <snsparse.h>
+
+#include "printf.h"
+
+#define ROWS 48
+#define COLS 40
+#define MAX_NNZ (ROWS * 12)
+#define N 3
+
+/// Matrices and vectors shared by all cores.
+static struct {
+    snsparse_coo_t coo;
+    snsparse_csr_t csr16, csr32, csc;
+    double *x, *y, *ref, *B, *C, *work;
+} data;
+
+static uint32_t lcg(uint32_t *state) {
+    *state = *state * 1664525 + 1013904223;
+    return *state >> 8;
+}
+
+static void *alloc_idcs(enum snrt_ssr_idx_size idx_size, uint32_t n) {
+    return snrt_l1alloc(n << idx_size);
+}
+
+static snsparse_csr_t alloc_csr(enum snrt_ssr_idx_size idx_size,
+                                uint32_t majors) {
+    return (snsparse_csr_t){
+        .idx_size = idx_size,
+        .vals = snrt_l1alloc(MAX_NNZ * sizeof(double)),
+        .idcs = alloc_idcs(idx_size, MAX_NNZ),
+        .ptrs = snrt_l1alloc((majors + 1) * sizeof(uint32_t)),
+    };
+}
+
+/// Generate a matrix with empty, short and long rows. All values are small
+/// integers such that every summation order yields the exact same result.
+static void generate(enum snrt_ssr_idx_size idx_size) {
+    uint32_t seed = 42;
+    snsparse_coo_t *coo = &data.coo;
+    coo->rows = ROWS;
+    coo->cols = COLS;
+    coo->idx_size = idx_size;
+    coo->nnz = 0;
+    for (uint32_t r = 0; r < ROWS; r++) {
+        uint32_t len = r % 7 == 3 ? 0 : lcg(&seed) % (r % 5 == 0 ? 12 : 6);
+        for (uint32_t i = 0; i < len; i++) {
+            uint32_t c = (r * 7 + i * 3) % COLS;
+            uint32_t e = coo->nnz++;
+            coo->vals[e] = (double)((int)(lcg(&seed) % 9) - 4);
+            if (idx_size == SNRT_SSR_IDX16) {
+                ((uint16_t *)coo->row_idcs)[e] = r;
+                ((uint16_t *)coo->col_idcs)[e] = c;
+            } else {
+                ((uint32_t *)coo->row_idcs)[e] = r;
+                ((uint32_t *)coo->col_idcs)[e] = c;
+            }
+        }
+    }
+    for (uint32_t c = 0; c < COLS; c++) data.x[c] = (double)(c % 5) - 2;
+    for (uint32_t i = 0; i < COLS * N; i++) data.B[i] = (double)(i % 7) - 3;
+}
+
+static uint32_t compare(const double *a, const double *b, uint32_t n,
+                        uint32_t inc, const char *what) {
+    uint32_t errors = 0;
+    for (uint32_t i = 0; i < n; i++) errors += a[i * inc] != b[i];
+    if (errors) printf("%s: %d errors\n", what, errors);
+    return errors;
+}
+
+int main() {
+    uint32_t errors = 0;
+    int is_main = snrt_global_core_idx() == 0;
+
+    if (is_main) {
+        data.coo.vals = snrt_l1alloc(MAX_NNZ * sizeof(double));
+        data.coo.row_idcs = alloc_idcs(SNRT_SSR_IDX32, MAX_NNZ);
+        data.coo.col_idcs = alloc_idcs(SNRT_SSR_IDX32, MAX_NNZ);
+        data.csr16 = alloc_csr(SNRT_SSR_IDX16, ROWS);
+        data.csr32 = alloc_csr(SNRT_SSR_IDX32, ROWS);
+        data.csc = alloc_csr(SNRT_SSR_IDX32, COLS);
+        data.x = snrt_l1alloc(COLS * sizeof(double));
+        data.y = snrt_l1alloc(ROWS * sizeof(double));
+        data.ref = snrt_l1alloc(ROWS * sizeof(double));
+        data.B = snrt_l1alloc(COLS * N * sizeof(double));
+        data.C = snrt_l1alloc(ROWS * N * sizeof(double));
+        data.work = snrt_l1alloc(2048);
+
+        generate(SNRT_SSR_IDX16);
+        snsparse_coo_to_csr(&data.coo, &data.csr16);
+        generate(SNRT_SSR_IDX32);
+        snsparse_coo_to_csr(&data.coo, &data.csr32);
+        snsparse_coomv(&data.coo, data.x, data.ref);
+
+        // The CSC form of A is the CSR form of its transpose.
+        snsparse_coo_t coo_t = data.coo;
+        coo_t.rows = COLS;
+        coo_t.cols = ROWS;
+        coo_t.row_idcs = data.coo.col_idcs;
+        coo_t.col_idcs = data.coo.row_idcs;
+        snsparse_coo_to_csr(&coo_t, &data.csc);
+        data.csc.rows = ROWS;
+        data.csc.cols = COLS;
+
+        // Partitions must tile the rows without gaps.
+        uint32_t expected_lo = 0;
+        for (uint32_t i = 0; i < 5; i++) {
+            uint32_t lo, hi;
+            snsparse_csr_partition(&data.csr32, 5, i, &lo, &hi);
+            errors += lo != expected_lo || hi < lo;
+            expected_lo = hi;
+        }
+        errors += expected_lo != ROWS;
+    }
+    snrt_cluster_hw_barrier();
+
+    // SpMV with both index widths.
+    snsparse_csrmv_cluster(&data.csr16, data.x, data.y);
+    if (is_main) errors += compare(data.y, data.ref, ROWS, 1, "csrmv16");
+    snrt_cluster_hw_barrier();
+    snsparse_csrmv_cluster(&data.csr32, data.x, data.y);
+    if (is_main) errors += compare(data.y, data.ref, ROWS, 1, "csrmv32");
+    snrt_cluster_hw_barrier();
+
+    // SpMM against one SpMV per column.
+    snsparse_csrmm_cluster(&data.csr16, N, data.B, COLS, data.C, N);
+    if (is_main) {
+        for (uint32_t j = 0; j < N; j++) {
+            snsparse_coomv(&data.coo, data.B + j * COLS, data.ref);
+            errors += compare(data.C + j, data.ref, ROWS, N, "csrmm");
+        }
+        snsparse_coomv(&data.coo, data.x, data.ref);
+    }
+    snrt_cluster_hw_barrier();
+
+    // Tiled SpMV with a buffer holding only a few rows at a time.
+    if (snsparse_csrmv_tiled(&data.csr32, data.x, data.y, data.work, 2048))
+        errors++;
+    if (is_main) errors += compare(data.y, data.ref, ROWS, 1, "tiled");
+
+    if (is_main) {
+        // CSC SpMV.
+        snsparse_cscmv(&data.csc, data.x, data.y);
+        errors += compare(data.y, data.ref, ROWS, 1, "cscmv");
+
+        // SpVV on every row of the matrix.
+        for (uint32_t r = 0; r < ROWS; r++) {
+            uint32_t ofs = data.csr16.ptrs[r];
+            snsparse_svec_t row = {
+                .len = COLS,
+                .nnz = data.csr16.ptrs[r + 1] - ofs,
+                .idx_size = SNRT_SSR_IDX16,
+                .vals = data.csr16.vals + ofs,
+                .idcs = (uint16_t *)data.csr16.idcs + ofs,
+            };
+            errors += snsparse_spvv(&row, data.x) != data.ref[r];
+        }
+    }
+
+    return is_main ? errors : 0;
+}
@@ -5,6 +5,8 @@
 # This script takes a trace generated for a Snitch hart and transforms the
 # additional decode stage info into meaningful annotation. It also counts
 # and computes various performance metrics up to each mcycle CSR read.
+# The bytes of the DMA transfers a hart starts are estimated from the sizes
+# passed to `dmcpy`/`dmcpyi` and the repetitions of 2D transfers.
 
 # Author: Paul Scheffler <paulsc@iis.ee.ethz.ch>
 
@@ -618,6 +620,22 @@ def annotate_fpu(
     return ', '.join(ret)
 
 
+# -------------------- DMA --------------------
+
+
+def count_dma(insn: str, extras: dict, dma_info: dict, perf_metrics: list):
+    """Adds the bytes of a DMA transfer started by `insn` to the section."""
+    mnemonic, _, operands = insn.strip().partition(' ')
+    if mnemonic == 'dmrep':
+        dma_info['reps'] = extras['opa']
+    elif mnemonic in ('dmcpy', 'dmcpyi'):
+        # The configuration is rs2 of `dmcpy` and an immediate of `dmcpyi`
+        cfg = extras['opb'] if mnemonic == 'dmcpy' else int(
+            operands.split(',')[-1])
+        reps = dma_info['reps'] if cfg & 2 else 1
+        perf_metrics[-1]['dma_bytes'] += extras['opa'] * reps
+
+
 # noinspection PyTypeChecker
 def annotate_insn(
     line: str,
@@ -627,6 +645,7 @@ def annotate_insn(
     dict,  # One deque (FIFO) per FPR storing start cycles and formats for each FPR WB
     fseq_info:
     dict,  # Info on the sequencer to properly map tunneled instruction PCs
+    dma_info: dict,  # Repetitions of the 2D DMA transfers
     perf_metrics: list,  # A list performance metric dicts
     dupl_time_info:
     bool = True,  # Show sim time and cycle again if same as previous line?
@@ -664,6 +683,7 @@ def annotate_insn(
                 insn, pc_str = ('', '')
             else:
                 perf_metrics[-1]['snitch_issues'] += 1
+                count_dma(insn, extras, dma_info, perf_metrics)
         # Annotate sequencer
         elif extras['source'] == TRACE_SRCES['sequencer']:
             if extras['cbuf_push']:
@@ -838,6 +858,7 @@ def main():
         'cfg_buf': deque(),
         'curr_cfg': None
     }
+    dma_info = {'reps': 1}
     perf_metrics = [
         defaultdict(int)
     ]  # all values initially 0, also 'start' time of measurement 0
@@ -846,8 +867,9 @@ def main():
     for line in line_iter:
         if line:
             ann_insn, time_info, empty = annotate_insn(
-                line, gpr_wb_info, fpr_wb_info, fseq_info, perf_metrics, False,
-                time_info, args.offl, not args.saddr, args.permissive)
+                line, gpr_wb_info, fpr_wb_info, fseq_info, dma_info,
+                perf_metrics, False, time_info, args.offl, not args.saddr,
+                args.permissive)
             if perf_metrics[0]['start'] is None:
                 perf_metrics[0]['start'] = time_info[1]
             if not empty:
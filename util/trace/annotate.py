@@ -14,10 +14,9 @@
 #           80000048  x13=0000000a                            # csrr    a3, mhartid
 
 import sys
-import os
 import re
-from functools import lru_cache
 import argparse
+from symbolize import Symbolizer
 
 # Argument parsing
 parser = argparse.ArgumentParser('annotate', allow_abbrev=True)
@@ -87,12 +86,16 @@ if not quiet:
 # buffer source files
 src_files = {}
 trace_start_col = -1
+symbolizer = Symbolizer(elf, addr2line)
 
 
-@lru_cache(maxsize=1024)
-def adr2line(addr):
-    cmd = f'{addr2line} -e {elf} -f -i {addr:x}'
-    return os.popen(cmd).read().split('\n')
+def trace_addr(line):
+    # RTL traces might not contain a PC on each line
+    try:
+        addr_str = re.split(r" +", line.strip())[3]
+        return addr_str, int(addr_str, base=16)
+    except (ValueError, IndexError):
+        return None, None
 
 
 with open(trace, 'r') as f:
@@ -103,20 +106,19 @@ with open(trace, 'r') as f:
 
     tot_lines = len(open(trace).readlines()[args.start:args.end])
     last_prog = 0
-    for lino, line in enumerate(f.readlines()):
-
-        # RTL traces might not contain a PC on each line
-        try:
-            addr_str = re.split(r" +", line.strip())[3]
-            addr = int(addr_str, base=16)
-            if trace_start_col < 0:
-                trace_start_col = line.find(addr_str)
-        except (ValueError, IndexError):
+    lines = f.readlines()
+    addrs = [trace_addr(line) for line in lines]
+    # Symbolize all PCs of the trace at once
+    symbolizer.prefetch(addr for _, addr in addrs if addr is not None)
+    for lino, (line, (addr_str, addr)) in enumerate(zip(lines, addrs)):
+
+        if addr is None:
             of.write(f'      {line[trace_start_col:]}')
             continue
+        if trace_start_col < 0:
+            trace_start_col = line.find(addr_str)
 
-        addr_hex = f'{addr:x}'
-        ret = adr2line(addr)
+        ret = symbolizer.lookup(addr)[1:]
 
         funs = ret[::2]
         files = [x.split('/')[-1] for x in ret[1::2]]
@@ -154,4 +156,5 @@ with open(trace, 'r') as f:
                 sys.stdout.flush()
 if not quiet:
     print(' done')
-    print(adr2line.cache_info())
+    print(symbolizer.stats())
+symbolizer.close()
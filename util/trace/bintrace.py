@@ -0,0 +1,140 @@
+#!/usr/bin/env python3
+
+# Copyright 2021 ETH Zurich and University of Bologna.
+# Licensed under the Apache License, Version 2.0, see LICENSE for details.
+# SPDX-License-Identifier: Apache-2.0
+
+# This script reads the binary instruction traces written by the Snitch core
+# complex tracer (`logs/trace_hart_*.bin`, or `.bin.gz` if compressed) and
+# converts them into the textual `.dasm` traces, which can be processed by
+# `spike-dasm` and `gen_trace.py` as before. The record format is described in
+# `hw/ip/test/src/trace.hh`. The module can also be imported to iterate over
+# the records of a trace without going through the text format.
+# Example:
+#     bintrace.py logs/trace_hart_00000.bin | spike-dasm | gen_trace.py
+
+import sys
+import gzip
+import struct
+import argparse
+
+VERSION = 1
+MAGIC = b'SNTRACE\0'
+
+FILE_HEADER = struct.Struct('<8sII')
+RECORD_HEADER = struct.Struct('<QQQIBBBB')
+
+FLAG_PC_VALID = 1 << 0
+FLAG_INSN_VALID = 1 << 1
+FLAG_INSN_WIDE = 1 << 2
+
+# Fields of the trace ports in the order of `snitch_pkg::*_trace_port_t`,
+# indexed by `snitch_pkg::trace_src_e`
+EXTRAS = (
+    ('source', 'stall', 'exception', 'rs1', 'rs2', 'rd', 'is_load', 'is_store',
+     'is_branch', 'pc_d', 'opa', 'opb', 'opa_select', 'opb_select', 'write_rd',
+     'csr_addr', 'writeback', 'gpr_rdata_1', 'ls_size', 'ld_result_32',
+     'lsu_rd', 'retire_load', 'alu_result', 'ls_amo', 'retire_acc', 'acc_pid',
+     'acc_pdata_32', 'fpu_offload', 'is_seq_insn'),
+    ('source', 'acc_q_hs', 'fpu_out_hs', 'lsu_q_hs', 'op_in', 'rs1', 'rs2',
+     'rs3', 'rd', 'op_sel_0', 'op_sel_1', 'op_sel_2', 'src_fmt', 'dst_fmt',
+     'int_fmt', 'acc_qdata_0', 'acc_qdata_1', 'acc_qdata_2', 'op_0', 'op_1',
+     'op_2', 'use_fpu', 'fpu_in_rd', 'fpu_in_acc', 'ls_size', 'is_load',
+     'is_store', 'lsu_qaddr', 'lsu_rd', 'acc_wb_ready', 'fpu_out_acc',
+     'fpr_waddr', 'fpr_wdata', 'fpr_we'),
+    ('source', 'cbuf_push', 'is_outer', 'max_inst', 'max_rpt', 'stg_max',
+     'stg_mask'),
+)
+
+# Size of the chunks read from the trace
+CHUNK_SIZE = 1 << 20
+
+
+def open_trace(path: str):
+    if path.endswith('.gz'):
+        return gzip.open(path, 'rb')
+    return open(path, 'rb')
+
+
+def read_header(f) -> int:
+    """Checks the file header and returns the hart ID."""
+    data = f.read(FILE_HEADER.size)
+    if len(data) != FILE_HEADER.size:
+        raise ValueError('Truncated trace header')
+    magic, version, hart_id = FILE_HEADER.unpack(data)
+    if magic != MAGIC:
+        raise ValueError('Not a binary Snitch trace')
+    if version != VERSION:
+        raise ValueError(
+            'Unsupported trace version {} (expected {})'.format(
+                version, VERSION))
+    return hart_id
+
+
+def read_records(f):
+    """Yields the records of a trace as tuples (time, cycle, insn, pc, source,
+    priv, flags, extras), where extras is a tuple of the values of the fields
+    in `EXTRAS[source]`. Expects the file header to be consumed."""
+    buf = b''
+    pos = 0
+    while True:
+        chunk = f.read(CHUNK_SIZE)
+        if not chunk:
+            break
+        buf = buf[pos:] + chunk
+        pos = 0
+        while pos + RECORD_HEADER.size <= len(buf):
+            header = RECORD_HEADER.unpack_from(buf, pos)
+            num_extras = header[7]
+            end = pos + RECORD_HEADER.size + 8 * num_extras
+            if end > len(buf):
+                break
+            extras = struct.unpack_from('<{}Q'.format(num_extras), buf,
+                                        pos + RECORD_HEADER.size)
+            yield header[:7] + (extras, )
+            pos = end
+    if pos != len(buf):
+        raise ValueError('Truncated trace record')
+
+
+def format_dasm(record) -> str:
+    """Formats a record like the textual tracer of `snitch_cc.sv`."""
+    time, cycle, insn, pc, source, priv, flags, extras = record
+    pc_str = '{:08x}'.format(pc) if flags & FLAG_PC_VALID else 'z' * 8
+    if flags & FLAG_INSN_VALID:
+        insn_str = '{:016x}'.format(insn) if flags & FLAG_INSN_WIDE \
+            else '{:08x}'.format(insn)
+    else:
+        insn_str = 'z' * 16
+    extras_str = ''.join("'{}': 0x{:x}, ".format(key, val)
+                         for key, val in zip(EXTRAS[source], extras))
+    return '{:>20} {} {:>8} 0x{} DASM({}) #; {{{}}}\n'.format(
+        time, cycle, priv, pc_str, insn_str, extras_str)
+
+
+def main():
+    parser = argparse.ArgumentParser('bintrace', allow_abbrev=True)
+    parser.add_argument(
+        'trace',
+        metavar='<trace>',
+        help='Binary trace (trace_hart_*.bin or trace_hart_*.bin.gz)')
+    parser.add_argument(
+        '-o',
+        '--output',
+        metavar='<dasm>',
+        nargs='?',
+        type=argparse.FileType('w'),
+        default=sys.stdout,
+        help='Output textual trace, stdout by default')
+    args = parser.parse_args()
+
+    with open_trace(args.trace) as f:
+        read_header(f)
+        out = args.output
+        for record in read_records(f):
+            out.write(format_dasm(record))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
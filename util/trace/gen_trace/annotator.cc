@@ -0,0 +1,887 @@
+// Copyright 2021 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "annotator.hh"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <unordered_map>
+
+#include "pyfmt.hh"
+
+namespace gen_trace {
+
+using namespace sim::trace;
+
+// -------------------- Architectural constants and enums --------------------
+
+// Below this absolute value: use signed int representation. Above: unsigned
+// hex
+static const int64_t MAX_SIGNED_INT_LIT = 0xFFFF;
+
+static const char *const REG_ABI_NAMES_I[32] = {
+    "zero", "ra", "sp", "gp", "tp",  "t0",  "t1", "t2", "s0", "s1", "a0",
+    "a1",   "a2", "a3", "a4", "a5",  "a6",  "a7", "s2", "s3", "s4", "s5",
+    "s6",   "s7", "s8", "s9", "s10", "s11", "t3", "t4", "t5", "t6"};
+
+static const char *const REG_ABI_NAMES_F[32] = {
+    "ft0", "ft1", "ft2", "ft3", "ft4", "ft5",  "ft6",  "ft7",
+    "fs0", "fs1", "fa0", "fa1", "fa2", "fa3",  "fa4",  "fa5",
+    "fa6", "fa7", "fs2", "fs3", "fs4", "fs5",  "fs6",  "fs7",
+    "fs8", "fs9", "fs10", "fs11", "ft8", "ft9", "ft10", "ft11"};
+
+static const char *const LS_SIZES[4] = {"Byte", "Half", "Word", "Doub"};
+
+static const uint64_t OPER_TYPE_GPR = 1;
+static const uint64_t OPER_TYPE_CSR = 8;
+
+// FPU operand types, the registers are indices into the FPU extras.
+enum FpuOperType { OperNone, OperAcc, OperReg };
+static const struct {
+    FpuOperType type;
+    FpuExtra reg;
+} FPU_OPER_TYPES[7] = {{OperNone, FpuSource}, {OperAcc, FpuSource},
+                       {OperReg, FpuRs1},     {OperReg, FpuRs2},
+                       {OperReg, FpuRs3},     {OperReg, FpuRs1},
+                       {OperReg, FpuRd}};
+
+// Exponent and mantissa widths
+static const int FLOAT_FMTS[5][2] = {{8, 23}, {11, 52}, {5, 10}, {5, 2},
+                                     {8, 7}};
+
+static const uint64_t LS_TO_FLOAT[4] = {3, 2, 0, 1};
+
+static const std::unordered_map<uint64_t, const char *> CSR_NAMES = {
+    {0xc00, "cycle"}, {0xc01, "time"}, {0xc02, "instret"},
+    {0xc03, "hpmcounter3"}, {0xc04, "hpmcounter4"}, {0xc05, "hpmcounter5"},
+    {0xc06, "hpmcounter6"}, {0xc07, "hpmcounter7"}, {0xc08, "hpmcounter8"},
+    {0xc09, "hpmcounter9"}, {0xc0a, "hpmcounter10"}, {0xc0b, "hpmcounter11"},
+    {0xc0c, "hpmcounter12"}, {0xc0d, "hpmcounter13"}, {0xc0e, "hpmcounter14"},
+    {0xc0f, "hpmcounter15"}, {0xc10, "hpmcounter16"}, {0xc11, "hpmcounter17"},
+    {0xc12, "hpmcounter18"}, {0xc13, "hpmcounter19"}, {0xc14, "hpmcounter20"},
+    {0xc15, "hpmcounter21"}, {0xc16, "hpmcounter22"}, {0xc17, "hpmcounter23"},
+    {0xc18, "hpmcounter24"}, {0xc19, "hpmcounter25"}, {0xc1a, "hpmcounter26"},
+    {0xc1b, "hpmcounter27"}, {0xc1c, "hpmcounter28"}, {0xc1d, "hpmcounter29"},
+    {0xc1e, "hpmcounter30"}, {0xc1f, "hpmcounter31"}, {0x100, "sstatus"},
+    {0x104, "sie"}, {0x105, "stvec"}, {0x106, "scounteren"},
+    {0x140, "sscratch"}, {0x141, "sepc"}, {0x142, "scause"}, {0x143, "stval"},
+    {0x144, "sip"}, {0x180, "satp"}, {0x200, "bsstatus"}, {0x204, "bsie"},
+    {0x205, "bstvec"}, {0x240, "bsscratch"}, {0x241, "bsepc"},
+    {0x242, "bscause"}, {0x243, "bstval"}, {0x244, "bsip"}, {0x280, "bsatp"},
+    {0xa00, "hstatus"}, {0xa02, "hedeleg"}, {0xa03, "hideleg"},
+    {0xa80, "hgatp"}, {0x7, "utvt"}, {0x45, "unxti"}, {0x46, "uintstatus"},
+    {0x48, "uscratchcsw"}, {0x49, "uscratchcswl"}, {0x107, "stvt"},
+    {0x145, "snxti"}, {0x146, "sintstatus"}, {0x148, "sscratchcsw"},
+    {0x149, "sscratchcswl"}, {0x307, "mtvt"}, {0x345, "mnxti"},
+    {0x346, "mintstatus"}, {0x348, "mscratchcsw"}, {0x349, "mscratchcswl"},
+    {0x300, "mstatus"}, {0x301, "misa"}, {0x302, "medeleg"}, {0x303, "mideleg"},
+    {0x304, "mie"}, {0x305, "mtvec"}, {0x306, "mcounteren"},
+    {0x340, "mscratch"}, {0x341, "mepc"}, {0x342, "mcause"}, {0x343, "mtval"},
+    {0x344, "mip"}, {0x3a0, "pmpcfg0"}, {0x3a1, "pmpcfg1"}, {0x3a2, "pmpcfg2"},
+    {0x3a3, "pmpcfg3"}, {0x3b0, "pmpaddr0"}, {0x3b1, "pmpaddr1"},
+    {0x3b2, "pmpaddr2"}, {0x3b3, "pmpaddr3"}, {0x3b4, "pmpaddr4"},
+    {0x3b5, "pmpaddr5"}, {0x3b6, "pmpaddr6"}, {0x3b7, "pmpaddr7"},
+    {0x3b8, "pmpaddr8"}, {0x3b9, "pmpaddr9"}, {0x3ba, "pmpaddr10"},
+    {0x3bb, "pmpaddr11"}, {0x3bc, "pmpaddr12"}, {0x3bd, "pmpaddr13"},
+    {0x3be, "pmpaddr14"}, {0x3bf, "pmpaddr15"}, {0x7a0, "tselect"},
+    {0x7a1, "tdata1"}, {0x7a2, "tdata2"}, {0x7a3, "tdata3"}, {0x7b0, "dcsr"},
+    {0x7b1, "dpc"}, {0x7b2, "dscratch"}, {0xb00, "mcycle"}, {0xb02, "minstret"},
+    {0xb03, "mhpmcounter3"}, {0xb04, "mhpmcounter4"}, {0xb05, "mhpmcounter5"},
+    {0xb06, "mhpmcounter6"}, {0xb07, "mhpmcounter7"}, {0xb08, "mhpmcounter8"},
+    {0xb09, "mhpmcounter9"}, {0xb0a, "mhpmcounter10"}, {0xb0b, "mhpmcounter11"},
+    {0xb0c, "mhpmcounter12"}, {0xb0d, "mhpmcounter13"},
+    {0xb0e, "mhpmcounter14"}, {0xb0f, "mhpmcounter15"},
+    {0xb10, "mhpmcounter16"}, {0xb11, "mhpmcounter17"},
+    {0xb12, "mhpmcounter18"}, {0xb13, "mhpmcounter19"},
+    {0xb14, "mhpmcounter20"}, {0xb15, "mhpmcounter21"},
+    {0xb16, "mhpmcounter22"}, {0xb17, "mhpmcounter23"},
+    {0xb18, "mhpmcounter24"}, {0xb19, "mhpmcounter25"},
+    {0xb1a, "mhpmcounter26"}, {0xb1b, "mhpmcounter27"},
+    {0xb1c, "mhpmcounter28"}, {0xb1d, "mhpmcounter29"},
+    {0xb1e, "mhpmcounter30"}, {0xb1f, "mhpmcounter31"}, {0x323, "mhpmevent3"},
+    {0x324, "mhpmevent4"}, {0x325, "mhpmevent5"}, {0x326, "mhpmevent6"},
+    {0x327, "mhpmevent7"}, {0x328, "mhpmevent8"}, {0x329, "mhpmevent9"},
+    {0x32a, "mhpmevent10"}, {0x32b, "mhpmevent11"}, {0x32c, "mhpmevent12"},
+    {0x32d, "mhpmevent13"}, {0x32e, "mhpmevent14"}, {0x32f, "mhpmevent15"},
+    {0x330, "mhpmevent16"}, {0x331, "mhpmevent17"}, {0x332, "mhpmevent18"},
+    {0x333, "mhpmevent19"}, {0x334, "mhpmevent20"}, {0x335, "mhpmevent21"},
+    {0x336, "mhpmevent22"}, {0x337, "mhpmevent23"}, {0x338, "mhpmevent24"},
+    {0x339, "mhpmevent25"}, {0x33a, "mhpmevent26"}, {0x33b, "mhpmevent27"},
+    {0x33c, "mhpmevent28"}, {0x33d, "mhpmevent29"}, {0x33e, "mhpmevent30"},
+    {0x33f, "mhpmevent31"}, {0xf11, "mvendorid"}, {0xf12, "marchid"},
+    {0xf13, "mimpid"}, {0xf14, "mhartid"}, {0xc80, "cycleh"}, {0xc81, "timeh"},
+    {0xc82, "instreth"}, {0xc83, "hpmcounter3h"}, {0xc84, "hpmcounter4h"},
+    {0xc85, "hpmcounter5h"}, {0xc86, "hpmcounter6h"}, {0xc87, "hpmcounter7h"},
+    {0xc88, "hpmcounter8h"}, {0xc89, "hpmcounter9h"}, {0xc8a, "hpmcounter10h"},
+    {0xc8b, "hpmcounter11h"}, {0xc8c, "hpmcounter12h"},
+    {0xc8d, "hpmcounter13h"}, {0xc8e, "hpmcounter14h"},
+    {0xc8f, "hpmcounter15h"}, {0xc90, "hpmcounter16h"},
+    {0xc91, "hpmcounter17h"}, {0xc92, "hpmcounter18h"},
+    {0xc93, "hpmcounter19h"}, {0xc94, "hpmcounter20h"},
+    {0xc95, "hpmcounter21h"}, {0xc96, "hpmcounter22h"},
+    {0xc97, "hpmcounter23h"}, {0xc98, "hpmcounter24h"},
+    {0xc99, "hpmcounter25h"}, {0xc9a, "hpmcounter26h"},
+    {0xc9b, "hpmcounter27h"}, {0xc9c, "hpmcounter28h"},
+    {0xc9d, "hpmcounter29h"}, {0xc9e, "hpmcounter30h"},
+    {0xc9f, "hpmcounter31h"}, {0xb80, "mcycleh"}, {0xb82, "minstreth"},
+    {0xb83, "mhpmcounter3h"}, {0xb84, "mhpmcounter4h"},
+    {0xb85, "mhpmcounter5h"}, {0xb86, "mhpmcounter6h"},
+    {0xb87, "mhpmcounter7h"}, {0xb88, "mhpmcounter8h"},
+    {0xb89, "mhpmcounter9h"}, {0xb8a, "mhpmcounter10h"},
+    {0xb8b, "mhpmcounter11h"}, {0xb8c, "mhpmcounter12h"},
+    {0xb8d, "mhpmcounter13h"}, {0xb8e, "mhpmcounter14h"},
+    {0xb8f, "mhpmcounter15h"}, {0xb90, "mhpmcounter16h"},
+    {0xb91, "mhpmcounter17h"}, {0xb92, "mhpmcounter18h"},
+    {0xb93, "mhpmcounter19h"}, {0xb94, "mhpmcounter20h"},
+    {0xb95, "mhpmcounter21h"}, {0xb96, "mhpmcounter22h"},
+    {0xb97, "mhpmcounter23h"}, {0xb98, "mhpmcounter24h"},
+    {0xb99, "mhpmcounter25h"}, {0xb9a, "mhpmcounter26h"},
+    {0xb9b, "mhpmcounter27h"}, {0xb9c, "mhpmcounter28h"},
+    {0xb9d, "mhpmcounter29h"}, {0xb9e, "mhpmcounter30h"},
+    {0xb9f, "mhpmcounter31h"}
+};
+
+static const char *const PERF_KEY_NAMES[NumPerfKeys] = {
+    "start",
+    "end",
+    "end_fpss",
+    "snitch_issues",
+    "snitch_load_latency",
+    "snitch_fseq_offloads",
+    "fpss_issues",
+    "fpss_fpu_issues",
+    "fpss_load_latency",
+    "fpss_fpu_latency",
+    "snitch_loads",
+    "snitch_stores",
+    "fpss_loads",
+    "fpss_stores",
+    "snitch_avg_load_latency",
+    "snitch_occupancy",
+    "snitch_fseq_rel_offloads",
+    "fseq_yield",
+    "fseq_fpu_yield",
+    "fpss_section_latency",
+    "fpss_avg_fpu_latency",
+    "fpss_avg_load_latency",
+    "fpss_occupancy",
+    "fpss_fpu_occupancy",
+    "fpss_fpu_rel_occupancy",
+    "cycles",
+    "total_ipc",
+    "dma_bytes"};
+
+// Performance keys which only serve to compute other metrics: omit on
+// printing
+static bool perf_key_omitted(PerfKey key) {
+    switch (key) {
+        case Start:
+        case End:
+        case EndFpss:
+        case SnitchIssues:
+        case SnitchLoadLatency:
+        case SnitchFseqOffloads:
+        case FpssIssues:
+        case FpssFpuIssues:
+        case FpssLoadLatency:
+        case FpssFpuLatency:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static const char *priv_lvl(const std::string &priv) {
+    if (priv == "3") return "M";
+    if (priv == "1") return "S";
+    if (priv == "0") return "U";
+    return "?";
+}
+
+// -------------------- Literal formatting --------------------
+
+static std::string int_lit(uint64_t num, uint64_t size = 2,
+                           bool force_hex = false) {
+    uint64_t width = 8 * (uint64_t(1) << size);
+    if (width < 64) num &= (uint64_t(1) << width) - 1;
+    int64_t num_signed = int32_t(uint32_t(num));
+    if (force_hex || std::abs(num_signed) > MAX_SIGNED_INT_LIT)
+        return "0x" + pyfmt::hex(num, width / 4);
+    return std::to_string(num_signed);
+}
+
+static double flt_decode(uint64_t val, uint64_t fmt) {
+    if (fmt >= 5) return NAN;
+    int w_exp = FLOAT_FMTS[fmt][0];
+    int w_mnt = FLOAT_FMTS[fmt][1];
+    int width = 1 + w_exp + w_mnt;
+    double sgn = (val >> (width - 1)) & 1 ? -1.0 : 1.0;
+    uint64_t mnt = val & ((uint64_t(1) << w_mnt) - 1);
+    uint64_t exp_unb = (val >> w_mnt) & ((uint64_t(1) << w_exp) - 1);
+    int exp_bias = -((1 << (w_exp - 1)) - 1);
+    if (exp_unb == (uint64_t(1) << w_exp) - 1)
+        return sgn * (mnt == 0 ? INFINITY : NAN);
+    else if (exp_unb == 0 && mnt == 0)
+        return sgn * 0.0;
+    else if (exp_unb == 0)
+        return std::ldexp(sgn * mnt, exp_bias + 1 - w_mnt);
+    else
+        return std::ldexp(sgn * (mnt | (uint64_t(1) << w_mnt)),
+                          int(exp_unb) + exp_bias - w_mnt);
+}
+
+static std::string flt_fmt(double flt, int width = 7) {
+    // If default literal shorter: use it
+    std::string default_str = pyfmt::repr(flt);
+    if (int(default_str.size()) - 1 <= width) return default_str;
+    // Else: fix significant digits
+    char buf[512];
+    auto res = std::to_chars(buf, buf + sizeof(buf), flt,
+                             std::chars_format::fixed, width);
+    return std::string(buf, res.ptr);
+}
+
+static std::string flt_lit(uint64_t num, uint64_t fmt, int width = 7) {
+    return flt_fmt(flt_decode(num, fmt), width);
+}
+
+static std::string join(const std::vector<std::string> &items) {
+    std::string ret;
+    for (size_t i = 0; i < items.size(); i++) {
+        if (i) ret += ", ";
+        ret += items[i];
+    }
+    return ret;
+}
+
+// A comma-delimited list of annotations, built in place.
+class Annotations {
+   public:
+    void push_back(const std::string &item) {
+        if (!empty) str += ", ";
+        str += item;
+        empty = false;
+    }
+    std::string str;
+
+   private:
+    bool empty = true;
+};
+
+static std::string left(const std::string &s, size_t width) {
+    std::string ret;
+    pyfmt::pad_right(ret, s, width);
+    return ret;
+}
+
+// -------------------- FPU helpers --------------------
+
+// Name and value of an FPU operand, the name is `NONE` if unused.
+static std::pair<std::string, std::string> flt_oper(const uint64_t *extras,
+                                                    int port) {
+    uint64_t op_sel = extras[FpuOpSel0 + port];
+    auto oper = FPU_OPER_TYPES[op_sel < 7 ? op_sel : 0];
+    if (oper.type == OperAcc) {
+        return {"ac" + std::to_string(port + 1),
+                int_lit(extras[FpuAccQdata0 + port], extras[FpuIntFmt])};
+    } else if (oper.type == OperNone) {
+        return {"NONE", "None"};
+    } else {
+        uint64_t fmt = extras[FpuIsStore] ? LS_TO_FLOAT[extras[FpuLsSize] & 3]
+                                          : extras[FpuSrcFmt];
+        return {REG_ABI_NAMES_F[extras[oper.reg] & 31],
+                flt_lit(extras[FpuOp0 + port], fmt)};
+    }
+}
+
+// -------------------- FPU Sequencer --------------------
+
+static std::string dasm_seq(const uint64_t *extras) {
+    std::vector<std::string> args = {
+        std::to_string(extras[FpuSeqMaxRpt] + 1),
+        std::to_string(extras[FpuSeqMaxInst] + 1)};
+    if (extras[FpuSeqStgMask]) {
+        std::string mask;
+        for (uint64_t m = extras[FpuSeqStgMask]; m; m >>= 1)
+            mask.insert(mask.begin(), '0' + (m & 1));
+        args.push_back("0b" + mask);
+        args.push_back(std::to_string(extras[FpuSeqStgMax] + 1));
+    }
+    return left("frep", 8) + join(args);
+}
+
+// -------------------- Annotator --------------------
+
+Annotator::Annotator(const Options &opts)
+    : opts(opts), gpr_wb_info(32), fpr_wb_info(32), perf_metrics(1) {
+    perf_metrics[0][Start] = Value::none();
+}
+
+std::deque<uint64_t> &Annotator::gpr_wb(uint64_t reg) {
+    return gpr_wb_info[reg & 31];
+}
+
+std::deque<Annotator::Writeback> &Annotator::fpr_wb(uint64_t reg) {
+    reg &= 31;
+    if (std::find(fpr_order.begin(), fpr_order.end(), reg) == fpr_order.end())
+        fpr_order.push_back(reg);
+    return fpr_wb_info[reg];
+}
+
+bool Annotator::fatal(const std::string &msg) {
+    err += (opts.permissive ? "WARNING" : "FATAL") + msg;
+    if (!opts.permissive) failed = true;
+    return opts.permissive;
+}
+
+bool Annotator::emul_seq(SeqIssue &issue, std::string &fseq_pc) {
+    // We are only called on FPSS issues, not on FSEQ issues -> we must
+    // consume FReps in same call
+    if (!has_curr_cfg) {
+        bool is_frep = !fpss_pcs.empty() && fpss_pcs.front().is_frep;
+        // Is an FRep incoming?
+        if (is_frep) {
+            fpss_pcs.pop_front();
+            if (cfg_buf.empty()) {
+                fatal(": FRep issued without sequencer configuration.\n");
+                failed = true;
+                return false;
+            }
+            curr_cfg = std::move(cfg_buf.front());
+            cfg_buf.pop_front();
+            curr_cfg.inst_iter = 0;
+            curr_cfg.fpss_buf.clear();
+            curr_cfg.outer_buf.clear();
+            has_curr_cfg = true;
+        }
+    }
+    // Are we working on an FRep ...
+    if (has_curr_cfg) {
+        FrepCfg &cfg = curr_cfg;
+        // If we are still filling our loop buffer: add to it and replicate
+        if (cfg.inst_iter <= cfg.max_inst) {
+            if (fpss_pcs.empty()) {
+                fatal(": FPSS issue without offloaded instruction.\n");
+                failed = true;
+                return false;
+            }
+            Offload offl = fpss_pcs.front();
+            fpss_pcs.pop_front();
+            if (offl.is_frep) {
+                if (!fatal(": FRep at " + cfg.fseq_pc +
+                           " contains another nested FRep"))
+                    return false;
+            }
+            // Outer loops: first consume loop body, then replicate buffer
+            if (cfg.is_outer) {
+                SeqIssue entry = {offl.pc, offl.sec, true, 0, cfg.inst_iter};
+                cfg.fpss_buf.push_back(entry);
+                cfg.outer_buf.push_back(entry);
+                // Once all loop instructions received: replicate buffer in
+                // outer-loop order
+                if (cfg.inst_iter == cfg.max_inst) {
+                    for (uint64_t rep = 1; rep <= cfg.max_rpt; rep++) {
+                        uint64_t idx = 0;
+                        for (auto &inst : cfg.outer_buf)
+                            cfg.fpss_buf.push_back(
+                                {inst.pc, inst.sec, true, rep, idx++});
+                    }
+                }
+            }
+            // Inner loops: replicate instructions during loop body
+            // consumption
+            else {
+                for (uint64_t rep = 0; rep <= cfg.max_rpt; rep++)
+                    cfg.fpss_buf.push_back(
+                        {offl.pc, offl.sec, true, rep, cfg.inst_iter});
+            }
+            // Iterate loop body instruction consumed
+            cfg.inst_iter++;
+        }
+        // Pull our instruction from the loop buffer
+        issue = cfg.fpss_buf.front();
+        cfg.fpss_buf.pop_front();
+        fseq_pc = cfg.fseq_pc;
+        // If we reached last iteration: terminate this FRep
+        if (issue.rep == cfg.max_rpt && issue.idx == cfg.max_inst)
+            has_curr_cfg = false;
+    }
+    // ... or is this a regular pass-through?
+    else {
+        if (fpss_pcs.empty()) {
+            fatal(": FPSS issue without offloaded instruction.\n");
+            failed = true;
+            return false;
+        }
+        issue = {fpss_pcs.front().pc, fpss_pcs.front().sec, false, 0, 0};
+        fpss_pcs.pop_front();
+    }
+    return true;
+}
+
+std::string Annotator::annotate_snitch(const uint64_t *extras, uint64_t cycle,
+                                       uint64_t pc) {
+    // Compound annotations in datapath order
+    Annotations ret;
+    bool force_hex_addr = !opts.saddr;
+    // If Sequencer offload: annotate if desired
+    if (opts.offl && extras[SnitchFpuOffload]) {
+        const char *target_name = extras[SnitchIsSeqInsn] ? "FSEQ" : "FPSS";
+        ret.push_back(std::string(target_name) + " <~~ 0x" +
+                      pyfmt::hex(pc, 8));
+    }
+    // If exception, annotate
+    if (!extras[SnitchStall] && extras[SnitchException])
+        ret.push_back("exception");
+    // Regular linear datapath operation
+    if (!(extras[SnitchStall] || extras[SnitchFpuOffload])) {
+        // Operand registers
+        if (extras[SnitchOpaSelect] == OPER_TYPE_GPR && extras[SnitchRs1] != 0)
+            ret.push_back(left(REG_ABI_NAMES_I[extras[SnitchRs1] & 31], 3) +
+                          " = " + int_lit(extras[SnitchOpa]));
+        if (extras[SnitchOpbSelect] == OPER_TYPE_GPR && extras[SnitchRs2] != 0)
+            ret.push_back(left(REG_ABI_NAMES_I[extras[SnitchRs2] & 31], 3) +
+                          " = " + int_lit(extras[SnitchOpb]));
+        // CSR (always operand b)
+        if (extras[SnitchOpbSelect] == OPER_TYPE_CSR) {
+            uint64_t csr_addr = extras[SnitchCsrAddr];
+            auto it = CSR_NAMES.find(csr_addr);
+            std::string csr_name = it != CSR_NAMES.end()
+                                       ? it->second
+                                       : "csr@" + pyfmt::hex(csr_addr);
+            uint64_t cycles_past = extras[SnitchOpb];
+            if (csr_name == "mcycle") {
+                perf_metrics.back()[End] = Value::of(int64_t(cycles_past));
+                perf_metrics.emplace_back();
+                perf_metrics.back()[Start] =
+                    Value::of(int64_t(cycles_past + 2));
+            }
+            ret.push_back(csr_name + " = " + int_lit(cycles_past));
+        }
+        // Load / Store
+        const char *ls_size = LS_SIZES[extras[SnitchLsSize] & 3];
+        if (extras[SnitchIsLoad]) {
+            perf_metrics.back()[SnitchLoads].i++;
+            gpr_wb(extras[SnitchRd]).push_back(cycle);
+            ret.push_back(
+                left(REG_ABI_NAMES_I[extras[SnitchRd] & 31], 3) + " <~~ " +
+                ls_size + "[" +
+                int_lit(extras[SnitchAluResult], 2, force_hex_addr) + "]");
+        } else if (extras[SnitchIsStore]) {
+            perf_metrics.back()[SnitchStores].i++;
+            ret.push_back(
+                int_lit(extras[SnitchGprRdata1]) + " ~~> " + ls_size + "[" +
+                int_lit(extras[SnitchAluResult], 2, force_hex_addr) + "]");
+        }
+        // Branches: all reg-reg ops
+        else if (extras[SnitchIsBranch]) {
+            ret.push_back(extras[SnitchAluResult] ? "taken" : "not taken");
+        }
+        // Datapath (ALU / Jump Target / Bypass) register writeback
+        if (extras[SnitchWriteRd] && extras[SnitchRd] != 0)
+            ret.push_back("(wrb) " +
+                          left(REG_ABI_NAMES_I[extras[SnitchRd] & 31], 3) +
+                          " <-- " + int_lit(extras[SnitchWriteback]));
+    }
+    // Retired loads and accelerator (includes FPU) data: can come back on
+    // stall and during other ops
+    if (extras[SnitchRetireLoad] && extras[SnitchLsuRd] != 0) {
+        auto &wb = gpr_wb(extras[SnitchLsuRd]);
+        if (wb.empty()) {
+            if (!fatal(": In cycle " + std::to_string(cycle) +
+                       ", LSU attempts writeback to " +
+                       REG_ABI_NAMES_I[extras[SnitchLsuRd] & 31] +
+                       ", but none in flight.\n"))
+                return "";
+        } else {
+            perf_metrics.back()[SnitchLoadLatency].i += cycle - wb.front();
+            wb.pop_front();
+        }
+        ret.push_back("(lsu) " +
+                      left(REG_ABI_NAMES_I[extras[SnitchLsuRd] & 31], 3) +
+                      " <-- " + int_lit(extras[SnitchLdResult32]));
+    }
+    if (extras[SnitchRetireAcc] && extras[SnitchAccPid] != 0)
+        ret.push_back("(acc) " +
+                      left(REG_ABI_NAMES_I[extras[SnitchAccPid] & 31], 3) +
+                      " <-- " + int_lit(extras[SnitchAccPdata32]));
+    // Any kind of PC change: Branch, Jump, etc.
+    if (!extras[SnitchStall] && extras[SnitchPcD] != pc + 4)
+        ret.push_back("goto " + int_lit(extras[SnitchPcD]));
+    // Return comma-delimited list
+    return ret.str;
+}
+
+std::string Annotator::annotate_fpu(const uint64_t *extras, uint64_t cycle,
+                                    size_t curr_sec) {
+    Annotations ret;
+    bool force_hex_addr = !opts.saddr;
+    // On issuing of instruction
+    if (extras[FpuAccQHs]) {
+        // If computation initiated: remember FPU destination format
+        if (extras[FpuUseFpu] && !extras[FpuFpuInAcc])
+            fpr_wb(extras[FpuFpuInRd]).push_back({extras[FpuDstFmt], cycle});
+        // Operands: omit on store
+        if (!extras[FpuIsStore]) {
+            for (int i_op = 0; i_op < 3; i_op++) {
+                auto oper = flt_oper(extras, i_op);
+                if (oper.first != "NONE")
+                    ret.push_back(left(oper.first, 4) + " = " + oper.second);
+            }
+        }
+        // Load / Store requests
+        if (extras[FpuLsuQHs]) {
+            uint64_t s = extras[FpuLsSize] & 3;
+            if (extras[FpuIsLoad]) {
+                perf_metrics[curr_sec][FpssLoads].i++;
+                // Load initiated: remember LSU destination format
+                fpr_wb(extras[FpuRd]).push_back({LS_TO_FLOAT[s], cycle});
+                ret.push_back(
+                    left(REG_ABI_NAMES_F[extras[FpuRd] & 31], 4) + " <~~ " +
+                    LS_SIZES[s] + "[" +
+                    int_lit(extras[FpuLsuQaddr], 2, force_hex_addr) + "]");
+            }
+            if (extras[FpuIsStore]) {
+                perf_metrics[curr_sec][FpssStores].i++;
+                auto oper = flt_oper(extras, 1);
+                ret.push_back(
+                    oper.second + " ~~> " + LS_SIZES[s] + "[" +
+                    int_lit(extras[FpuLsuQaddr], 2, force_hex_addr) + "]");
+            }
+        }
+    }
+    // On FLOP completion
+    if (extras[FpuFpuOutHs]) perf_metrics.back()[FpssFpuIssues].i++;
+    // Register writeback
+    if (extras[FpuFprWe]) {
+        std::string writer =
+            extras[FpuAccQHs] && extras[FpuAccWbReady]
+                ? "acc"
+                : (extras[FpuFpuOutHs] && !extras[FpuFpuOutAcc] ? "fpu"
+                                                                : "lsu");
+        // accelerator bus format is 0 for regular float32
+        uint64_t fmt = 0;
+        if (writer == "fpu" || writer == "lsu") {
+            auto &wb = fpr_wb(extras[FpuFprWaddr]);
+            if (wb.empty()) {
+                std::string upper = writer;
+                std::transform(upper.begin(), upper.end(), upper.begin(),
+                               ::toupper);
+                if (!fatal(": In cycle " + std::to_string(cycle) + ", " +
+                           upper + " attempts writeback to " +
+                           REG_ABI_NAMES_F[extras[FpuFprWaddr] & 31] +
+                           ", but none in flight.\n"))
+                    return "";
+            } else {
+                fmt = wb.front().fmt;
+                uint64_t start_time = wb.front().cycle;
+                wb.pop_front();
+                if (writer == "lsu")
+                    perf_metrics[curr_sec][FpssLoadLatency].i +=
+                        cycle - start_time;
+                else
+                    perf_metrics[curr_sec][FpssFpuLatency].i +=
+                        cycle - start_time;
+            }
+        }
+        ret.push_back("(f:" + writer + ") " +
+                      left(REG_ABI_NAMES_F[extras[FpuFprWaddr] & 31], 4) +
+                      " <-- " + flt_lit(extras[FpuFprWdata], fmt));
+    }
+    return ret.str;
+}
+
+// Adds the bytes of a DMA transfer started by `insn` to the section.
+void Annotator::count_dma(const std::string &insn, const uint64_t *extras) {
+    size_t begin = insn.find_first_not_of(' ');
+    if (begin == std::string::npos) return;
+    size_t end = insn.find(' ', begin);
+    std::string mnemonic = insn.substr(begin, end - begin);
+    if (mnemonic == "dmrep") {
+        dma_reps = extras[SnitchOpa];
+    } else if (mnemonic == "dmcpy" || mnemonic == "dmcpyi") {
+        // The configuration is rs2 of `dmcpy` and an immediate of `dmcpyi`
+        uint64_t cfg = mnemonic == "dmcpy"
+                           ? extras[SnitchOpb]
+                           : strtoull(insn.c_str() + insn.rfind(',') + 1,
+                                      nullptr, 10);
+        uint64_t reps = cfg & 2 ? dma_reps : 1;
+        perf_metrics.back()[DmaBytes].i += extras[SnitchOpa] * reps;
+    }
+}
+
+bool Annotator::annotate(const TraceLine &line) {
+    if (failed) return false;
+    bool show_time_info = !has_time_info || line.time != last_time ||
+                          line.cycle != last_cycle;
+    std::string pc = line.pc;
+    std::string insn = line.insn;
+    std::string annot;
+    bool empty = false;
+
+    if (line.has_extras) {
+        const uint64_t *extras = line.extras;
+        // Annotate snitch
+        if (line.source == SrcSnitch) {
+            uint64_t pc_val = strtoull(line.pc.c_str(), nullptr, 16);
+            annot = annotate_snitch(extras, line.cycle, pc_val);
+            if (failed) return false;
+            if (extras[SnitchFpuOffload]) {
+                perf_metrics.back()[SnitchFseqOffloads].i++;
+                fpss_pcs.push_back({line.pc, perf_metrics.size() - 1,
+                                    extras[SnitchIsSeqInsn] != 0});
+                if (extras[SnitchIsSeqInsn]) fseq_pcs.push_back(line.pc);
+            }
+            if (extras[SnitchStall] || extras[SnitchFpuOffload]) {
+                insn.clear();
+                pc.clear();
+            } else {
+                perf_metrics.back()[SnitchIssues].i++;
+                count_dma(insn, extras);
+            }
+        }
+        // Annotate sequencer
+        else if (line.source == SrcFpuSeq) {
+            if (extras[FpuSeqCbufPush]) {
+                if (fseq_pcs.empty()) {
+                    fatal(": Sequencer configured without FRep.\n");
+                    failed = true;
+                    return false;
+                }
+                FrepCfg cfg;
+                cfg.is_outer = extras[FpuSeqIsOuter];
+                cfg.max_inst = extras[FpuSeqMaxInst];
+                cfg.max_rpt = extras[FpuSeqMaxRpt];
+                cfg.fseq_pc = fseq_pcs.front();
+                fseq_pcs.pop_front();
+                insn = dasm_seq(extras);
+                pc = cfg.fseq_pc;
+                annot = std::string(cfg.is_outer ? "outer" : "inner") + ", " +
+                        std::to_string((cfg.max_inst + 1) *
+                                       (cfg.max_rpt + 1)) +
+                        " issues";
+                cfg_buf.push_back(std::move(cfg));
+            } else {
+                insn.clear();
+                pc.clear();
+            }
+        }
+        // Annotate FPSS
+        else if (line.source == SrcFpu) {
+            Annotations annot_list;
+            if (!extras[FpuAccQHs]) {
+                insn.clear();
+                pc.clear();
+            } else {
+                SeqIssue issue;
+                std::string fseq_pc;
+                if (!emul_seq(issue, fseq_pc)) return false;
+                pc = issue.pc;
+                curr_sec = issue.sec;
+                // Record cycle in case this was last insn in section
+                perf_metrics[curr_sec][EndFpss] =
+                    Value::of(int64_t(line.cycle));
+                perf_metrics[curr_sec][FpssIssues].i++;
+                if (issue.in_frep)
+                    annot_list.push_back(
+                        "[" +
+                        fseq_pc.substr(fseq_pc.size() -
+                                       std::min<size_t>(4, fseq_pc.size())) +
+                        " " + std::to_string(issue.rep) + ":" +
+                        std::to_string(issue.idx) + "]");
+            }
+            annot_list.push_back(annotate_fpu(extras, line.cycle, curr_sec));
+            if (failed) return false;
+            annot = annot_list.str;
+        } else {
+            err += "Unknown trace source: " + std::to_string(line.source) +
+                   "\n";
+            failed = true;
+            return false;
+        }
+        // omit empty trace lines (due to double stalls, performance measures)
+        empty = insn.empty() && annot.empty();
+    }
+
+    if (!empty) {
+        std::string time_str, cycle_str;
+        if (show_time_info) {
+            time_str = std::to_string(line.time);
+            cycle_str = std::to_string(line.cycle);
+        }
+        pyfmt::pad_left(out, time_str, 8);
+        out += ' ';
+        pyfmt::pad_left(out, cycle_str, 8);
+        out += ' ';
+        pyfmt::pad_left(out, priv_lvl(line.priv), 8);
+        out += ' ';
+        pyfmt::pad_left(out, pc, 10);
+        out += ' ';
+        pyfmt::pad_right(out, insn, 30);
+        if (line.has_extras) {
+            out += " #; ";
+            out += annot;
+        }
+        out += '\n';
+        // Reset time info if empty: last line on record is previous one!
+        has_time_info = true;
+        last_time = line.time;
+        last_cycle = line.cycle;
+    }
+    if (perf_metrics[0].get(Start).kind == Value::None && has_time_info)
+        perf_metrics[0][Start] = Value::of(int64_t(last_cycle));
+    return true;
+}
+
+// -------------------- Performance metrics --------------------
+
+static Value safe_div(Value dividend, Value divisor) {
+    if (divisor.truthy())
+        return Value::of(dividend.to_double() / divisor.to_double());
+    return Value::of(int64_t(0));
+}
+
+static std::string fmt_value(const Value &val) {
+    if (val.kind == Value::None) return "None";
+    if (val.kind == Value::Float) return flt_fmt(val.f, 4);
+    return int_lit(val.i);
+}
+
+static std::string str_value(const Value &val) {
+    if (val.kind == Value::None) return "None";
+    if (val.kind == Value::Float) return pyfmt::repr(val.f);
+    return std::to_string(val.i);
+}
+
+static std::string json_value(const Value &val) {
+    if (val.kind == Value::None) return "null";
+    if (val.kind == Value::Float) return pyfmt::json(val.f);
+    return std::to_string(val.i);
+}
+
+void Annotator::finish() {
+    if (has_time_info)
+        perf_metrics.back()[End] = Value::of(int64_t(last_cycle));
+
+    // Compute metrics
+    for (auto &seg : perf_metrics) {
+        // Access the measured keys in the order of `eval_perf_metrics`,
+        // which inserts missing ones in this order
+        for (PerfKey key : {EndFpss, End, Start, FpssFpuIssues, FpssIssues,
+                            SnitchLoadLatency, SnitchLoads, SnitchIssues,
+                            SnitchFseqOffloads, FpssFpuLatency,
+                            FpssLoadLatency, FpssLoads})
+            seg[key];
+        int64_t fpss_latency =
+            std::max<int64_t>(seg[EndFpss].i - seg[End].i, 0);
+        // This can be argued over, but it's the most conservatice choice
+        int64_t end = seg[End].i + fpss_latency;
+        int64_t cycles = end - seg[Start].i + 1;
+        Value fpss_fpu_rel_issues =
+            safe_div(seg[FpssFpuIssues], seg[FpssIssues]);
+        Value snitch_occupancy = safe_div(seg[SnitchIssues], Value::of(cycles));
+        Value fpss_occupancy = safe_div(seg[FpssIssues], Value::of(cycles));
+        // Snitch
+        seg[SnitchAvgLoadLatency] =
+            safe_div(seg[SnitchLoadLatency], seg[SnitchLoads]);
+        seg[SnitchOccupancy] = snitch_occupancy;
+        seg[SnitchFseqRelOffloads] = safe_div(
+            seg[SnitchFseqOffloads],
+            Value::of(seg[SnitchIssues].i + seg[SnitchFseqOffloads].i));
+        // FSeq
+        seg[FseqYield] = safe_div(seg[FpssIssues], seg[SnitchFseqOffloads]);
+        seg[FseqFpuYield] =
+            safe_div(safe_div(seg[FpssFpuIssues], seg[SnitchFseqOffloads]),
+                     fpss_fpu_rel_issues);
+        // FPSS
+        seg[FpssSectionLatency] = Value::of(fpss_latency);
+        seg[FpssAvgFpuLatency] =
+            safe_div(seg[FpssFpuLatency], seg[FpssFpuIssues]);
+        seg[FpssAvgLoadLatency] =
+            safe_div(seg[FpssLoadLatency], seg[FpssLoads]);
+        seg[FpssOccupancy] = fpss_occupancy;
+        seg[FpssFpuOccupancy] = safe_div(seg[FpssFpuIssues], Value::of(cycles));
+        seg[FpssFpuRelOccupancy] = fpss_fpu_rel_issues;
+        seg[Cycles] = Value::of(cycles);
+        if (fpss_occupancy.kind == Value::Int &&
+            snitch_occupancy.kind == Value::Int)
+            seg[TotalIpc] = Value::of(fpss_occupancy.i + snitch_occupancy.i);
+        else
+            seg[TotalIpc] = Value::of(fpss_occupancy.to_double() +
+                                      snitch_occupancy.to_double());
+    }
+
+    // Emit metrics
+    out += "\n## Performance metrics\n";
+    for (size_t idx = 0; idx < perf_metrics.size(); idx++) {
+        auto &seg = perf_metrics[idx];
+        out += "\nPerformance metrics for section " + std::to_string(idx) +
+               " @ (" + str_value(seg.get(Start)) + ", " +
+               str_value(seg.get(End)) + "):";
+        for (PerfKey key : seg.keys()) {
+            if (!opts.allkeys && perf_key_omitted(key)) continue;
+            out += '\n';
+            pyfmt::pad_right(out, PERF_KEY_NAMES[key], 40);
+            pyfmt::pad_left(out, fmt_value(seg.get(key)), 10);
+        }
+        out += '\n';
+    }
+
+    // Check for any loose ends and warn before exiting
+    size_t seq_isns = fseq_pcs.size() + cfg_buf.size();
+    int64_t unseq_left = int64_t(fpss_pcs.size()) - int64_t(fseq_pcs.size());
+    bool warn_trip = false;
+    // The GPR check of `gen_trace.py` also iterates over the FPRs
+    for (const char *const *names : {REG_ABI_NAMES_F, REG_ABI_NAMES_I}) {
+        for (uint8_t fpr : fpr_order) {
+            size_t len = fpr_wb_info[fpr].size();
+            if (len) {
+                warn_trip = true;
+                err += "WARNING: " + std::to_string(len) +
+                       " transactions still in flight for " + names[fpr] +
+                       ".\n";
+            }
+        }
+    }
+    if (seq_isns) {
+        warn_trip = true;
+        err += "WARNING: " + std::to_string(seq_isns) +
+               " Sequencer instructions were not issued.\n";
+    }
+    if (unseq_left) {
+        warn_trip = true;
+        err += "WARNING: " + std::to_string(unseq_left) +
+               " unsequenced FPSS instructions were not issued.\n";
+    }
+    if (has_curr_cfg) {
+        warn_trip = true;
+        err += "WARNING: Not all FPSS instructions from sequence " +
+               curr_cfg.fseq_pc + " were issued.\n";
+    }
+    if (warn_trip)
+        err +=
+            "WARNING: Inconsistent final state; performance metrics\n"
+            "may be inaccurate. Is this trace complete?\n";
+}
+
+std::string Annotator::dump_perf() const {
+    std::string ret = "[";
+    for (size_t idx = 0; idx < perf_metrics.size(); idx++) {
+        auto &seg = perf_metrics[idx];
+        ret += idx ? ",\n    {" : "\n    {";
+        bool first = true;
+        for (PerfKey key : seg.keys()) {
+            ret += first ? "\n        \"" : ",\n        \"";
+            first = false;
+            ret += PERF_KEY_NAMES[key];
+            ret += "\": " + json_value(seg.get(key));
+        }
+        ret += "\n    }";
+    }
+    ret += "\n]";
+    return ret;
+}
+
+}  // namespace gen_trace
@@ -0,0 +1,198 @@
+// Copyright 2021 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+// Annotation of the trace of a Snitch hart: a port of the per-line state
+// machine of `util/gen_trace.py` (GPR/FPR writeback bookkeeping, FREP
+// sequencer emulation and performance metrics per section), which produces
+// identical output.
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "trace.hh"
+
+namespace gen_trace {
+
+struct Options {
+    // Annotate FPSS and sequencer offloads when they happen in core (-o)
+    bool offl = false;
+    // Use signed decimal (not unsigned hex) for small addresses (-s)
+    bool saddr = false;
+    // Include performance metrics measured to compute others (-a)
+    bool allkeys = false;
+    // Ignore some state-related issues when they occur (-p)
+    bool permissive = false;
+};
+
+// A parsed trace line with the instruction already disassembled.
+struct TraceLine {
+    uint64_t time;
+    uint64_t cycle;
+    std::string priv;
+    // PC as printed in the trace, e.g. `0x80000000`
+    std::string pc;
+    // Instruction as matched by `TRACE_IN_REGEX`, including trailing spaces
+    std::string insn;
+    bool has_extras;
+    uint8_t source;
+    uint64_t extras[sim::trace::MAX_EXTRAS];
+};
+
+// A performance metric, which has the type Python would give it.
+struct Value {
+    enum Kind { None, Int, Float } kind = Int;
+    int64_t i = 0;
+    double f = 0;
+
+    static Value none() { return Value{None, 0, 0}; }
+    static Value of(int64_t i) { return Value{Int, i, 0}; }
+    static Value of(double f) { return Value{Float, 0, f}; }
+    double to_double() const { return kind == Float ? f : i; }
+    bool truthy() const { return kind == Float ? f != 0 : i != 0; }
+};
+
+enum PerfKey : uint8_t {
+    Start,
+    End,
+    EndFpss,
+    SnitchIssues,
+    SnitchLoadLatency,
+    SnitchFseqOffloads,
+    FpssIssues,
+    FpssFpuIssues,
+    FpssLoadLatency,
+    FpssFpuLatency,
+    SnitchLoads,
+    SnitchStores,
+    FpssLoads,
+    FpssStores,
+    SnitchAvgLoadLatency,
+    SnitchOccupancy,
+    SnitchFseqRelOffloads,
+    FseqYield,
+    FseqFpuYield,
+    FpssSectionLatency,
+    FpssAvgFpuLatency,
+    FpssAvgLoadLatency,
+    FpssOccupancy,
+    FpssFpuOccupancy,
+    FpssFpuRelOccupancy,
+    Cycles,
+    TotalIpc,
+    DmaBytes,
+    NumPerfKeys
+};
+
+// Performance metrics of a section, which behaves like the `defaultdict(int)`
+// of `gen_trace.py`: keys are inserted on first access, which defines the
+// order in which they are printed.
+class Section {
+   public:
+    Value &operator[](PerfKey key) {
+        if (!present[key]) {
+            present[key] = true;
+            order.push_back(key);
+        }
+        return values[key];
+    }
+    const std::vector<PerfKey> &keys() const { return order; }
+    const Value &get(PerfKey key) const { return values[key]; }
+
+   private:
+    Value values[NumPerfKeys];
+    bool present[NumPerfKeys] = {};
+    std::vector<PerfKey> order;
+};
+
+class Annotator {
+   public:
+    explicit Annotator(const Options &opts);
+
+    // Annotates a line and appends it to `out` unless it carries no
+    // information. Returns false on a fatal inconsistency.
+    bool annotate(const TraceLine &line);
+
+    // Evaluates and appends the performance metrics to `out`, and appends
+    // warnings about the final state to `err`.
+    void finish();
+
+    // The performance metrics as `json.dumps(perf_metrics, indent=4)`.
+    std::string dump_perf() const;
+
+    // Annotated trace and messages, drained by the caller.
+    std::string out;
+    std::string err;
+
+   private:
+    // A writeback in flight: destination format and start cycle.
+    struct Writeback {
+        uint64_t fmt;
+        uint64_t cycle;
+    };
+    // An instruction offloaded to the FPSS.
+    struct Offload {
+        std::string pc;
+        size_t sec;
+        bool is_frep;
+    };
+    // An instruction issued by the sequencer, with its repetition and index
+    // in the loop body if it is part of an FREP.
+    struct SeqIssue {
+        std::string pc;
+        size_t sec;
+        bool in_frep;
+        uint64_t rep;
+        uint64_t idx;
+    };
+    struct FrepCfg {
+        bool is_outer;
+        uint64_t max_inst;
+        uint64_t max_rpt;
+        std::string fseq_pc;
+        uint64_t inst_iter;
+        std::deque<SeqIssue> fpss_buf;
+        std::deque<SeqIssue> outer_buf;
+    };
+
+    std::string annotate_snitch(const uint64_t *extras, uint64_t cycle,
+                                uint64_t pc);
+    std::string annotate_fpu(const uint64_t *extras, uint64_t cycle,
+                             size_t curr_sec);
+    bool emul_seq(SeqIssue &issue, std::string &fseq_pc);
+    void count_dma(const std::string &insn, const uint64_t *extras);
+    bool fatal(const std::string &msg);
+
+    Options opts;
+    bool failed = false;
+    // `None` before the first line.
+    bool has_time_info = false;
+    uint64_t last_time;
+    uint64_t last_cycle;
+
+    std::vector<std::deque<uint64_t>> gpr_wb_info;
+    std::vector<std::deque<Writeback>> fpr_wb_info;
+    // FPRs in the order in which `gen_trace.py` first accesses them.
+    std::vector<uint8_t> fpr_order;
+
+    size_t curr_sec = 0;
+    std::deque<Offload> fpss_pcs;
+    std::deque<std::string> fseq_pcs;
+    std::deque<FrepCfg> cfg_buf;
+    bool has_curr_cfg = false;
+    FrepCfg curr_cfg;
+
+    // Repetitions of the 2D DMA transfers, set by `dmrep`
+    uint64_t dma_reps = 1;
+
+    std::vector<Section> perf_metrics;
+
+    std::deque<uint64_t> &gpr_wb(uint64_t reg);
+    std::deque<Writeback> &fpr_wb(uint64_t reg);
+};
+
+}  // namespace gen_trace
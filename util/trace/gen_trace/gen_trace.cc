@@ -0,0 +1,488 @@
+// Copyright 2021 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+// Native replacement of the `spike-dasm | gen_trace.py` pipeline: reads the
+// traces of any number of harts (binary `.bin` or `.bin.gz` traces as well as
+// textual `.dasm` traces, disassembled or not), disassembles the instructions
+// in-process and writes the annotated traces `<trace>.txt` next to the inputs.
+// The output, including the performance metrics dumped with `-d`, is the same
+// as the one of `gen_trace.py`. Harts are processed in parallel, and every
+// trace is streamed, such that memory use does not grow with its length.
+// Example:
+//     gen_trace -j 8 -d logs/trace_hart_*.bin
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "annotator.hh"
+#include "disasm.h"
+#include "trace.hh"
+
+using namespace sim::trace;
+
+// Size of the chunks read from binary traces and written to the outputs
+static const size_t CHUNK_SIZE = 1 << 20;
+
+static std::mutex stderr_mutex;
+
+// -------------------- Disassembly --------------------
+
+// Disassembles instructions like `spike-dasm`, caching the results: traces
+// are dominated by a few hot loops. The disassembler itself is shared
+// between threads, the cache is per thread.
+class Disassembler {
+   public:
+    explicit Disassembler(const disassembler_t &dis) : dis(dis) {}
+
+    const std::string &disassemble(uint64_t bits) {
+        auto it = cache.find(bits);
+        if (it != cache.end()) return it->second;
+        return cache.emplace(bits, dis.disassemble(insn_t(bits)))
+            .first->second;
+    }
+
+    // Replaces all occurrences of `DASM(<hex>)` in a line, see
+    // `spike_main/spike-dasm.cc`.
+    void substitute(std::string &s) {
+        size_t pos = 0;
+        while ((pos = s.find("DASM(", pos)) != std::string::npos) {
+            size_t start = pos;
+            pos += strlen("DASM(");
+            if (s[pos] == '0' && (s[pos + 1] == 'x' || s[pos + 1] == 'X'))
+                pos += 2;
+            if (!isxdigit(s[pos])) continue;
+            char *endp;
+            int64_t bits = strtoull(&s[pos], &endp, 16);
+            if (*endp != ')') continue;
+            size_t nbits = 4 * (endp - &s[pos]);
+            if (nbits < 64) bits = bits << (64 - nbits) >> (64 - nbits);
+            const std::string &dis = disassemble(bits);
+            s = s.substr(0, start) + dis + s.substr(endp - &s[0] + 1);
+            pos = start + dis.length();
+        }
+    }
+
+   private:
+    const disassembler_t &dis;
+    std::unordered_map<uint64_t, std::string> cache;
+};
+
+// -------------------- Trace readers --------------------
+
+static bool ends_with(const std::string &s, const char *suffix) {
+    size_t len = strlen(suffix);
+    return s.size() >= len && s.compare(s.size() - len, len, suffix) == 0;
+}
+
+// An input trace, decompressed through `gzip` if needed.
+class Input {
+   public:
+    explicit Input(const std::string &path) {
+        if (path == "-") {
+            file = stdin;
+        } else if (ends_with(path, ".gz")) {
+            std::string cmd = "gzip -dc '" + path + "'";
+            file = popen(cmd.c_str(), "r");
+            piped = true;
+        } else {
+            file = fopen(path.c_str(), "rb");
+        }
+    }
+
+    ~Input() {
+        if (!file || file == stdin) return;
+        if (piped)
+            pclose(file);
+        else
+            fclose(file);
+    }
+
+    FILE *file = nullptr;
+
+   private:
+    bool piped = false;
+};
+
+// Reads the records of a binary trace and converts them into the lines
+// `bintrace.py | spike-dasm` would produce.
+class BinaryReader {
+   public:
+    BinaryReader(FILE *file, Disassembler &dasm) : file(file), dasm(dasm) {}
+
+    // Checks the file header, returns an error message on failure.
+    std::string read_header() {
+        FileHeader header;
+        if (fread(&header, sizeof(header), 1, file) != 1)
+            return "Truncated trace header";
+        if (memcmp(header.magic, MAGIC, sizeof(MAGIC)))
+            return "Not a binary Snitch trace";
+        if (header.version != VERSION)
+            return "Unsupported trace version " +
+                   std::to_string(header.version) + " (expected " +
+                   std::to_string(VERSION) + ")";
+        return "";
+    }
+
+    // Returns false at the end of the trace, with `error` set if the trace
+    // is malformed.
+    bool next(gen_trace::TraceLine &line, std::string &error) {
+        if (!fill(sizeof(RecordHeader))) {
+            if (pos != end) error = "Truncated trace record";
+            return false;
+        }
+        RecordHeader header;
+        memcpy(&header, &buf[pos], sizeof(header));
+        if (header.source > SrcFpuSeq ||
+            header.num_extras != num_extras(header.source)) {
+            error = "Malformed trace record";
+            return false;
+        }
+        size_t len = sizeof(header) + 8 * header.num_extras;
+        if (!fill(len)) {
+            error = "Truncated trace record";
+            return false;
+        }
+        memcpy(line.extras, &buf[pos + sizeof(header)], 8 * header.num_extras);
+        pos += len;
+
+        line.time = header.time;
+        line.cycle = header.cycle;
+        line.priv = std::to_string(header.priv);
+        line.pc = "0xzzzzzzzz";
+        if (header.flags & FlagPcValid) {
+            for (int i = 0; i < 8; i++)
+                line.pc[9 - i] = "0123456789abcdef"[(header.pc >> 4 * i) & 15];
+        }
+        if (header.flags & FlagInsnValid) {
+            // The textual trace prints narrow instructions with 32 bit,
+            // which `spike-dasm` sign-extends
+            uint64_t bits = header.insn;
+            if (!(header.flags & FlagInsnWide))
+                bits = int64_t(int32_t(uint32_t(bits)));
+            line.insn = dasm.disassemble(bits);
+        } else {
+            line.insn = "DASM(zzzzzzzzzzzzzzzz)";
+        }
+        // The instruction is matched up to the annotations
+        line.insn += ' ';
+        line.has_extras = true;
+        line.source = header.source;
+        return true;
+    }
+
+   private:
+    // Makes sure `len` bytes are buffered at `pos`.
+    bool fill(size_t len) {
+        if (end - pos >= len) return true;
+        memmove(buf.data(), buf.data() + pos, end - pos);
+        end -= pos;
+        pos = 0;
+        end += fread(buf.data() + end, 1, buf.size() - end, file);
+        return end >= len;
+    }
+
+    FILE *file;
+    Disassembler &dasm;
+    std::vector<char> buf = std::vector<char>(CHUNK_SIZE);
+    size_t pos = 0;
+    size_t end = 0;
+};
+
+// Reads textual traces line by line, disassembling any `DASM(...)` left.
+class TextReader {
+   public:
+    TextReader(FILE *file, Disassembler &dasm) : file(file), dasm(dasm) {
+        // Map the extras of all sources by name
+        for (uint8_t src = SrcSnitch; src <= SrcFpuSeq; src++) {
+            auto names = extras_names(src);
+            for (size_t i = 0; i < num_extras(src); i++)
+                index[src][names[i]] = i;
+        }
+    }
+
+    bool next(gen_trace::TraceLine &line, std::string &error) {
+        if (!getline(s)) return false;
+        dasm.substitute(s);
+        if (!parse(line)) {
+            error = "Not a valid trace line:\n" + s;
+            return false;
+        }
+        return true;
+    }
+
+   private:
+    bool getline(std::string &s) {
+        s.clear();
+        char chunk[4096];
+        while (fgets(chunk, sizeof(chunk), file)) {
+            s += chunk;
+            if (s.back() == '\n') {
+                s.pop_back();
+                return true;
+            }
+        }
+        return !s.empty();
+    }
+
+    // Matches `TRACE_IN_REGEX` of `gen_trace.py`.
+    bool parse(gen_trace::TraceLine &line) {
+        const char *p = s.c_str();
+        while (isspace(*p)) p++;
+        uint64_t nums[3];
+        for (auto &num : nums) {
+            if (!isdigit(*p)) return false;
+            num = strtoull(p, const_cast<char **>(&p), 10);
+            if (!isspace(*p)) return false;
+            while (isspace(*p)) p++;
+        }
+        line.time = nums[0];
+        line.cycle = nums[1];
+        line.priv = std::to_string(nums[2]);
+        const char *pc = p;
+        if (p[0] != '0' || p[1] != 'x') return false;
+        p += 2;
+        while (isxdigit(*p) || *p == 'z') p++;
+        if (p == pc + 2 || !isspace(*p)) return false;
+        line.pc.assign(pc, p);
+        while (isspace(*p)) p++;
+        const char *insn = p;
+        while (*p && *p != '#' && *p != ';') p++;
+        line.insn.assign(insn, p);
+        line.has_extras = false;
+        if (p[0] != '#' || p[1] != ';') return true;
+        p += 2;
+        while (isspace(*p)) p++;
+        if (!*p) return true;
+        return read_annotations(p, line);
+    }
+
+    // Reads the `'key': 0xval` pairs of the annotations.
+    bool read_annotations(const char *p, gen_trace::TraceLine &line) {
+        std::vector<std::pair<std::string, uint64_t>> pairs;
+        uint64_t source = 0;
+        while ((p = strchr(p, '\''))) {
+            const char *key = ++p;
+            p = strchr(p, '\'');
+            if (!p) break;
+            std::string name(key, p++);
+            while (isspace(*p)) p++;
+            if (*p != ':') continue;
+            p++;
+            while (isspace(*p)) p++;
+            uint64_t val = strtoull(p, const_cast<char **>(&p), 16);
+            if (name == "source") source = val;
+            pairs.emplace_back(std::move(name), val);
+        }
+        if (source > SrcFpuSeq) return false;
+        line.has_extras = true;
+        line.source = source;
+        memset(line.extras, 0, sizeof(line.extras));
+        for (auto &pair : pairs) {
+            auto it = index[source].find(pair.first);
+            if (it != index[source].end())
+                line.extras[it->second] = pair.second;
+        }
+        return true;
+    }
+
+    FILE *file;
+    Disassembler &dasm;
+    std::string s;
+    std::unordered_map<std::string, size_t> index[SrcFpuSeq + 1];
+};
+
+// -------------------- Main --------------------
+
+struct Config {
+    gen_trace::Options opts;
+    bool dump_perf = false;
+    std::string dump_path;
+    unsigned jobs = 1;
+    int xlen = 64;
+    std::vector<std::string> inputs;
+};
+
+// The path of an output next to the input, `-` for stdout.
+static std::string output_path(const std::string &input, const char *ext) {
+    if (input == "-") return "-";
+    std::string stem = input;
+    for (const char *suffix : {".gz", ".bin", ".dasm"})
+        if (ends_with(stem, suffix)) stem.resize(stem.size() - strlen(suffix));
+    return stem + ext;
+}
+
+static void write_out(FILE *out, std::string &s) {
+    fwrite(s.data(), 1, s.size(), out);
+    s.clear();
+}
+
+static void report(const std::string &input, const std::string &msg,
+                   bool prefix) {
+    if (msg.empty()) return;
+    std::lock_guard<std::mutex> lock(stderr_mutex);
+    if (!prefix) {
+        fputs(msg.c_str(), stderr);
+        return;
+    }
+    size_t start = 0;
+    while (start < msg.size()) {
+        size_t end = msg.find('\n', start);
+        end = end == std::string::npos ? msg.size() : end + 1;
+        fprintf(stderr, "%s: %.*s", input.c_str(), int(end - start),
+                &msg[start]);
+        start = end;
+    }
+}
+
+// Annotates a single trace, returns false on failure.
+static bool process(const Config &cfg, const std::string &input,
+                    const disassembler_t &dis) {
+    bool prefix = cfg.inputs.size() > 1;
+    Input in(input);
+    if (!in.file) {
+        report(input, "Failed to open " + input + "\n", prefix);
+        return false;
+    }
+    // Binary traces are told apart by their magic, such that they can also
+    // be read from stdin
+    int c = fgetc(in.file);
+    if (c != EOF) ungetc(c, in.file);
+    bool binary = c == MAGIC[0];
+
+    std::string out_path = output_path(input, ".txt");
+    FILE *out = out_path == "-" ? stdout : fopen(out_path.c_str(), "w");
+    if (!out) {
+        report(input, "Failed to open " + out_path + "\n", prefix);
+        return false;
+    }
+
+    Disassembler dasm(dis);
+    BinaryReader bin(in.file, dasm);
+    TextReader text(in.file, dasm);
+    gen_trace::Annotator annotator(cfg.opts);
+    std::string error = binary ? bin.read_header() : "";
+    bool ok = error.empty();
+    gen_trace::TraceLine line;
+    while (ok && (binary ? bin.next(line, error) : text.next(line, error))) {
+        ok = annotator.annotate(line);
+        if (annotator.out.size() >= CHUNK_SIZE) write_out(out, annotator.out);
+        // Messages are rare, but must not be held back
+        if (!annotator.err.empty() && cfg.opts.permissive) {
+            report(input, annotator.err, prefix);
+            annotator.err.clear();
+        }
+    }
+    ok &= error.empty();
+    if (ok) annotator.finish();
+    write_out(out, annotator.out);
+    if (out != stdout) fclose(out);
+    if (!error.empty()) annotator.err += error + "\n";
+    report(input, annotator.err, prefix);
+    if (!ok) return false;
+
+    if (cfg.dump_perf) {
+        std::string path = cfg.dump_path.empty()
+                               ? output_path(input, ".json")
+                               : cfg.dump_path;
+        FILE *json = path == "-" ? stdout : fopen(path.c_str(), "w");
+        if (!json) {
+            report(input, "Failed to open " + path + "\n", prefix);
+            return false;
+        }
+        std::string perf = annotator.dump_perf();
+        write_out(json, perf);
+        if (json != stdout) fclose(json);
+    }
+    return true;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [options] <trace>...\n"
+            "Annotates Snitch traces (.bin, .bin.gz or .dasm, - for stdin) "
+            "into <trace>.txt.\n"
+            "  -o, --offl        Annotate FPSS and sequencer offloads when "
+            "they happen in core\n"
+            "  -s, --saddr       Use signed decimal (not unsigned hex) for "
+            "small addresses\n"
+            "  -a, --allkeys     Include performance metrics measured to "
+            "compute others\n"
+            "  -p, --permissive  Ignore some state-related issues when they "
+            "occur\n"
+            "  -d, --dump-perf   Dump performance metrics as json text into "
+            "<trace>.json\n"
+            "  --dump-perf=FILE  Dump performance metrics of a single trace "
+            "into FILE\n"
+            "  -j, --jobs N      Annotate N traces in parallel\n"
+            "  --xlen N          Disassemble for RV32 or RV64 (default 64)\n",
+            prog);
+}
+
+int main(int argc, char **argv) {
+    Config cfg;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-o" || arg == "--offl") {
+            cfg.opts.offl = true;
+        } else if (arg == "-s" || arg == "--saddr") {
+            cfg.opts.saddr = true;
+        } else if (arg == "-a" || arg == "--allkeys") {
+            cfg.opts.allkeys = true;
+        } else if (arg == "-p" || arg == "--permissive") {
+            cfg.opts.permissive = true;
+        } else if (arg == "-d" || arg == "--dump-perf") {
+            cfg.dump_perf = true;
+        } else if (arg.compare(0, 12, "--dump-perf=") == 0) {
+            cfg.dump_perf = true;
+            cfg.dump_path = arg.substr(12);
+        } else if ((arg == "-j" || arg == "--jobs") && i + 1 < argc) {
+            cfg.jobs = std::max(1, atoi(argv[++i]));
+        } else if (arg.compare(0, 2, "-j") == 0 && arg.size() > 2) {
+            cfg.jobs = std::max(1, atoi(&arg[2]));
+        } else if (arg == "--xlen" && i + 1 < argc) {
+            cfg.xlen = atoi(argv[++i]);
+        } else if (arg == "-h" || arg == "--help") {
+            usage(argv[0]);
+            return 0;
+        } else if (arg != "-" && arg[0] == '-') {
+            usage(argv[0]);
+            return 1;
+        } else {
+            cfg.inputs.push_back(arg);
+        }
+    }
+    if (cfg.inputs.empty()) cfg.inputs.push_back("-");
+    if (!cfg.dump_path.empty() && cfg.inputs.size() > 1) {
+        fprintf(stderr, "--dump-perf=FILE requires a single trace\n");
+        return 1;
+    }
+    if (cfg.xlen != 32 && cfg.xlen != 64) {
+        fprintf(stderr, "Unsupported XLEN %d\n", cfg.xlen);
+        return 1;
+    }
+
+    const disassembler_t dis(cfg.xlen);
+    std::atomic<size_t> next(0);
+    std::atomic<bool> failed(false);
+    auto worker = [&]() {
+        for (size_t i; (i = next++) < cfg.inputs.size();)
+            if (!process(cfg, cfg.inputs[i], dis)) failed = true;
+    };
+    std::vector<std::thread> threads;
+    unsigned jobs = std::min<size_t>(cfg.jobs, cfg.inputs.size());
+    for (unsigned i = 1; i < jobs; i++) threads.emplace_back(worker);
+    worker();
+    for (auto &thread : threads) thread.join();
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,81 @@
+// Copyright 2021 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+// Formatting of numbers like Python does, such that the native annotator
+// reproduces the output of `gen_trace.py` character by character.
+
+#pragma once
+
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+namespace pyfmt {
+
+// `repr(x)` of a Python float: the shortest representation which round-trips,
+// in positional notation for decimal exponents in [-4, 16).
+inline std::string repr(double x) {
+    if (std::isnan(x)) return "nan";
+    if (std::isinf(x)) return x > 0 ? "inf" : "-inf";
+    if (x == 0) return std::signbit(x) ? "-0.0" : "0.0";
+
+    char buf[64];
+    auto res = std::to_chars(buf, buf + sizeof(buf), x,
+                             std::chars_format::scientific);
+    std::string sci(buf, res.ptr);
+    std::string ret = sci[0] == '-' ? "-" : "";
+    size_t pos = ret.size();
+    size_t e_pos = sci.find('e');
+    std::string digits;
+    for (size_t i = pos; i < e_pos; i++)
+        if (sci[i] != '.') digits += sci[i];
+    int exp = std::stoi(sci.substr(e_pos + 1));
+    int ndigits = digits.size();
+
+    if (exp >= -4 && exp < 16) {
+        int decpt = exp + 1;
+        if (decpt <= 0) {
+            ret += "0." + std::string(-decpt, '0') + digits;
+        } else if (decpt >= ndigits) {
+            ret += digits + std::string(decpt - ndigits, '0') + ".0";
+        } else {
+            ret += digits.substr(0, decpt) + "." + digits.substr(decpt);
+        }
+    } else {
+        ret += digits[0];
+        if (ndigits > 1) ret += "." + digits.substr(1);
+        std::string e = std::to_string(std::abs(exp));
+        if (e.size() < 2) e = "0" + e;
+        ret += (exp < 0 ? "e-" : "e+") + e;
+    }
+    return ret;
+}
+
+// A float as `json.dumps` writes it.
+inline std::string json(double x) {
+    if (std::isnan(x)) return "NaN";
+    if (std::isinf(x)) return x > 0 ? "Infinity" : "-Infinity";
+    return repr(x);
+}
+
+// `'{:>width}'.format(s)` and `'{:<width}'.format(s)`.
+inline void pad_left(std::string &out, const std::string &s, size_t width) {
+    if (s.size() < width) out.append(width - s.size(), ' ');
+    out += s;
+}
+
+inline void pad_right(std::string &out, const std::string &s, size_t width) {
+    out += s;
+    if (s.size() < width) out.append(width - s.size(), ' ');
+}
+
+inline std::string hex(uint64_t x, int width = 0) {
+    char buf[40];
+    snprintf(buf, sizeof(buf), "%0*llx", width, (unsigned long long)x);
+    return buf;
+}
+
+}  // namespace pyfmt
@@ -0,0 +1,276 @@
+#!/usr/bin/env python3
+
+# Copyright 2021 ETH Zurich and University of Bologna.
+# Licensed under the Apache License, Version 2.0, see LICENSE for details.
+# SPDX-License-Identifier: Apache-2.0
+
+# This script merges the performance metrics that `gen_trace.py` dumps for
+# each hart (`--dump-perf`) into a single cluster report. The trace of a hart
+# is split into sections at every `mcycle` read, i.e. at every call of
+# `benchmark_get_cycle()`, so section `n` of all harts is delimited by the same
+# pair of markers in the program. For each section, the report contains:
+#
+# - the span of the section over all harts and the critical path, i.e. the
+#   hart whose own work (issues and memory stalls) takes longest,
+# - the load imbalance between the harts,
+# - the idle cycles of each hart, attributed to TCDM contention, waiting for
+#   the DMA and waiting for other harts at a barrier,
+# - a roofline point: FPU operations against bytes moved by the DMA.
+#
+# The DMA bytes are estimated from the sizes of the `dmcpy`/`dmcpyi` the harts
+# issue (`dma_bytes` of `gen_trace.py`). Cluster performance counters cannot
+# be recovered from the traces. Software reads them with
+# `snrt_get_perf_counter()`; to include them, write them to a JSON file passed
+# with `--counters`, holding a list with an object per section that maps the
+# counter type (`enum snrt_perf_cnt_type` in lower case without the
+# `SNRT_PERF_CNT_` prefix, e.g. `dma_ar_bw`) to its value. The DMA bandwidth
+# counters replace the estimate where given.
+#
+# The stall attribution is an estimate: load latency above the nominal TCDM
+# latency counts as contention (scaled to `tcdm_congested` if given), and the
+# DMA hart waits for its transfers while the DMA is busy (`dma_busy`). The
+# remaining idle time of a hart is spent waiting for the critical hart, which
+# counts as a DMA wait if that is the DMA hart and as a barrier otherwise.
+
+import re
+import sys
+import json
+import argparse
+
+# Metrics summed per section over the harts
+SUM_KEYS = ('snitch_issues', 'snitch_fseq_offloads', 'snitch_loads',
+            'snitch_stores', 'fpss_issues', 'fpss_fpu_issues', 'fpss_loads',
+            'fpss_stores', 'dma_bytes')
+
+# Counters which count the bytes moved by the DMA
+DMA_BYTES_KEYS = ('dma_ar_bw', 'dma_aw_bw')
+
+
+def safe_div(dividend, divisor, zero_div=0):
+    return dividend / divisor if divisor else zero_div
+
+
+def hart_id(path: str, default: int) -> int:
+    # Traces are named `trace_hart_<hartid in hex>`
+    match = re.search(r'hart_([0-9a-fA-F]+)', path)
+    return int(match.group(1), 16) if match else default
+
+
+def hart_section(seg: dict, tcdm_latency: int) -> dict:
+    """Derives the work and memory stalls of a hart in a section."""
+    cycles = seg.get('cycles', 0)
+    issues = seg.get('snitch_issues', 0) + seg.get('snitch_fseq_offloads', 0)
+    loads = seg.get('snitch_loads', 0) + seg.get('fpss_loads', 0)
+    latency = (seg.get('snitch_load_latency', 0) +
+               seg.get('fpss_load_latency', 0))
+    idle = max(cycles - issues, 0)
+    return {
+        'start': seg.get('start'),
+        'end': seg.get('end'),
+        'cycles': cycles,
+        'issues': issues,
+        'idle': idle,
+        'load_stalls': min(max(latency - loads * tcdm_latency, 0), idle),
+        'fpu_ops': seg.get('fpss_fpu_issues', 0),
+        'total_ipc': seg.get('total_ipc', 0),
+    }
+
+
+def attribute_stalls(harts: dict, dma_hart: int, counters: dict):
+    """Splits the idle cycles of each hart into stall causes in place and
+    returns the critical hart."""
+    # Scale the load stalls to the measured TCDM congestion if available
+    congested = counters.get('tcdm_congested')
+    load_stalls = sum(h['load_stalls'] for h in harts.values())
+    scale = safe_div(congested, load_stalls, 0) if congested is not None \
+        else 1
+    # The DMA hart waits for its transfers while the DMA is busy
+    dma_busy = counters.get('dma_busy', 0)
+    for i, h in harts.items():
+        tcdm = min(round(h['load_stalls'] * scale), h['idle'])
+        dma = min(dma_busy, h['idle'] - tcdm) if i == dma_hart else 0
+        h['stalls'] = {'tcdm': tcdm, 'dma': dma, 'barrier': 0}
+        h['work'] = h['issues'] + tcdm + dma
+        del h['load_stalls']
+    # All others wait for the hart with the most work
+    critical = max(harts, key=lambda i: (harts[i]['work'], -i))
+    critical_work = harts[critical]['work']
+    cause = 'dma' if critical == dma_hart else 'barrier'
+    for h in harts.values():
+        rest = h['idle'] - h['stalls']['tcdm'] - h['stalls']['dma']
+        wait = min(critical_work - h['work'], rest)
+        h['stalls'][cause] += wait
+        h['stalls']['other'] = rest - wait
+    return critical
+
+
+def roofline(fpu_ops: int, dma_bytes, cycles: int, args) -> dict:
+    flops = fpu_ops * args.flops_per_op
+    ret = {
+        'flops': flops,
+        'dma_bytes': dma_bytes,
+        'performance': safe_div(flops, cycles),
+        'intensity': None,
+        'bound': None,
+    }
+    if dma_bytes is not None:
+        ret['intensity'] = safe_div(flops, dma_bytes, None)
+        if args.peak_flops and args.peak_bw:
+            ridge = args.peak_flops / args.peak_bw
+            intensity = ret['intensity']
+            ret['bound'] = 'compute' if intensity is None or \
+                intensity >= ridge else 'memory'
+    return ret
+
+
+def report_section(idx: int, sections: dict, counters: dict, args) -> dict:
+    harts = {
+        i: hart_section(seg, args.tcdm_latency)
+        for i, seg in sections.items()
+    }
+    critical = attribute_stalls(harts, args.dma_hart, counters)
+    start = min(h['start'] for h in harts.values() if h['start'] is not None)
+    end = max(h['end'] for h in harts.values() if h['end'] is not None)
+    span = end - start + 1
+    compute = [h['work'] for i, h in harts.items() if i != args.dma_hart]
+    totals = {
+        key: sum(seg.get(key, 0) for seg in sections.values())
+        for key in SUM_KEYS
+    }
+    stalls = {
+        cause: sum(h['stalls'][cause] for h in harts.values())
+        for cause in ('tcdm', 'dma', 'barrier', 'other')
+    }
+    # Every transfer reads and writes its bytes, which are moved once
+    dma_bytes = totals['dma_bytes']
+    if any(k in counters for k in DMA_BYTES_KEYS):
+        dma_bytes = max(counters.get(k, 0) for k in DMA_BYTES_KEYS)
+    return {
+        'section': idx,
+        'start': start,
+        'end': end,
+        'cycles': span,
+        'harts': len(harts),
+        'critical_hart': critical,
+        'critical_path': harts[critical]['work'],
+        'load_imbalance': 1 - safe_div(
+            sum(compute), len(compute) * max(compute, default=0), 1),
+        'totals': totals,
+        'stalls': stalls,
+        'roofline': roofline(totals['fpss_fpu_issues'], dma_bytes, span,
+                             args),
+        'counters': counters,
+        'per_hart': {str(i): h for i, h in sorted(harts.items())},
+    }
+
+
+def fmt_report(report: dict) -> str:
+    ret = []
+    for sec in report['sections']:
+        ret.append('Section {} @ ({}, {}): {} cycles, critical hart {} ({} '
+                   'cycles), imbalance {:.2%}'.format(
+                       sec['section'], sec['start'], sec['end'],
+                       sec['cycles'], sec['critical_hart'],
+                       sec['critical_path'], sec['load_imbalance']))
+        stalls = sec['stalls']
+        ret.append('    stalls: tcdm {tcdm}, dma {dma}, barrier {barrier}, '
+                   'other {other}'.format(**stalls))
+        roof = sec['roofline']
+        intensity = 'n/a' if roof['intensity'] is None else '{:.4f}'.format(
+            roof['intensity'])
+        ret.append('    roofline: {:.4f} flop/cycle at {} flop/B ({})'.format(
+            roof['performance'], intensity, roof['bound'] or 'unknown'))
+    return '\n'.join(ret)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Merge the performance metrics of all harts into a '
+        'cluster report')
+    parser.add_argument('perf',
+                        metavar='perf.json',
+                        nargs='+',
+                        help='Performance metrics dumped by gen_trace.py '
+                        'for each hart')
+    parser.add_argument('-o',
+                        '--output',
+                        type=argparse.FileType('w'),
+                        default=sys.stdout,
+                        help='Output JSON report (default: stdout)')
+    parser.add_argument('-c',
+                        '--counters',
+                        type=argparse.FileType('r'),
+                        help='Cluster performance counters per section')
+    parser.add_argument('--dma-hart',
+                        type=int,
+                        help='Hart which drives the DMA (default: the last of '
+                        'several)')
+    parser.add_argument('--tcdm-latency',
+                        type=int,
+                        default=1,
+                        help='Load latency without contention in cycles '
+                        '(default: %(default)s)')
+    parser.add_argument('--flops-per-op',
+                        type=int,
+                        default=1,
+                        help='Floating-point operations per FPU instruction '
+                        '(default: %(default)s)')
+    parser.add_argument('--peak-flops',
+                        type=float,
+                        help='Peak performance in flop/cycle (default: one '
+                        'FPU instruction per compute hart and cycle)')
+    parser.add_argument('--peak-bw',
+                        type=float,
+                        default=64,
+                        help='Peak DMA bandwidth in B/cycle '
+                        '(default: %(default)s)')
+    parser.add_argument('-s',
+                        '--summary',
+                        action='store_true',
+                        help='Print a human-readable summary to stderr')
+    args = parser.parse_args()
+
+    perf = {}
+    for idx, path in enumerate(args.perf):
+        with open(path) as f:
+            perf[hart_id(path, idx)] = json.load(f)
+    if len(perf) != len(args.perf):
+        parser.error('multiple metrics for the same hart')
+    if args.dma_hart is None and len(perf) > 1:
+        args.dma_hart = max(perf)
+    if args.peak_flops is None:
+        compute = len(perf) - (args.dma_hart in perf)
+        args.peak_flops = max(compute, 1) * args.flops_per_op
+    counters = json.load(args.counters) if args.counters else []
+
+    # Align the sections of all harts by their index
+    num_sections = max(len(secs) for secs in perf.values())
+    incomplete = sorted(i for i, s in perf.items() if len(s) < num_sections)
+    if incomplete:
+        print('WARNING: harts {} have fewer than {} sections; is the '
+              'number of benchmark_get_cycle() calls the same on all harts?'.
+              format(incomplete, num_sections),
+              file=sys.stderr)
+    sections = []
+    for idx in range(num_sections):
+        secs = {i: s[idx] for i, s in perf.items() if idx < len(s)}
+        cnts = counters[idx] if idx < len(counters) else {}
+        sections.append(report_section(idx, secs, cnts, args))
+
+    report = {
+        'harts': sorted(perf),
+        'dma_hart': args.dma_hart,
+        'peak_flops': args.peak_flops,
+        'peak_bw': args.peak_bw,
+        'cycles': sum(sec['cycles'] for sec in sections),
+        'sections': sections,
+    }
+    with args.output as f:
+        f.write(json.dumps(report, indent=4) + '\n')
+    if args.summary:
+        print(fmt_report(report), file=sys.stderr)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,120 @@
+# Copyright 2021 ETH Zurich and University of Bologna.
+# Licensed under the Apache License, Version 2.0, see LICENSE for details.
+# SPDX-License-Identifier: Apache-2.0
+
+# Symbolization of trace addresses for `annotate.py` and `tracevis.py`. Instead
+# of spawning `addr2line` for every address, a single `addr2line` process is
+# kept alive and fed the addresses in batches through a pipe. Results are kept
+# for the lifetime of the symbolizer: the PCs of a trace are bounded by the
+# code size of the binary, so the cache stays small even for long traces.
+
+import subprocess
+import threading
+import time
+
+
+class Symbolizer:
+    """Resolves addresses like `addr2line -f -a -i`: the result of a lookup
+    is the list of output lines for the address, starting with the address
+    followed by function and source location of each (inlined) frame."""
+
+    def __init__(self,
+                 elf: str,
+                 addr2line: str = 'addr2line',
+                 cache: bool = True,
+                 batch_size: int = 4096):
+        self.proc = subprocess.Popen([addr2line, '-e', elf, '-f', '-a', '-i'],
+                                     stdin=subprocess.PIPE,
+                                     stdout=subprocess.PIPE,
+                                     universal_newlines=True,
+                                     bufsize=1)
+        self.cache = {} if cache else None
+        self.batch_size = batch_size
+        # Statistics
+        self.lookups = 0
+        self.hits = 0
+        self.resolved = 0
+        self.batches = 0
+        self.elapsed = 0.0
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
+
+    def close(self):
+        if self.proc is not None:
+            self.proc.stdin.close()
+            self.proc.wait()
+            self.proc = None
+
+    def _query(self, addrs: list) -> list:
+        """Symbolizes a batch of addresses in the `addr2line` process."""
+        start = time.perf_counter()
+
+        # A trailing sentinel address delimits the output of the last one.
+        # Feed the addresses from a thread, such that `addr2line` never blocks
+        # on a full output pipe while we are still writing.
+        def feed():
+            self.proc.stdin.write(''.join(f'{a:x}\n' for a in addrs) + '0\n')
+            self.proc.stdin.flush()
+
+        feeder = threading.Thread(target=feed)
+        feeder.start()
+        results = []
+        out = self.proc.stdout
+        line = out.readline()
+        # Skip the output of the previous batch's sentinel
+        while line and not line.startswith('0x'):
+            line = out.readline()
+        for _ in addrs:
+            if not line:
+                raise RuntimeError('addr2line terminated unexpectedly')
+            result = [line.rstrip('\n')]
+            line = out.readline()
+            while line and not line.startswith('0x'):
+                result.append(line.rstrip('\n'))
+                line = out.readline()
+            results.append(result)
+        feeder.join()
+
+        self.batches += 1
+        self.resolved += len(addrs)
+        self.elapsed += time.perf_counter() - start
+        return results
+
+    def prefetch(self, addrs):
+        """Symbolizes all addresses not cached yet in as few batches as
+        possible."""
+        if self.cache is None:
+            return
+        todo = sorted(set(a for a in addrs if a not in self.cache))
+        for i in range(0, len(todo), self.batch_size):
+            batch = todo[i:i + self.batch_size]
+            self.cache.update(zip(batch, self._query(batch)))
+
+    def symbolize(self, addrs: list) -> list:
+        """Returns the lookup results of a list of addresses."""
+        addrs = list(addrs)
+        self.lookups += len(addrs)
+        if self.cache is None:
+            results = []
+            for i in range(0, len(addrs), self.batch_size):
+                results += self._query(addrs[i:i + self.batch_size])
+            return results
+        cached = len(self.cache)
+        self.prefetch(addrs)
+        self.hits += len(addrs) - (len(self.cache) - cached)
+        return [self.cache[a] for a in addrs]
+
+    def lookup(self, addr: int) -> list:
+        return self.symbolize([addr])[0]
+
+    def stats(self) -> str:
+        hit_rate = self.hits / self.lookups if self.lookups else 0
+        throughput = self.resolved / self.elapsed if self.elapsed else 0
+        return (f'symbolizer: {self.lookups} lookups, {self.hits} cache hits '
+                f'({hit_rate:.1%}), {self.resolved} addresses resolved in '
+                f'{self.batches} batches, {self.elapsed:.2f} s '
+                f'({throughput:.0f} addresses/s)')
@@ -0,0 +1,64 @@
+#!/usr/bin/env python3
+
+# Copyright 2021 ETH Zurich and University of Bologna.
+# Licensed under the Apache License, Version 2.0, see LICENSE for details.
+# SPDX-License-Identifier: Apache-2.0
+
+# Checks of the tracks `timeline.py` puts the instructions of a trace on. Run
+# with `python3 -m unittest test_timeline` from this directory.
+
+import unittest
+from timeline import CORE, FPU, SEQUENCER, Hart, is_fpu_insn, parse_rtl
+
+# An FREP loop as annotated by `gen_trace.py`: the core issues `frep.o`, the
+# sequencer reports the configuration, and the FPU issues the loop body.
+TRACE = """\
+    1000      500        M 0x80000100 addi    a0, a0, 1                      #; a0  = 1, (wrb) a0  <-- 2
+    1001      501        M 0x80000104 frep.o  a1, 2, 0, 0                    #; a1  = 3
+    1002      502        M 0x80000104 frep    4, 2                           #; inner, 8 issues
+    1004      504        M 0x80000110 addi    a2, a2, 1                      #; a2  = 0, (wrb) a2  <-- 1
+    1005      505        M 0x80000108 fadd.d  ft0, ft1, ft2                  #; [0104 0:0], ft1 = 1.0, ft2 = 2.0
+"""
+
+
+class Recorder:
+    """Collects the slices instead of writing them."""
+
+    def __init__(self):
+        self.slices = []
+
+    def meta(self, *args):
+        pass
+
+    def slice(self, name, ts, dur, pid, tid, pc=None, **fields):
+        self.slices.append((name, ts, dur, tid))
+
+
+class TestTimeline(unittest.TestCase):
+
+    def test_is_fpu_insn(self):
+        for insn in ('fadd.d', 'fmadd.s', 'flw', 'c.fld'):
+            self.assertTrue(is_fpu_insn(insn), insn)
+        for insn in ('frep', 'frep.o', 'frep.i', 'fence', 'fence.i'):
+            self.assertFalse(is_fpu_insn(insn), insn)
+
+    def test_frep_tracks(self):
+        writer = Recorder()
+        hart = Hart(0, writer, False, False, False)
+        for line in parse_rtl(TRACE.splitlines(), False):
+            hart.insn(*line)
+        hart.finish()
+        core = [(n, ts, dur) for n, ts, dur, tid in writer.slices
+                if tid == CORE]
+        # The configuration does not cut short the `frep.o` before it
+        self.assertEqual(core, [('addi', 500, 1), ('frep.o', 501, 3),
+                                ('addi', 504, 2)])
+        self.assertEqual([n for n, _, _, tid in writer.slices if tid == FPU],
+                         ['fadd.d'])
+        self.assertEqual(
+            [n for n, _, _, tid in writer.slices if tid == SEQUENCER],
+            ['frep 4, 2'])
+
+
+if __name__ == '__main__':
+    unittest.main()
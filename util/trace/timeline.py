@@ -0,0 +1,335 @@
+#!/usr/bin/env python3
+
+# Copyright 2021 ETH Zurich and University of Bologna.
+# Licensed under the Apache License, Version 2.0, see LICENSE for details.
+# SPDX-License-Identifier: Apache-2.0
+
+# This script converts the traces of many harts into a timeline that can be
+# loaded into [Perfetto](https://ui.perfetto.dev) or `about:tracing`. Unlike
+# `tracevis.py`, it streams the traces line by line and writes the events as
+# soon as they are complete, so the memory footprint does not depend on the
+# length of the traces. The output is in the JSON trace event format, which is
+# compressed if the output file ends in `.gz`.
+#
+# Each hart is a process with the following tracks:
+# - core: instructions issued by the integer core,
+# - fpu: instructions issued to the FPU,
+# - sequencer: FREP loops, from the first to the last issue of their body,
+# - dma: DMA transfers, from `dmcpy` until the hart has waited for them with
+#   `dmstati`; this is an upper bound on the duration of the transfer.
+#
+# With `--aggregate-frep`, the instructions of FREP bodies are only shown as
+# the slices on the sequencer track, which shrinks the timelines of kernels
+# spending most of their time in FREP loops considerably.
+
+import re
+import sys
+import gzip
+import json
+import argparse
+from perf_report import hart_id
+from symbolize import Symbolizer
+
+CORE, FPU, SEQUENCER, DMA = range(4)
+TRACK_NAMES = ('core', 'fpu', 'sequencer', 'dma')
+
+# Annotation of instructions issued by the FREP sequencer: `[<pc> <rep>:<idx>]`
+RE_FREP_ISSUE = re.compile(r'\[([0-9a-f]{4}) \d+:\d+\]')
+# Annotation of FREP configurations: `inner, <n> issues`
+RE_FREP_CFG = re.compile(r'(inner|outer), (\d+) issues')
+
+DMA_COPY = ('dmcpy', 'dmcpyi')
+DMA_STAT = ('dmstat', 'dmstati')
+
+
+def is_fpu_insn(insn: str) -> bool:
+    # Offloaded instructions only show up in the trace when the FPU issues them
+    if insn.startswith('c.f'):
+        return True
+    # The core issues the FREP configuration (`frep.o`, `frep.i`) itself
+    return insn.startswith('f') and not insn.startswith(('fence', 'frep'))
+
+
+def open_trace(path: str, mode: str = 'rt'):
+    return gzip.open(path, mode) if path.endswith('.gz') else open(path, mode)
+
+
+class Writer:
+    """Writes events in batches, symbolizing their PCs if an ELF is given."""
+
+    def __init__(self, file, window: tuple, symbolizer: Symbolizer = None,
+                 batch_size: int = 4096):
+        self.file = file
+        self.start, self.end = window
+        self.symbolizer = symbolizer
+        self.batch_size = batch_size
+        self.batch = []
+        self.events = 0
+        self.file.write('{"traceEvents": [\n')
+
+    def meta(self, name: str, pid: int, tid: int, value: str):
+        self.file.write(
+            f'{{"name": "{name}", "ph": "M", "pid": {pid}, "tid": {tid}, '
+            f'"args": {{"name": {json.dumps(value)}}}}},\n')
+
+    def slice(self, name: str, ts: int, dur: int, pid: int, tid: int,
+              pc: str = None, **fields):
+        if ts + dur <= self.start or (self.end is not None and ts >= self.end):
+            return
+        self.batch.append((name, ts, dur, pid, tid, pc, fields))
+        if len(self.batch) >= self.batch_size:
+            self.flush()
+
+    def flush(self):
+        funcs = {}
+        if self.symbolizer:
+            pcs = sorted(set(int(e[5], 16) for e in self.batch if e[5]))
+            for pc, ret in zip(pcs, self.symbolizer.symbolize(pcs)):
+                funcs[pc] = ret[1:3]
+        out = []
+        for name, ts, dur, pid, tid, pc, fields in self.batch:
+            if pc:
+                fields['pc'] = pc
+                if funcs:
+                    fields['function'], fields['origin'] = funcs[int(pc, 16)]
+            out.append(f'{{"name": {json.dumps(name)}, "ph": "X", '
+                       f'"ts": {ts}, "dur": {dur}, "pid": {pid}, '
+                       f'"tid": {tid}, "args": {json.dumps(fields)}}},\n')
+        self.file.write(''.join(out))
+        self.events += len(self.batch)
+        self.batch = []
+
+    def close(self):
+        self.flush()
+        self.file.write('{}]}\n')
+
+
+class Hart:
+    """Turns the instructions of a hart into slices on its tracks."""
+
+    def __init__(self, hart: int, writer: Writer, aggregate_frep: bool,
+                 annotations: bool, fixed_duration: bool):
+        self.hart = hart
+        self.writer = writer
+        self.aggregate_frep = aggregate_frep
+        self.annotations = annotations
+        self.fixed_duration = fixed_duration
+        # Core instruction waiting for the next one to know its duration
+        self.pending = None
+        self.last_ts = 0
+        # Open FREP loops by the last four digits of their PC
+        self.freps = {}
+        # DMA transfers in flight and last cycle the hart polled the DMA
+        self.transfers = []
+        self.polled = None
+        for tid, name in enumerate(TRACK_NAMES):
+            writer.meta('thread_name', hart, tid, name)
+
+    def insn(self, ts: int, pc: str, insn: str, args: str, annot: str):
+        self.last_ts = ts
+        extra = {'annotation': annot} if self.annotations and annot else {}
+        frep_issue = RE_FREP_ISSUE.match(annot)
+        if frep_issue:
+            self.frep_issue(frep_issue.group(1), ts)
+            if not self.aggregate_frep:
+                self.writer.slice(insn, ts, 1, self.hart, FPU, pc,
+                                  operands=args, **extra)
+            return
+        if is_fpu_insn(insn):
+            self.writer.slice(insn, ts, 1, self.hart, FPU, pc, operands=args,
+                              **extra)
+            return
+        if insn == 'frep':
+            # Sequencer configuration: only opens the loop on its track
+            cfg = RE_FREP_CFG.search(annot)
+            if cfg:
+                self.frep_cfg(pc, f'frep {args}', int(cfg.group(2)))
+            return
+        self.dma(ts, insn, args)
+        self.core(ts, (insn, pc, args, extra))
+
+    def core(self, ts: int, insn: tuple):
+        if self.pending:
+            last_ts, (name, pc, args, extra) = self.pending
+            dur = 1 if self.fixed_duration else max(ts - last_ts, 1)
+            self.writer.slice(name, last_ts, dur, self.hart, CORE, pc,
+                              operands=args, **extra)
+        self.pending = (ts, insn) if insn else None
+
+    def frep_cfg(self, pc: str, name: str, issues: int):
+        key = pc[-4:]
+        if key in self.freps:
+            self.close_frep(key)
+        self.freps[key] = [name, pc, issues, 0, None, None]
+
+    def frep_issue(self, key: str, ts: int):
+        frep = self.freps.get(key)
+        if frep is None:
+            # The configuration was issued before the trace (window) started
+            frep = self.freps[key] = ['frep', None, None, 0, None, None]
+        frep[3] += 1
+        if frep[4] is None:
+            frep[4] = ts
+        frep[5] = ts
+        if frep[3] == frep[2]:
+            self.close_frep(key)
+
+    def close_frep(self, key: str):
+        name, pc, issues, seen, first, last = self.freps.pop(key)
+        if first is not None:
+            self.writer.slice(name, first, last - first + 1, self.hart,
+                              SEQUENCER, pc, issues=seen)
+
+    def dma(self, ts: int, insn: str, args: str):
+        if insn in DMA_STAT:
+            self.polled = ts
+            return
+        # The first instruction after the polling loop completes the wait
+        if self.polled is not None:
+            if insn.startswith(('b', 'c.b')):
+                return
+            for start, args in self.transfers:
+                self.writer.slice('dma', start, self.polled - start + 1,
+                                  self.hart, DMA, operands=args)
+            self.transfers = []
+            self.polled = None
+        if insn in DMA_COPY:
+            self.transfers.append((ts, args))
+
+    def finish(self):
+        ts = self.last_ts + 1
+        self.core(ts, None)
+        for key in list(self.freps):
+            self.close_frep(key)
+        for start, args in self.transfers:
+            self.writer.slice('dma', start, ts - start, self.hart, DMA,
+                              operands=args)
+        self.transfers = []
+
+
+def parse_rtl(lines, use_time: bool):
+    """Yields `(ts, pc, insn, args, annotation)` of the instructions in a
+    trace annotated by `gen_trace.py`. Lines repeating the time stamp of the
+    previous one leave it out."""
+    ts = None
+    for line in lines:
+        head, _, annot = line.partition('#;')
+        fields = head.split()
+        if len(fields) >= 2 and fields[0].isdigit() and fields[1].isdigit():
+            ts = int(fields[0] if use_time else fields[1])
+            fields = fields[2:]
+        # Skip the privilege level; lines without PC only retire writebacks
+        if len(fields) < 3 or not fields[1].startswith('0x') or ts is None:
+            continue
+        yield ts, fields[1], fields[2], ' '.join(fields[3:]), annot.strip()
+
+
+def parse_banshee(lines):
+    """Yields `(hart, ts, pc, insn, args)` of the instructions in a Banshee
+    trace, which holds the instructions of all harts."""
+    for line in lines:
+        head, _, insn = line.partition('#')
+        fields = head.split()
+        insn = insn.split(None, 1)
+        if len(fields) < 4 or not insn or not fields[0].isdigit():
+            continue
+        yield (int(fields[2]), int(fields[0]), '0x' + fields[3], insn[0],
+               insn[1].strip() if len(insn) > 1 else '')
+
+
+def parse_window(window: str) -> tuple:
+    start, _, end = window.partition(':')
+    return (int(start) if start else 0, int(end) if end else None)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Stream the traces of many harts into a timeline')
+    parser.add_argument('traces',
+                        metavar='<trace>',
+                        nargs='+',
+                        help='Annotated traces (`trace_hart_<id>.txt[.gz]`) '
+                        'or Banshee traces')
+    parser.add_argument('-o',
+                        '--output',
+                        metavar='<json>',
+                        default='timeline.json.gz',
+                        help='Output file, compressed if it ends in `.gz` '
+                        '(default: %(default)s)')
+    parser.add_argument('-e',
+                        '--elf',
+                        metavar='<elf>',
+                        help='Binary executed to generate the traces, to '
+                        'annotate the functions of instructions')
+    parser.add_argument('--addr2line',
+                        metavar='<path>',
+                        default='addr2line',
+                        help='`addr2line` binary to use for parsing')
+    parser.add_argument('-w',
+                        '--window',
+                        metavar='<start>:<end>',
+                        type=parse_window,
+                        default=(0, None),
+                        help='Only export the cycles in [start, end)')
+    parser.add_argument('-f',
+                        '--aggregate-frep',
+                        action='store_true',
+                        help='Show FREP loops as a single slice instead of '
+                        'all instructions of their body')
+    parser.add_argument('-a',
+                        '--annotations',
+                        action='store_true',
+                        help='Include the annotations of instructions')
+    parser.add_argument('-t',
+                        '--time',
+                        action='store_true',
+                        help='Use the traces time instead of cycles')
+    parser.add_argument('-b',
+                        '--banshee',
+                        action='store_true',
+                        help='Parse Banshee traces')
+    args = parser.parse_args()
+
+    symbolizer = Symbolizer(args.elf, args.addr2line) if args.elf else None
+    with open_trace(args.output, 'wt') as output:
+        writer = Writer(output, args.window, symbolizer)
+        harts = {}
+
+        def get_hart(hart):
+            if hart not in harts:
+                writer.meta('process_name', hart, 0, f'hart {hart}')
+                harts[hart] = Hart(hart, writer, args.aggregate_frep,
+                                   args.annotations, args.banshee)
+            return harts[hart]
+
+        for idx, path in enumerate(args.traces):
+            lines = 0
+            with open_trace(path) as f:
+                if args.banshee:
+                    for hart, ts, pc, insn, insn_args in parse_banshee(f):
+                        get_hart(hart).insn(ts, pc, insn, insn_args, '')
+                        lines += 1
+                    for h in harts.values():
+                        h.finish()
+                    harts.clear()
+                else:
+                    hart = get_hart(hart_id(path, idx))
+                    for ts, pc, insn, insn_args, annot in parse_rtl(
+                            f, args.time):
+                        if args.window[1] is not None and \
+                                ts >= args.window[1]:
+                            break
+                        hart.insn(ts, pc, insn, insn_args, annot)
+                        lines += 1
+                    hart.finish()
+            print(f'{path}: {lines} instructions', file=sys.stderr)
+        writer.close()
+    print(f'{args.output}: {writer.events} events', file=sys.stderr)
+    if symbolizer:
+        symbolizer.close()
+        print(symbolizer.stats(), file=sys.stderr)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
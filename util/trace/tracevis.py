@@ -14,10 +14,9 @@
 #         Samuel Riedel <sriedel@iis.ee.ethz.ch>
 
 import re
-import os
 import sys
-from functools import lru_cache
 import argparse
+from symbolize import Symbolizer
 
 has_progressbar = True
 try:
@@ -60,24 +59,11 @@ ACC_LINE_REGEX = r' *(\d+) +(\d+) +([3M1S0U]?) *#; (.*)'
 buf = []
 
 
-@lru_cache(maxsize=1024)
-def addr2line_cache(addr):
-    cmd = f'{addr2line} -e {elf} -f -a -i {addr:x}'
-    return os.popen(cmd).read().split('\n')
-
-
 def flush(buf, hartid):
     global output_file
     # get function names
-    pcs = [x[3] for x in buf]
-    a2ls = []
-
-    if cache:
-        for addr in pcs:
-            a2ls += addr2line_cache(int(addr, base=16))[:-1]
-    else:
-        a2ls = os.popen(
-            f'{addr2line} -e {elf} -f -a -i {" ".join(pcs)}').read().split('\n')[:-1]
+    pcs = [int(x[3], base=16) for x in buf]
+    a2ls = [a2l for ret in symbolizer.symbolize(pcs) for a2l in ret]
 
     for i in range(len(buf)-1):
         (time, cyc, priv, pc, instr, args, cmt) = buf.pop(0)
@@ -230,6 +216,8 @@ print('output:', output, file=sys.stderr)
 print('addr2line:', addr2line, file=sys.stderr)
 print('cache:', cache, file=sys.stderr)
 
+symbolizer = Symbolizer(elf, addr2line, cache)
+
 # Compile regex
 if banshee:
     re_line = re.compile(BANSHEE_REGEX)
@@ -302,6 +290,10 @@ with open(output, 'w') as output_file:
         tot_lines = len(open(filename).readlines())
         with open(filename) as f:
             all_lines = f.readlines()[args.start:args.end]
+            # Symbolize all PCs of the trace at once
+            matches = (re_line.match(line) for line in all_lines)
+            symbolizer.prefetch(
+                int(m.group(4), base=16) for m in matches if m)
             # offload lookahead
             if not banshee:
                 lah = offload_lookahead(all_lines)
@@ -321,3 +313,6 @@ with open(output, 'w') as output_file:
 
     # JSON footer
     output_file.write(r'{}]}''\n')
+
+symbolizer.close()
+print(symbolizer.stats(), file=sys.stderr)